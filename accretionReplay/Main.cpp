@@ -0,0 +1,380 @@
+/*****************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Questionable Coding
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************/
+#include <qcSysGen/AccretionLog.h>
+#include <qcSysGen/Consts.h>
+#include <qcSysGen/Generator.h>
+#include <qcSysGen/System.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <map>
+#include <vector>
+
+using namespace qc::SystemGenerator;
+
+// Records, replays and compares accretion event logs.
+//
+//   accretionReplay record <log> <firstSeed> <count> [--protoplanets N] [--generate-star] [--bode] [--generate2]
+//   accretionReplay print <log>
+//   accretionReplay summary <log>
+//   accretionReplay diff <logA> <logB>
+//
+// `record` generates the seeds and writes one AccretionLog per system to the file.  `print` replays
+// each log as text, rebuilding the planet list from the PlanetCommitted and Collision events, so the
+// order in which the planets formed and merged can be followed without a debugger.  `summary` counts
+// the events of each type.  `diff` pairs the logs of two files by seed and reports the first event
+// that differs, which is the quickest way to find where a change to the generator alters its output.
+
+namespace
+{
+
+/// @brief Number of events shown before the first difference.
+static constexpr size_t DiffContext = 3u;
+
+/// @brief A planet rebuilt from the events.
+struct ReplayPlanet
+{
+    double sma;
+    double mass;
+};
+
+//----------------------------------------------------------------------------
+// Print one event.
+void PrintEvent(size_t index, const AccretionEvent& e)
+{
+    printf("  %5llu %-20s %10u %14.8g %14.8g %14.8g %14.8g\n", static_cast<unsigned long long>(index),
+           AccretionEventTypeName(e.type), e.detail, e.value[0], e.value[1], e.value[2], e.value[3]);
+}
+
+//----------------------------------------------------------------------------
+// Read every log in a file.
+bool ReadLogs(const char* path, std::vector<AccretionLog>& logs)
+{
+    FILE* fp = nullptr;
+    if (fopen_s(&fp, path, "rb") != 0 || !fp)
+    {
+        fprintf(stderr, "Unable to open '%s'\n", path);
+        return false;
+    }
+
+    // A log that fails to read after at least one byte is left is truncated or corrupt, even though the
+    // stream may be at its end by then; only running out of bytes between two logs is a clean end.
+    AccretionLog log;
+    bool atEnd = false;
+    for (;;)
+    {
+        const int next = fgetc(fp);
+        if (next == EOF)
+        {
+            atEnd = (ferror(fp) == 0);
+            break;
+        }
+
+        ungetc(next, fp);
+        if (!log.read(fp))
+        {
+            break;
+        }
+        logs.emplace_back(log);
+    }
+
+    fclose(fp);
+
+    if (!atEnd)
+    {
+        fprintf(stderr, "'%s' is not an accretion log, or is truncated\n", path);
+    }
+    return atEnd;
+}
+
+//----------------------------------------------------------------------------
+// Compare the logs of two files.
+int Diff(const char* pathA, const char* pathB)
+{
+    std::vector<AccretionLog> a;
+    std::vector<AccretionLog> b;
+    if (!ReadLogs(pathA, a) || !ReadLogs(pathB, b))
+    {
+        return 1;
+    }
+
+    std::map<uint64_t, const AccretionLog*> bySeed;
+    for (const auto& log : b)
+    {
+        bySeed[log.getSeed()] = &log;
+    }
+
+    uint32_t compared = 0u;
+    uint32_t different = 0u;
+    for (const auto& logA : a)
+    {
+        auto found = bySeed.find(logA.getSeed());
+        if (found == bySeed.end())
+        {
+            printf("Seed %llu: only in %s\n", static_cast<unsigned long long>(logA.getSeed()), pathA);
+            continue;
+        }
+
+        const AccretionLog& logB = *found->second;
+        bySeed.erase(found);
+        ++compared;
+
+        const std::vector<AccretionEvent>& eventsA = logA.getEvents();
+        const std::vector<AccretionEvent>& eventsB = logB.getEvents();
+        const size_t common = std::min(eventsA.size(), eventsB.size());
+
+        size_t i = 0u;
+        while (i < common && !memcmp(&eventsA[i], &eventsB[i], sizeof(AccretionEvent)))
+        {
+            ++i;
+        }
+
+        if (i == common && eventsA.size() == eventsB.size())
+        {
+            continue;
+        }
+
+        ++different;
+        printf("Seed %llu: first difference at event %llu (%llu vs %llu events)\n", static_cast<unsigned long long>(logA.getSeed()),
+               static_cast<unsigned long long>(i), static_cast<unsigned long long>(eventsA.size()), static_cast<unsigned long long>(eventsB.size()));
+        for (size_t c = (i > DiffContext) ? i - DiffContext : 0u; c < i; ++c)
+        {
+            PrintEvent(c, eventsA[c]);
+        }
+        printf(" %s:\n", pathA);
+        if (i < eventsA.size())
+        {
+            PrintEvent(i, eventsA[i]);
+        }
+        printf(" %s:\n", pathB);
+        if (i < eventsB.size())
+        {
+            PrintEvent(i, eventsB[i]);
+        }
+    }
+
+    for (const auto& remaining : bySeed)
+    {
+        printf("Seed %llu: only in %s\n", static_cast<unsigned long long>(remaining.first), pathB);
+    }
+
+    printf("%u systems compared, %u different\n", compared, different);
+    return (different == 0u && bySeed.empty() && compared == a.size()) ? 0 : 2;
+}
+
+//----------------------------------------------------------------------------
+// Replay every log in a file as text.
+int Print(const char* path)
+{
+    std::vector<AccretionLog> logs;
+    if (!ReadLogs(path, logs))
+    {
+        return 1;
+    }
+
+    for (const auto& log : logs)
+    {
+        printf("Seed %llu: %llu events\n", static_cast<unsigned long long>(log.getSeed()), static_cast<unsigned long long>(log.getEvents().size()));
+
+        std::vector<ReplayPlanet> planets;
+        size_t index = 0u;
+        for (const auto& e : log.getEvents())
+        {
+            PrintEvent(index++, e);
+
+            if (e.type == AccretionEventType::Collision)
+            {
+                // The merged body is injected again, and is committed or collides in turn.
+                for (auto p = planets.begin(); p != planets.end(); ++p)
+                {
+                    if (p->sma == e.value[0] && p->mass == e.value[1])
+                    {
+                        planets.erase(p);
+                        break;
+                    }
+                }
+            }
+            else if (e.type == AccretionEventType::PlanetCommitted)
+            {
+                ReplayPlanet p = { e.value[0], e.value[2] + e.value[3] };
+                planets.emplace_back(p);
+            }
+        }
+
+        printf(" Planets:\n");
+        for (const auto& p : planets)
+        {
+            printf("  %10.5f AU %12.6f Earth masses\n", p.sma, p.mass * SolarMassToEarthMass);
+        }
+    }
+
+    return 0;
+}
+
+//----------------------------------------------------------------------------
+// Generate a range of seeds and write their logs.
+int Record(int argc, char** argv)
+{
+    if (argc < 5)
+    {
+        fprintf(stderr, "record requires <log> <firstSeed> <count>\n");
+        return 1;
+    }
+
+    const char* path = argv[2];
+    const uint64_t firstSeed = strtoull(argv[3], nullptr, 10);
+    const uint64_t count = strtoull(argv[4], nullptr, 10);
+
+    Config config;
+    bool useGenerate2 = false;
+    for (int i = 5; i < argc; ++i)
+    {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : "";
+
+        if (!strcmp(arg, "--protoplanets")) { config.protoplanetCount = static_cast<uint32_t>(strtoul(value, nullptr, 10)); ++i; }
+        else if (!strcmp(arg, "--generate-star")) { config.generateStar = true; }
+        else if (!strcmp(arg, "--bode")) { config.generateBodeSeeds = true; }
+        else if (!strcmp(arg, "--generate2")) { useGenerate2 = true; }
+        else
+        {
+            fprintf(stderr, "Unknown option '%s'\n", arg);
+            return 1;
+        }
+    }
+
+    FILE* fp = nullptr;
+    if (fopen_s(&fp, path, "wb") != 0 || !fp)
+    {
+        fprintf(stderr, "Unable to create '%s'\n", path);
+        return 1;
+    }
+
+    Generator generator;
+    AccretionLog log;
+    generator.setAccretionLog(&log);
+
+    bool ok = true;
+    for (uint64_t i = 0; i < count && ok; ++i)
+    {
+        SolarSystem system;
+        generator.seed(firstSeed + i);
+        if (useGenerate2)
+        {
+            generator.accrete2(system, config);
+        }
+        else
+        {
+            generator.accrete(system, config);
+        }
+        ok = log.write(fp);
+    }
+
+    fclose(fp);
+    if (!ok)
+    {
+        fprintf(stderr, "Error writing '%s'\n", path);
+        return 1;
+    }
+
+    return 0;
+}
+
+//----------------------------------------------------------------------------
+// Count the events of every log in a file.
+int Summary(const char* path)
+{
+    std::vector<AccretionLog> logs;
+    if (!ReadLogs(path, logs))
+    {
+        return 1;
+    }
+
+    uint64_t total[AccretionEventTypeCount] = { };
+    uint64_t planets = 0u;
+    uint32_t maxSweeps = 0u;
+
+    for (const auto& log : logs)
+    {
+        for (const auto& e : log.getEvents())
+        {
+            const uint32_t t = static_cast<uint32_t>(e.type);
+            if (t < AccretionEventTypeCount)
+            {
+                ++total[t];
+            }
+
+            if (e.type == AccretionEventType::DustCollected)
+            {
+                maxSweeps = std::max(maxSweeps, e.detail + 1u);
+            }
+            else if (e.type == AccretionEventType::SystemEnd)
+            {
+                planets += e.detail;
+            }
+        }
+    }
+
+    printf("%llu systems, %llu planets\n", static_cast<unsigned long long>(logs.size()), static_cast<unsigned long long>(planets));
+    for (uint32_t t = 0; t < AccretionEventTypeCount; ++t)
+    {
+        printf("  %-20s %12llu\n", AccretionEventTypeName(static_cast<AccretionEventType>(t)), static_cast<unsigned long long>(total[t]));
+    }
+    printf("  Most sweeps by one protoplanet: %u\n", maxSweeps);
+
+    return 0;
+}
+
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+    if (argc >= 5 && !strcmp(argv[1], "record"))
+    {
+        return Record(argc, argv);
+    }
+    else if (argc == 3 && !strcmp(argv[1], "print"))
+    {
+        return Print(argv[2]);
+    }
+    else if (argc == 3 && !strcmp(argv[1], "summary"))
+    {
+        return Summary(argv[2]);
+    }
+    else if (argc == 4 && !strcmp(argv[1], "diff"))
+    {
+        return Diff(argv[2], argv[3]);
+    }
+
+    printf("Usage:\n"
+           "  accretionReplay record <log> <firstSeed> <count> [--protoplanets N] [--generate-star] [--bode] [--generate2]\n"
+           "  accretionReplay print <log>\n"
+           "  accretionReplay summary <log>\n"
+           "  accretionReplay diff <logA> <logB>\n");
+    return 1;
+}
@@ -0,0 +1,214 @@
+/*****************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Questionable Coding
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************/
+#include <qcSysGen/AdaptiveSearch.h>
+#include <qcSysGen/Generator.h>
+#include <qcSysGen/PlanetFilter.h>
+#include <qcSysGen/System.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+
+using namespace qc::SystemGenerator;
+
+// Searches for rare systems by steering the generator's inputs, and compares the hit rate against
+// uniform sampling of the same inputs.
+//
+//   adaptiveSearch [--target EXPR] [--star M0] [--max-subtype N] [--seeds N] [--rounds N] [--samples N]
+//                  [--first-seed S] [--search-seed S] [--workers W] [--generate2]
+//
+// The target is a PlanetFilter expression, such as "type == Ocean && esi > 0.95".  --star selects the
+// class of the star and its lowest subtype; --max-subtype widens the range of subtypes the search may use.
+// The best hits are listed with every input needed to regenerate them, and the best one is regenerated
+// to confirm that it reproduces.
+
+namespace
+{
+
+/// @brief Number of hits listed in the report.
+static constexpr size_t ReportedHits = 10u;
+
+//----------------------------------------------------------------------------
+// Parse a star type such as "G2" or "K5V".
+bool ParseStar(const char* text, SearchSpace& space)
+{
+    static const char Classes[] = "OBAFGKM";
+
+    const char* c = (*text) ? strchr(Classes, *text) : nullptr;
+    if (!c || text[1] < '0' || text[1] > '9' || (text[2] && strcmp(text + 2, "V")))
+    {
+        return false;
+    }
+
+    space.starClass = static_cast<StarClassification>(c - Classes);
+    space.minSubtype = space.maxSubtype = text[1] - '0';
+    return true;
+}
+
+//----------------------------------------------------------------------------
+// Print the summary of one search.
+void Report(const char* name, const AdaptiveSearch& search)
+{
+    uint64_t samples = 0u;
+    double seconds = 0.0;
+    for (const auto& r : search.getRounds())
+    {
+        samples += r.samples;
+        seconds += r.seconds;
+    }
+
+    printf("%-10s %10llu systems %8llu hits %10.3f CPU-s %12.3f hits/CPU-s\n", name, static_cast<unsigned long long>(samples),
+           static_cast<unsigned long long>(search.getHits().size()), seconds, search.getHitsPerSecond());
+}
+
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+    Config config;
+    SearchSpace space;
+    AdaptiveSearchSettings settings;
+    std::string target = "type == Terrestrial && esi > 0.9";
+    int32_t maxSubtype = -1;
+    uint32_t workerCount = 0u;
+
+    space.starClass = StarClassification::G_V;
+    space.minSubtype = space.maxSubtype = 2;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : "";
+
+        if (!strcmp(arg, "--target")) { target = value; ++i; }
+        else if (!strcmp(arg, "--max-subtype")) { maxSubtype = atoi(value); ++i; }
+        else if (!strcmp(arg, "--seeds")) { space.seedCount = static_cast<uint32_t>(strtoul(value, nullptr, 10)); ++i; }
+        else if (!strcmp(arg, "--rounds")) { settings.roundCount = static_cast<uint32_t>(strtoul(value, nullptr, 10)); ++i; }
+        else if (!strcmp(arg, "--samples")) { settings.samplesPerRound = static_cast<uint32_t>(strtoul(value, nullptr, 10)); ++i; }
+        else if (!strcmp(arg, "--first-seed")) { settings.firstSeed = strtoull(value, nullptr, 10); ++i; }
+        else if (!strcmp(arg, "--search-seed")) { settings.searchSeed = strtoull(value, nullptr, 10); ++i; }
+        else if (!strcmp(arg, "--workers")) { workerCount = static_cast<uint32_t>(strtoul(value, nullptr, 10)); ++i; }
+        else if (!strcmp(arg, "--star"))
+        {
+            if (!ParseStar(value, space))
+            {
+                fprintf(stderr, "Invalid star type '%s'\n", value);
+                return 1;
+            }
+            ++i;
+        }
+        else if (!strcmp(arg, "--generate2")) { settings.useGenerate2 = true; }
+        else
+        {
+            printf("Usage:\n"
+                   "  adaptiveSearch [--target EXPR] [--star M0] [--max-subtype N] [--seeds N] [--rounds N] [--samples N]\n"
+                   "                 [--first-seed S] [--search-seed S] [--workers W] [--generate2]\n");
+            return 1;
+        }
+    }
+
+    if (maxSubtype >= 0)
+    {
+        space.maxSubtype = maxSubtype;
+    }
+
+    PlanetFilter filter;
+    std::string error;
+    if (!filter.compile(target.c_str(), &error))
+    {
+        fprintf(stderr, "Invalid target '%s': %s\n", target.c_str(), error.c_str());
+        return 1;
+    }
+
+    AdaptiveSearch uniform(space, workerCount);
+    AdaptiveSearch adaptive(space, workerCount);
+
+    printf("Target: %s\n", target.c_str());
+    printf("%u rounds of %u systems, %u seeds, %u workers\n", settings.roundCount, settings.samplesPerRound, space.seedCount,
+           adaptive.getWorkerCount());
+
+    AdaptiveSearchSettings uniformSettings = settings;
+    uniformSettings.adaptive = false;
+    uniform.run(config, filter, uniformSettings);
+    adaptive.run(config, filter, settings);
+
+    printf("\n%5s %10s %8s %10s\n", "Round", "Systems", "Hits", "Elite");
+    for (size_t r = 0; r < adaptive.getRounds().size(); ++r)
+    {
+        const SearchRound& round = adaptive.getRounds()[r];
+        printf("%5zu %10llu %8llu %10.4f\n", r, static_cast<unsigned long long>(round.samples), static_cast<unsigned long long>(round.hits),
+               round.eliteScore);
+    }
+
+    printf("\n");
+    Report("Uniform", uniform);
+    Report("Adaptive", adaptive);
+    if (uniform.getHitsPerSecond() > 0.0)
+    {
+        printf("Speedup: %.2fx\n", adaptive.getHitsPerSecond() / uniform.getHitsPerSecond());
+    }
+
+    const std::vector<SearchHit>& hits = adaptive.getHits();
+    if (hits.empty())
+    {
+        return 0;
+    }
+
+    std::vector<size_t> best(hits.size());
+    for (size_t i = 0; i < hits.size(); ++i)
+    {
+        best[i] = i;
+    }
+    std::stable_sort(best.begin(), best.end(), [&hits](size_t lhs, size_t rhs) { return hits[lhs].earthSimilarityIndex > hits[rhs].earthSimilarityIndex; });
+
+    static const char Classes[] = "OBAFGKM";
+    printf("\n%20s %5s %8s %6s %6s  Seeds (SMA AU / ecc)\n", "Seed", "Star", "Age Gyr", "Planet", "ESI");
+    for (size_t i = 0; i < std::min(ReportedHits, best.size()); ++i)
+    {
+        const SearchHit& h = hits[best[i]];
+        printf("%20llu %c%dV %9.4f %6u %6.4f ", static_cast<unsigned long long>(h.sample.seed), Classes[static_cast<uint32_t>(h.sample.starClass)],
+               h.sample.subtype, h.sample.age * 1.0e-9, h.planetOrdinal, h.earthSimilarityIndex);
+        for (const auto& s : h.sample.seeds)
+        {
+            printf(" %.17g/%.9g", s.semiMajorAxis, s.eccentricity);
+        }
+        printf("\n");
+    }
+
+    // Regenerate the best hit from its recorded inputs.
+    const SearchHit& top = hits[best[0]];
+    Generator generator;
+    SolarSystem system;
+    AdaptiveSearch::regenerate(top.sample, config, settings.useGenerate2, generator, system);
+
+    const bool reproduced = top.planetOrdinal <= system.getPlanets().size() &&
+        system.getPlanets()[top.planetOrdinal - 1u].getEarthSimilarityIndex() == top.earthSimilarityIndex;
+    printf("\nRegenerated seed %llu: %s\n", static_cast<unsigned long long>(top.sample.seed), reproduced ? "identical" : "MISMATCH");
+
+    return reproduced ? 0 : 1;
+}
@@ -0,0 +1,256 @@
+/*****************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Questionable Coding
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************/
+#include <qcSysGen/Batch.h>
+#include <qcSysGen/CostProfiler.h>
+#include <qcSysGen/Generator.h>
+#include <qcSysGen/System.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+using namespace qc::SystemGenerator;
+
+// Finds the systems that are the most expensive to generate, and replays them as a benchmark.
+//
+//   costProfiler [--systems N] [--first-seed S] [--workers W] [--star G2] [--generate-star] [--generate2]
+//                [--top N] [--rank Metric] [--corpus file]
+//   costProfiler --replay file [--repeat R] [--star G2] [--generate-star]
+//
+// The first form profiles a range of seeds, reports the distribution of every cost measure and the
+// top N systems by the ranking measure (WallTime by default), and optionally writes those systems as a
+// corpus.  The second form regenerates every system of a corpus R times on one thread and reports the
+// median time of each, along with the time recorded in the corpus.  The Config and Star must match the
+// ones the corpus was profiled with; a corpus whose Config fingerprint or library version differs is
+// rejected.
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Parse a star type such as "G2" or "K5V".
+bool ParseStar(const char* text, Star& star)
+{
+    static const char Classes[] = "OBAFGKM";
+
+    const char* c = (*text) ? strchr(Classes, *text) : nullptr;
+    if (!c || text[1] < '0' || text[1] > '9' || (text[2] && strcmp(text + 2, "V")))
+    {
+        return false;
+    }
+
+    star.setType(static_cast<StarClassification>(c - Classes), text[1] - '0');
+    return true;
+}
+
+//----------------------------------------------------------------------------
+// Parse the name of a CostMetric.
+bool ParseMetric(const char* text, CostMetric& metric)
+{
+    for (uint32_t m = 0; m < CostMetricCount; ++m)
+    {
+        if (!strcmp(text, CostMetricName(CostMetric(m))))
+        {
+            metric = CostMetric(m);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+//----------------------------------------------------------------------------
+// Regenerate every system of a corpus and report its timing.
+int Replay(const char* path, const Config& config, const Star& star, uint32_t repeat)
+{
+    FILE* fp = nullptr;
+    if (fopen_s(&fp, path, "rt") || !fp)
+    {
+        fprintf(stderr, "Unable to open '%s'\n", path);
+        return 1;
+    }
+
+    std::vector<CostCorpusEntry> corpus;
+    const bool valid = ReadCostCorpus(fp, corpus);
+    fclose(fp);
+    if (!valid)
+    {
+        fprintf(stderr, "'%s' is not a cost corpus\n", path);
+        return 1;
+    }
+
+    Generator generator;
+    SolarSystem system;
+    SystemCost cost;
+    generator.setSystemCost(&cost);
+
+    std::vector<double> seconds(repeat);
+    double total = 0.0;
+    uint32_t mismatched = 0u;
+
+    printf("%20s %12s %12s %8s\n", "Seed", "Corpus(us)", "Median(us)", "Counts");
+    for (const auto& e : corpus)
+    {
+        const bool useGenerate2 = (e.key.flags & GenerationCacheKey::UseGenerate2) != 0u;
+        const GenerationCacheKey expected = GenerationCacheKey::Make(e.key.seed, config, star, useGenerate2);
+        if (expected.configFingerprint != e.key.configFingerprint || expected.version != e.key.version ||
+            expected.starClass != e.key.starClass || expected.subtype != e.key.subtype)
+        {
+            fprintf(stderr, "Seed %llu was profiled with a different Config, Star or library version\n", static_cast<unsigned long long>(e.key.seed));
+            return 1;
+        }
+
+        for (uint32_t r = 0; r < repeat; ++r)
+        {
+            const auto start = std::chrono::steady_clock::now();
+
+            system.add(star);
+            generator.seed(e.key.seed);
+            if (useGenerate2)
+            {
+                generator.generate2(system, config);
+            }
+            else
+            {
+                generator.generate(system, config);
+            }
+
+            seconds[r] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        std::sort(seconds.begin(), seconds.end());
+        const double median = seconds[repeat / 2u];
+        total += median;
+
+        // The counters only depend on the seed, so they must match the corpus exactly.
+        const bool match = cost.dustSweeps == e.cost.dustSweeps && cost.protoplanets == e.cost.protoplanets &&
+            cost.wastedProtoplanets == e.cost.wastedProtoplanets && cost.peakDustBands == e.cost.peakDustBands &&
+            cost.collisions == e.cost.collisions && cost.evaluationRounds == e.cost.evaluationRounds && cost.planetCount == e.cost.planetCount;
+        mismatched += match ? 0u : 1u;
+
+        printf("%20llu %12.1f %12.1f %8s\n", static_cast<unsigned long long>(e.key.seed), e.cost.seconds * 1.0e6, median * 1.0e6, match ? "ok" : "DIFFER");
+    }
+
+    printf("\n%zu systems, %.3f ms total median time, %u with different counts\n", corpus.size(), total * 1.0e3, mismatched);
+
+    return (mismatched > 0u) ? 1 : 0;
+}
+
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+    Config config;
+    BatchSettings settings;
+    settings.firstSeed = 1u;
+    settings.systemCount = 100000u;
+    uint32_t workerCount = 0u;
+    uint32_t top = 50u;
+    uint32_t repeat = 5u;
+    CostMetric metric = CostMetric::WallTime;
+    const char* corpusPath = nullptr;
+    const char* replayPath = nullptr;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : "";
+
+        if (!strcmp(arg, "--systems")) { settings.systemCount = strtoull(value, nullptr, 10); ++i; }
+        else if (!strcmp(arg, "--first-seed")) { settings.firstSeed = strtoull(value, nullptr, 10); ++i; }
+        else if (!strcmp(arg, "--workers")) { workerCount = static_cast<uint32_t>(strtoul(value, nullptr, 10)); ++i; }
+        else if (!strcmp(arg, "--top")) { top = static_cast<uint32_t>(strtoul(value, nullptr, 10)); ++i; }
+        else if (!strcmp(arg, "--repeat")) { repeat = std::max(1u, static_cast<uint32_t>(strtoul(value, nullptr, 10))); ++i; }
+        else if (!strcmp(arg, "--corpus")) { corpusPath = value; ++i; }
+        else if (!strcmp(arg, "--replay")) { replayPath = value; ++i; }
+        else if (!strcmp(arg, "--rank"))
+        {
+            if (!ParseMetric(value, metric))
+            {
+                fprintf(stderr, "Invalid measure '%s'\n", value);
+                return 1;
+            }
+            ++i;
+        }
+        else if (!strcmp(arg, "--star"))
+        {
+            if (!ParseStar(value, settings.star))
+            {
+                fprintf(stderr, "Invalid star type '%s'\n", value);
+                return 1;
+            }
+            ++i;
+        }
+        else if (!strcmp(arg, "--generate-star")) { config.generateStar = true; }
+        else if (!strcmp(arg, "--generate2")) { settings.useGenerate2 = true; }
+        else
+        {
+            printf("Usage:\n"
+                   "  costProfiler [--systems N] [--first-seed S] [--workers W] [--star G2] [--generate-star] [--generate2]\n"
+                   "               [--top N] [--rank Metric] [--corpus file]\n"
+                   "  costProfiler --replay file [--repeat R] [--star G2] [--generate-star]\n"
+                   "Metrics: WallTime, DustSweeps, WastedProtoplanets, PeakDustBands, Collisions, EvaluationRounds\n");
+            return 1;
+        }
+    }
+
+    if (replayPath)
+    {
+        return Replay(replayPath, config, settings.star, repeat);
+    }
+
+    const BatchGenerator batch(workerCount);
+    CostProfiler profiler(top, metric);
+
+    const auto start = std::chrono::steady_clock::now();
+    profiler.run(batch, config, settings);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    printf("%llu systems from seed %llu, %u workers, %.2f s\n\n", static_cast<unsigned long long>(settings.systemCount),
+           static_cast<unsigned long long>(settings.firstSeed), batch.getWorkerCount(), seconds);
+    profiler.report(stdout);
+
+    if (corpusPath)
+    {
+        FILE* fp = nullptr;
+        if (fopen_s(&fp, corpusPath, "wt") || !fp || !profiler.writeCorpus(fp))
+        {
+            fprintf(stderr, "Unable to write '%s'\n", corpusPath);
+            if (fp)
+            {
+                fclose(fp);
+            }
+            return 1;
+        }
+        fclose(fp);
+        printf("\nWrote %zu systems to '%s'\n", profiler.getWorst().size(), corpusPath);
+    }
+
+    return 0;
+}
@@ -0,0 +1,166 @@
+/*****************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Questionable Coding
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************/
+#include <qcSysGen/GenerationCache.h>
+#include <qcSysGen/GenerationService.h>
+#include <qcSysGen/Metrics.h>
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+using namespace qc::SystemGenerator;
+
+// Serves GenerationRequests on a Unix domain socket until interrupted.
+//
+//   generationDaemon --socket path [--workers W] [--interactive-workers I] [--bulk-workers B]
+//                    [--cache dir] [--cache-bytes B] [--metrics-socket path] [--metrics-file path]
+//
+// Requests are answered with SystemRecords (see GenerationService.h for the protocol).  With --cache, fully
+// evaluated systems are shared through a GenerationCache, which other daemons and batch runs may use as well.
+// Interactive requests preempt bulk ones; --interactive-workers and --bulk-workers limit how many workers
+// each class may occupy.  Metrics are served on their own socket, or rewritten to a file every few seconds.
+
+namespace
+{
+
+std::atomic<bool> interrupted{ false };
+
+//----------------------------------------------------------------------------
+void OnSignal(int)
+{
+    interrupted = true;
+}
+
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+    const char* socketPath = nullptr;
+    const char* cachePath = nullptr;
+    const char* metricsSocket = nullptr;
+    const char* metricsFile = nullptr;
+    uint64_t cacheBytes = 256ull << 20;
+    uint32_t workerCount = 0u;
+    uint32_t interactiveLimit = 0u;
+    uint32_t bulkLimit = 0u;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : "";
+
+        if (!strcmp(arg, "--socket")) { socketPath = value; ++i; }
+        else if (!strcmp(arg, "--workers")) { workerCount = static_cast<uint32_t>(strtoul(value, nullptr, 10)); ++i; }
+        else if (!strcmp(arg, "--interactive-workers")) { interactiveLimit = static_cast<uint32_t>(strtoul(value, nullptr, 10)); ++i; }
+        else if (!strcmp(arg, "--bulk-workers")) { bulkLimit = static_cast<uint32_t>(strtoul(value, nullptr, 10)); ++i; }
+        else if (!strcmp(arg, "--cache")) { cachePath = value; ++i; }
+        else if (!strcmp(arg, "--cache-bytes")) { cacheBytes = strtoull(value, nullptr, 10); ++i; }
+        else if (!strcmp(arg, "--metrics-socket")) { metricsSocket = value; ++i; }
+        else if (!strcmp(arg, "--metrics-file")) { metricsFile = value; ++i; }
+        else
+        {
+            fprintf(stderr, "Unknown option '%s'\n", arg);
+            return 1;
+        }
+    }
+
+    if (!socketPath)
+    {
+        fprintf(stderr, "usage: generationDaemon --socket path [--workers W] [--interactive-workers I] [--bulk-workers B] [--cache dir] [--cache-bytes B] [--metrics-socket path] [--metrics-file path]\n");
+        return 1;
+    }
+
+    MetricsRegistry registry;
+    std::unique_ptr<GenerationMetrics> metrics;
+    if (metricsSocket || metricsFile)
+    {
+        metrics.reset(new GenerationMetrics(registry));
+        if (metricsSocket && !registry.serve(metricsSocket))
+        {
+            fprintf(stderr, "Unable to serve metrics on '%s'\n", metricsSocket);
+            return 1;
+        }
+    }
+
+    GenerationCache cache;
+    if (cachePath)
+    {
+        if (!cache.open(cachePath, cacheBytes))
+        {
+            fprintf(stderr, "Unable to open the cache in '%s'\n", cachePath);
+            return 1;
+        }
+        cache.setMetrics(metrics.get());
+    }
+
+    GenerationServer server(workerCount);
+    server.setCache(cachePath ? &cache : nullptr);
+    server.setMetrics(metrics.get());
+    if (interactiveLimit > 0u)
+    {
+        server.setConcurrencyLimit(RequestPriority::Interactive, interactiveLimit);
+    }
+    if (bulkLimit > 0u)
+    {
+        server.setConcurrencyLimit(RequestPriority::Bulk, bulkLimit);
+    }
+    if (!server.start(socketPath))
+    {
+        fprintf(stderr, "Unable to listen on '%s'\n", socketPath);
+        return 1;
+    }
+
+    signal(SIGINT, OnSignal);
+    signal(SIGTERM, OnSignal);
+    printf("Serving on '%s' with %u workers\n", socketPath, server.getWorkerCount());
+    fflush(stdout);
+
+    uint32_t ticks = 0u;
+    while (!interrupted)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        if (metricsFile && ++ticks % 50u == 0u)
+        {
+            registry.writeFile(metricsFile);
+        }
+    }
+
+    server.stop();
+    if (metricsFile)
+    {
+        registry.writeFile(metricsFile);
+    }
+
+    printf("%llu requests, %llu shared, %llu preemptions\n", static_cast<unsigned long long>(server.getRequestCount()),
+           static_cast<unsigned long long>(server.getSharedCount()), static_cast<unsigned long long>(server.getPreemptionCount()));
+
+    return 0;
+}
@@ -0,0 +1,138 @@
+/*****************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Questionable Coding
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************/
+#pragma once
+
+#include <cstdint>
+#include <stdio.h>
+#include <vector>
+
+namespace qc
+{
+
+namespace SystemGenerator
+{
+
+/// @brief The kinds of event recorded in an AccretionLog.
+///
+/// The meaning of AccretionEvent::detail and AccretionEvent::value depends on the type.
+enum class AccretionEventType : uint32_t
+{
+    SystemBegin, //!< Accretion started.  value: stellar mass, stellar luminosity, dust zone inner and outer edge.  detail: number of protoplanet seeds.
+    ProtoplanetInjected, //!< A protoplanet starts sweeping.  value: sma, eccentricity, mass, critical mass.  A ProtoplanetInjected right after a Collision is the merged body.
+    DustCollected, //!< One sweep of the dust bands.  value: mass collected, gas collected, inner and outer effect limit.  detail: sweep number (0-based).
+    DustLanesUpdated, //!< A protoplanet cleared its lane.  value: inner and outer effect limit, mass, critical mass.  detail: bands split (low 16 bits) and merged (high 16 bits).
+    Collision, //!< A protoplanet collided with a planet.  value: planet sma, planet mass, merged sma, merged mass.
+    PlanetCommitted, //!< A protoplanet became a planet.  value: sma, eccentricity, dust mass, gas mass.
+    SystemEnd, //!< Accretion finished.  detail: planet count.  value: protoplanet count.
+};
+
+/// @brief Number of AccretionEventType values.
+static constexpr uint32_t AccretionEventTypeCount = 7u;
+
+/// @brief Returns the name of an AccretionEventType.
+/// @param type The event type.
+/// @return The name, or "Unknown".
+const char* AccretionEventTypeName(AccretionEventType type);
+
+/// @brief A fixed-size accretion event.  Masses are in Solar masses, distances in AU.
+struct AccretionEvent
+{
+    AccretionEventType type; //!< The event type.
+    uint32_t detail; //!< Type-specific integer.
+    double value[4]; //!< Type-specific values.
+};
+
+/// @brief Records the accretion events of one system.
+///
+/// Attach a log with Generator::setAccretionLog().  Every accretion the Generator runs afterwards
+/// clears the log and records its events into it, so a log always describes the last system.  The
+/// event buffer keeps its capacity between systems, and a Generator without a log only pays a
+/// null-pointer test per event, so a log can be left attached for sampled seeds in production runs
+/// (see BatchSettings::accretionLogInterval).
+///
+/// Logs are written as a small header followed by the raw events.  Several logs may be written to
+/// the same file one after the other.
+class AccretionLog
+{
+    public:
+
+    AccretionLog() { }
+    ~AccretionLog() { }
+
+    /// @brief Clear the log and start recording a system.
+    /// @param seed_ The seed of the system.
+    void begin(uint64_t seed_)
+    {
+        seed = seed_;
+        events.clear();
+    }
+
+    /// @brief Remove all events.
+    void clear()
+    {
+        seed = 0u;
+        events.clear();
+    }
+
+    /// @brief Returns the recorded events, in order.
+    /// @return The events.
+    const std::vector<AccretionEvent>& getEvents() const { return events; }
+
+    /// @brief Returns the seed of the recorded system.
+    /// @return The seed.
+    uint64_t getSeed() const { return seed; }
+
+    /// @brief Read a log written by write().
+    /// @param fp The stream.
+    /// @return true on success, false at the end of the stream, if the data is not a log, or if the log is truncated.
+    bool read(FILE* fp);
+
+    /// @brief Append an event.
+    /// @param type The event type.
+    /// @param detail The type-specific integer.
+    /// @param a The first value.
+    /// @param b The second value.
+    /// @param c The third value.
+    /// @param d The fourth value.
+    void record(AccretionEventType type, uint32_t detail, double a, double b = 0.0, double c = 0.0, double d = 0.0)
+    {
+        const AccretionEvent e = { type, detail, { a, b, c, d } };
+        events.emplace_back(e);
+    }
+
+    /// @brief Write the log.
+    /// @param fp The stream.
+    /// @return true on success.
+    bool write(FILE* fp) const;
+
+    private:
+
+    uint64_t seed = 0u; //!< The seed of the recorded system.
+
+    std::vector<AccretionEvent> events; //!< The recorded events.
+};
+
+}
+}
@@ -0,0 +1,222 @@
+/*****************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Questionable Coding
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************/
+#pragma once
+
+#include "Config.h"
+#include "Star.h"
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace qc
+{
+
+namespace SystemGenerator
+{
+
+class Generator;
+class PlanetFilter;
+class SolarSystem;
+
+/// @brief The inputs an AdaptiveSearch may steer.
+///
+/// The search controls the subtype and age of the star and the placement of `seedCount` protoplanet
+/// seeds.  The class of the star is fixed.
+struct SearchSpace
+{
+    /// @brief The class of the star.
+    StarClassification starClass = StarClassification::G_V;
+
+    /// @brief The lowest subtype the search may use, [0, 9].
+    int32_t minSubtype = 0;
+
+    /// @brief The highest subtype the search may use, [minSubtype, 9].
+    int32_t maxSubtype = 9;
+
+    /// @brief The number of protoplanet seeds placed by the search.  The rest of the dust is accreted normally.
+    uint32_t seedCount = 3u;
+
+    /// @brief The highest eccentricity the search may give a seed, (0, 0.9].
+    float maxEccentricity = 0.25f;
+};
+
+/// @brief Settings for AdaptiveSearch::run().
+struct AdaptiveSearchSettings
+{
+    /// @brief The Generator seed of the first sample.  Sample `i` uses `firstSeed + i`.
+    uint64_t firstSeed = 0u;
+
+    /// @brief Seeds the random numbers used to draw the samples.
+    uint64_t searchSeed = 1u;
+
+    /// @brief The number of rounds.  The proposal distribution is updated after each round.
+    uint32_t roundCount = 20u;
+
+    /// @brief The number of systems generated each round.
+    uint32_t samplesPerRound = 1000u;
+
+    /// @brief The fraction of each round's best samples the proposal distribution is fitted to.
+    float eliteFraction = 0.1f;
+
+    /// @brief How far the proposal distribution moves towards the elite samples each round, (0, 1].
+    float smoothing = 0.7f;
+
+    /// @brief The smallest standard deviation of each input, as a fraction of its range.  Keeps the
+    /// search from collapsing onto a single point.
+    float minSigma = 0.02f;
+
+    /// @brief The smallest probability of each star subtype, as a fraction of the uniform probability.
+    float minSubtypeWeight = 0.05f;
+
+    /// @brief When false, every round draws from the initial, uniform distribution.  This is the baseline
+    /// the adaptive search is compared against.
+    bool adaptive = true;
+
+    /// @brief When true, Generator::generate2() is used instead of Generator::generate().
+    bool useGenerate2 = false;
+};
+
+/// @brief The inputs of one system generated by an AdaptiveSearch.
+///
+/// Every input that was drawn by the search is recorded as a value, so the system can be regenerated
+/// exactly with AdaptiveSearch::regenerate() and the Config that was used for the search.
+struct SearchSample
+{
+    uint64_t seed; //!< The Generator seed.
+    StarClassification starClass; //!< The class of the star.
+    int32_t subtype; //!< The subtype of the star.
+    double age; //!< The age of the star, in years.
+    std::vector<ProtoplanetSeed> seeds; //!< The protoplanet seeds, used as Config::protoplanetSeeds.
+};
+
+/// @brief A system with at least one planet that matches the target of an AdaptiveSearch.
+struct SearchHit
+{
+    SearchSample sample; //!< The inputs of the system.
+    uint32_t round; //!< The round the system was generated in.
+    uint32_t planetOrdinal; //!< 1-based position of the best matching planet in SolarSystem::getPlanets().
+    float earthSimilarityIndex; //!< The ESI of that planet.
+};
+
+/// @brief Statistics of one round of an AdaptiveSearch.
+struct SearchRound
+{
+    uint64_t samples; //!< Systems generated.
+    uint64_t hits; //!< Systems with a matching planet.
+    double seconds; //!< Time the workers spent generating the round's systems, summed over the workers.
+    float eliteScore; //!< The lowest score among the elite samples.
+};
+
+/// @brief Searches for systems that contain a planet matching a PlanetFilter by steering the inputs
+/// of the generator.
+///
+/// Scanning seeds with a fixed Config wastes almost every system when the target is rare.  Instead,
+/// the search draws the star subtype, the star's age and the protoplanet seeds from a proposal
+/// distribution, and uses the cross-entropy method to move that distribution towards the inputs that
+/// produce the best systems.  Each round, the samples are ranked (systems with a hit first, then by the
+/// best ESI of their planets), and the distribution is refitted to the top `eliteFraction` of them: a
+/// categorical distribution over the subtypes, and a truncated normal distribution over each of the
+/// age, the log of the semi-major axis (within the protoplanet zone) and the eccentricity of each seed.
+/// The first round, and every round when AdaptiveSearchSettings::adaptive is false, draws uniformly
+/// from the SearchSpace.
+///
+/// The samples of a round are drawn before any of them are generated, and the distribution is only
+/// updated between rounds, so the results do not depend on the number of workers.
+///
+/// The hit rate per second of generation time (getHitsPerSecond()) is directly comparable between an
+/// adaptive search and a uniform one.
+class AdaptiveSearch
+{
+    public:
+
+    /// @brief Constructor.
+    /// @param space_ The inputs to search.
+    /// @param workerCount_ The number of worker threads to use.  If 0, the hardware concurrency is used.
+    explicit AdaptiveSearch(const SearchSpace& space_, uint32_t workerCount_ = 0u);
+    ~AdaptiveSearch() { }
+
+    /// @brief Returns the systems with a matching planet found by the last run(), in the order they were generated.
+    /// @return The hits.
+    const std::vector<SearchHit>& getHits() const { return hits; }
+
+    /// @brief Returns the number of hits per second of generation time during the last run().
+    /// @return Hits per second, summed over the workers.
+    double getHitsPerSecond() const;
+
+    /// @brief Returns the statistics of each round of the last run().
+    /// @return The rounds.
+    const std::vector<SearchRound>& getRounds() const { return rounds; }
+
+    /// @brief Returns the number of worker threads this search uses.
+    /// @return The worker count, always at least 1.
+    uint32_t getWorkerCount() const { return workerCount; }
+
+    /// @brief Regenerate the system described by `sample`.
+    ///
+    /// This is exactly how run() generates each system.
+    /// @param sample The inputs of the system.
+    /// @param config The Config used for the search.  Its star and seed settings are replaced by the sample's.
+    /// @param useGenerate2 When true, Generator::generate2() is used instead of Generator::generate().
+    /// @param generator The Generator.
+    /// @param system The SolarSystem that will contain the results.
+    static void regenerate(const SearchSample& sample, const Config& config, bool useGenerate2, Generator& generator, SolarSystem& system);
+
+    /// @brief Search for systems with a planet matching `target`.
+    ///
+    /// Any previous results are discarded.
+    /// @param config The Config used for every system.  Config::generateStar and Config::protoplanetSeeds
+    /// are overridden by each sample.
+    /// @param target The filter a planet must match.  It must be compiled.
+    /// @param settings The search settings.
+    void run(const Config& config, const PlanetFilter& target, const AdaptiveSearchSettings& settings);
+
+    private:
+
+    /// @brief The proposal distribution.  Every continuous input is normalized to [0, 1].
+    struct Proposal
+    {
+        std::vector<double> subtypeWeight; //!< Probability of each subtype in [minSubtype, maxSubtype].
+        std::vector<double> mean; //!< Mean of each continuous input.
+        std::vector<double> sigma; //!< Standard deviation of each continuous input.
+    };
+
+    SearchSpace space; //!< The inputs to search.
+    uint32_t workerCount; //!< Number of worker threads.
+
+    std::vector<Star> stars; //!< An evaluated star for each subtype in the space.
+
+    std::vector<SearchHit> hits; //!< Hits of the last run.
+    std::vector<SearchRound> rounds; //!< Rounds of the last run.
+
+    // Draw one sample from the proposal.  The normalized inputs are stored in `inputs`.
+    void draw(const Proposal& proposal, bool uniform, uint64_t seed, std::mt19937_64& rng, SearchSample& sample, double* inputs) const;
+
+    // Refit the proposal to the elite samples.
+    void update(Proposal& proposal, const AdaptiveSearchSettings& settings, const std::vector<uint32_t>& elite, const std::vector<SearchSample>& samples, const std::vector<double>& inputs) const;
+};
+
+}
+}
@@ -0,0 +1,208 @@
+/*****************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Questionable Coding
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************/
+#pragma once
+
+#include "Config.h"
+#include "Numa.h"
+#include "Star.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace qc
+{
+
+namespace SystemGenerator
+{
+
+class Generator;
+struct GenerationMetrics;
+class PhaseCounters;
+class RecordWriter;
+class SolarSystem;
+
+/// @brief Describes a range of seeds to be generated by the BatchGenerator.
+///
+/// Each system in the batch is generated from its own seed, `firstSeed + systemIndex`, so any
+/// system in a batch can be regenerated exactly by seeding a Generator with that value and calling
+/// Generator::generate() (or Generator::generate2()) with the same Config and Star.
+struct BatchSettings
+{
+    /// @brief The seed used for the first system of the batch.
+    uint64_t firstSeed = 0u;
+
+    /// @brief The number of systems to generate.
+    uint64_t systemCount = 0u;
+
+    /// @brief The star used for every system when Config::generateStar is false.
+    ///
+    /// Defaults to a G2V.
+    Star star;
+
+    /// @brief When true, Generator::generate2() is used instead of Generator::generate().
+    bool useGenerate2 = false;
+
+    /// @brief When non-zero, the accretion events of every system whose index is a multiple of
+    /// this value are recorded.
+    ///
+    /// The callbacks of a recorded system can read the log with Generator::getAccretionLog(); it
+    /// returns nullptr for the other systems.
+    uint64_t accretionLogInterval = 0u;
+
+    /// @brief When true, the cost of every system is measured.
+    ///
+    /// The callbacks can read it with Generator::getSystemCost().  The wall time covers accretion,
+    /// and evaluation for the SystemCallback; it is only filled in by the time each callback runs.
+    bool profileCosts = false;
+
+    /// @brief When set, every worker opens its own PhaseCounters, and their counts are added to these
+    /// counters when run() returns.
+    ///
+    /// The counters' own hardware events are not used, so they do not need to be open.
+    PhaseCounters* phaseCounters = nullptr;
+
+    /// @brief When set, run() stops early once the flag becomes true.
+    ///
+    /// Workers check the flag before every system, so run() returns once the systems in progress are
+    /// finished.  Systems that were not started are never delivered.
+    const std::atomic<bool>* cancel = nullptr;
+
+    /// @brief When set, the workers update the system counters, phase latencies, planet counts and queue
+    /// depth of these metrics.
+    GenerationMetrics* metrics = nullptr;
+
+    /// @brief When set, every evaluated system is appended to this writer by the worker that generated it,
+    /// before the SystemCallback runs, and every discarded system is skipped.
+    ///
+    /// The worker index is the producer index, so the writer needs at least getWorkerCount() producers.
+    /// Each worker flushes its records when it finishes; the writer stays open for further batches.
+    RecordWriter* output = nullptr;
+};
+
+/// @brief Generates a large number of solar systems across a pool of worker threads.
+///
+/// Each worker owns its own Generator and SolarSystem, so the per-system callback is invoked
+/// concurrently from several threads.  The callback receives the index of the worker that
+/// generated the system, which allows the caller to keep one accumulator per worker and merge
+/// them after run() returns, without any locking on the hot path.
+///
+/// Workers claim systems in small blocks, so the order in which systems are delivered is not
+/// deterministic, but the contents of each system are.
+///
+/// When constructed as NUMA aware, the workers are spread over the NUMA nodes in proportion to the
+/// number of processors of each node, and every worker is pinned to its node before it creates its
+/// Generator and SolarSystem, so the planets, dust bands and anything the callbacks allocate live in
+/// that node's memory.  The seed range is split between the nodes, and a worker only takes systems
+/// from another node's share once its own is exhausted.  Per-worker results should be combined with
+/// runOnNodes(), which merges each node's workers on that node, leaving only the final hand-off of
+/// one result per node to cross between sockets.
+class BatchGenerator
+{
+    public:
+
+    /// @brief Callback invoked once per generated system.
+    ///
+    /// Parameters are: the worker index [0, getWorkerCount()), the seed used for the system,
+    /// the index of the system within the batch, the fully-evaluated SolarSystem, and the
+    /// Generator that produced it (for Generator::getProtoplanetCount(), etc).
+    typedef std::function<void(uint32_t, uint64_t, uint64_t, const SolarSystem&, const Generator&)> SystemCallback;
+
+    /// @brief Callback invoked once per system after accretion, before the planets are evaluated.
+    ///
+    /// The parameters are the same as SystemCallback, but the planets only contain their orbital
+    /// elements and masses (see Generator::accrete()).  Return false to discard the system without
+    /// evaluating it; the SystemCallback is not invoked for discarded systems.
+    typedef std::function<bool(uint32_t, uint64_t, uint64_t, const SolarSystem&, const Generator&)> FilterCallback;
+
+    /// @brief Callback invoked once per NUMA node by runOnNodes().
+    ///
+    /// The parameter is the node index [0, getNodeCount()).
+    typedef std::function<void(uint32_t)> NodeCallback;
+
+    /// @brief Constructor.
+    /// @param workerCount_ The number of worker threads to use.  If 0, the hardware concurrency
+    /// is used.
+    /// @param numaAware_ When true, workers are distributed over and pinned to the NUMA nodes.
+    explicit BatchGenerator(uint32_t workerCount_ = 0u, bool numaAware_ = false);
+    ~BatchGenerator() { }
+
+    /// @brief Returns the number of NUMA nodes the workers are distributed over.
+    /// @return The node count.  Always 1 unless the BatchGenerator is NUMA aware.
+    uint32_t getNodeCount() const { return static_cast<uint32_t>(nodes.size()); }
+
+    /// @brief Returns the number of worker threads this BatchGenerator uses.
+    /// @return The worker count, always at least 1.
+    uint32_t getWorkerCount() const { return workerCount; }
+
+    /// @brief Returns the node a worker runs on.
+    /// @param worker The worker index [0, getWorkerCount()).
+    /// @return The node index [0, getNodeCount()).
+    uint32_t getWorkerNode(uint32_t worker) const { return workerNode[worker]; }
+
+    /// @brief Returns true if the workers are pinned to NUMA nodes.
+    bool isNumaAware() const { return numaAware; }
+
+    /// @brief Generate every system described by `settings`.
+    ///
+    /// This method blocks until all of the systems have been generated and delivered to `callback`.
+    /// @param config The Config used for every system.
+    /// @param settings The seed range and star for the batch.
+    /// @param callback The callback that receives each system.
+    void run(const Config& config, const BatchSettings& settings, const SystemCallback& callback) const
+    {
+        run(config, settings, FilterCallback(), callback);
+    }
+
+    /// @brief Generate every system described by `settings`, skipping the evaluation of any system
+    /// that `filter` rejects.
+    ///
+    /// Discarding a system before evaluation does not affect any other system, and a system that
+    /// passes the filter is identical to the one Generator::generate() produces for the same seed.
+    /// @param config The Config used for every system.
+    /// @param settings The seed range and star for the batch.
+    /// @param filter The pre-evaluation filter.  May be empty, in which case every system is evaluated.
+    /// @param callback The callback that receives each evaluated system.
+    void run(const Config& config, const BatchSettings& settings, const FilterCallback& filter, const SystemCallback& callback) const;
+
+    /// @brief Invoke `callback` once for every node, concurrently, each on a thread pinned to that node.
+    ///
+    /// This method blocks until every invocation has returned.
+    /// @param callback The callback.
+    void runOnNodes(const NodeCallback& callback) const;
+
+    private:
+
+    uint32_t workerCount; //!< Number of worker threads.
+    bool numaAware; //!< Whether workers are pinned to their nodes.
+
+    std::vector<NumaNode> nodes; //!< The nodes that have at least one worker.
+    std::vector<uint32_t> workerNode; //!< Node index of each worker.
+    std::vector<uint32_t> nodeWorkerCount; //!< Number of workers on each node.
+};
+
+}
+}
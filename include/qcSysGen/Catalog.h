@@ -0,0 +1,126 @@
+/*****************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Questionable Coding
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************/
+#pragma once
+
+#include "CatalogIndex.h"
+#include "PlanetColumns.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace qc
+{
+
+namespace SystemGenerator
+{
+
+class SolarSystem;
+
+/// @brief A row of the Catalog's system table.
+struct CatalogSystem
+{
+    uint64_t seed; //!< The seed used to generate the system.
+    uint64_t systemIndex; //!< Index of the system within its batch.
+    uint32_t firstPlanet; //!< Row of the system's first planet in the planet columns.
+    uint32_t planetCount; //!< Number of planets in the system.
+    uint8_t starClass; //!< StarClassification of the central star.
+    uint8_t starSubtype; //!< Numeric subtype of the central star (the 2 in G2V).
+    uint16_t reserved; //!< Padding.  Always 0.
+};
+
+/// @brief A stored collection of generated solar systems.
+///
+/// The catalog keeps a table of systems plus the queryable attributes of each planet in PlanetColumns.
+/// It does not keep the full SolarSystem; any system can be regenerated exactly from its seed.
+///
+/// The catalog's CatalogIndex is updated every time systems are appended, so queries never need
+/// to scan the whole catalog.  Appending is not thread-safe.  With the BatchGenerator, either keep
+/// one Catalog per worker and append() them together afterwards, or serialize the appends.
+class Catalog
+{
+    public:
+
+    Catalog() { }
+    ~Catalog() { }
+
+    /// @brief Append a generated system.
+    /// @param seed The seed the system was generated from.
+    /// @param systemIndex The index of the system within its batch.
+    /// @param system The evaluated system.
+    void append(uint64_t seed, uint64_t systemIndex, const SolarSystem& system);
+
+    /// @brief Append the contents of another catalog.
+    /// @param rhs The catalog to append.
+    void append(const Catalog& rhs);
+
+    /// @brief Remove every system.
+    void clear();
+
+    /// @brief Find the planets that match a query.
+    /// @param query The query.
+    /// @param rows Receives the matching planet rows, in ascending order.
+    void find(const CatalogQuery& query, std::vector<uint32_t>& rows) const { index.find(planets, query, rows); }
+
+    /// @brief Find the systems with at least one planet that matches a query.
+    /// @param query The query.
+    /// @param rows Receives the matching system rows, in ascending order.
+    void findSystems(const CatalogQuery& query, std::vector<uint32_t>& rows) const;
+
+    /// @brief Returns the catalog's index.
+    /// @return The index.
+    const CatalogIndex& getIndex() const { return index; }
+
+    /// @brief Returns the planet columns.
+    /// @return The planets.
+    const PlanetColumns& getPlanets() const { return planets; }
+
+    /// @brief Returns the system table.
+    /// @return The systems.
+    const std::vector<CatalogSystem>& getSystems() const { return systems; }
+
+    /// @brief Replace the contents of the catalog with a file written by save().
+    ///
+    /// The index is rebuilt after the file is read.  A file that is truncated, or that holds out-of-range
+    /// enumeration values or system rows, is rejected.
+    /// @param filename The file to read.
+    /// @return true on success.  On failure, the catalog is empty.
+    bool load(const char* filename);
+
+    /// @brief Write the catalog to a file.
+    ///
+    /// The file stores the system table followed by each of the planet columns, in native byte order.
+    /// @param filename The file to write.
+    /// @return true on success.
+    bool save(const char* filename) const;
+
+    private:
+
+    std::vector<CatalogSystem> systems; //!< The system table.
+    PlanetColumns planets; //!< The planets of every system, in system order.
+    CatalogIndex index; //!< Secondary indexes over `planets`.
+};
+
+}
+}
@@ -0,0 +1,233 @@
+/*****************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Questionable Coding
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************/
+#pragma once
+
+#include "PlanetColumns.h"
+
+#include <cfloat>
+#include <cstdint>
+#include <vector>
+
+namespace qc
+{
+
+namespace SystemGenerator
+{
+
+/// @brief A growable bitmap with one bit per catalog row.
+class Bitmap
+{
+    public:
+
+    /// @brief Returns the number of set bits.
+    /// @return The population count.
+    size_t count() const;
+
+    /// @brief Intersect this bitmap with another one.
+    /// @param rhs The other bitmap.  Bits beyond its size are treated as clear.
+    void intersect(const Bitmap& rhs);
+
+    /// @brief Grow (or shrink) the bitmap.  New bits are clear.
+    /// @param bitCount_ The new number of bits.
+    void resize(size_t bitCount_);
+
+    /// @brief Set a bit.
+    /// @param index The bit to set.  Must be less than size().
+    void set(size_t index) { word[index >> 6u] |= (1ull << (index & 63u)); }
+
+    /// @brief Set every bit.
+    void setAll();
+
+    /// @brief Returns the number of bits in the bitmap.
+    /// @return The bit count.
+    size_t size() const { return bitCount; }
+
+    /// @brief Test a bit.
+    /// @param index The bit to test.  Must be less than size().
+    /// @return true if the bit is set.
+    bool test(size_t index) const { return (word[index >> 6u] & (1ull << (index & 63u))) != 0u; }
+
+    /// @brief Merge another bitmap into this one.
+    /// @param rhs The other bitmap.  It may not be larger than this one.
+    void unite(const Bitmap& rhs);
+
+    /// @brief Direct access to the 64-bit words that make up the bitmap.
+    /// @return The words.  Bits beyond size() are always clear.
+    const std::vector<uint64_t>& getWords() const { return word; }
+
+    private:
+
+    std::vector<uint64_t> word; //!< The bits, 64 per word.
+    size_t bitCount = 0u; //!< Number of valid bits.
+};
+
+/// @brief Minimum and maximum of a float column over fixed-size blocks of rows.
+class ZoneMap
+{
+    public:
+
+    /// @brief Number of rows covered by each block.
+    static constexpr uint32_t BlockSize = 1024u;
+
+    /// @brief Add the next row's value.
+    /// @param value The value.
+    void append(float value);
+
+    /// @brief Remove all rows.
+    void clear();
+
+    /// @brief Returns the number of blocks.
+    /// @return The block count.
+    size_t getBlockCount() const { return minimum.size(); }
+
+    /// @brief Returns the smallest value in a block.
+    /// @param block The block.
+    /// @return The minimum.
+    float getMinimum(size_t block) const { return minimum[block]; }
+
+    /// @brief Returns the largest value in a block.
+    /// @param block The block.
+    /// @return The maximum.
+    float getMaximum(size_t block) const { return maximum[block]; }
+
+    private:
+
+    std::vector<float> minimum; //!< Per-block minimum.
+    std::vector<float> maximum; //!< Per-block maximum.
+    size_t rowCount = 0u; //!< Number of rows added.
+};
+
+/// @brief An inclusive range of values used in a CatalogQuery.  The default range matches everything.
+struct CatalogRange
+{
+    float lower = -FLT_MAX; //!< Smallest matching value.
+    float upper = FLT_MAX; //!< Largest matching value.
+
+    /// @brief Returns true if the range excludes any value.
+    /// @return true if the range is bounded.
+    bool isBounded() const { return lower > -FLT_MAX || upper < FLT_MAX; }
+
+    /// @brief Returns true if `value` is in the range.
+    /// @param value The value to test.
+    /// @return true if the value matches.
+    bool contains(float value) const { return value >= lower && value <= upper; }
+};
+
+/// @brief Describes the planets to find in a Catalog.
+///
+/// The masks contain one bit per enumeration value, (1 << value).  A planet matches the query when
+/// its value is in each non-zero mask and inside each of the ranges.
+struct CatalogQuery
+{
+    uint32_t starClasses = 0u; //!< Mask of StarClassification values.  0 matches any star.
+    uint32_t planetTypes = 0u; //!< Mask of PlanetType values.  0 matches any planet type.
+    uint32_t orbitalZones = 0u; //!< Mask of OrbitalZone values.  0 matches any zone.
+
+    CatalogRange earthSimilarityIndex; //!< Range of the ESI.
+    CatalogRange mass; //!< Range of the mass, in Earth masses.
+    CatalogRange surfaceTemperature; //!< Range of the mean surface temperature, in Kelvin.
+
+    /// @brief Add a star classification to the query.
+    /// @param c The classification.
+    /// @return This query.
+    CatalogQuery& add(StarClassification c) { starClasses |= (1u << static_cast<uint32_t>(c)); return *this; }
+
+    /// @brief Add a planet type to the query.
+    /// @param t The planet type.
+    /// @return This query.
+    CatalogQuery& add(PlanetType t) { planetTypes |= (1u << static_cast<uint32_t>(t)); return *this; }
+
+    /// @brief Add an orbital zone to the query.
+    /// @param z The orbital zone.
+    /// @return This query.
+    CatalogQuery& add(OrbitalZone z) { orbitalZones |= (1u << static_cast<uint32_t>(z)); return *this; }
+};
+
+/// @brief Secondary indexes over the planet rows of a Catalog.
+///
+/// The enumerated attributes (star classification, planet type and orbital zone) are indexed with
+/// one bitmap per value.  The ESI, mass and temperature are indexed with zone maps.  Because the
+/// rows of a catalog are only ever appended, both kinds of index are maintained incrementally with
+/// append().
+///
+/// A lookup intersects the bitmaps of the requested values, skips every block whose zone maps are
+/// disjoint from the requested ranges, and accepts blocks that fall entirely inside the ranges
+/// without reading them.  Only the remaining rows of partially-matching blocks are read from the
+/// columns.
+class CatalogIndex
+{
+    public:
+
+    /// @brief Index the rows of `planets` that were added since the last call.
+    /// @param planets The columns being indexed.  Rows may only be appended between calls.
+    void append(const PlanetColumns& planets);
+
+    /// @brief Remove all rows from the index.
+    void clear();
+
+    /// @brief Find the planets that match a query.
+    /// @param planets The indexed columns.  Any rows that have not been indexed are ignored.
+    /// @param query The query.
+    /// @param rows Receives the matching rows, in ascending order.
+    void find(const PlanetColumns& planets, const CatalogQuery& query, std::vector<uint32_t>& rows) const;
+
+    /// @brief Returns the number of rows that have been indexed.
+    /// @return The row count.
+    size_t getRowCount() const { return rowCount; }
+
+    /// @brief Returns the bitmap of planets orbiting a class of star.
+    /// @param c The star classification.
+    /// @return The bitmap.
+    const Bitmap& getBitmap(StarClassification c) const { return starClass[static_cast<uint32_t>(c)]; }
+
+    /// @brief Returns the bitmap of planets of a type.
+    /// @param t The planet type.
+    /// @return The bitmap.
+    const Bitmap& getBitmap(PlanetType t) const { return planetType[static_cast<uint32_t>(t)]; }
+
+    /// @brief Returns the bitmap of planets in an orbital zone.
+    /// @param z The orbital zone.
+    /// @return The bitmap.
+    const Bitmap& getBitmap(OrbitalZone z) const { return orbitalZone[static_cast<uint32_t>(z)]; }
+
+    private:
+
+    size_t rowCount = 0u; //!< Number of rows indexed.
+
+    Bitmap starClass[StarClassificationCount]; //!< Bitmap per StarClassification.
+    Bitmap planetType[PlanetTypeCount]; //!< Bitmap per PlanetType.
+    Bitmap orbitalZone[OrbitalZoneCount]; //!< Bitmap per OrbitalZone.
+
+    ZoneMap earthSimilarityIndex; //!< Zone map of the ESI column.
+    ZoneMap mass; //!< Zone map of the mass column.
+    ZoneMap surfaceTemperature; //!< Zone map of the surface temperature column.
+
+    // Build the candidate bitmap for the enumerated terms of a query.  Returns false if the query
+    // has no enumerated terms, in which case every row is a candidate.
+    bool selectCandidates(const CatalogQuery& query, Bitmap& candidates) const;
+};
+
+}
+}
@@ -27,8 +27,12 @@
 #include <vector>
 
 
-// When defined, printfs may be inserted in the code for debug purposes.
+// When defined, printfs may be inserted in the code for debug purposes.  Define QC_NO_DEBUG_PRINTF
+// in the project settings to compile all of the verbose logging out of the library, in which case
+// Config::verboseLogging has no effect.
+#if !defined(QC_NO_DEBUG_PRINTF)
 #define ALLOW_DEBUG_PRINTF
+#endif
 
 namespace qc
 {
@@ -36,6 +40,8 @@ namespace qc
 namespace SystemGenerator
 {
 
+class SeedStrategy;
+
 /// @brief Represents a seed value for a protoplanet during system generation.
 ///
 /// Higher eccentricity values are able to collect more dust, leading to larger planets.
@@ -82,7 +88,7 @@ struct ProtoplanetSeed
 /// spawns in has already been cleared of dust - in that case, it most likely will be absorbed by an existing
 /// planet.
 /// 
-/// Note that if this vector is not empty, it takes priority over `generateBodeSeeds`.
+/// Note that if this vector is not empty, it takes priority over `seedStrategy` and `generateBodeSeeds`.
 struct Config
 {
     //--- Constants used to configure the generator.
@@ -152,7 +158,7 @@ struct Config
     /// seeds will be correspond to the other entries found using the Blagg modification of Bode's Law.
     /// All elements after the first will be shuffled to allow for less deterministic results.
     /// 
-    /// If the protoplanetSeeds vector is not empty, it will override this switch.
+    /// If the protoplanetSeeds vector is not empty, or seedStrategy is set, it will override this switch.
     bool generateBodeSeeds = false;
 
     /// @brief When true, moons may be synthesized around each planet using a Bode Law progression.
@@ -185,6 +191,12 @@ struct Config
     /// When this vector is not empty, it will determine the placement of the initial protoplanets that
     /// are generated for the solar system.
     std::vector<ProtoplanetSeed> protoplanetSeeds;
+
+    /// @brief An optional strategy that places the initial protoplanets when protoplanetSeeds is empty.
+    ///
+    /// When set, it takes priority over `generateBodeSeeds`.  The strategy is not owned by the Config, and
+    /// must outlive every generation that uses it.  See SeedStrategy.
+    const SeedStrategy* seedStrategy = nullptr;
 };
 
 }
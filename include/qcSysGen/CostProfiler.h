@@ -0,0 +1,187 @@
+/*****************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Questionable Coding
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************/
+#pragma once
+
+#include "Batch.h"
+#include "GenerationCache.h"
+#include "Statistics.h"
+
+#include <cstdint>
+#include <stdio.h>
+#include <vector>
+
+namespace qc
+{
+
+namespace SystemGenerator
+{
+
+/// @brief The cost of generating one system.
+///
+/// Attach a SystemCost with Generator::setSystemCost().  Every accretion the Generator runs afterwards
+/// resets it and counts its work into it, and SolarSystem::evaluate() adds the evaluation rounds of the
+/// planets.  The wall time is not measured by the Generator: BatchGenerator fills in `seconds` when
+/// BatchSettings::profileCosts is set.  A Generator without a SystemCost only pays a null-pointer test
+/// at each counting site.
+struct SystemCost
+{
+    uint64_t seed = 0u; //!< The seed of the system.
+    uint64_t systemIndex = 0u; //!< Index of the system within the batch.
+    double seconds = 0.0; //!< Wall time of accretion and evaluation.
+    uint32_t dustSweeps = 0u; //!< Number of passes over the dust bands (accreteDust iterations).
+    uint32_t protoplanets = 0u; //!< Number of protoplanets injected, not counting the bodies formed by collisions.
+    uint32_t wastedProtoplanets = 0u; //!< Number of injected protoplanets that did not collect any dust.
+    uint32_t dustBands = 0u; //!< Number of dust bands at the end of accretion.
+    uint32_t peakDustBands = 0u; //!< Largest number of dust bands during accretion.
+    uint32_t collisions = 0u; //!< Number of protoplanets that merged with a planet.
+    uint32_t evaluationRounds = 0u; //!< Number of surface condition updates run while evaluating the planets.
+    uint32_t planetCount = 0u; //!< Number of planets in the system.
+
+    /// @brief Reset the counters and start counting a system.
+    /// @param seed_ The seed of the system.
+    void begin(uint64_t seed_)
+    {
+        const uint64_t systemIndex_ = systemIndex;
+        *this = SystemCost();
+        seed = seed_;
+        systemIndex = systemIndex_;
+        dustBands = peakDustBands = 1u;
+    }
+
+    /// @brief Returns the number of injected protoplanets that collected dust.
+    /// @return The consumed protoplanet count.
+    uint32_t getConsumedProtoplanets() const { return protoplanets - wastedProtoplanets; }
+};
+
+/// @brief The measures a CostProfiler can rank systems by.
+///
+/// Every measure except WallTime only depends on the seed, Config and Star, so a corpus ranked by one of
+/// them is the same on every machine.
+enum class CostMetric : uint32_t
+{
+    WallTime, //!< SystemCost::seconds.
+    DustSweeps, //!< SystemCost::dustSweeps.
+    WastedProtoplanets, //!< SystemCost::wastedProtoplanets.
+    PeakDustBands, //!< SystemCost::peakDustBands.
+    Collisions, //!< SystemCost::collisions.
+    EvaluationRounds, //!< SystemCost::evaluationRounds.
+};
+
+/// @brief Number of CostMetric values.
+static constexpr uint32_t CostMetricCount = 6u;
+
+/// @brief Returns the value of a measure.
+/// @param cost The cost.
+/// @param metric The measure.
+/// @return The value.
+double GetCostMetric(const SystemCost& cost, CostMetric metric);
+
+/// @brief Returns the name of a CostMetric.
+/// @param metric The measure.
+/// @return The name, or "Unknown".
+const char* CostMetricName(CostMetric metric);
+
+/// @brief One system of a cost corpus: everything needed to regenerate it, and what it cost.
+struct CostCorpusEntry
+{
+    GenerationCacheKey key; //!< Identifies the system.
+    SystemCost cost; //!< The measured cost.
+};
+
+/// @brief Read a corpus written by CostProfiler::writeCorpus().
+/// @param fp The stream.
+/// @param corpus Receives the entries, in the order they were written.
+/// @return true on success, false if the stream is not a corpus or an entry is malformed.
+bool ReadCostCorpus(FILE* fp, std::vector<CostCorpusEntry>& corpus);
+
+/// @brief Profiles the cost of every system of a batch, and keeps the N most expensive ones.
+///
+/// Each worker of the BatchGenerator keeps a bounded heap of its N worst systems, as well as quantile
+/// sketches and moments of every measure, so memory use does not depend on the size of the batch.  The
+/// heaps are merged once the batch completes.
+///
+/// The worst systems can be written as a corpus: a text file with one line per system, holding its seed,
+/// Star, Config fingerprint and library version (see GenerationCacheKey) and its costs.  A corpus is both
+/// a reproduction set for the slow seeds and a benchmark input set.
+class CostProfiler
+{
+    public:
+
+    /// @brief Constructor.
+    /// @param k_ The number of systems to keep.
+    /// @param metric_ The measure the systems are ranked by.
+    explicit CostProfiler(uint32_t k_, CostMetric metric_ = CostMetric::WallTime);
+    ~CostProfiler() { }
+
+    /// @brief Returns the moments of a measure over every system of the last run.
+    /// @param m The measure.
+    /// @return The moments.
+    const RunningMoments& getMoments(CostMetric m) const { return moments[static_cast<uint32_t>(m)]; }
+
+    /// @brief Returns the quantile sketch of a measure over every system of the last run.
+    /// @param m The measure.
+    /// @return The quantile sketch.
+    const QuantileSketch& getQuantiles(CostMetric m) const { return quantiles[static_cast<uint32_t>(m)]; }
+
+    /// @brief Returns the number of systems profiled during the last run.
+    /// @return The system count.
+    uint64_t getSystemCount() const { return moments[0].getCount(); }
+
+    /// @brief Returns the most expensive systems of the last run, most expensive first.
+    /// @return Up to K systems.
+    const std::vector<SystemCost>& getWorst() const { return worst; }
+
+    /// @brief Write the rank table of the worst systems and the quantiles of every measure as text.
+    /// @param fp The output stream.
+    void report(FILE* fp) const;
+
+    /// @brief Profile the systems described by `settings`.
+    ///
+    /// Any previous results are discarded.  BatchSettings::profileCosts is forced on.
+    /// @param batch The BatchGenerator used to generate the systems.
+    /// @param config The Config used for every system.
+    /// @param settings The seed range and star.
+    void run(const BatchGenerator& batch, const Config& config, const BatchSettings& settings);
+
+    /// @brief Write the worst systems of the last run as a corpus.
+    /// @param fp The output stream.
+    /// @return true on success.
+    bool writeCorpus(FILE* fp) const;
+
+    private:
+
+    uint32_t k; //!< Number of systems to keep.
+    CostMetric metric; //!< The measure systems are ranked by.
+
+    GenerationCacheKey key; //!< Key of the last run, with a seed of 0.
+
+    std::vector<RunningMoments> moments; //!< Moments of each measure.
+    std::vector<QuantileSketch> quantiles; //!< Quantile sketch of each measure.
+
+    std::vector<SystemCost> worst; //!< Results of the last run, most expensive first.
+};
+
+}
+}
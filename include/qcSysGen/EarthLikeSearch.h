@@ -0,0 +1,111 @@
+/*****************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Questionable Coding
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************/
+#pragma once
+
+#include "Batch.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace qc
+{
+
+namespace SystemGenerator
+{
+
+/// @brief One of the results of an EarthLikeSearch.
+///
+/// The planet can be regenerated exactly by seeding a Generator with `seed` and generating the
+/// system with the Config and Star that were used for the search.
+struct EarthLikeCandidate
+{
+    uint64_t seed; //!< The seed used to generate the system.
+    uint64_t systemIndex; //!< Index of the system within the batch.
+    uint32_t planetOrdinal; //!< 1-based position of the planet in SolarSystem::getPlanets() (matches the planet's default name).
+    float earthSimilarityIndex; //!< The planet's ESI.
+    float hydrosphere; //!< The planet's hydrosphere percentage, [0, 1].
+    float surfacePressure; //!< The planet's surface pressure, in millibars.
+};
+
+/// @brief Ranks two candidates.
+///
+/// Candidates are ranked by ESI.  Ties are broken by the hydrosphere closest to Earth's, then the
+/// surface pressure closest to Earth's, and finally by seed and planet ordinal so the ranking is
+/// a total order.
+/// @param lhs The first candidate.
+/// @param rhs The second candidate.
+/// @return true if `lhs` ranks ahead of `rhs`.
+bool IsBetterCandidate(const EarthLikeCandidate& lhs, const EarthLikeCandidate& rhs);
+
+/// @brief Searches a range of seeds for the K most Earth-like planets.
+///
+/// Each worker of the BatchGenerator keeps its own bounded heap of the best K planets it has found.
+/// Once a worker's heap is full, its K-th best ESI is a lower bound on the global K-th best ESI, so the
+/// workers publish it to a shared atomic threshold.  Before a system is evaluated, the upper bound of
+/// each planet's ESI (Planet::getEarthSimilarityLimit()) is compared against the threshold, and systems
+/// that can not contribute a planet to the results are discarded without evaluation.
+///
+/// The results do not depend on the number of workers or the order in which the systems are processed.
+class EarthLikeSearch
+{
+    public:
+
+    /// @brief Constructor.
+    /// @param k_ The number of planets to keep.
+    explicit EarthLikeSearch(uint32_t k_) :k(k_) { }
+    ~EarthLikeSearch() { }
+
+    /// @brief Returns the number of systems that were evaluated.
+    /// @return The evaluated system count.
+    uint64_t getEvaluatedCount() const { return evaluatedCount; }
+
+    /// @brief Returns the number of systems that were discarded before evaluation.
+    /// @return The pruned system count.
+    uint64_t getPrunedCount() const { return prunedCount; }
+
+    /// @brief Returns the results of the last run(), best first.
+    /// @return Up to K candidates.
+    const std::vector<EarthLikeCandidate>& getResults() const { return results; }
+
+    /// @brief Search the systems described by `settings`.
+    ///
+    /// Any previous results are discarded.
+    /// @param batch The BatchGenerator used to generate the systems.
+    /// @param config The Config used for every system.
+    /// @param settings The seed range and star.
+    void run(const BatchGenerator& batch, const Config& config, const BatchSettings& settings);
+
+    private:
+
+    uint32_t k; //!< Number of results to keep.
+
+    uint64_t evaluatedCount = 0u; //!< Systems evaluated during the last run.
+    uint64_t prunedCount = 0u; //!< Systems discarded before evaluation during the last run.
+
+    std::vector<EarthLikeCandidate> results; //!< Results of the last run, best first.
+};
+
+}
+}
@@ -24,6 +24,8 @@
 ****************************************************************************/
 #pragma once
 
+#include <cstdint>
+
 namespace qc
 {
 
@@ -66,6 +68,9 @@ enum class OrbitalZone
     Outer, //!< Outside the snow line.
 };
 
+/// @brief Number of OrbitalZone values.
+static constexpr uint32_t OrbitalZoneCount = 4u;
+
 /// @brief Return an English string corresponding to the orbital zone.
 /// @note Returns "Unknown" for invalid values.
 /// @param orbitalZone The OrbitalZone to stringify.
@@ -98,6 +103,9 @@ enum class PlanetType
     BrownDwarf, //!< Large gas giants, but not large enough to sustain nuclear fusion of hydrogen.  13x to 80x M(Jupiter).
 };
 
+/// @brief Number of PlanetType values.
+static constexpr uint32_t PlanetTypeCount = 11u;
+
 /// @brief Returns an English string corresponding to the name of the PlanetType.
 /// @note Returns "Unknown" for invalid values.
 /// @param type The PlanetType to stringify.
@@ -27,6 +27,8 @@
 #include "Consts.h"
 
 #include <algorithm>
+#include <math.h>
+#include <utility>
 
 namespace qc
 {
@@ -42,7 +44,7 @@ namespace SystemGenerator
 /// @param lower The lower bound of the range.
 /// @param upper The upper bound of the range.
 /// @return The clamped value.
-template <class T_> inline T_ Clamp(T_ value, T_ lower, T_ upper)
+template <class T_> constexpr T_ Clamp(T_ value, T_ lower, T_ upper)
 {
     return std::min(upper, std::max(value, lower));
 }
@@ -61,6 +63,59 @@ double CriticalLimit(double sma, double eccentricity, double stellarLuminosity);
 
 //----------------------------------------------------------------------------
 
+/// @brief Returns the star-dependent term of CriticalLimit(), so it can be computed once per star.
+/// @param stellarLuminosity Luminosity of the star, Sol = 1.0.
+/// @return The critical limit scalar, for ScaledCriticalLimit().
+inline double CriticalLimitScalar(double stellarLuminosity)
+{
+    return sqrt(stellarLuminosity);
+}
+
+//----------------------------------------------------------------------------
+
+/// @brief Returns the density of the nebular dust at a given distance from the star, per Dole 1969.
+/// @param sma Distance from the star, in AU.
+/// @param stellarMass Mass of the star, in Solar masses.
+/// @return Dust density, in Solar masses per cubic AU.
+double DustDensity(double sma, double stellarMass);
+
+//----------------------------------------------------------------------------
+
+/// @brief Returns the star-dependent term of DustDensity(), so it can be computed once per star.
+/// @param stellarMass Mass of the star, in Solar masses.
+/// @return The dust density scalar, for ScaledDustDensity().
+double DustDensityScalar(double stellarMass);
+
+//----------------------------------------------------------------------------
+
+/// @brief "reduced_mass" in the original accrete implementation.  Provides a number
+/// in the range [0, 1) based on the provided mass.
+/// @param mass Mass of the protoplanet, in Solar masses.
+/// @return The effect limit scalar.
+inline double EffectLimitScalar(double mass)
+{
+    return pow(mass / (1.0 + mass), (1.0 / 4.0));
+}
+
+//----------------------------------------------------------------------------
+
+/// @brief Returns the inner and outer effect limits of a protoplanet - the region it sweeps
+/// dust from.
+/// @param sma The SMA of the protoplanet, in AU.
+/// @param eccentricity Eccentricity of the protoplanet's orbit.
+/// @param effectLimitScalar EffectLimitScalar() of the protoplanet's mass.
+/// @return The inner and outer effect limits, in AU.
+inline std::pair<double, double> EffectLimits(double sma, double eccentricity, double effectLimitScalar)
+{
+    /// Mean eccentricity of the nebular dust in Dole 1969.
+    /// The original value was 0.25, but it looks like the various versions afterwards used 0.2 instead.
+    static constexpr double CloudEccentricity = 0.2;
+
+    return std::make_pair(sma * (1.0 - eccentricity) * (1.0 - effectLimitScalar) / (1.0 + CloudEccentricity), sma * (1.0 + eccentricity) * (1.0 + effectLimitScalar) / (1.0 - CloudEccentricity));
+}
+
+//----------------------------------------------------------------------------
+
 /// @brief Returns the escape velocity of a body
 /// @param mass Mass of the body, in Solar masses.
 /// @param radius Radius of the body, in km.
@@ -79,7 +134,7 @@ inline double EscapeVelocity(double mass, double radius)
 /// @param lower The lower range of values.
 /// @param upper The upper range of values.
 /// @return The interpolant in the range [0.0, 1.0].
-template <class T_> inline T_ InverseLerp(T_ value, T_ lower, T_ upper)
+template <class T_> constexpr T_ InverseLerp(T_ value, T_ lower, T_ upper)
 {
     return (value <= lower) ? (T_)0 : ((value >= upper) ? (T_)1 : ((value - lower) / (upper - lower)));
 }
@@ -156,7 +211,7 @@ double KothariRadius(double mass, double sma, bool forGasGiant, float materialZo
 /// @param lower The lower range of values.
 /// @param upper The upper range of values.
 /// @return Value in the range [lower, upper].
-template <class T_> inline T_ Lerp(T_ interpolant, T_ lower, T_ upper)
+template <class T_> constexpr T_ Lerp(T_ interpolant, T_ lower, T_ upper)
 {
     return (interpolant <= (T_)(0)) ? lower : ((interpolant >= (T_)(1)) ? upper : (lower + (upper - lower) * interpolant));
 }
@@ -213,6 +268,23 @@ inline double RMSVelocity(float molecularWeight, float exosphereTemperature)
 
 //----------------------------------------------------------------------------
 
+/// @brief Equivalent to CriticalLimit(), with the star's contribution precomputed.
+/// @param sma The SMA, in AU.
+/// @param eccentricity Eccentricity of the orbit, [0.0, 1.0).
+/// @param criticalLimitScalar CriticalLimitScalar() of the star's luminosity.
+/// @return Minimum planetoid mass for gas retention, in Solar masses.
+double ScaledCriticalLimit(double sma, double eccentricity, double criticalLimitScalar);
+
+//----------------------------------------------------------------------------
+
+/// @brief Equivalent to DustDensity(), with the star's contribution precomputed.
+/// @param sma Distance from the star, in AU.
+/// @param dustDensityScalar DustDensityScalar() of the star's mass.
+/// @return Dust density, in Solar masses per cubic AU.
+double ScaledDustDensity(double sma, double dustDensityScalar);
+
+//----------------------------------------------------------------------------
+
 /// @brief Return the density of a body, given its mass and radius.
 /// @param mass Mass of the body, in Solar masses.
 /// @param radius Radius of the body, in km.
@@ -0,0 +1,85 @@
+/*****************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Questionable Coding
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************/
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace qc
+{
+
+namespace SystemGenerator
+{
+
+/// @brief Accumulates a 64-bit FNV-1a hash of a sequence of values.
+///
+/// Used to identify the inputs of a generation, such as a Config, so the results can be cached.  Values
+/// are hashed by their in-memory representation, so fingerprints are only comparable between builds
+/// with the same layout and byte order.
+class Fingerprint
+{
+    public:
+
+    Fingerprint() { }
+    ~Fingerprint() { }
+
+    /// @brief Add a block of bytes to the hash.
+    /// @param data The bytes.
+    /// @param size The number of bytes.
+    void add(const void* data, size_t size)
+    {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash = (hash ^ bytes[i]) * 1099511628211ull;
+        }
+    }
+
+    /// @brief Add a value to the hash.
+    /// @tparam T_ A type without padding or pointers.
+    /// @param value The value.
+    template<class T_> void add(const T_& value) { add(&value, sizeof(T_)); }
+
+    /// @brief Add a null-terminated string to the hash, including its terminator.
+    /// @param text The string.
+    void addString(const char* text)
+    {
+        do
+        {
+            add(*text);
+        } while (*text++);
+    }
+
+    /// @brief Returns the hash.
+    /// @return The hash of every value added so far.
+    uint64_t get() const { return hash; }
+
+    private:
+
+    uint64_t hash = 14695981039346656037ull; //!< FNV-1a offset basis.
+};
+
+}
+}
@@ -0,0 +1,205 @@
+/*****************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Questionable Coding
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************/
+#pragma once
+
+#include "Config.h"
+#include "Star.h"
+#include "SystemRecord.h"
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace qc
+{
+
+namespace SystemGenerator
+{
+
+class Generator;
+struct GenerationMetrics;
+class SolarSystem;
+
+struct GenerationCacheIndex;
+
+/// @brief Returns a hash of every Config setting that changes the generated systems.
+///
+/// Config::verboseLogging is ignored.  Config::seedStrategy contributes SeedStrategy::addFingerprint().
+/// @param config The Config.
+/// @return The fingerprint.
+uint64_t GetConfigFingerprint(const Config& config);
+
+/// @brief Identifies one generated system: everything that determines its contents.
+struct GenerationCacheKey
+{
+    /// @brief Flag set in `flags` when the system was generated with Generator::generate2().
+    static constexpr uint8_t UseGenerate2 = 0x01u;
+
+    uint64_t seed; //!< The Generator seed.
+    uint64_t configFingerprint; //!< GetConfigFingerprint() of the Config.
+    uint32_t version; //!< SysGenVersion of the library that generated the system.
+    uint8_t starClass; //!< StarClassification of the requested star.  0 when Config::generateStar is true.
+    int8_t subtype; //!< Subtype of the requested star.  0 when Config::generateStar is true.
+    uint8_t flags; //!< Combination of the flags above.
+    uint8_t reserved; //!< Padding.  Always 0.
+    double starAge; //!< Requested age of the star, or 0 for a random age.  0 when Config::generateStar is true.
+
+    /// @brief Build the key of a system.
+    /// @param seed The Generator seed.
+    /// @param config The Config.
+    /// @param star The star, before evaluation.
+    /// @param useGenerate2 When true, the system is generated with Generator::generate2().
+    /// @return The key.
+    static GenerationCacheKey Make(uint64_t seed, const Config& config, const Star& star, bool useGenerate2 = false);
+};
+
+/// @brief A persistent cache of generated systems, shared by the processes of one host.
+///
+/// The cache is a directory holding two files.  `cache.dat` is an append-only log of entries, each a
+/// GenerationCacheKey followed by the system's SystemRecord.  `cache.idx` is a memory-mapped open-addressing
+/// hash table from key to entry, with the time each entry was last used.
+///
+/// Every process maps the index and coordinates through an advisory lock on it: lookups share the lock and
+/// inserts take it exclusively, so any number of processes may read and write the same cache.  Within a
+/// process, calls are serialized by a mutex, so one GenerationCache may be shared by several threads; a
+/// process should not open the same directory twice, because the lock is held per process.
+///
+/// When an insert would take the cache above its size limit, or fill too much of the index, the least
+/// recently used entries are evicted.  Evicted entries leave dead space in `cache.dat`; once the dead space
+/// exceeds the size limit, the live entries are copied to a new file that replaces the old one, and the
+/// other processes reopen it on their next call.
+///
+/// Keys include SysGenVersion, so entries written by another version of the library are never served.
+///
+/// Only available on POSIX systems; on other platforms open() fails.
+class GenerationCache
+{
+    public:
+
+    /// @brief Largest fraction of the index slots that may hold entries.
+    static constexpr float MaxLoadFactor = 0.75f;
+
+    GenerationCache() { }
+    ~GenerationCache() { close(); }
+
+    GenerationCache(const GenerationCache&) = delete;
+    GenerationCache& operator=(const GenerationCache&) = delete;
+
+    /// @brief Open a cache, creating it if it does not exist.
+    ///
+    /// The size limit and slot count are fixed by the process that creates the cache; later processes use
+    /// the values stored in the index.
+    /// @param directory The directory holding the cache files.  It is created if it does not exist.
+    /// @param maxBytes The most data the cache may hold, in bytes.
+    /// @param slotCount The number of index slots, which limits the number of entries.
+    /// @return true on success.
+    bool open(const char* directory, uint64_t maxBytes, uint32_t slotCount = 65536u);
+
+    /// @brief Close the cache.  The files are kept.
+    void close();
+
+    /// @brief Look up a system.
+    /// @param key The system's key.
+    /// @param record Receives the SystemRecord (see SystemRecord::size) on a hit.
+    /// @return true on a hit.
+    bool find(const GenerationCacheKey& key, std::vector<uint8_t>& record);
+
+    /// @brief Returns the number of finds that hit since open().
+    /// @return The hit count.
+    uint64_t getHitCount() const { return hitCount; }
+
+    /// @brief Returns the number of finds that missed since open().
+    /// @return The miss count.
+    uint64_t getMissCount() const { return missCount; }
+
+    /// @brief Returns the SystemRecord of a system, generating and storing it only if it is not in the cache.
+    ///
+    /// On a hit, the Generator is not run and `system` is not changed.
+    /// @param seed The Generator seed.
+    /// @param config The Config.
+    /// @param star The star, used when Config::generateStar is false.
+    /// @param useGenerate2 When true, the system is generated with Generator::generate2().
+    /// @param generator The Generator used on a miss.
+    /// @param system The SolarSystem used on a miss.
+    /// @param record Receives the SystemRecord.
+    /// @return true if the record came from the cache.
+    bool getOrGenerate(uint64_t seed, const Config& config, const Star& star, bool useGenerate2, Generator& generator, SolarSystem& system, std::vector<uint8_t>& record);
+
+    /// @brief Store a system.  If the key is already present, the cache is unchanged.
+    /// @param key The system's key.
+    /// @param system The evaluated system.
+    /// @return true if the system is in the cache when the call returns.
+    bool insert(const GenerationCacheKey& key, const SolarSystem& system);
+
+    /// @brief Returns true if the cache is open.
+    bool isOpen() const { return index != nullptr; }
+
+    /// @brief Have the cache update the cache hit, miss, size and entry metrics.
+    ///
+    /// The size and entry gauges describe the shared cache, including the entries of other processes, as of
+    /// this process's last call.
+    /// @param metrics_ The metrics, or nullptr.  The cache does not take ownership.
+    void setMetrics(GenerationMetrics* metrics_) { metrics = metrics_; }
+
+    private:
+
+    std::mutex mutex; //!< Serializes the calls of this process.
+
+    std::string directory; //!< The cache directory.
+    int indexFile = -1; //!< Descriptor of cache.idx.  Holds the advisory lock.
+    int dataFile = -1; //!< Descriptor of cache.dat.
+    uint64_t dataGeneration = 0u; //!< Generation of the open cache.dat.
+
+    GenerationCacheIndex* index = nullptr; //!< The mapped index.
+    size_t mappedSize = 0u; //!< Size of the mapping.
+
+    uint64_t hitCount = 0u; //!< Finds that hit.
+    uint64_t missCount = 0u; //!< Finds that missed.
+
+    GenerationMetrics* metrics = nullptr; //!< Receives the cache metrics, if set.
+
+    std::vector<uint64_t> recordScratch; //!< 8-byte aligned space to serialize records.
+
+    // Compact cache.dat.  Requires the exclusive lock.
+    bool compact();
+
+    // Evict the least recently used entries until `bytes` more bytes and one more entry fit.  Requires the exclusive lock.
+    void evict(uint64_t bytes);
+
+    // Find the slot of a key, or the slot it would be inserted in: slotCount if every slot is live.  Requires
+    // the lock.
+    uint32_t findSlot(uint64_t hash, const GenerationCacheKey& key, bool& found);
+
+    // Take or release the advisory lock on the index.
+    bool lock(bool exclusive);
+    void unlock();
+
+    // Reopen cache.dat if another process replaced it.  Requires the lock.
+    bool syncDataFile();
+};
+
+}
+}
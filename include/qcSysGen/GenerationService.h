@@ -0,0 +1,325 @@
+/*****************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Questionable Coding
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************/
+#pragma once
+
+#include "Config.h"
+#include "Star.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace qc
+{
+
+namespace SystemGenerator
+{
+
+class GenerationCache;
+class Generator;
+struct GenerationMetrics;
+class SolarSystem;
+
+/// @brief How far a GenerationService request is taken.
+enum class EvaluationLevel : uint8_t
+{
+    Accreted, //!< Only the orbits and masses of the planets (Generator::accrete()).
+    Evaluated, //!< Fully evaluated planets (Generator::generate()).
+};
+
+/// @brief The scheduling class of a GenerationService request.
+enum class RequestPriority : uint8_t
+{
+    Interactive, //!< Someone is waiting for the system.  Preempts Bulk work.
+    Bulk, //!< Background pre-generation.
+};
+
+/// @brief Number of RequestPriority values.
+static constexpr uint32_t RequestPriorityCount = 2u;
+
+/// @brief A request sent to a GenerationServer.  Fixed layout, in host byte order.
+///
+/// The switches are always taken from `flags`.  The numeric Config values are taken from the request when
+/// their bit is set in `overrideMask`, and from the server's base Config otherwise.  Seed strategies and
+/// explicit protoplanet seeds can not be sent; the server's base Config supplies them.
+struct GenerationRequest
+{
+    static constexpr uint32_t Magic = 0x52474351u; //!< "QCGR".
+    static constexpr uint8_t ProtocolVersion = 1u; //!< Version of the request and response layouts.
+
+    // Bits of `flags`.
+    static constexpr uint8_t UseGenerate2 = 0x01u; //!< Generate with Generator::generate2().
+    static constexpr uint8_t GenerateStar = 0x02u; //!< Config::generateStar.  The star fields are ignored.
+    static constexpr uint8_t GenerateBodeSeeds = 0x04u; //!< Config::generateBodeSeeds.
+
+    // Bits of `overrideMask`.
+    static constexpr uint32_t OverrideProtoplanetSeedMass = 0x01u; //!< Use `protoplanetSeedMass`.
+    static constexpr uint32_t OverrideDensityVariation = 0x02u; //!< Use `densityVariation`.
+    static constexpr uint32_t OverrideInclinationMean = 0x04u; //!< Use `inclinationMean`.
+    static constexpr uint32_t OverrideInclinationStdDev = 0x08u; //!< Use `inclinationStdDev`.
+    static constexpr uint32_t OverrideProtoplanetCount = 0x10u; //!< Use `protoplanetCount`.
+
+    uint32_t magic; //!< Magic.
+    uint8_t version; //!< ProtocolVersion.
+    uint8_t level; //!< EvaluationLevel.
+    uint8_t flags; //!< Combination of the flags above.
+    uint8_t starClass; //!< StarClassification of the star.
+    uint64_t requestId; //!< Chosen by the client, and returned in the response.
+    uint64_t seed; //!< The Generator seed.
+    double starAge; //!< Age of the star in years, or 0 for a random age.
+    int8_t subtype; //!< Subtype of the star.
+    uint8_t priority; //!< RequestPriority.
+    uint8_t reserved[2]; //!< Padding.  Always 0.
+    uint32_t overrideMask; //!< Combination of the override bits above.
+    uint32_t protoplanetCount; //!< Config::protoplanetCount.
+    float densityVariation; //!< Config::densityVariation.
+    float inclinationMean; //!< Config::inclinationMean.
+    float inclinationStdDev; //!< Config::inclinationStdDev.
+    double protoplanetSeedMass; //!< Config::protoplanetSeedMass.
+
+    /// @brief Build a request for a system around a given star, with no overrides.
+    /// @param requestId_ The request ID.
+    /// @param seed_ The Generator seed.
+    /// @param star The star.  Only its type and age are sent.
+    /// @param level_ The evaluation level.
+    /// @param priority_ The scheduling class.
+    /// @return The request.
+    static GenerationRequest Make(uint64_t requestId_, uint64_t seed_, const Star& star, EvaluationLevel level_ = EvaluationLevel::Evaluated,
+                                  RequestPriority priority_ = RequestPriority::Interactive);
+};
+
+/// @brief The header of a response from a GenerationServer.  It is followed by `recordSize` bytes of
+/// SystemRecord when `status` is Ok.
+struct GenerationResponse
+{
+    static constexpr uint32_t Magic = 0x53474351u; //!< "QCGS".
+
+    /// @brief Values of `status`.
+    enum Status : uint32_t
+    {
+        Ok, //!< The record follows.
+        BadRequest, //!< The request was malformed, or of an unsupported version.
+        Failed, //!< The system could not be generated or serialized.
+    };
+
+    // Bits of `flags`.
+    static constexpr uint32_t FromCache = 0x01u; //!< The record came from the server's GenerationCache.
+    static constexpr uint32_t Shared = 0x02u; //!< An identical request was in flight, and its result was shared.
+
+    uint32_t magic; //!< Magic.
+    uint32_t status; //!< Status.
+    uint64_t requestId; //!< The request ID.
+    uint32_t recordSize; //!< Size of the SystemRecord that follows.
+    uint32_t flags; //!< Combination of the flags above.
+};
+
+/// @brief Connects to a GenerationServer.
+///
+/// Requests may be pipelined: send() any number of requests, then receive() the responses, which arrive in
+/// the order they complete, not the order they were sent.  Not thread-safe.  POSIX only.
+class GenerationClient
+{
+    public:
+
+    GenerationClient() { }
+    ~GenerationClient() { close(); }
+
+    GenerationClient(const GenerationClient&) = delete;
+    GenerationClient& operator=(const GenerationClient&) = delete;
+
+    /// @brief Close the connection.
+    void close();
+
+    /// @brief Connect to a server.
+    /// @param path The server's socket path.
+    /// @return true on success.
+    bool connect(const char* path);
+
+    /// @brief Send a request and wait for its response.  Only valid when no other request is in flight.
+    /// @param request The request.
+    /// @param response Receives the response header.
+    /// @param record Receives the SystemRecord.
+    /// @return true if a response was received.  Check GenerationResponse::status.
+    bool generate(const GenerationRequest& request, GenerationResponse& response, std::vector<uint8_t>& record);
+
+    /// @brief Returns true if the client is connected.
+    bool isConnected() const { return socket >= 0; }
+
+    /// @brief Wait for the next response.
+    /// @param response Receives the response header.
+    /// @param record Receives the SystemRecord, resized to GenerationResponse::recordSize.
+    /// @return true if a response was received, false if the connection failed.
+    bool receive(GenerationResponse& response, std::vector<uint8_t>& record);
+
+    /// @brief Send a request.
+    /// @param request The request.
+    /// @return true on success.
+    bool send(const GenerationRequest& request);
+
+    private:
+
+    int socket = -1; //!< The connection, or -1.
+};
+
+/// @brief Serves GenerationRequests over a Unix domain socket from a pool of workers.
+///
+/// Every connection has its own reader thread, which queues the requests it receives; both are released once
+/// the client disconnects.  The workers take requests from the queue one at a time, so requests arriving
+/// together from several clients are spread over the pool, and each worker keeps its own Generator and
+/// SolarSystem warm.  A request identical to one that is queued or being generated (same seed, star, level
+/// and effective Config) is not queued again: it waits for the first one, and the result is sent to every
+/// requester.  Fully evaluated systems are looked up in, and stored to, the optional GenerationCache, which
+/// can be shared with other processes.
+///
+/// Requests are scheduled by RequestPriority.  Idle workers take Interactive requests before Bulk ones, and
+/// each class can be limited to a number of workers with setConcurrencyLimit(), so bulk pre-generation can
+/// be kept from occupying the whole pool.  A worker generating a Bulk system also polls for Interactive
+/// requests at every safe point of its Generator (see Preemptor): when one is waiting and its class is under
+/// its limit, the worker suspends the bulk system and generates the interactive one on a second Generator
+/// before resuming.  An interactive request therefore waits at most one protoplanet or planet evaluation
+/// even when every worker is busy with bulk work.  An Interactive request identical to a queued Bulk one
+/// promotes it.  Priority is not part of the request identity, so either shares an identical job in flight.
+///
+/// Responses are written by the workers, under a lock per connection, as soon as each system is done.
+/// POSIX only; on other platforms start() fails.
+class GenerationServer
+{
+    public:
+
+    /// @brief Constructor.
+    /// @param workerCount_ The number of workers.  If 0, the hardware concurrency is used.
+    explicit GenerationServer(uint32_t workerCount_ = 0u);
+    ~GenerationServer() { stop(); }
+
+    GenerationServer(const GenerationServer&) = delete;
+    GenerationServer& operator=(const GenerationServer&) = delete;
+
+    /// @brief Returns the number of times a bulk system was suspended to generate interactive ones.
+    uint64_t getPreemptionCount() const { return preemptionCount.load(std::memory_order_relaxed); }
+
+    /// @brief Returns the number of requests answered from an identical request in flight.
+    uint64_t getSharedCount() const { return sharedCount.load(std::memory_order_relaxed); }
+
+    /// @brief Returns the number of requests received.
+    uint64_t getRequestCount() const { return requestCount.load(std::memory_order_relaxed); }
+
+    /// @brief Returns the number of workers.
+    uint32_t getWorkerCount() const { return workerCount; }
+
+    /// @brief Set the Config the requests' overrides are applied to.  Only valid before start().
+    /// @param config The base Config.  Its seed strategy must outlive the server.
+    void setBaseConfig(const Config& config) { baseConfig = config; }
+
+    /// @brief Limit the number of workers generating requests of a class at once.  Only valid before start().
+    ///
+    /// A worker suspended by preemption still counts against the limit of the class it suspended.  By
+    /// default neither class is limited.
+    /// @param priority The class.
+    /// @param limit The largest number of workers, at least 1.
+    void setConcurrencyLimit(RequestPriority priority, uint32_t limit) { concurrencyLimit[static_cast<uint32_t>(priority)] = (limit > 0u) ? limit : 1u; }
+
+    /// @brief Use a cache for fully evaluated systems.  Only valid before start().
+    /// @param cache_ The cache, or nullptr.  The server does not take ownership.
+    void setCache(GenerationCache* cache_) { cache = cache_; }
+
+    /// @brief Update service metrics.  Only valid before start().
+    /// @param metrics_ The metrics, or nullptr.  The server does not take ownership.
+    void setMetrics(GenerationMetrics* metrics_) { metrics = metrics_; }
+
+    /// @brief Start accepting connections and serving requests.
+    ///
+    /// An existing socket file at `path` is replaced.
+    /// @param path The socket path.
+    /// @return true on success.
+    bool start(const char* path);
+
+    /// @brief Stop serving, close every connection and remove the socket file.
+    ///
+    /// Requests that were not started are dropped without a response.
+    void stop();
+
+    private:
+
+    struct Connection;
+    struct Job;
+    struct Worker;
+
+    uint32_t workerCount; //!< Number of workers.
+
+    Config baseConfig; //!< The Config the overrides are applied to.
+    GenerationCache* cache = nullptr; //!< Cache of evaluated systems, if set.
+    GenerationMetrics* metrics = nullptr; //!< Service metrics, if set.
+
+    int listenSocket = -1; //!< The socket accepting connections, or -1.
+    std::string socketPath; //!< The path of the socket.
+
+    std::thread acceptor; //!< Accepts connections.
+    std::vector<std::thread> workers; //!< Generate the systems.
+
+    std::mutex connectionMutex; //!< Guards `connections`.
+    std::vector<std::shared_ptr<Connection>> connections; //!< The open connections.
+
+    std::mutex queueMutex; //!< Guards `queue`, `running`, `inFlight` and `stopping`.
+    std::condition_variable queueReady; //!< Signalled when a job is queued or finished, or the server stops.
+    std::deque<std::shared_ptr<Job>> queue[RequestPriorityCount]; //!< Jobs waiting for a worker, by class.
+    uint32_t running[RequestPriorityCount] = { }; //!< Workers generating each class, suspended ones included.
+    uint32_t concurrencyLimit[RequestPriorityCount] = { UINT32_MAX, UINT32_MAX }; //!< Worker limit of each class.
+    std::map<std::string, std::shared_ptr<Job>> inFlight; //!< Queued and running jobs, by request contents.
+    bool stopping = false; //!< Set by stop().
+
+    std::atomic<uint32_t> interactivePending{ 0u }; //!< Nonzero when bulk workers should preempt.  Polled by the Generators.
+
+    std::atomic<uint64_t> requestCount{ 0u }; //!< Requests received.
+    std::atomic<uint64_t> sharedCount{ 0u }; //!< Requests that joined a job in flight.
+    std::atomic<uint64_t> preemptionCount{ 0u }; //!< Bulk systems suspended for interactive ones.
+
+    // Accept connections until stop().
+    void acceptConnections();
+
+    // Read the requests of a connection until it closes.
+    void readRequests(std::shared_ptr<Connection> connection);
+
+    // Generate a job and send the result to everyone waiting for it.
+    void run(Job& job, Generator& generator, SolarSystem& system, std::vector<uint8_t>& record);
+
+    // Queue a request, or attach it to an identical job in flight.
+    void submit(const std::shared_ptr<Connection>& connection, const GenerationRequest& request);
+
+    // Recompute `interactivePending`.  queueMutex must be held.
+    void updatePending();
+
+    // Take jobs from the queue and generate them until stop().
+    void work();
+};
+
+}
+}
@@ -24,10 +24,13 @@
 ****************************************************************************/
 #pragma once
 
+#include "AccretionLog.h"
 #include "Config.h"
 #include "Planet.h"
+#include "PreparedConfig.h"
 #include "Star.h"
 
+#include <atomic>
 #include <random>
 
 #include <forward_list>
@@ -39,7 +42,36 @@ namespace SystemGenerator
 {
 
 // Forward declarations
+class LaneAccretor;
+class PhaseCounters;
 class SolarSystem;
+struct SystemCost;
+
+/// @brief Runs other work at the safe points of a Generator.
+///
+/// A Generator with a Preemptor attached polls it between protoplanets and between planet evaluations, and
+/// calls preempt() whenever the pending count is nonzero.  preempt() runs on the generating thread and must
+/// not touch the preempted Generator or SolarSystem; the preempted system is then generated exactly as it
+/// would have been without the interruption.
+class Preemptor
+{
+    public:
+
+    /// @brief Constructor.
+    /// @param pending_ The count polled at every safe point.  Nonzero when preempt() has work to do.
+    explicit Preemptor(const std::atomic<uint32_t>& pending_) : pending(pending_) { }
+    virtual ~Preemptor() { }
+
+    /// @brief Returns true if preempt() has work to do.
+    bool isPending() const { return pending.load(std::memory_order_relaxed) != 0u; }
+
+    /// @brief Run the pending work.
+    virtual void preempt() = 0;
+
+    private:
+
+    const std::atomic<uint32_t>& pending; //!< Polled at every safe point.
+};
 
 /// @brief The Generator is the functional element used to generate random solar systems.
 /// 
@@ -75,6 +107,12 @@ class SolarSystem;
 /// seeds were always consumed starting close to the sun, or far from the sun, all solar systems would
 /// end up being generally similar.
 /// 
+/// ## Seed Strategies
+/// 
+/// Config::seedStrategy replaces the Bode seeds with any other SeedStrategy, such as a uniform or
+/// log-uniform scatter, a table of orbits relative to the ecosphere, or a chain of resonant orbits.
+/// The Bode seeds are themselves the BodeSeedStrategy.
+/// 
 /// ## Manual Seeds
 /// 
 /// If you want more control over the initial state of the solar system, you can specify one or more seeds
@@ -84,15 +122,51 @@ class SolarSystem;
 /// to Config::protoplanetSeeds.  Once the protoplanets from Config::protoplanetSeeds are placed, the remainder
 /// of the dust in the solar system will be consumed using accretion.
 /// 
-/// Manual seeds take priority over Config::generateBodeSeeds, so supplying entries in Config::protoplanetSeeds
-/// will cause Generator to treat Config::generateBodeSeeds as false.
+/// Manual seeds take priority over Config::seedStrategy and Config::generateBodeSeeds, so supplying entries in
+/// Config::protoplanetSeeds will cause Generator to ignore them.
 class Generator
 {
     public:
 
-    Generator() { mt.seed(seedVal); }
+    Generator() :config(&ownConfig.getConfig()) { mt.seed(seedVal); }
     ~Generator() { }
 
+    // The Generator points at its own config, so it may not be copied.
+    Generator(const Generator&) = delete;
+    Generator& operator=(const Generator&) = delete;
+
+    /// @brief Run the accretion stage of generate() without evaluating the planets.
+    /// 
+    /// When this method returns, the planets of `system` contain their orbital elements and
+    /// their dust and gas masses, but none of the derived values.  Call SolarSystem::evaluate()
+    /// to finish the system.  generate() is exactly accrete() followed by SolarSystem::evaluate(),
+    /// so the results are identical, but a caller may inspect the planets (and discard the system)
+    /// before paying for evaluation.
+    /// @param system The SolarSystem that will contain the results.
+    /// @param config_ The Config that configures the generator.
+    void accrete(SolarSystem& system, const Config& config_);
+
+    /// @brief Run the accretion stage of generate() with a PreparedConfig.
+    ///
+    /// See accrete() and PreparedConfig.
+    /// @param system The SolarSystem that will contain the results.
+    /// @param config_ The PreparedConfig that configures the generator.  It must outlive the call.
+    void accrete(SolarSystem& system, const PreparedConfig& config_);
+
+    /// @brief Run the accretion stage of generate2() without evaluating the planets.
+    /// 
+    /// See accrete() and generate2().
+    /// @param system The SolarSystem that will contain the results.
+    /// @param config_ The Config that configures the generator.
+    void accrete2(SolarSystem& system, const Config& config_);
+
+    /// @brief Run the accretion stage of generate2() with a PreparedConfig.
+    ///
+    /// See accrete2() and PreparedConfig.
+    /// @param system The SolarSystem that will contain the results.
+    /// @param config_ The PreparedConfig that configures the generator.  It must outlive the call.
+    void accrete2(SolarSystem& system, const PreparedConfig& config_);
+
     /// @brief Generate a random solar system.
     /// 
     /// Any existing planets in `system` will be removed.  If Config::generateStar is true,
@@ -106,6 +180,15 @@ class Generator
     /// @param config_ The Config that configures the generator.
     void generate(SolarSystem& system, const Config& config_);
 
+    /// @brief Generate a random solar system with a PreparedConfig.
+    ///
+    /// Identical to generate() with the Config the PreparedConfig was prepared from, without the
+    /// per-system cost of copying and normalizing it.
+    /// @param system The SolarSystem that will contain the results.  If the config was prepared with
+    /// a star the system should use that star; otherwise the star-specific values are computed per system.
+    /// @param config_ The PreparedConfig that configures the generator.  It must outlive the call.
+    void generate(SolarSystem& system, const PreparedConfig& config_);
+
     /// @brief Generate a random solar system.
     /// 
     /// Any existing planets in `system` will be removed.  If Config::generateStar is true,
@@ -115,7 +198,7 @@ class Generator
     /// 
     /// This generator method uses a semi-parallel accretion algorithm.  Instead of each protoplanet
     /// being fully accreted before the next one protoplanet is evaluated, each of the initial protoplanets
-    /// (those provided in Config::protoplanetSeeds or those created via Config::generateBodeSeeds, as
+    /// (those provided in Config::protoplanetSeeds or those created by the Config::seedStrategy, as
     /// well as those added because of Config::protoplanetCount) accrete dust once, and then each one
     /// accretes again.  This continues until no protoplanets are collecting dust.  At that stage,
     /// if there is still dust available, the sequential accretion algorithm used in generate() is used
@@ -124,11 +207,30 @@ class Generator
     /// @param config_ The Config that configures the generator.
     void generate2(SolarSystem& system, const Config& config_);
 
+    /// @brief Generate a random solar system with a PreparedConfig, using the generate2() algorithm.
+    ///
+    /// See generate(SolarSystem&, const PreparedConfig&).
+    /// @param system The SolarSystem that will contain the results.
+    /// @param config_ The PreparedConfig that configures the generator.  It must outlive the call.
+    void generate2(SolarSystem& system, const PreparedConfig& config_);
+
+    /// @brief Returns the AccretionLog attached with setAccretionLog().
+    /// @return The log, or nullptr.
+    const AccretionLog* getAccretionLog() const { return accretionLog; }
+
     /// @brief Returns the percentage random variation in density to use generating a planet.
     /// 
     /// This variation allows for a little more variety in planetary sizes and characteristics.
     /// @return The density variation percentage, [0, 1].
-    float getDensityVariation() const { return config.densityVariation; }
+    float getDensityVariation() const { return densityVariation; }
+
+    /// @brief Returns the PhaseCounters attached with setPhaseCounters().
+    /// @return The counters, or nullptr.
+    PhaseCounters* getPhaseCounters() const { return phaseCounters; }
+
+    /// @brief Returns the Preemptor attached with setPreemptor().
+    /// @return The preemptor, or nullptr.
+    Preemptor* getPreemptor() const { return preemptor; }
 
     /// @brief Returns the number of protoplanets that were successfully generated.
     /// 
@@ -140,9 +242,18 @@ class Generator
     /// @return The seed values.
     uint64_t getSeed() const { return seedVal; }
 
+    /// @brief Returns the SystemCost attached with setSystemCost().
+    /// @return The cost, or nullptr.
+    SystemCost* getSystemCost() const { return systemCost; }
+
     /// @brief Indicates whether verbose logging is enabled.
     /// @return True if we want verbose logging.
-    bool getVerbose() const { return config.verboseLogging; }
+    bool getVerbose() const { return verboseLogging; }
+
+    /// @brief A safe point: lets the attached Preemptor run its pending work, if any.
+    ///
+    /// Called between protoplanets and between planet evaluations.
+    void preemptionPoint() { if (preemptor && preemptor->isPending()) { preemptor->preempt(); } }
 
     /// @brief Select a uniformly-distributed random number within the range
     /// [(1 - range) * center, (1 + range) * center].
@@ -226,6 +337,26 @@ class Generator
     /// @param seedVal_ The seed value.
     void seed(uint64_t seedVal_) { seedVal = seedVal_; mt.seed(seedVal); }
 
+    /// @brief Attach a log that records the accretion events of every following system.
+    ///
+    /// Recording does not change the generated systems.
+    /// @param accretionLog_ The log, or nullptr to stop recording.  The Generator does not take ownership.
+    void setAccretionLog(AccretionLog* accretionLog_) { accretionLog = accretionLog_; }
+
+    /// @brief Attach PhaseCounters that count the events of every following system per GenerationPhase.
+    /// @param phaseCounters_ The counters, or nullptr to stop counting.  The Generator does not take ownership.
+    void setPhaseCounters(PhaseCounters* phaseCounters_) { phaseCounters = phaseCounters_; }
+
+    /// @brief Attach a Preemptor that runs other work at the safe points of every following system.
+    ///
+    /// Preemption does not change the generated systems.
+    /// @param preemptor_ The preemptor, or nullptr.  The Generator does not take ownership.
+    void setPreemptor(Preemptor* preemptor_) { preemptor = preemptor_; }
+
+    /// @brief Attach a SystemCost that counts the work of every following system.
+    /// @param systemCost_ The cost, or nullptr to stop counting.  The Generator does not take ownership.
+    void setSystemCost(SystemCost* systemCost_) { systemCost = systemCost_; }
+
     private:
 
     /// @brief Represents a band of dust during accrual.
@@ -290,9 +421,27 @@ class Generator
     /// @brief The dust available for accretion.
     AvailableDust availableDust;
 
+    AccretionLog* accretionLog = nullptr; //!< Receives the accretion events, if set.
+
+    SystemCost* systemCost = nullptr; //!< Counts the work of the current system, if set.
+
+    PhaseCounters* phaseCounters = nullptr; //!< Counts the events of each phase, if set.
+
+    Preemptor* preemptor = nullptr; //!< Runs other work at the safe points, if set.
+
     bool dustRemains = false; //!< Does any dust remain for accretion?
 
-    Config config; //!< Copy of the config values.
+    PreparedConfig ownConfig; //!< Prepared copy of the Config passed to the Config overloads.
+
+    const Config* config; //!< The config of the current system.  Only valid during accretion.
+
+    float densityVariation = 0.0f; //!< Config::densityVariation of the current system, used by evaluation.
+
+    bool verboseLogging = false; //!< Config::verboseLogging of the current system, used by evaluation.
+
+    double criticalLimitScalar = 0.0; //!< CriticalLimitScalar() of the star.
+
+    double dustDensityScalar = 0.0; //!< DustDensityScalar() of the star.
 
     BandLimit_t protoplanetZone; //!< Shadow copy of the Star's protoplanet zone
 
@@ -306,6 +455,12 @@ class Generator
     /// @brief The list of planets as generated by coalescePlanetisimals()
     PlanetList planetList;
 
+    /// @brief The protoplanet seeds of the current system.  Kept between systems to reuse its capacity.
+    std::vector<ProtoplanetSeed> protoplanetSeedScratch;
+
+    /// @brief The seed layout of the current star, when the config was not prepared with the star.
+    SeedLayout seedLayoutScratch;
+
     /// @brief Value used to seed the Mersenne twister engine.
     uint64_t seedVal = 5489u;
 
@@ -321,12 +476,32 @@ class Generator
     // of growing the protoplanet until it's swept its neighborhood.  Used in generate2().
     bool accreteDust2(Protoplanet& protoplanet);
 
+    // Add a new planet for the protoplanet to the planet list, keeping the list sorted by semi-major axis.
+    void addPlanet(const Protoplanet& protoplanet);
+
+    // Reset the generator and the system for a new accretion pass: applies the config, evaluates
+    // or generates the star, fills protoplanetSeeds from the config (manual or Bode seeds) and
+    // creates the initial dust band.
+    void beginAccretion(SolarSystem& system, const PreparedConfig& config_, std::vector<ProtoplanetSeed>& protoplanetSeeds);
+
     // Attempt to convert the protoplanet into a planet.  First, each existing planet is tested
     // to see if the protoplanet may have collided with it.  If not, a new planet is formed.
     // If there was a collision, a new protoplanet is formed using post-colliision mass and
     // orbital characteristics, and it goes through collectDust() to sweep its neighborhood.
     void coalescePlanetisimals(const Protoplanet& protoplanet);
 
+    /// @brief The outcome of collidePlanetisimals().
+    enum class Collision
+    {
+        None, //!< No collision; the protoplanet becomes a new planet.
+        Merged, //!< The protoplanet merged with a planet; the merged body continues to accrete.
+        Captured, //!< The protoplanet and a planet became a planet and moon; nothing is left to accrete.
+    };
+
+    // Test the protoplanet for a collision with the existing planets.  On a merge, the planet is
+    // removed from the planet list and `newProtoplanet` receives the merged body.
+    Collision collidePlanetisimals(const Protoplanet& protoplanet, Protoplanet& newProtoplanet);
+
     /// @brief Execute one iteration to collect dust from the dustband.  Recurse to the next dust band to continue collecting.
     /// @param lastMass The amount of dust added in the previous step.
     /// @param additionalDustMass The amount of dust to add to the body.
@@ -336,16 +511,16 @@ class Generator
     /// @return Net increase in mass (dust mass + gas mass)
     double collectDust(double lastMass, double& additionalDustMass, double& additionalGasMass, const Protoplanet& protoplanet, AvailableDust::iterator dustband);
 
-    // Generate a sequence of protoplanet seeds based on Blagg's modification of Bode's Law.
-    // The first seed in the returned vector is always closest to the ideal habitable zone.
-    // The remainder of the seeds are randomly sorted to allow for more variation in the results.
-    void generateBodeSeeds(std::vector<ProtoplanetSeed>& protoplanetSeeds, const Star& star);
+    // Assign the final random orbital elements to the planets and copy them to the system.
+    void finishAccretion(SolarSystem& system);
 
     // Generate a random star for the solar system.
     void generateStar(SolarSystem& system);
 
     // Clear dust and gas (as appropriate) from the availableDust list.
     void updateDustLanes(const Protoplanet& protoplanet);
+
+    friend class LaneAccretor;
 };
 
 }
@@ -0,0 +1,157 @@
+/*****************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Questionable Coding
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************/
+#pragma once
+
+#include "Batch.h"
+#include "Generator.h"
+#include "System.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace qc
+{
+
+namespace SystemGenerator
+{
+
+/// @brief Experimental accretion engine that generates several independent systems in lockstep,
+/// one per lane.
+///
+/// The dust sweep - GetEffectLimits(), the collectDust() density, width and area math - is the
+/// innermost loop of Generator::accrete().  This engine keeps the protoplanet of each lane and the
+/// dust bands of every lane in structure-of-arrays form, and advances every lane by one sweep per
+/// iteration, so the band loop runs across the lanes with divergence handled by masking instead
+/// of branches.  Everything that is structural or consumes random numbers - choosing protoplanets,
+/// splitting dust bands, collisions, the star and the final orbital elements - runs per lane with the
+/// library's own Generator code.
+///
+/// Every arithmetic operation of the sweep is performed in the same order as the scalar code, and the
+/// transcendental functions are still evaluated per lane with the C runtime, so the systems are
+/// identical to the ones Generator::generate() produces for the same seed.  The library is the
+/// correctness oracle: any difference is a bug in this engine.  (Compiling with floating-point
+/// contraction enabled, e.g. FMA on GCC with -march, lets the compiler round the two paths
+/// differently.)
+///
+/// Only the generate() accretion model runs in lanes.  When BatchSettings::useGenerate2 is set, each
+/// system is generated by the lane's Generator directly.
+///
+/// The engine is single threaded; compare it against a BatchGenerator with one worker to measure the
+/// throughput per core.
+class LaneAccretor
+{
+    public:
+
+    /// @brief The number of systems generated in lockstep.  Eight doubles fill one AVX-512 register or
+    /// two AVX registers.
+    static constexpr uint32_t LaneCount = 8u;
+
+    LaneAccretor();
+    ~LaneAccretor() { }
+
+    /// @brief Returns the number of lane-iterations that advanced a protoplanet during the last run().
+    ///
+    /// getLaneStepCount() / (getStepCount() * LaneCount) is the lane occupancy.
+    /// @return The number of useful lane steps.
+    uint64_t getLaneStepCount() const { return laneStepCount; }
+
+    /// @brief Returns the number of lockstep iterations of the last run().
+    /// @return The iteration count.
+    uint64_t getStepCount() const { return stepCount; }
+
+    /// @brief Generate every system described by `settings`.
+    ///
+    /// The callback is invoked on the calling thread with a worker index of 0.  Systems are delivered
+    /// in the order they complete, which is not the order of their indices.
+    /// @param config The Config used for every system.
+    /// @param settings The seed range and star for the batch.
+    /// @param callback The callback that receives each evaluated system.
+    void run(const Config& config, const BatchSettings& settings, const BatchGenerator::SystemCallback& callback);
+
+    private:
+
+    //--- Protoplanet state, one entry per lane.
+    double sma[LaneCount]; //!< Semi-major axis of the lane's protoplanet.
+    double eccentricity[LaneCount]; //!< Eccentricity of the lane's protoplanet.
+    double mass[LaneCount]; //!< Total mass of the lane's protoplanet, in solar masses.
+    double dustMass[LaneCount]; //!< Dust mass of the lane's protoplanet, in solar masses.
+    double gasMass[LaneCount]; //!< Gas mass of the lane's protoplanet, in solar masses.
+    double criticalMass[LaneCount]; //!< Critical mass for gas retention, in solar masses.
+    double dustDensity[LaneCount]; //!< Dust density at the protoplanet's SMA.
+    double areaScale[LaneCount]; //!< 4 * PI * sma^2.
+    double addedMass[LaneCount]; //!< Mass collected by the last sweep.
+    double addedDustMass[LaneCount]; //!< Dust mass collected by the last sweep.
+    double addedGasMass[LaneCount]; //!< Gas mass collected by the last sweep.
+    double rInner[LaneCount]; //!< Inner effect limit of the last sweep.
+    double rOuter[LaneCount]; //!< Outer effect limit of the last sweep.
+    bool sweeping[LaneCount]; //!< Is the lane sweeping a protoplanet?
+
+    //--- Dust bands, `bandCapacity` rows of LaneCount entries.  Rows past a lane's band count hold an
+    //--- empty band that lies outside every effect limit.
+    std::vector<double> bandInner; //!< Inner edge of each band.
+    std::vector<double> bandOuter; //!< Outer edge of each band.
+    std::vector<double> bandDust; //!< 1 if the band has dust, 0 otherwise.
+    std::vector<double> bandGas; //!< 1 if the band has gas, 0 otherwise.
+    uint32_t bandCapacity = 0u; //!< Number of rows allocated.
+    uint32_t bandRows = 0u; //!< Number of rows in use by any lane.
+    uint32_t bandCount[LaneCount]; //!< Number of bands of each lane.
+
+    //--- System state, one entry per lane.
+    std::vector<Generator> generator; //!< The Generator of each lane.
+    std::vector<SolarSystem> system; //!< The system each lane is generating.
+    std::vector<ProtoplanetSeed> protoplanetSeeds[LaneCount]; //!< Protoplanet seeds of each lane's system.
+    size_t nextProtoplanetSeed[LaneCount]; //!< The next seed each lane applies.
+    uint64_t systemIndex[LaneCount]; //!< Index of each lane's system within the batch.
+    bool busy[LaneCount]; //!< Is the lane generating a system?
+
+    //--- Run state.
+    PreparedConfig config; //!< The Config of the current run, prepared with the batch's star.
+    const BatchSettings* settings = nullptr; //!< The settings of the current run.
+    const BatchGenerator::SystemCallback* callback = nullptr; //!< The callback of the current run.
+    uint64_t nextSystem = 0u; //!< The next system to assign to a lane.
+
+    uint64_t stepCount = 0u; //!< Lockstep iterations of the last run.
+    uint64_t laneStepCount = 0u; //!< Useful lane steps of the last run.
+
+    // Advance the lane until it is sweeping a protoplanet, finishing systems and starting new ones as
+    // needed.  Returns false if the lane has nothing left to do.
+    bool advance(uint32_t lane);
+
+    // Finish the lane's protoplanet once its sweep has converged: collect the mass, clear the dust
+    // lanes, and coalesce it with the planets.  A collision leaves the merged protoplanet sweeping.
+    void finishProtoplanet(uint32_t lane);
+
+    // Start sweeping a protoplanet in the lane.
+    void loadProtoplanet(uint32_t lane, double sma_, float eccentricity_, double mass_, double dustMass_, double gasMass_);
+
+    // Copy the lane's dust bands from its Generator into the band table.
+    void scatterBands(uint32_t lane);
+
+    // Perform one sweep of every lane that is sweeping.
+    void sweep();
+};
+
+}
+}
@@ -0,0 +1,290 @@
+/*****************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Questionable Coding
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************/
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace qc
+{
+
+namespace SystemGenerator
+{
+
+/// @brief A metric of a MetricsRegistry.  Metrics are created by the registry.
+class Metric
+{
+    public:
+
+    virtual ~Metric() { }
+
+    /// @brief Returns the help text.
+    const std::string& getHelp() const { return help; }
+
+    /// @brief Returns the labels, eg `phase="accretion"`, or an empty string.
+    const std::string& getLabels() const { return labels; }
+
+    /// @brief Returns the metric name.
+    const std::string& getName() const { return name; }
+
+    /// @brief Returns the Prometheus type name of the metric ("counter", "gauge" or "histogram").
+    virtual const char* getTypeName() const = 0;
+
+    /// @brief Append the samples of the metric in the Prometheus text format.
+    /// @param out The string to append to.
+    virtual void writeSamples(std::string& out) const = 0;
+
+    protected:
+
+    Metric(const char* name_, const char* help_, const char* labels_)
+        : name(name_)
+        , help(help_ ? help_ : "")
+        , labels(labels_ ? labels_ : "")
+    { }
+
+    std::string name; //!< The metric name.
+    std::string help; //!< The help text.
+    std::string labels; //!< The labels, without braces.
+};
+
+/// @brief A monotonically increasing count.
+class MetricCounter : public Metric
+{
+    public:
+
+    /// @brief Add to the count.
+    /// @param n The amount to add.
+    void add(uint64_t n = 1u) { value.fetch_add(n, std::memory_order_relaxed); }
+
+    /// @brief Returns the count.
+    uint64_t get() const { return value.load(std::memory_order_relaxed); }
+
+    const char* getTypeName() const override { return "counter"; }
+
+    void writeSamples(std::string& out) const override;
+
+    private:
+
+    MetricCounter(const char* name_, const char* help_, const char* labels_) :Metric(name_, help_, labels_) { }
+
+    std::atomic<uint64_t> value{ 0u }; //!< The count.
+
+    friend class MetricsRegistry;
+};
+
+/// @brief A value that may go up and down.
+class MetricGauge : public Metric
+{
+    public:
+
+    /// @brief Add to the value.
+    /// @param delta The amount to add.  May be negative.
+    void add(double delta);
+
+    /// @brief Returns the value.
+    double get() const;
+
+    const char* getTypeName() const override { return "gauge"; }
+
+    /// @brief Set the value.
+    /// @param v The value.
+    void set(double v);
+
+    void writeSamples(std::string& out) const override;
+
+    private:
+
+    MetricGauge(const char* name_, const char* help_, const char* labels_) :Metric(name_, help_, labels_) { }
+
+    std::atomic<uint64_t> bits{ 0u }; //!< Bit pattern of the double value.
+
+    friend class MetricsRegistry;
+};
+
+/// @brief Counts observations in buckets with fixed upper bounds.
+class MetricHistogram : public Metric
+{
+    public:
+
+    /// @brief Returns the upper bounds of the buckets, not counting the implicit +Inf bucket.
+    const std::vector<double>& getBounds() const { return bounds; }
+
+    /// @brief Returns the number of observations.
+    uint64_t getCount() const;
+
+    /// @brief Returns the sum of the observations.
+    double getSum() const;
+
+    const char* getTypeName() const override { return "histogram"; }
+
+    /// @brief Add an observation.
+    /// @param v The observed value.
+    void observe(double v);
+
+    void writeSamples(std::string& out) const override;
+
+    private:
+
+    MetricHistogram(const char* name_, const char* help_, const char* labels_, const std::vector<double>& bounds_);
+
+    std::vector<double> bounds; //!< Bucket upper bounds, ascending.
+    std::unique_ptr<std::atomic<uint64_t>[]> bucket; //!< Observations per bucket (not cumulative), the last is +Inf.
+    std::atomic<uint64_t> sumBits{ 0u }; //!< Bit pattern of the double sum.
+
+    friend class MetricsRegistry;
+};
+
+/// @brief Returns `count` bucket bounds growing geometrically from `start` by `factor`.
+/// @param start The first bound.  Must be greater than 0.
+/// @param factor The ratio between adjacent bounds.  Must be greater than 1.
+/// @param count The number of bounds.
+/// @return The bounds.
+std::vector<double> ExponentialBuckets(double start, double factor, uint32_t count);
+
+/// @brief Returns `count` bucket bounds spaced `width` apart from `start`.
+/// @param start The first bound.
+/// @param width The spacing.  Must be greater than 0.
+/// @param count The number of bounds.
+/// @return The bounds.
+std::vector<double> LinearBuckets(double start, double width, uint32_t count);
+
+/// @brief Holds the metrics of a service, and exports them in the Prometheus text format.
+///
+/// Metrics are created once, typically at startup, and live as long as the registry.  Creating metrics is
+/// serialized by a mutex; updating them only uses relaxed atomics, so any number of threads may update
+/// them without locking, and an export never blocks an update.  An export reads each value once, so a
+/// histogram exported while it is updated may be off by the observations in flight.
+///
+/// Metrics that share a name, with different labels, are exported under a single HELP and TYPE line and
+/// must have the same type.
+///
+/// The text can be written to a file, replaced atomically so a collector (such as the node_exporter
+/// textfile collector) never reads a partial file, or served on a Unix domain socket: every connection is
+/// answered with an HTTP/1.0 response holding the text, so `curl --unix-socket` or a proxy can scrape it.
+/// Serving is only available on POSIX systems.
+class MetricsRegistry
+{
+    public:
+
+    MetricsRegistry() { }
+    ~MetricsRegistry() { stopServing(); }
+
+    MetricsRegistry(const MetricsRegistry&) = delete;
+    MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+
+    /// @brief Create a counter.
+    /// @param name The metric name, eg "qcsysgen_systems_generated_total".
+    /// @param help The help text.
+    /// @param labels The labels without braces, eg `phase="accretion"`, or nullptr.
+    /// @return The counter.
+    MetricCounter& addCounter(const char* name, const char* help, const char* labels = nullptr);
+
+    /// @brief Create a gauge.
+    /// @param name The metric name.
+    /// @param help The help text.
+    /// @param labels The labels without braces, or nullptr.
+    /// @return The gauge.
+    MetricGauge& addGauge(const char* name, const char* help, const char* labels = nullptr);
+
+    /// @brief Create a histogram.
+    /// @param name The metric name.
+    /// @param help The help text.
+    /// @param bounds The bucket upper bounds, ascending.  The +Inf bucket is added.
+    /// @param labels The labels without braces, or nullptr.  Must not contain `le`.
+    /// @return The histogram.
+    MetricHistogram& addHistogram(const char* name, const char* help, const std::vector<double>& bounds, const char* labels = nullptr);
+
+    /// @brief Returns true while serve() is answering connections.
+    bool isServing() const { return listenSocket >= 0; }
+
+    /// @brief Answer every connection to a Unix domain socket with the metrics, on a background thread.
+    ///
+    /// An existing socket file at `path` is replaced.
+    /// @param path The socket path.
+    /// @return true on success.  Always false on platforms without Unix domain sockets.
+    bool serve(const char* path);
+
+    /// @brief Stop answering connections and remove the socket file.
+    void stopServing();
+
+    /// @brief Write every metric in the Prometheus text format.
+    /// @param out Receives the text.
+    void write(std::string& out) const;
+
+    /// @brief Write every metric in the Prometheus text format to a file.
+    ///
+    /// The text is written to `path` + ".tmp", which is then renamed to `path`.
+    /// @param path The file path.
+    /// @return true on success.
+    bool writeFile(const char* path) const;
+
+    private:
+
+    mutable std::mutex mutex; //!< Guards `metrics`.
+    std::vector<std::unique_ptr<Metric>> metrics; //!< The metrics, in the order they were created.
+
+    int listenSocket = -1; //!< The socket serve() listens on, or -1.
+    std::string socketPath; //!< The path of the socket.
+    std::thread server; //!< Answers the connections.
+
+    // Add a metric, checking that its name is not used by a metric of another type.
+    void add(Metric* metric);
+};
+
+/// @brief The standard metrics of a generation service.
+///
+/// Set BatchSettings::metrics to have the BatchGenerator update the system counters, latencies, planet
+/// counts and queue depth, and GenerationCache::setMetrics() to have a cache update the cache metrics.
+/// Latencies are in seconds.
+struct GenerationMetrics
+{
+    /// @brief Create the metrics in a registry.
+    /// @param registry The registry.
+    /// @param prefix The prefix of the metric names.
+    explicit GenerationMetrics(MetricsRegistry& registry, const char* prefix = "qcsysgen");
+
+    MetricCounter& systemsGenerated; //!< Systems generated and evaluated.
+    MetricCounter& systemsDiscarded; //!< Systems discarded by a filter before evaluation.
+    MetricCounter& systemsCancelled; //!< Systems not generated because their batch was cancelled.
+
+    MetricHistogram& accretionSeconds; //!< Time spent accreting each system, including the star and seeds.
+    MetricHistogram& evaluationSeconds; //!< Time spent evaluating each system.
+    MetricHistogram& planetsPerSystem; //!< Planets per generated system.
+
+    MetricGauge& queueDepth; //!< Systems of the running batches that no worker has claimed yet.
+
+    MetricCounter& cacheHits; //!< GenerationCache finds that hit.
+    MetricCounter& cacheMisses; //!< GenerationCache finds that missed.
+    MetricGauge& cacheBytes; //!< Size of the live entries of the GenerationCache.
+    MetricGauge& cacheEntries; //!< Number of live entries of the GenerationCache.
+};
+
+}
+}
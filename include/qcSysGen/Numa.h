@@ -0,0 +1,59 @@
+/*****************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Questionable Coding
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************/
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace qc
+{
+
+namespace SystemGenerator
+{
+
+/// @brief A NUMA node and the logical processors that belong to it.
+struct NumaNode
+{
+    uint32_t id; //!< The operating system's node number.
+    uint16_t group; //!< Processor group of the node's processors (Windows only; always 0 elsewhere).
+    std::vector<uint32_t> processor; //!< Logical processors of the node (within `group` on Windows).
+};
+
+/// @brief Returns the NUMA nodes that have processors.
+///
+/// On systems without NUMA support, or when the topology can't be read, a single node containing every
+/// processor is returned.
+/// @return The nodes, sorted by id.  Never empty.
+std::vector<NumaNode> GetNumaTopology();
+
+/// @brief Restrict the calling thread to the processors of a node.
+///
+/// Memory the thread touches first afterwards is normally allocated on the same node.
+/// @param node The node.
+/// @return true on success.
+bool PinThreadToNode(const NumaNode& node);
+
+}
+}
@@ -0,0 +1,220 @@
+/*****************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Questionable Coding
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************/
+#pragma once
+
+#include <cstdint>
+#include <stdio.h>
+#include <vector>
+
+namespace qc
+{
+
+namespace SystemGenerator
+{
+
+/// @brief The phases of generating a system that PhaseCounters measure.
+///
+/// Phases nest, and the counts of a phase exclude the phases nested within it: a protoplanet that
+/// collides with a planet re-enters Accretion from Coalescence, and the surface condition and gas
+/// stages of a planet are nested in Planet.
+enum class GenerationPhase : uint32_t
+{
+    Star, //!< Generating and evaluating the star.
+    Seeds, //!< Placing the protoplanet seeds.
+    Accretion, //!< Sweeping the dust bands, and finishing the planets' orbits.
+    Coalescence, //!< Colliding protoplanets with the planets, and adding new planets.
+    Planet, //!< Evaluating a planet, apart from the stages below.
+    SurfaceConditions, //!< Iterating a planet's surface conditions to convergence.
+    Gases, //!< Computing a planet's atmospheric composition.
+};
+
+/// @brief Number of GenerationPhase values.
+static constexpr uint32_t GenerationPhaseCount = 7u;
+
+/// @brief Returns the name of a GenerationPhase.
+/// @param phase The phase.
+/// @return The name, or "Unknown".
+const char* GenerationPhaseName(GenerationPhase phase);
+
+/// @brief The events PhaseCounters count.
+enum class PhaseCounter : uint32_t
+{
+    Cycles, //!< CPU cycles, user space only.
+    Instructions, //!< Instructions retired, user space only.
+    CacheMisses, //!< Last level cache misses.
+    BranchMisses, //!< Mispredicted branches.
+    Allocations, //!< Heap allocations, counted by the hook installed with PhaseCounters::SetAllocationCounter().
+};
+
+/// @brief Number of PhaseCounter values.
+static constexpr uint32_t PhaseCounterCount = 5u;
+
+/// @brief Returns the name of a PhaseCounter.
+/// @param counter The counter.
+/// @return The name, or "Unknown".
+const char* PhaseCounterName(PhaseCounter counter);
+
+/// @brief Counts hardware events and allocations per GenerationPhase.
+///
+/// Attach the counters to a Generator with Generator::setPhaseCounters(), or set
+/// BatchSettings::phaseCounters to count every worker of a batch.  A Generator without counters only
+/// pays a null-pointer test per phase change.
+///
+/// The hardware events use Linux `perf_event_open`, opened as one group on the calling thread, so
+/// every event is scheduled together and the counters only see the thread that opened them.  Events
+/// are counted in user space only, so the `read` of each phase change does not count against the
+/// phases.  On other platforms, or when the kernel refuses the events (see
+/// `/proc/sys/kernel/perf_event_paranoid`), open() fails and only allocations and phase entries are
+/// counted.
+///
+/// Allocations can not be counted by the library itself.  A program that wants them replaces the
+/// global `operator new`, counts into a thread-local variable, and installs a function returning it
+/// with SetAllocationCounter().
+class PhaseCounters
+{
+    public:
+
+    /// @brief Returns the calling thread's count of allocations.
+    typedef uint64_t (*AllocationCounter)();
+
+    PhaseCounters();
+    ~PhaseCounters() { close(); }
+
+    PhaseCounters(const PhaseCounters&) = delete;
+    PhaseCounters& operator=(const PhaseCounters&) = delete;
+
+    /// @brief Stop counting hardware events.
+    void close();
+
+    /// @brief Attribute the events since the last phase change to the current phase, and enter `phase`.
+    /// @param phase The phase.
+    void enter(GenerationPhase phase);
+
+    /// @brief Returns the count of an event in a phase.
+    /// @param phase The phase.
+    /// @param counter The event.
+    /// @return The count.
+    uint64_t get(GenerationPhase phase, PhaseCounter counter) const { return count[static_cast<uint32_t>(phase)][static_cast<uint32_t>(counter)]; }
+
+    /// @brief Returns the number of times a phase was entered.
+    /// @param phase The phase.
+    /// @return The entry count.
+    uint64_t getEntries(GenerationPhase phase) const { return entries[static_cast<uint32_t>(phase)]; }
+
+    /// @brief Returns true if an event is counted.
+    /// @param counter The event.
+    /// @return true if the hardware counter is open, or, for Allocations, an allocation counter is installed.
+    bool isCounting(PhaseCounter counter) const;
+
+    /// @brief Attribute the events since the last phase change to the current phase, and return to the
+    /// phase it was entered from.
+    void leave();
+
+    /// @brief Add the counts of another PhaseCounters to this one.
+    /// @param rhs The counters to merge.
+    void merge(const PhaseCounters& rhs);
+
+    /// @brief Open the hardware counters for the calling thread.
+    ///
+    /// Only the calling thread is counted, so the counters must be opened on the thread that generates
+    /// the systems.  Any counts are kept.
+    /// @return true if at least one hardware event is counted.
+    bool open();
+
+    /// @brief Write the counts of every phase, and the derived rates, as text.
+    /// @param fp The output stream.
+    void report(FILE* fp) const;
+
+    /// @brief Clear the counts.
+    void reset();
+
+    /// @brief Install the function that returns the calling thread's allocation count.
+    /// @param counter The function, or nullptr to stop counting allocations.
+    static void SetAllocationCounter(AllocationCounter counter);
+
+    private:
+
+    int groupFd; //!< perf_event file descriptor of the group leader, or -1.
+    int eventFd[PhaseCounterCount]; //!< perf_event file descriptor of each hardware event, or -1.
+    uint32_t eventSlot[PhaseCounterCount]; //!< Position of each open event in the group's read format.
+    uint32_t openCount; //!< Number of hardware events in the group.
+    uint32_t countedMask; //!< Bit set of the PhaseCounter values counted by the counters that were merged.
+
+    uint64_t last[PhaseCounterCount]; //!< Counter values at the last phase change.
+    uint64_t count[GenerationPhaseCount][PhaseCounterCount]; //!< Counts per phase.
+    uint64_t entries[GenerationPhaseCount]; //!< Entries per phase.
+
+    std::vector<GenerationPhase> stack; //!< The phases entered and not yet left, innermost last.
+
+    // Read the counters, add the events since the last phase change to the current phase, and update `last`.
+    void sample();
+};
+
+/// @brief Enters a phase for the lifetime of the object.  Does nothing without PhaseCounters.
+class PhaseScope
+{
+    public:
+
+    /// @brief Constructor.
+    /// @param counters_ The counters, or nullptr.
+    /// @param phase The phase to enter.
+    PhaseScope(PhaseCounters* counters_, GenerationPhase phase)
+        : counters(counters_)
+    {
+        if (counters)
+        {
+            counters->enter(phase);
+        }
+    }
+
+    ~PhaseScope()
+    {
+        if (counters)
+        {
+            counters->leave();
+        }
+    }
+
+    PhaseScope(const PhaseScope&) = delete;
+    PhaseScope& operator=(const PhaseScope&) = delete;
+
+    /// @brief Leave the current phase of the scope and enter another one.
+    /// @param phase The phase to enter.
+    void change(GenerationPhase phase)
+    {
+        if (counters)
+        {
+            counters->leave();
+            counters->enter(phase);
+        }
+    }
+
+    private:
+
+    PhaseCounters* counters; //!< The counters, or nullptr.
+};
+
+}
+}
@@ -122,6 +122,19 @@ class Planet
     /// @return The ESI, in the range [0.0, 1.0].
     float getEarthSimilarityIndex() const { return earthSimilarityIndex; }
 
+    /// @brief Returns an upper bound on the Earth Similarity Index this planet can reach once it is evaluated.
+    /// 
+    /// This is intended to be called on an unevaluated planet (after Generator::accrete()), so a caller
+    /// can skip evaluating systems that cannot contain an interesting planet.  It only uses the mass and
+    /// orbit of the planet, so it is much cheaper than evaluate().  The radius, density, and escape velocity
+    /// terms of the ESI are bounded using the range of radii the planet can end up with (density variation
+    /// and loss of hydrogen and helium included); the temperature and atmosphere terms are assumed to be
+    /// ideal.
+    /// @param star The star at the center of the SolarSystem.  It must have been evaluated.
+    /// @param densityVariation The Config::densityVariation used to generate the planet.
+    /// @return A value in the range [0.0, 1.0] that is never less than the ESI computed by evaluate().
+    float getEarthSimilarityLimit(const Star& star, float densityVariation) const;
+
     /// @brief Returns the orbital eccentricity.
     /// @return Eccentricity.
     float getEccentricity() const { return eccentricity; }
@@ -237,8 +250,12 @@ class Planet
         boilingPoint = 0.0f;
         volatileGasInventory = 0.0;
         periapsis = apoapsis = 0.0;
+        resonant = false;
         runawayGreenhouse = false;
         surfacePressure = 0.0f;
+        meanSurfaceTemperature = 0.0f;
+        hydrosphere = iceCoverage = cloudCoverage = 0.0f;
+        earthSimilarityIndex = 0.0f;
         evaluated = false;
     }
 
@@ -253,6 +270,7 @@ class Planet
 
     private:
     friend class Generator;
+    friend class PlanetView;
 
     std::string name; //!< Name of the planet.
 
@@ -0,0 +1,92 @@
+/*****************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Questionable Coding
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************/
+#pragma once
+
+#include "Enums.h"
+#include "Star.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace qc
+{
+
+namespace SystemGenerator
+{
+
+class Planet;
+class SolarSystem;
+
+/// @brief The commonly queried attributes of a set of planets, stored as one array per attribute.
+///
+/// Each planet occupies the same row in every column.  Enumerations are stored as uint8_t, and all
+/// of the physical quantities are stored as floats in the units listed below, so that queries can
+/// sweep a column without touching the others.
+struct PlanetColumns
+{
+    std::vector<uint32_t> system; //!< Row of the owning system (see Catalog::getSystems()).
+    std::vector<uint8_t> ordinal; //!< 1-based position of the planet in its SolarSystem.
+    std::vector<uint8_t> starClass; //!< StarClassification of the central star.
+    std::vector<uint8_t> planetType; //!< PlanetType of the planet.
+    std::vector<uint8_t> orbitalZone; //!< OrbitalZone of the planet.
+    std::vector<float> semimajorAxis; //!< Semimajor axis, in AU.
+    std::vector<float> mass; //!< Total mass, in Earth masses.
+    std::vector<float> radius; //!< Radius, in km.
+    std::vector<float> earthSimilarityIndex; //!< Earth Similarity Index, [0, 1].
+    std::vector<float> surfaceTemperature; //!< Mean surface temperature, in Kelvin.
+    std::vector<float> hydrosphere; //!< Liquid water coverage, [0, 1].
+    std::vector<float> surfacePressure; //!< Surface pressure, in millibars.
+
+    /// @brief Append one planet to the columns.
+    /// @param systemRow The row of the planet's system.
+    /// @param ordinal_ The 1-based position of the planet in its SolarSystem.
+    /// @param starClass_ The classification of the central star.
+    /// @param planet The planet.  It must have been evaluated.
+    void append(uint32_t systemRow, uint32_t ordinal_, StarClassification starClass_, const Planet& planet);
+
+    /// @brief Append every planet of a system.
+    /// @param systemRow The row of the system.
+    /// @param solarSystem The system.  It must have been evaluated.
+    void append(uint32_t systemRow, const SolarSystem& solarSystem);
+
+    /// @brief Append every row of another set of columns.
+    /// @param rhs The columns to append.
+    /// @param systemOffset Added to each appended `system` value.
+    void append(const PlanetColumns& rhs, uint32_t systemOffset);
+
+    /// @brief Remove all rows.
+    void clear();
+
+    /// @brief Reserve space for `count` rows in every column.
+    /// @param count The number of rows.
+    void reserve(size_t count);
+
+    /// @brief Returns the number of rows.
+    /// @return The row count.
+    size_t size() const { return system.size(); }
+};
+
+}
+}
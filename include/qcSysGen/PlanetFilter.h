@@ -0,0 +1,144 @@
+/*****************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Questionable Coding
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************/
+#pragma once
+
+#include "PlanetColumns.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace qc
+{
+
+namespace SystemGenerator
+{
+
+/// @brief A predicate over the rows of PlanetColumns, compiled from a text expression.
+///
+/// Expressions combine comparisons with `&&`, `||`, `!` and parentheses, for example
+///
+///     type == Terrestrial && esi > 0.85 && temp in [270, 310]
+///     star in {G_V, K_V} && (type == Ocean || hydro >= 0.5)
+///
+/// Numeric fields are `sma` (AU), `mass` (Earth masses), `radius` (km), `esi`, `temp` (K), `hydro`
+/// ([0, 1]) and `pressure` (mb).  They support `==`, `!=`, `<`, `<=`, `>`, `>=` and `in [lower, upper]`
+/// (inclusive).  Enumerated fields are `star` (StarClassification), `type` (PlanetType) and `zone`
+/// (OrbitalZone).  They support `==`, `!=` and `in {a, b, ...}`, using the enumerator names.
+///
+/// compile() reduces every comparison to either a range test on a float column or a set test on an
+/// enumerated column, and arranges them into a postfix program.  select() runs the program over
+/// fixed-size chunks of rows, one instruction at a time across the whole chunk, so each step is a
+/// tight loop over a single column instead of a call per planet.
+///
+/// The same PlanetColumns type is used by the Catalog, and can be filled with
+/// PlanetColumns::append(uint32_t, const SolarSystem&) from a BatchGenerator callback, so one compiled
+/// filter serves both stored catalogs and systems as they are generated.
+///
+/// A compiled PlanetFilter is immutable, and select() may be called from several threads at once.
+class PlanetFilter
+{
+    public:
+
+    /// @brief Number of rows processed by each pass of the program.
+    static constexpr uint32_t ChunkSize = 256u;
+
+    PlanetFilter() { }
+    ~PlanetFilter() { }
+
+    /// @brief Compile an expression.
+    /// @param expression The expression.
+    /// @param error If not null, receives a description of the problem when compilation fails.
+    /// @return true on success.  On failure the filter is invalid and matches no rows.
+    bool compile(const char* expression, std::string* error = nullptr);
+
+    /// @brief Returns true if the filter has been compiled successfully.
+    /// @return true if the filter is valid.
+    bool isValid() const { return !program.empty(); }
+
+    /// @brief Find the rows that match the filter.
+    /// @param planets The columns to filter.
+    /// @param rows Receives the matching rows, in ascending order.
+    void select(const PlanetColumns& planets, std::vector<uint32_t>& rows) const { select(planets, 0u, planets.size(), rows); }
+
+    /// @brief Find the rows in [first, last) that match the filter.
+    /// @param planets The columns to filter.
+    /// @param first The first row to test.
+    /// @param last One past the last row to test.
+    /// @param rows Receives the matching rows, in ascending order.
+    void select(const PlanetColumns& planets, size_t first, size_t last, std::vector<uint32_t>& rows) const;
+
+    private:
+
+    /// @brief The columns a program can read.
+    enum class Field : uint8_t
+    {
+        StarClass,
+        PlanetType,
+        OrbitalZone,
+        SemimajorAxis,
+        Mass,
+        Radius,
+        EarthSimilarityIndex,
+        SurfaceTemperature,
+        Hydrosphere,
+        SurfacePressure,
+    };
+
+    /// @brief Program operations.
+    enum class Opcode : uint8_t
+    {
+        InRange, //!< Push (lower <= column <= upper).
+        InSet, //!< Push ((set >> column) & 1).
+        And, //!< Pop two, push both.
+        Or, //!< Pop two, push either.
+        Not, //!< Invert the top of the stack.
+    };
+
+    /// @brief One step of a compiled program.
+    struct Instruction
+    {
+        Opcode op;
+        Field field;
+        uint32_t set; //!< Enumerator mask for InSet.
+        float lower; //!< Lower bound for InRange.
+        float upper; //!< Upper bound for InRange.
+    };
+
+    std::vector<Instruction> program; //!< The postfix program.  Empty if not compiled.
+    uint32_t stackDepth = 0u; //!< Largest stack depth the program needs.
+
+    // Recursive descent parser.  Each method appends to `program` and advances `cursor`.
+    bool parseOr(const char*& cursor, std::string& error, uint32_t& depth);
+    bool parseAnd(const char*& cursor, std::string& error, uint32_t& depth);
+    bool parseUnary(const char*& cursor, std::string& error, uint32_t& depth);
+    bool parseComparison(const char*& cursor, std::string& error, uint32_t& depth);
+
+    // Record that one more value was pushed on the stack.
+    void push(uint32_t& depth);
+};
+
+}
+}
@@ -0,0 +1,136 @@
+/*****************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Questionable Coding
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************/
+#pragma once
+
+#include "Config.h"
+#include "SeedStrategy.h"
+#include "Star.h"
+
+namespace qc
+{
+
+namespace SystemGenerator
+{
+
+/// @brief A Config that has been validated and normalized once, for reuse across many systems.
+///
+/// Generator::generate() and friends copy the Config they are given and normalize it before every
+/// system.  A PreparedConfig does that work once: it holds the normalized settings, resolves the
+/// SeedStrategy, remembers whether any of the protoplanet seeds need a random eccentricity, and, when
+/// it is prepared with a Star and Config::generateStar is false, holds the evaluated star, the
+/// star-dependent constants used by the accretion equations and the strategy's seed layout.  The Generator only keeps a pointer to it, so passing a PreparedConfig
+/// costs nothing per system.
+///
+/// A PreparedConfig must outlive any accretion that uses it, and must not be re-prepared while a
+/// Generator is using it.  Generating with a PreparedConfig gives exactly the same systems as
+/// generating with the Config it was prepared from.
+class PreparedConfig
+{
+    public:
+
+    PreparedConfig() { }
+
+    /// @brief Constructor.  See prepare(const Config&).
+    /// @param config_ The Config.
+    explicit PreparedConfig(const Config& config_) { prepare(config_); }
+
+    /// @brief Constructor.  See prepare(const Config&, const Star&).
+    /// @param config_ The Config.
+    /// @param star_ The star every system will use.
+    PreparedConfig(const Config& config_, const Star& star_) { prepare(config_, star_); }
+
+    ~PreparedConfig() { }
+
+    /// @brief Returns the normalized Config.
+    /// @return The Config.
+    const Config& getConfig() const { return config; }
+
+    /// @brief Returns the critical limit scalar of the prepared star.  Only valid if hasStar().
+    /// @return CriticalLimitScalar() of the star's luminosity.
+    double getCriticalLimitScalar() const { return criticalLimitScalar; }
+
+    /// @brief Returns the dust density scalar of the prepared star.  Only valid if hasStar().
+    /// @return DustDensityScalar() of the star's mass.
+    double getDustDensityScalar() const { return dustDensityScalar; }
+
+    /// @brief Returns the seed layout of the prepared star.  Only valid if hasStar() and getSeedStrategy()
+    /// is not nullptr.
+    /// @return The layout.
+    const SeedLayout& getSeedLayout() const { return seedLayout; }
+
+    /// @brief Returns the strategy that places the seeds when Config::protoplanetSeeds is empty.
+    ///
+    /// This is Config::seedStrategy, or a BodeSeedStrategy if it is not set and Config::generateBodeSeeds is true.
+    /// @return The strategy, or nullptr.
+    const SeedStrategy* getSeedStrategy() const { return seedStrategy; }
+
+    /// @brief Returns the prepared star.  Only valid if hasStar().
+    /// @return The evaluated Star.
+    const Star& getStar() const { return star; }
+
+    /// @brief Indicates whether any of Config::protoplanetSeeds has an eccentricity that has to be
+    /// replaced by a random one.
+    /// @return true if the seeds need random eccentricities.
+    bool hasRandomSeedEccentricity() const { return randomSeedEccentricity; }
+
+    /// @brief Indicates whether the star-dependent values were prepared.
+    ///
+    /// When true, systems using the star returned by getStar() skip the star-dependent work; the values are
+    /// computed as usual for a system with any other star.
+    /// @return true if a star was prepared.
+    bool hasStar() const { return starPrepared; }
+
+    /// @brief Prepare a Config without a star.
+    ///
+    /// The star-dependent values are computed for every system, as they are when generating with a Config.
+    /// @param config_ The Config.
+    void prepare(const Config& config_);
+
+    /// @brief Prepare a Config and the star used by every system.
+    ///
+    /// The star is ignored when Config::generateStar is true, since every system generates its own.
+    /// @param config_ The Config.
+    /// @param star_ The star every system will use.
+    void prepare(const Config& config_, const Star& star_);
+
+    private:
+
+    Config config; //!< The normalized Config.
+
+    const SeedStrategy* seedStrategy = nullptr; //!< The resolved seed strategy.
+
+    Star star; //!< The evaluated star, if starPrepared.
+
+    SeedLayout seedLayout; //!< The seed strategy's layout for the star, if starPrepared.
+
+    double criticalLimitScalar = 0.0; //!< CriticalLimitScalar() of the star.
+    double dustDensityScalar = 0.0; //!< DustDensityScalar() of the star.
+
+    bool randomSeedEccentricity = false; //!< Do any protoplanet seeds need a random eccentricity?
+    bool starPrepared = false; //!< Were the star-dependent values prepared?
+};
+
+}
+}
@@ -0,0 +1,168 @@
+/*****************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Questionable Coding
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************/
+#pragma once
+
+#include "SystemRecord.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace qc
+{
+
+namespace SystemGenerator
+{
+
+/// @brief The precision a RecordEncoder keeps for each kind of value.
+///
+/// Values with a wide range are kept to a relative precision: their floating point mantissa is rounded to
+/// the given number of bits, so the relative error is at most 2^-(bits + 1).  Values with a narrow range are
+/// rounded to a fixed step.  Float fields keep at most their own 23 mantissa bits.
+struct RecordCodecPrecision
+{
+    uint32_t orbitBits = 28u; //!< Mantissa bits of semimajor axes, apsides and the star's distances.
+    uint32_t massBits = 20u; //!< Mantissa bits of masses, and of the star's mass, luminosity, radius and age.
+    uint32_t sizeBits = 16u; //!< Mantissa bits of radius, density, gravity, pressure, sphere of influence and gas fractions.
+    uint32_t fractionBits = 16u; //!< Coverages and ESI are rounded to multiples of 1 / (2^fractionBits - 1).
+    float temperatureStep = 0.01f; //!< Temperatures are rounded to multiples of this, in Kelvin.
+    float eccentricityStep = 1.0e-6f; //!< Eccentricities are rounded to multiples of this.
+    float inclinationStep = 1.0e-4f; //!< Inclinations are rounded to multiples of this, in degrees.
+};
+
+/// @brief The header at the start of a compressed record stream.  Fixed layout, in host byte order.
+struct RecordStreamHeader
+{
+    static constexpr uint32_t Magic = 0x43524351u; //!< "QCRC".
+    static constexpr uint32_t CodecVersion = 1u; //!< Version of the encoding.
+
+    uint32_t magic; //!< Magic.
+    uint32_t version; //!< CodecVersion.
+    RecordCodecPrecision precision; //!< The precision the stream was encoded with.
+
+    /// @brief Build the header of a stream.
+    /// @param precision_ The precision.
+    /// @return The header.
+    static RecordStreamHeader Make(const RecordCodecPrecision& precision_);
+
+    /// @brief Returns true if the header is one this version can decode.
+    bool isValid() const { return magic == Magic && version == CodecVersion; }
+};
+
+/// @brief The header of a block of compressed records.  Deltas restart at every block, so each block can be
+/// decoded on its own.
+struct RecordBlockHeader
+{
+    uint32_t size; //!< Size of the encoded records that follow, in bytes.
+    uint32_t recordCount; //!< Number of records in the block.
+};
+
+/// @brief Compresses SystemRecords.
+///
+/// Each record is stored as a planet count, the seed and systemIndex as deltas from the previous record,
+/// the star, then each planet.  Planets are sorted by semimajor axis, so most planet fields are stored as
+/// the difference from the same field of the previous planet, as zigzag varints.  The planet type, orbital
+/// zone and two flags share one byte, and the atmosphere is a bitmask of the gases present followed by
+/// their fractions.  Apsides and total mass are only stored when they cannot be derived from the
+/// semimajor axis and eccentricity, and the dust and gas masses.
+///
+/// A typical evaluated system shrinks to about a quarter of its SystemRecord.  Encoding uses no
+/// transcendental functions; quantizing a relative value is a rounding shift of its bits.
+class RecordEncoder
+{
+    public:
+
+    /// @brief Constructor.
+    /// @param precision_ The precision.
+    explicit RecordEncoder(const RecordCodecPrecision& precision_ = RecordCodecPrecision());
+
+    /// @brief Encode a record.
+    /// @param record The record.
+    /// @param out The destination, with room for at least GetMaxSize(record.planetCount) bytes.
+    /// @return The number of bytes written.
+    size_t encode(const SystemRecord& record, uint8_t* out);
+
+    /// @brief Returns the precision.
+    const RecordCodecPrecision& getPrecision() const { return precision; }
+
+    /// @brief Returns the largest encoded size of a record.
+    /// @param planetCount The number of planets of the record.
+    /// @return The size, in bytes.
+    static size_t GetMaxSize(uint32_t planetCount);
+
+    /// @brief Restart the deltas, at the start of a block.
+    void reset() { previousSeed = previousIndex = 0u; }
+
+    private:
+
+    RecordCodecPrecision precision; //!< The precision.
+    uint64_t previousSeed = 0u; //!< Seed of the previous record of the block.
+    uint64_t previousIndex = 0u; //!< systemIndex of the previous record of the block.
+};
+
+/// @brief Decompresses the records written by a RecordEncoder with the same precision.
+class RecordDecoder
+{
+    public:
+
+    /// @brief Constructor.
+    /// @param precision_ The precision the records were encoded with.
+    explicit RecordDecoder(const RecordCodecPrecision& precision_ = RecordCodecPrecision());
+
+    /// @brief Decode a record.
+    /// @param data The encoded record.
+    /// @param size The number of bytes available at `data`.
+    /// @param record The destination.  Must be 8-byte aligned.
+    /// @param recordSize The size of `record`, at least GetDecodedSize().
+    /// @return The number of bytes consumed, or 0 if the data is truncated or invalid, or `record` is too small.
+    size_t decode(const uint8_t* data, size_t size, void* record, size_t recordSize);
+
+    /// @brief Returns the precision.
+    const RecordCodecPrecision& getPrecision() const { return precision; }
+
+    /// @brief Returns the size of the SystemRecord an encoded record decodes to.
+    /// @param data The encoded record.
+    /// @param size The number of bytes available at `data`.
+    /// @return The size, in bytes, or 0 if the data is truncated or invalid.
+    static size_t GetDecodedSize(const uint8_t* data, size_t size);
+
+    /// @brief Restart the deltas, at the start of a block.
+    void reset() { previousSeed = previousIndex = 0u; resuming = false; }
+
+    /// @brief Continue decoding in the middle of a block, at a record whose seed and systemIndex are known,
+    /// such as one found through a seek index.
+    /// @param seed The seed of the next record.
+    /// @param systemIndex The systemIndex of the next record.
+    void resume(uint64_t seed, uint64_t systemIndex) { previousSeed = seed; previousIndex = systemIndex; resuming = true; }
+
+    private:
+
+    RecordCodecPrecision precision; //!< The precision.
+    uint64_t previousSeed = 0u; //!< Seed of the previous record of the block, or of the next one when resuming.
+    uint64_t previousIndex = 0u; //!< systemIndex of the previous record of the block, or of the next one when resuming.
+    bool resuming = false; //!< Set by resume(): the next record's deltas are ignored.
+};
+
+}
+}
@@ -0,0 +1,186 @@
+/*****************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Questionable Coding
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************/
+#pragma once
+
+#include "RecordCodec.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace qc
+{
+
+namespace SystemGenerator
+{
+
+struct SystemRecord;
+
+/// @brief An entry of the seek index of a record file: a run of records with consecutive seeds and
+/// systemIndex values, stored one after the other within one block.  Fixed layout, in host byte order.
+struct RecordSeekEntry
+{
+    uint64_t seed; //!< The seed of the first record.
+    uint64_t systemIndex; //!< The systemIndex of the first record.
+    uint64_t offset; //!< File offset of the first record.
+    uint32_t recordCount; //!< Number of records in the run.
+    uint32_t reserved; //!< Padding.  Always 0.
+};
+
+/// @brief The end of a record file with a seek index.  Fixed layout, in host byte order.
+///
+/// The index is two copies of the entries, one sorted by seed and one sorted by systemIndex, each starting
+/// on a page boundary, followed by the fences: the first key of every page of entries, for the seed order
+/// then for the systemIndex order.  The fences are small enough to be kept in memory, so a lookup reads one
+/// page of entries and the pages of the records it decodes.
+struct RecordSeekTrailer
+{
+    static constexpr uint64_t Magic = 0x31304b4545534351u; //!< "QCSEEK01".
+    static constexpr uint32_t SeekVersion = 1u; //!< Version of the index.
+    static constexpr uint32_t PageSize = 4096u; //!< Alignment of the entry arrays.
+    static constexpr uint32_t EntriesPerPage = PageSize / sizeof(RecordSeekEntry); //!< Entries per fence.
+
+    uint64_t dataSize; //!< End of the records, from the start of the file.
+    uint64_t entryCount; //!< Number of entries in each order.
+    uint64_t seedOffset; //!< File offset of the entries sorted by seed.
+    uint64_t indexOffset; //!< File offset of the entries sorted by systemIndex.
+    uint64_t fenceOffset; //!< File offset of the fences.
+    uint32_t interval; //!< The largest recordCount of an entry.
+    uint32_t version; //!< SeekVersion.
+    uint64_t magic; //!< Magic.  Last, so it ends the file.
+
+    /// @brief Returns the number of fences of each order.
+    uint64_t getFenceCount() const { return (entryCount + EntriesPerPage - 1u) / EntriesPerPage; }
+};
+
+/// @brief Random access to a file written by a RecordWriter.
+///
+/// The file is memory mapped.  When it ends with a seek index (see RecordWriterSettings::seekInterval), a
+/// record is found by seed or by systemIndex with binary searches, first over the fences held in memory,
+/// then over one page of entries.  The record is then reached from the start of its run: in place for
+/// plain records, or by decoding at most RecordSeekTrailer::interval records for compressed ones.  Only the
+/// pages of the entries and records visited are read, which keeps lookups cheap when the file is not in the
+/// page cache.
+///
+/// A reader holds the record it decoded last, so it must only be used by one thread at a time; open one
+/// reader per thread to share a file.  Use a RecordCursor to read every record in file order, and a
+/// SystemView to read the fields of a record.  POSIX only; on other platforms open() fails.
+class RecordFileReader
+{
+    public:
+
+    RecordFileReader();
+    ~RecordFileReader();
+
+    RecordFileReader(const RecordFileReader&) = delete;
+    RecordFileReader& operator=(const RecordFileReader&) = delete;
+
+    /// @brief Unmap the file.
+    void close();
+
+    /// @brief Look a record up by seed.
+    ///
+    /// When several batches of a file share a seed, one of their records is returned.
+    /// @param seed The seed the system was generated from.
+    /// @return The record, or nullptr if it is not in the index.  A compressed record is decoded into the
+    /// reader and remains valid until the next lookup; a plain one points into the mapping.
+    const SystemRecord* findSeed(uint64_t seed);
+
+    /// @brief Look a record up by systemIndex.
+    /// @param systemIndex The index of the system within its batch.
+    /// @return The record, or nullptr if it is not in the index.  See findSeed().
+    const SystemRecord* findSystemIndex(uint64_t systemIndex);
+
+    /// @brief Returns the number of seek index entries, or 0 if the file has no index.
+    uint64_t getSeekEntryCount() const { return seekEntryCount; }
+
+    /// @brief Returns true if the records are compressed.
+    bool isCompressed() const { return compressed; }
+
+    /// @brief Returns true if a file is mapped.
+    bool isOpen() const { return map != nullptr; }
+
+    /// @brief Map a file written by a RecordWriter.
+    /// @param path The file.
+    /// @return true on success, even if the file has no seek index.
+    bool open(const char* path);
+
+    private:
+    friend class RecordCursor;
+
+    const uint8_t* map = nullptr; //!< The mapped file.
+    size_t mapSize = 0u; //!< Size of `map`.
+    size_t dataBegin = 0u; //!< Offset of the first record.
+    size_t dataEnd = 0u; //!< Offset following the last record.
+    bool compressed = false; //!< Set if the file starts with a RecordStreamHeader.
+
+    const RecordSeekEntry* seedEntries = nullptr; //!< The entries sorted by seed.
+    const RecordSeekEntry* indexEntries = nullptr; //!< The entries sorted by systemIndex.
+    uint64_t seekEntryCount = 0u; //!< Number of entries in each order.
+    uint32_t seekInterval = 0u; //!< The largest recordCount of an entry.
+    std::vector<uint64_t> seedFences; //!< The first seed of each page of `seedEntries`.
+    std::vector<uint64_t> indexFences; //!< The first systemIndex of each page of `indexEntries`.
+
+    RecordDecoder decoder; //!< Decodes compressed records.
+    std::vector<uint64_t> scratch; //!< The last record decoded.
+
+    // Find the entry covering a key in one order, and read the record.
+    const SystemRecord* find(const RecordSeekEntry* entries, const std::vector<uint64_t>& fences, uint64_t RecordSeekEntry::* key, uint64_t value);
+
+    // Read the record at a position within the run of an entry.
+    const SystemRecord* read(const RecordSeekEntry& entry, uint64_t position);
+};
+
+/// @brief Reads the records of a RecordFileReader in file order.
+///
+/// Plain records are returned in place, so iterating a plain file allocates nothing and only reads the
+/// record headers; the fields of the star and planets are read when a SystemView asks for them.
+/// Compressed records are decoded one at a time into the cursor.  Several cursors may iterate one reader
+/// at once, each on its own thread.
+class RecordCursor
+{
+    public:
+    /// @brief Constructor.  The cursor starts at the first record.
+    /// @param file_ The file.  It must stay open while the cursor is used.
+    explicit RecordCursor(const RecordFileReader& file_);
+
+    /// @brief Read the next record.
+    /// @return The record, or nullptr after the last one or at a corrupt one.  A compressed record remains
+    /// valid until the next call; a plain one points into the mapping.
+    const SystemRecord* next();
+
+    /// @brief Go back to the first record.
+    void rewind();
+
+    private:
+    const RecordFileReader& file; //!< The file.
+    size_t position = 0u; //!< Offset of the next record, or of the next block header.
+    size_t blockEnd = 0u; //!< Offset of the end of the current compressed block.
+    RecordDecoder decoder; //!< Decodes compressed records.
+    std::vector<uint64_t> scratch; //!< The last record decoded.
+};
+
+}
+}
@@ -0,0 +1,246 @@
+/*****************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Questionable Coding
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************/
+#pragma once
+
+#include "RecordCodec.h"
+#include "RecordFile.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace qc
+{
+
+namespace SystemGenerator
+{
+
+class SolarSystem;
+
+/// @brief How a RecordWriter performs its writes.
+enum class RecordWriterBackend
+{
+    IoUring, //!< Asynchronous writes submitted through a Linux io_uring.
+    ThreadPool, //!< pwrite() from a pool of I/O threads.
+};
+
+/// @brief Configures a RecordWriter.
+struct RecordWriterSettings
+{
+    /// @brief The number of producers appending records, such as the workers of a BatchGenerator.
+    uint32_t producerCount = 1u;
+
+    /// @brief When true, the file holds the records in systemIndex order (which is seed order within a
+    /// batch), whatever order the producers append them in.
+    ///
+    /// Every index from `firstIndex` on must then be either appended or skipped.
+    bool ordered = false;
+
+    /// @brief The first systemIndex of the file when `ordered` is true.
+    uint64_t firstIndex = 0u;
+
+    /// @brief Size of each output buffer, in bytes.  Every record must fit in one buffer.
+    size_t bufferSize = 1u << 20;
+
+    /// @brief The largest number of full buffers queued or being written at once.
+    ///
+    /// When every one of them is in flight, producers wait for a write to complete.
+    uint32_t buffersInFlight = 8u;
+
+    /// @brief When true, io_uring is used if the kernel supports it.
+    bool useIoUring = true;
+
+    /// @brief The number of I/O threads of the ThreadPool backend.
+    uint32_t ioThreadCount = 4u;
+
+    /// @brief When true, the records are compressed with a RecordEncoder by the producers.
+    ///
+    /// The file then starts with a RecordStreamHeader, followed by blocks, each a RecordBlockHeader and its
+    /// encoded records.  A block is an output buffer of one producer, or a chunk in ordered mode.
+    bool compress = false;
+
+    /// @brief The precision of compressed records.
+    RecordCodecPrecision precision;
+
+    /// @brief When nonzero, close() appends a seek index to the file, with an entry at least every
+    /// `seekInterval` records, so RecordFileReader can find a record by seed or systemIndex.
+    ///
+    /// Smaller intervals make lookups of compressed records decode less, at the cost of a larger index.
+    uint32_t seekInterval = 0u;
+};
+
+/// @brief Writes a stream of SystemRecords to a file without stalling the producers on I/O.
+///
+/// Each producer serializes its systems straight into a buffer of its own.  Full buffers are handed to the
+/// I/O backend and the producer carries on with a fresh one, so a producer only waits when
+/// RecordWriterSettings::buffersInFlight writes are already outstanding.  The buffers are page aligned and
+/// allocated once, when the file is opened.
+///
+/// The backend is a Linux io_uring, driven by one thread that keeps every outstanding write submitted at
+/// once, or, when io_uring is not available, a pool of threads calling pwrite().  Either way the writes
+/// complete in any order; their file offsets are assigned when the buffers are handed over.
+///
+/// In ordered mode, records are staged in per-producer chunks covering runs of consecutive systemIndex
+/// values.  A chunk is sealed when the producer's next index is not the following one, and sealed chunks are
+/// packed into the output buffers in index order as soon as the run before them is complete.  Producers
+/// never wait for each other: a chunk that arrives early is kept until the chunks before it arrive.
+///
+/// The file is a plain concatenation of SystemRecords, or a compressed record stream (see
+/// RecordWriterSettings::compress), optionally followed by a seek index (see RecordSeekTrailer).  The index
+/// entries are collected as the records are appended, and sorted when the file is closed.  Each producer must
+/// only be used by one thread at a time.  POSIX only; on other platforms open() fails.
+class RecordWriter
+{
+    public:
+
+    RecordWriter();
+    ~RecordWriter();
+
+    RecordWriter(const RecordWriter&) = delete;
+    RecordWriter& operator=(const RecordWriter&) = delete;
+
+    /// @brief Serialize a system into the file.
+    /// @param producer The producer index [0, RecordWriterSettings::producerCount).
+    /// @param seed The seed the system was generated from.
+    /// @param systemIndex The index of the system within its batch.
+    /// @param system The evaluated system.
+    /// @return false if the record does not fit in a buffer, the writer is not open, or a write failed.
+    /// With compression, the bound on the encoded size must fit (see RecordEncoder::GetMaxSize()).
+    bool append(uint32_t producer, uint64_t seed, uint64_t systemIndex, const SolarSystem& system);
+
+    /// @brief Write everything appended, and close the file.
+    ///
+    /// In ordered mode, chunks still waiting for missing indices are written in index order after the
+    /// complete runs.
+    /// @return true if every write succeeded.
+    bool close();
+
+    /// @brief Hand the records a producer has staged over for writing.
+    ///
+    /// Call when a producer stops appending for a while, such as at the end of a batch.
+    /// @param producer The producer index.
+    void flush(uint32_t producer);
+
+    /// @brief Returns the backend in use.
+    RecordWriterBackend getBackend() const { return backend; }
+
+    /// @brief Returns the number of bytes handed to the backend so far.
+    uint64_t getBytesQueued() const { return fileSize.load(std::memory_order_relaxed); }
+
+    /// @brief Returns true if a write has failed.
+    bool hasFailed() const { return failed.load(std::memory_order_relaxed); }
+
+    /// @brief Returns true if the file is open.
+    bool isOpen() const { return file >= 0; }
+
+    /// @brief Create (or truncate) a file and start the backend.
+    /// @param path The file.
+    /// @param settings_ The settings.
+    /// @return true on success.
+    bool open(const char* path, const RecordWriterSettings& settings_);
+
+    /// @brief Mark a systemIndex as having no record, such as a system discarded by a filter.
+    ///
+    /// Only needed in ordered mode; otherwise it does nothing.
+    /// @param producer The producer index.
+    /// @param systemIndex The index of the system within its batch.
+    void skip(uint32_t producer, uint64_t systemIndex);
+
+    private:
+
+    struct Buffer;
+    struct Chunk;
+    struct IoRing;
+    struct Producer;
+
+    RecordWriterSettings settings; //!< The settings passed to open().
+    RecordWriterBackend backend = RecordWriterBackend::ThreadPool; //!< The backend in use.
+    int file = -1; //!< The file, or -1.
+
+    std::vector<Buffer> buffers; //!< Every output buffer.
+    std::vector<Producer*> producers; //!< The state of each producer, each on its own cache lines.
+
+    std::mutex bufferMutex; //!< Guards `freeBuffers` and `pendingWrites`.
+    std::condition_variable bufferFreed; //!< Signalled when a write completes.
+    std::vector<Buffer*> freeBuffers; //!< Buffers ready to be filled.
+    uint32_t pendingWrites = 0u; //!< Buffers queued or being written.
+
+    std::mutex writeMutex; //!< Guards `writes` and `stopping`.
+    std::condition_variable writeQueued; //!< Signalled when a buffer is queued, or the backend stops.
+    std::deque<Buffer*> writes; //!< Full buffers waiting for the backend.
+    bool stopping = false; //!< Set by close() once everything is queued.
+    std::atomic<uint64_t> fileSize{ 0u }; //!< Offset of the next buffer.  Only written under `writeMutex`.
+    std::atomic<bool> failed{ false }; //!< Set when a write fails.
+
+    std::mutex orderMutex; //!< Guards the ordered-mode state below.
+    std::map<uint64_t, Chunk*> waitingChunks; //!< Sealed chunks that arrived early, by first index.
+    std::vector<Chunk*> freeChunks; //!< Chunks ready to be reused.
+    std::vector<Chunk*> chunks; //!< Every chunk, for deletion.
+    uint64_t nextIndex = 0u; //!< The index following the last one packed.
+    Buffer* packing = nullptr; //!< The buffer chunks are packed into.
+
+    std::vector<RecordSeekEntry> seekEntries; //!< The seek index entries, at file offsets.  Guarded by `writeMutex`.
+
+    IoRing* ring = nullptr; //!< The io_uring, when used.
+    std::vector<std::thread> ioThreads; //!< Run the backend.
+
+    // Get an empty buffer, waiting for a write to complete if there are none.
+    Buffer* acquireBuffer();
+
+    // Return a buffer whose write is complete, successful or not.
+    void completeWrite(Buffer* buffer, bool succeeded);
+
+    // Get an empty chunk for ordered mode, starting at an index.
+    Chunk* acquireChunk(Producer& producer, uint64_t systemIndex);
+
+    // Fill in the block header of a producer's buffer or chunk, or empty it if it holds no record.
+    void closeBlock(uint8_t* block, size_t& used, uint32_t recordCount);
+
+    // Pack a chunk into the output buffers, submitting the ones that fill up.  orderMutex must be held.
+    void pack(Chunk* chunk);
+
+    // Sort the seek index entries and write the index after the records.
+    bool writeSeekIndex();
+
+    // Hand a sealed chunk to the ordering stage.
+    void seal(Chunk* chunk);
+
+    // Assign a buffer its file offset and queue it for the backend.
+    void submit(Buffer* buffer);
+
+    // Run the io_uring backend.
+    void runIoRing();
+
+    // Run an I/O thread of the thread pool backend.
+    void runIoThread();
+};
+
+}
+}
@@ -0,0 +1,144 @@
+/*****************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Questionable Coding
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************/
+#pragma once
+
+#include "SystemRecord.h"
+
+#include <cstdint>
+#include <string>
+
+namespace qc
+{
+
+namespace SystemGenerator
+{
+
+class SolarSystem;
+
+struct ResultRingHeader;
+
+/// @brief Publishes SystemRecords into a named shared-memory ring for consumers in other processes.
+///
+/// The ring is a POSIX shared-memory object (shm_open) holding a header followed by a power-of-two data
+/// area.  There is one writer and up to ResultRingWriter::MaxReaders readers.  Each reader owns a cursor
+/// in the header; the writer never overwrites data that any attached reader has not released, so a slow
+/// reader applies backpressure to the writer instead of losing records.  Records are never split across
+/// the end of the data area, so a reader always sees a complete SystemRecord in place, without copying.
+///
+/// The header is only marked valid once it is fully initialized.  A writer that finds a ring left behind by
+/// a dead writer replaces it, readers that die are detached by the writer when they hold up the ring, and
+/// readers can tell when the writer has closed the ring or died.
+///
+/// The writer is not thread-safe.  With the BatchGenerator, publish from the SystemCallback under a mutex.
+/// When no reader is attached, published records are dropped.
+///
+/// Only available on POSIX systems; on other platforms create() and attach() fail.
+class ResultRingWriter
+{
+    public:
+
+    /// @brief Largest number of readers that may attach to a ring.
+    static constexpr uint32_t MaxReaders = 16u;
+
+    ResultRingWriter() { }
+    ~ResultRingWriter() { close(); }
+
+    /// @brief Create the ring.
+    /// @param name_ The shared-memory object name, eg "/qcSysGen".
+    /// @param capacity The size of the data area, in bytes.  Rounded up to a power of two.
+    /// @return true on success.  Fails if another live writer owns a ring of the same name.
+    bool create(const char* name_, uint64_t capacity);
+
+    /// @brief Mark the ring closed, so readers know no more records will arrive, and remove its name.
+    ///
+    /// Readers that are attached keep their mapping and may finish reading.
+    void close();
+
+    /// @brief Serialize a system into the ring.
+    /// @param seed The seed the system was generated from.
+    /// @param systemIndex The index of the system within its batch.
+    /// @param system The evaluated system.
+    /// @param wait If true, wait for readers to make room.  If false, fail when the ring is full.
+    /// @return true if the record was published (or dropped because no reader is attached).
+    bool publish(uint64_t seed, uint64_t systemIndex, const SolarSystem& system, bool wait = true);
+
+    private:
+
+    std::string name; //!< Shared-memory object name.
+    ResultRingHeader* header = nullptr; //!< The mapped ring.
+    uint8_t* data = nullptr; //!< Start of the data area.
+    size_t mappedSize = 0u; //!< Size of the mapping.
+
+    // Returns the position of the slowest attached reader, detaching any that have died.
+    uint64_t getReadLimit(uint64_t writePosition);
+};
+
+/// @brief Reads SystemRecords from a ring created by a ResultRingWriter in another process.
+class ResultRingReader
+{
+    public:
+
+    ResultRingReader() { }
+    ~ResultRingReader() { detach(); }
+
+    /// @brief Attach to a ring and claim a reader cursor.
+    ///
+    /// The reader starts with the next record published after it attaches.
+    /// @param name_ The shared-memory object name used by the writer.
+    /// @return true on success.  Fails if the ring does not exist yet, its writer has closed it or died,
+    /// or all of the reader cursors are in use.
+    bool attach(const char* name_);
+
+    /// @brief Release the reader cursor and unmap the ring.
+    void detach();
+
+    /// @brief Returns true if the writer closed the ring or is no longer running.
+    /// @return true if no more records will be published.
+    bool isFinished() const;
+
+    /// @brief Get the next record.
+    ///
+    /// The record stays valid, in place, until release() or the next call to next().  Calling next() again
+    /// releases the previous record.
+    /// @param timeoutMilliseconds How long to wait for a record to be published.
+    /// @return The record, or nullptr if none arrived in time.
+    const SystemRecord* next(uint32_t timeoutMilliseconds = 0u);
+
+    /// @brief Return the space used by the record returned by next() to the writer.
+    void release();
+
+    private:
+
+    ResultRingHeader* header = nullptr; //!< The mapped ring.
+    const uint8_t* data = nullptr; //!< Start of the data area.
+    size_t mappedSize = 0u; //!< Size of the mapping.
+    uint32_t slot = 0u; //!< Index of this reader's cursor.
+    uint64_t position = 0u; //!< Position of the next record.
+    uint64_t pending = 0u; //!< Position following the record returned by next().
+    bool holding = false; //!< Is a record returned by next() waiting to be released?
+};
+
+}
+}
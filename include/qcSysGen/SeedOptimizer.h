@@ -0,0 +1,202 @@
+/*****************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Questionable Coding
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************/
+#pragma once
+
+#include "Config.h"
+#include "Star.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace qc
+{
+
+namespace SystemGenerator
+{
+
+class Generator;
+class Planet;
+class SolarSystem;
+
+/// @brief An inclusive range of one planet property.
+///
+/// The default range is empty, which leaves the property unconstrained.
+struct TargetRange
+{
+    float lower = 1.0f; //!< Lowest accepted value.
+    float upper = 0.0f; //!< Highest accepted value.
+
+    /// @brief Returns true if the range constrains the property.
+    bool isSet() const { return lower <= upper; }
+
+    /// @brief Set the range.
+    /// @param lower_ Lowest accepted value.
+    /// @param upper_ Highest accepted value.
+    void set(float lower_, float upper_) { lower = lower_; upper = upper_; }
+};
+
+/// @brief The properties a designer wants one planet of a system to have.
+///
+/// Only the ranges that are set are considered.  The units match PlanetColumns.
+struct PlanetTarget
+{
+    TargetRange semimajorAxis; //!< Semimajor axis, in AU.
+    TargetRange mass; //!< Total mass, in Earth masses.
+    TargetRange radius; //!< Radius, in km.
+    TargetRange earthSimilarityIndex; //!< Earth Similarity Index, [0, 1].
+    TargetRange surfaceTemperature; //!< Mean surface temperature, in Kelvin.
+    TargetRange hydrosphere; //!< Liquid water coverage, [0, 1].
+    TargetRange surfacePressure; //!< Surface pressure, in millibars.
+
+    /// @brief Accepted planet types, as a mask of (1 << PlanetType).  0 accepts every type.
+    uint32_t typeMask = 0u;
+
+    /// @brief Returns how far a planet is from the target.
+    ///
+    /// Each property outside its range adds its distance to the nearest bound, relative to the size
+    /// of the range (or of the bound, for narrow ranges).  A planet of the wrong type adds 1.
+    /// @param planet The planet.  It must have been evaluated.
+    /// @return The penalty.  0 if the planet matches the target.
+    float getPenalty(const Planet& planet) const;
+};
+
+/// @brief Settings for SeedOptimizer::run().
+struct SeedOptimizerSettings
+{
+    /// @brief The star of the designed system.  Defaults to a G2V.
+    Star star;
+
+    /// @brief The number of protoplanet seeds to optimize.  If 0, one seed per target is used.
+    uint32_t seedCount = 0u;
+
+    /// @brief The number of independent optimizations, each from a different starting point.
+    uint32_t restartCount = 16u;
+
+    /// @brief The number of seed placements each restart may evaluate.
+    uint32_t evaluationsPerRestart = 200u;
+
+    /// @brief The number of Generator seeds each seed placement is evaluated with.  The placement
+    /// scores as the best of them.
+    uint32_t rngSeedsPerPoint = 4u;
+
+    /// @brief The number of candidates to return.
+    uint32_t resultCount = 5u;
+
+    /// @brief Seeds the random starting points and Generator seeds of the restarts.
+    uint64_t searchSeed = 1u;
+
+    /// @brief When true, Generator::generate2() is used instead of Generator::generate().
+    bool useGenerate2 = false;
+};
+
+/// @brief One design returned by a SeedOptimizer.
+///
+/// The system can be regenerated exactly with SeedOptimizer::regenerate(), or by generating it with
+/// `seeds` as Config::protoplanetSeeds, the optimizer's star, and a Generator seeded with `seed`.
+struct DesignCandidate
+{
+    uint64_t seed; //!< The Generator seed.
+    std::vector<ProtoplanetSeed> seeds; //!< The protoplanet seeds.
+    float score; //!< The sum of the targets' penalties.  0 if every target was met.
+    std::vector<uint32_t> planetOrdinal; //!< 1-based position of the planet matched to each target, or 0 if there was none.
+};
+
+/// @brief Searches for protoplanet seeds that produce planets with the requested properties.
+///
+/// Each restart runs a Nelder-Mead simplex search over the log of the semi-major axis (within the star's
+/// protoplanet zone) and the eccentricity of every seed.  Because accretion is chaotic in the Generator
+/// seed, each placement is generated with several Generator seeds, fixed for the restart, and scores as
+/// the best of them.  Restarts begin from random placements, except the first, which starts from
+/// Config::protoplanetSeeds if it is not empty, or otherwise places one seed at the center of each
+/// target's semi-major axis range.  A restart ends early once it meets every target.
+///
+/// Restarts run in parallel, one per worker at a time.  Each restart depends only on its index, so the
+/// results do not depend on the number of workers.
+///
+/// Targets are matched to planets in order: each target takes the planet with the lowest penalty that
+/// has not been matched to an earlier target.  A target without a planet adds a penalty of
+/// MissingPlanetPenalty.
+class SeedOptimizer
+{
+    public:
+
+    /// @brief Penalty of a target that could not be matched to a planet.
+    static constexpr float MissingPlanetPenalty = 10.0f;
+
+    /// @brief Constructor.
+    /// @param workerCount_ The number of worker threads to use.  If 0, the hardware concurrency is used.
+    explicit SeedOptimizer(uint32_t workerCount_ = 0u);
+    ~SeedOptimizer() { }
+
+    /// @brief Returns the number of systems generated by the last run().
+    /// @return The system count.
+    uint64_t getGeneratedCount() const { return generatedCount; }
+
+    /// @brief Returns the best designs of the last run(), best first.
+    /// @return Up to SeedOptimizerSettings::resultCount candidates.
+    const std::vector<DesignCandidate>& getResults() const { return results; }
+
+    /// @brief Returns the number of worker threads this optimizer uses.
+    /// @return The worker count, always at least 1.
+    uint32_t getWorkerCount() const { return workerCount; }
+
+    /// @brief Regenerate the system of a candidate.
+    ///
+    /// This is exactly how run() generates each system.
+    /// @param candidate The candidate.
+    /// @param config The Config used for the search.
+    /// @param star The star used for the search.
+    /// @param useGenerate2 When true, Generator::generate2() is used instead of Generator::generate().
+    /// @param generator The Generator.
+    /// @param system The SolarSystem that will contain the results.
+    static void regenerate(const DesignCandidate& candidate, const Config& config, const Star& star, bool useGenerate2, Generator& generator, SolarSystem& system);
+
+    /// @brief Search for seeds that meet the targets.
+    ///
+    /// Any previous results are discarded.
+    /// @param config The Config used for every system.  Config::generateStar and Config::protoplanetSeeds
+    /// are overridden by each candidate.
+    /// @param targets The targets, in priority order.
+    /// @param settings The search settings.
+    void run(const Config& config, const std::vector<PlanetTarget>& targets, const SeedOptimizerSettings& settings);
+
+    /// @brief Score a system against the targets.
+    /// @param targets The targets.
+    /// @param system The system.  It must have been evaluated.
+    /// @param planetOrdinal If not null, receives the 1-based position of the planet matched to each target, or 0.
+    /// @return The sum of the targets' penalties.
+    static float score(const std::vector<PlanetTarget>& targets, const SolarSystem& system, std::vector<uint32_t>* planetOrdinal = nullptr);
+
+    private:
+
+    uint32_t workerCount; //!< Number of worker threads.
+
+    uint64_t generatedCount = 0u; //!< Systems generated during the last run.
+
+    std::vector<DesignCandidate> results; //!< Results of the last run, best first.
+};
+
+}
+}
@@ -0,0 +1,205 @@
+/*****************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Questionable Coding
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************/
+#pragma once
+
+#include "Config.h"
+#include "Fingerprint.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace qc
+{
+
+namespace SystemGenerator
+{
+
+class Generator;
+class Star;
+
+/// @brief The deterministic, per-star part of a seed layout.
+///
+/// The contents are defined by the SeedStrategy that fills it.
+typedef std::vector<double> SeedLayout;
+
+/// @brief Places the initial protoplanet seeds of a system.
+///
+/// A strategy works in two stages.  prepare() computes everything that only depends on the star (the
+/// "skeleton" of the layout) and generate() applies the random perturbations for one system.  When a
+/// PreparedConfig is prepared with a fixed star, prepare() runs once and every system only pays for
+/// generate().  Otherwise, prepare() runs once per system.
+///
+/// Strategies are used concurrently by every worker of a BatchGenerator, so both methods must be
+/// const and may not modify the strategy.  All of the randomness must come from the Generator, so
+/// systems remain reproducible from their seed.
+///
+/// Select a strategy with Config::seedStrategy.  Config::protoplanetSeeds takes priority over the
+/// strategy, and Config::generateBodeSeeds selects the BodeSeedStrategy when no strategy is set.
+class SeedStrategy
+{
+    public:
+
+    virtual ~SeedStrategy() { }
+
+    /// @brief Add the strategy and its parameters to a fingerprint.
+    ///
+    /// Two strategies with the same fingerprint must generate the same seeds.  The default adds the name,
+    /// which is enough for strategies without parameters.
+    /// @param fingerprint The fingerprint.
+    virtual void addFingerprint(Fingerprint& fingerprint) const { fingerprint.addString(getName()); }
+
+    /// @brief Append the seeds of one system.
+    /// @param generator The Generator, which provides the random numbers.
+    /// @param star The system's star.
+    /// @param layout The layout prepare() computed for `star`.
+    /// @param seeds The seed list.  Seeds outside the star's protoplanet zone are discarded by the Generator.
+    virtual void generate(Generator& generator, const Star& star, const SeedLayout& layout, std::vector<ProtoplanetSeed>& seeds) const = 0;
+
+    /// @brief Returns the name of the strategy, for reports.
+    /// @return The name.
+    virtual const char* getName() const = 0;
+
+    /// @brief Compute the per-star part of the layout.
+    /// @param star The evaluated star.
+    /// @param layout Receives the layout.
+    virtual void prepare(const Star& star, SeedLayout& layout) const = 0;
+};
+
+/// @brief Seeds derived from Blagg's modification of Bode's Law.
+///
+/// This is the layout used by Config::generateBodeSeeds, and generates exactly the same seeds.  The
+/// star's ecosphere and the 1.7275^n progression are cached in the layout; the coefficients of the law
+/// are randomized for every system.  See Config::generateBodeSeeds.
+class BodeSeedStrategy : public SeedStrategy
+{
+    public:
+
+    BodeSeedStrategy() { }
+    ~BodeSeedStrategy() { }
+
+    void generate(Generator& generator, const Star& star, const SeedLayout& layout, std::vector<ProtoplanetSeed>& seeds) const override;
+    const char* getName() const override { return "Bode"; }
+    void prepare(const Star& star, SeedLayout& layout) const override;
+};
+
+/// @brief A fixed number of seeds with a semi-major axis uniformly distributed over the protoplanet zone.
+class UniformSeedStrategy : public SeedStrategy
+{
+    public:
+
+    /// @brief Constructor.
+    /// @param count_ The number of seeds per system.
+    explicit UniformSeedStrategy(uint32_t count_) :count(count_) { }
+    ~UniformSeedStrategy() { }
+
+    void addFingerprint(Fingerprint& fingerprint) const override;
+    void generate(Generator& generator, const Star& star, const SeedLayout& layout, std::vector<ProtoplanetSeed>& seeds) const override;
+    const char* getName() const override { return "Uniform"; }
+    void prepare(const Star& star, SeedLayout& layout) const override;
+
+    private:
+
+    uint32_t count; //!< Seeds per system.
+};
+
+/// @brief A fixed number of seeds with the logarithm of the semi-major axis uniformly distributed over
+/// the protoplanet zone, so each octave of distance receives the same number of seeds.
+class LogUniformSeedStrategy : public SeedStrategy
+{
+    public:
+
+    /// @brief Constructor.
+    /// @param count_ The number of seeds per system.
+    explicit LogUniformSeedStrategy(uint32_t count_) :count(count_) { }
+    ~LogUniformSeedStrategy() { }
+
+    void addFingerprint(Fingerprint& fingerprint) const override;
+    void generate(Generator& generator, const Star& star, const SeedLayout& layout, std::vector<ProtoplanetSeed>& seeds) const override;
+    const char* getName() const override { return "LogUniform"; }
+    void prepare(const Star& star, SeedLayout& layout) const override;
+
+    private:
+
+    uint32_t count; //!< Seeds per system.
+};
+
+/// @brief Seeds from a user-supplied table, jittered for every system.
+///
+/// Unlike Config::protoplanetSeeds, the table is in units of the star's ecosphere radius, so the same
+/// table can be used with any star.
+class TableSeedStrategy : public SeedStrategy
+{
+    public:
+
+    /// @brief Constructor.
+    /// @param table_ The seeds.  The semi-major axes are multiples of the ecosphere radius, and invalid
+    /// eccentricities are replaced with random ones (see ProtoplanetSeed).
+    /// @param jitter_ The maximum random variation of each semi-major axis, as a ratio.  0 places the seeds
+    /// exactly.
+    TableSeedStrategy(const std::vector<ProtoplanetSeed>& table_, float jitter_) :table(table_), jitter(jitter_) { }
+    ~TableSeedStrategy() { }
+
+    void addFingerprint(Fingerprint& fingerprint) const override;
+    void generate(Generator& generator, const Star& star, const SeedLayout& layout, std::vector<ProtoplanetSeed>& seeds) const override;
+    const char* getName() const override { return "Table"; }
+    void prepare(const Star& star, SeedLayout& layout) const override;
+
+    private:
+
+    std::vector<ProtoplanetSeed> table; //!< The seeds, relative to the ecosphere.
+    float jitter; //!< Random variation of the semi-major axes.
+};
+
+/// @brief A chain of seeds in mean-motion resonance with each other.
+///
+/// The first seed is placed near the ecosphere, and the others are placed inwards and outwards so the
+/// orbital periods of neighbouring seeds have the ratio `periodRatio` (3:2 by default), until the chain
+/// leaves the protoplanet zone.
+class ResonantChainSeedStrategy : public SeedStrategy
+{
+    public:
+
+    /// @brief Constructor.
+    /// @param periodRatio_ The ratio of the periods of neighbouring seeds.  Clamped to at least MinPeriodRatio, since
+    /// a ratio of 1 or less would never reach the edge of the protoplanet zone.
+    /// @param jitter_ The maximum random variation of the position of the chain, as a ratio.
+    explicit ResonantChainSeedStrategy(double periodRatio_ = 1.5, float jitter_ = 0.1f) :periodRatio(periodRatio_ > MinPeriodRatio ? periodRatio_ : MinPeriodRatio), jitter(jitter_) { }
+    ~ResonantChainSeedStrategy() { }
+
+    void addFingerprint(Fingerprint& fingerprint) const override;
+    void generate(Generator& generator, const Star& star, const SeedLayout& layout, std::vector<ProtoplanetSeed>& seeds) const override;
+    const char* getName() const override { return "ResonantChain"; }
+    void prepare(const Star& star, SeedLayout& layout) const override;
+
+    static constexpr double MinPeriodRatio = 1.01; //!< Smallest period ratio; keeps the chain to a few hundred seeds.
+
+    private:
+
+    double periodRatio; //!< Period ratio of neighbouring seeds.
+    float jitter; //!< Random variation of the position of the chain.
+};
+
+}
+}
@@ -59,6 +59,9 @@ enum class StarClassification : uint32_t
     M_V, //!< Main sequence class M.  Red dwarfs.
 };
 
+/// @brief Number of StarClassification values.
+static constexpr uint32_t StarClassificationCount = 7u;
+
 /// @brief Encapsulates a star's classification.
 typedef std::pair<StarClassification, int32_t> StarType_t;
 
@@ -146,6 +149,12 @@ class Star
     /// @return Stellar luminosity, Sol = 1.0.
     double getLuminosity() const { return luminositySolar; }
 
+    /// @brief Returns the oldest age the star may have.  Only valid after evaluate().
+    ///
+    /// Shorter-lived stars have a lower limit than MaximumStellarAge.
+    /// @return Maximum stellar age, in years.
+    double getMaximumAge() const { return std::min(MaximumStellarAge, 1.0e10 * (massSolar / luminositySolar)); }
+
     /// @brief Returns the mass of the star in units of Solar mass.
     /// @return Stellar mass, Sol = 1.0.
     double getMass() const { return massSolar; }
@@ -178,7 +187,7 @@ class Star
 
     /// @brief Get the star's classification and subtype.
     /// @return The star's type.
-    StarType_t&& getStarType() const { return std::make_pair(type, subtype); }
+    StarType_t getStarType() const { return std::make_pair(type, subtype); }
 
     /// @brief Place the stellar class of this star in the provided string.
     /// 
@@ -0,0 +1,334 @@
+/*****************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Questionable Coding
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************/
+#pragma once
+
+#include "Enums.h"
+#include "Star.h"
+
+#include <cstdint>
+#include <stdio.h>
+#include <vector>
+
+namespace qc
+{
+
+namespace SystemGenerator
+{
+
+class Generator;
+class SolarSystem;
+
+/// @brief A histogram with a fixed number of bins.
+///
+/// Bins may be spaced linearly or logarithmically between the lower and upper bound.  Values outside
+/// of the range are counted in the underflow / overflow counters.  Memory use is fixed at construction.
+class Histogram
+{
+    public:
+
+    /// @brief Constructor.
+    /// @param lower_ Lower bound of the first bin.  Must be greater than 0 if `logarithmic_` is true.
+    /// @param upper_ Upper bound of the last bin.
+    /// @param binCount Number of bins.  Must be at least 1.
+    /// @param logarithmic_ If true, bins are spaced logarithmically.
+    Histogram(double lower_, double upper_, uint32_t binCount, bool logarithmic_ = false);
+
+    /// @brief Add a value to the histogram.
+    /// @param value The value to add.
+    void add(double value);
+
+    /// @brief Returns the number of values in a bin.
+    /// @param index The bin index, [0, getBinCount()).
+    /// @return The count.
+    uint64_t getBin(uint32_t index) const { return bin[index]; }
+
+    /// @brief Returns the number of bins.
+    /// @return The bin count.
+    uint32_t getBinCount() const { return static_cast<uint32_t>(bin.size()); }
+
+    /// @brief Returns the lower edge of a bin.  `getBinLower(getBinCount())` returns the upper bound of the histogram.
+    /// @param index The bin index, [0, getBinCount()].
+    /// @return The lower edge of the bin.
+    double getBinLower(uint32_t index) const;
+
+    /// @brief Returns the number of values that exceeded the upper bound.
+    /// @return The overflow count.
+    uint64_t getOverflow() const { return overflow; }
+
+    /// @brief Returns the total number of values added, including underflow and overflow.
+    /// @return The total count.
+    uint64_t getTotal() const;
+
+    /// @brief Returns the number of values that were below the lower bound.
+    /// @return The underflow count.
+    uint64_t getUnderflow() const { return underflow; }
+
+    /// @brief Merge another histogram into this one.  The histograms must have identical layouts.
+    /// @param rhs The histogram to merge.
+    void merge(const Histogram& rhs);
+
+    /// @brief Read counts written by write().  The histogram must have the same layout as the one written.
+    /// @param fp The input stream.
+    /// @return true on success.
+    bool read(FILE* fp);
+
+    /// @brief Write the histogram as text.
+    /// @param fp The output stream.
+    /// @param title The title printed above the histogram.
+    void report(FILE* fp, const char* title) const;
+
+    /// @brief Write the counts in binary form.
+    /// @param fp The output stream.
+    /// @return true on success.
+    bool write(FILE* fp) const;
+
+    private:
+
+    std::vector<uint64_t> bin; //!< Bin counts.
+    uint64_t underflow = 0u; //!< Count of values < lower.
+    uint64_t overflow = 0u; //!< Count of values >= upper.
+    double lower; //!< Lower bound (or log of the lower bound).
+    double upper; //!< Upper bound (or log of the upper bound).
+    double scale; //!< Converts (value - lower) to a bin index.
+    bool logarithmic; //!< Are bins logarithmically spaced?
+};
+
+/// @brief Streaming mean / variance / min / max using Welford's algorithm.
+///
+/// Two RunningMoments may be merged using the parallel form of the algorithm (Chan, et al.), so
+/// each worker thread may keep its own instance.
+class RunningMoments
+{
+    public:
+
+    /// @brief Add a value.
+    /// @param value The value to add.
+    void add(double value);
+
+    /// @brief Returns the number of values added.
+    /// @return The count.
+    uint64_t getCount() const { return count; }
+
+    /// @brief Returns the largest value added.
+    /// @return The maximum.  0 if no values were added.
+    double getMax() const { return maxValue; }
+
+    /// @brief Returns the mean of the values added.
+    /// @return The mean.  0 if no values were added.
+    double getMean() const { return mean; }
+
+    /// @brief Returns the smallest value added.
+    /// @return The minimum.  0 if no values were added.
+    double getMin() const { return minValue; }
+
+    /// @brief Returns the standard deviation of the values added.
+    /// @return The sample standard deviation.
+    double getStdDev() const;
+
+    /// @brief Returns the variance of the values added.
+    /// @return The sample variance.  0 if fewer than two values were added.
+    double getVariance() const { return (count > 1u) ? m2 / double(count - 1u) : 0.0; }
+
+    /// @brief Merge another RunningMoments into this one.
+    /// @param rhs The moments to merge.
+    void merge(const RunningMoments& rhs);
+
+    /// @brief Read moments written by write().
+    /// @param fp The input stream.
+    /// @return true on success.
+    bool read(FILE* fp);
+
+    /// @brief Write the moments in binary form.
+    /// @param fp The output stream.
+    /// @return true on success.
+    bool write(FILE* fp) const;
+
+    private:
+
+    uint64_t count = 0u; //!< Number of values.
+    double mean = 0.0; //!< Running mean.
+    double m2 = 0.0; //!< Sum of squared differences from the mean.
+    double minValue = 0.0; //!< Smallest value.
+    double maxValue = 0.0; //!< Largest value.
+};
+
+/// @brief A mergeable quantile sketch with bounded relative error.
+///
+/// Positive values are placed in logarithmically-spaced buckets whose width is set by the relative
+/// accuracy (the DDSketch approach), so a quantile estimate is within `relativeAccuracy` of the true
+/// value.  Values at or below zero are counted in a separate zero bucket.  The bucket range is fixed at
+/// construction, so memory use is constant; values outside the range are clamped into the end buckets.
+class QuantileSketch
+{
+    public:
+
+    /// @brief Constructor.
+    /// @param minValue The smallest positive value tracked precisely.
+    /// @param maxValue The largest value tracked precisely.
+    /// @param relativeAccuracy The relative accuracy of the quantile estimates, eg 0.01 for 1%.
+    QuantileSketch(double minValue, double maxValue, double relativeAccuracy);
+
+    /// @brief Add a value.
+    /// @param value The value to add.
+    void add(double value);
+
+    /// @brief Returns the number of values added.
+    /// @return The count.
+    uint64_t getCount() const { return count; }
+
+    /// @brief Estimate a quantile.
+    /// @param q The quantile, [0, 1].
+    /// @return The estimated value.  0 if no values were added.
+    double getQuantile(double q) const;
+
+    /// @brief Merge another sketch into this one.  The sketches must have identical layouts.
+    /// @param rhs The sketch to merge.
+    void merge(const QuantileSketch& rhs);
+
+    /// @brief Read counts written by write().  The sketch must have the same layout as the one written.
+    /// @param fp The input stream.
+    /// @return true on success.
+    bool read(FILE* fp);
+
+    /// @brief Write the counts in binary form.
+    /// @param fp The output stream.
+    /// @return true on success.
+    bool write(FILE* fp) const;
+
+    private:
+
+    std::vector<uint64_t> bucket; //!< Bucket counts.
+    uint64_t zeroCount = 0u; //!< Count of values <= 0.
+    uint64_t count = 0u; //!< Total count.
+    double gamma; //!< Ratio between adjacent bucket bounds.
+    double logGamma; //!< log(gamma).
+    int32_t minIndex; //!< Bucket key of bucket[0].
+};
+
+/// @brief Accumulates statistics about a population of generated solar systems.
+///
+/// The statistics include the planet type mix per StarClassification, OrbitalZone occupancy,
+/// Earth Similarity Index and surface temperature distributions (for non-gaseous planets), the
+/// number of planets per system, and the number of protoplanets consumed per system.
+///
+/// Memory use is fixed, regardless of the number of systems added.  One PopulationStatistics should
+/// be kept per worker thread (see BatchGenerator::SystemCallback) and the results merged once the
+/// batch completes.
+class PopulationStatistics
+{
+    public:
+
+    PopulationStatistics();
+    ~PopulationStatistics() { }
+
+    /// @brief Add a generated system to the statistics.
+    /// @param system The evaluated SolarSystem.
+    /// @param generator The Generator that created `system`.
+    void add(const SolarSystem& system, const Generator& generator);
+
+    /// @brief Returns the distribution of the Earth Similarity Index of non-gaseous planets.
+    const Histogram& getEsiHistogram() const { return esiHistogram; }
+
+    /// @brief Returns the moments of the Earth Similarity Index of non-gaseous planets.
+    const RunningMoments& getEsiMoments() const { return esiMoments; }
+
+    /// @brief Returns the quantile sketch of the Earth Similarity Index of non-gaseous planets.
+    const QuantileSketch& getEsiQuantiles() const { return esiQuantiles; }
+
+    /// @brief Returns the number of planets in a given orbital zone.
+    /// @param zone The OrbitalZone.
+    /// @return The number of planets.
+    uint64_t getOrbitalZoneCount(OrbitalZone zone) const { return orbitalZone[static_cast<uint32_t>(zone)]; }
+
+    /// @brief Returns the number of planets of a given type around a given class of star.
+    /// @param star The StarClassification.
+    /// @param type The PlanetType.
+    /// @return The number of planets.
+    uint64_t getPlanetTypeCount(StarClassification star, PlanetType type) const { return planetType[static_cast<uint32_t>(star)][static_cast<uint32_t>(type)]; }
+
+    /// @brief Returns the distribution of planets per system.
+    const Histogram& getPlanetsPerSystem() const { return planetsPerSystem; }
+
+    /// @brief Returns the moments of the number of protoplanets consumed per system.
+    const RunningMoments& getProtoplanetMoments() const { return protoplanetMoments; }
+
+    /// @brief Returns the distribution of the number of protoplanets consumed per system.
+    const Histogram& getProtoplanetHistogram() const { return protoplanetHistogram; }
+
+    /// @brief Returns the number of systems added.
+    uint64_t getSystemCount() const { return systemCount; }
+
+    /// @brief Returns the distribution of mean surface temperature of non-gaseous planets, in Kelvin.
+    const Histogram& getTemperatureHistogram() const { return temperatureHistogram; }
+
+    /// @brief Returns the moments of mean surface temperature of non-gaseous planets, in Kelvin.
+    const RunningMoments& getTemperatureMoments() const { return temperatureMoments; }
+
+    /// @brief Returns the quantile sketch of mean surface temperature of non-gaseous planets, in Kelvin.
+    const QuantileSketch& getTemperatureQuantiles() const { return temperatureQuantiles; }
+
+    /// @brief Merge another PopulationStatistics into this one.
+    /// @param rhs The statistics to merge.
+    void merge(const PopulationStatistics& rhs);
+
+    /// @brief Replace the statistics with ones written by write().
+    ///
+    /// Together with write(), this lets statistics gathered in separate processes be merged.
+    /// @param fp The input stream.
+    /// @return true on success.
+    bool read(FILE* fp);
+
+    /// @brief Write a text report of the statistics.
+    /// @param fp The output stream.
+    void report(FILE* fp) const;
+
+    /// @brief Write the statistics in binary form, in native byte order.
+    /// @param fp The output stream.
+    /// @return true on success.
+    bool write(FILE* fp) const;
+
+    private:
+
+    uint64_t systemCount = 0u; //!< Number of systems added.
+
+    uint64_t planetType[StarClassificationCount][PlanetTypeCount]; //!< Planet type mix per star classification.
+    uint64_t orbitalZone[OrbitalZoneCount]; //!< Planet count per orbital zone.
+
+    Histogram planetsPerSystem; //!< Planets per system.
+
+    Histogram protoplanetHistogram; //!< Protoplanets consumed per system (log bins).
+    RunningMoments protoplanetMoments; //!< Protoplanets consumed per system.
+
+    Histogram esiHistogram; //!< ESI of non-gaseous planets.
+    RunningMoments esiMoments; //!< ESI of non-gaseous planets.
+    QuantileSketch esiQuantiles; //!< ESI of non-gaseous planets.
+
+    Histogram temperatureHistogram; //!< Surface temperature of non-gaseous planets (log bins).
+    RunningMoments temperatureMoments; //!< Surface temperature of non-gaseous planets.
+    QuantileSketch temperatureQuantiles; //!< Surface temperature of non-gaseous planets.
+};
+
+}
+}
@@ -0,0 +1,121 @@
+/*****************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Questionable Coding
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************/
+#pragma once
+
+#include "Enums.h"
+#include "Planet.h"
+#include "Star.h"
+
+#include <cstdint>
+
+namespace qc
+{
+
+namespace SystemGenerator
+{
+
+class SolarSystem;
+
+/// @brief Fixed-layout image of an evaluated Star.
+struct StarRecord
+{
+    uint8_t starClass; //!< StarClassification.
+    int8_t subtype; //!< Numeric subtype (the 2 in G2V).
+    uint16_t reserved; //!< Padding.  Always 0.
+    float temperature; //!< Surface temperature, in Kelvin.
+    double age; //!< Age, in years.
+    double mass; //!< Mass, in Solar masses.
+    double luminosity; //!< Luminosity, in Solar luminosities.
+    double radius; //!< Radius, in Solar radii.
+    double ecosphere; //!< Ideal habitable radius, in AU.
+    double snowLine; //!< Snow line, in AU.
+    double habitableZone[2]; //!< Inner and outer edge of the habitable zone, in AU.
+};
+
+/// @brief Fixed-layout image of an evaluated Planet.
+struct PlanetRecord
+{
+    /// @brief Largest number of atmospheric components stored.  Matches the number of Gas values.
+    static constexpr uint32_t MaxAtmosphere = 13u;
+
+    double semimajorAxis; //!< Semimajor axis, in AU.
+    double periapsis; //!< Periapsis, in AU.
+    double apoapsis; //!< Apoapsis, in AU.
+    double mass; //!< Total mass, in Solar masses.
+    double dustMass; //!< Dust mass, in Solar masses.
+    double gasMass; //!< Gas mass, in Solar masses.
+    double sphereOfInfluence; //!< Sphere of influence, in AU.
+    double surfaceGravity; //!< Surface gravity, in G's.
+    float eccentricity; //!< Orbital eccentricity.
+    float inclination; //!< Orbital inclination, in degrees.
+    float radius; //!< Radius, in km.
+    float density; //!< Density, in g/cc.
+    float surfacePressure; //!< Surface pressure, in millibars.
+    float surfaceTemperature; //!< Mean surface temperature, in Kelvin.
+    float hydrosphere; //!< Liquid water coverage, [0, 1].
+    float iceCoverage; //!< Ice coverage, [0, 1].
+    float cloudCoverage; //!< Cloud coverage, [0, 1].
+    float earthSimilarityIndex; //!< Earth Similarity Index, [0, 1].
+    uint8_t planetType; //!< PlanetType.
+    uint8_t orbitalZone; //!< OrbitalZone.
+    uint8_t atmosphereCount; //!< Number of valid entries in `atmosphere`.
+    uint8_t reserved; //!< Padding.  Always 0.
+    AtmosphereComponent atmosphere[MaxAtmosphere]; //!< Major atmospheric components, largest first.
+};
+
+/// @brief Fixed-layout image of an evaluated SolarSystem.
+///
+/// A record is the header below, immediately followed by `planetCount` PlanetRecords.  Records contain no
+/// pointers, so they can be copied, stored or shared between processes as-is and read in place.  Names
+/// are not stored; planets are identified by their 1-based position.
+struct SystemRecord
+{
+    uint32_t size; //!< Total size of the record, in bytes, including the planets.
+    uint32_t planetCount; //!< Number of PlanetRecords following the header.
+    uint64_t seed; //!< The seed the system was generated from.
+    uint64_t systemIndex; //!< The index of the system within its batch.
+    StarRecord star; //!< The central star.
+
+    /// @brief Access the planets that follow the header.
+    /// @return The first PlanetRecord.
+    const PlanetRecord* getPlanets() const { return reinterpret_cast<const PlanetRecord*>(this + 1); }
+
+    /// @brief Returns the size of the record for a SolarSystem.
+    /// @param system The system.
+    /// @return The size, in bytes.
+    static size_t GetSize(const SolarSystem& system);
+
+    /// @brief Write the record for a SolarSystem.
+    /// @param buffer The destination.  Must be 8-byte aligned.
+    /// @param bufferSize The size of `buffer`, in bytes.
+    /// @param seed The seed the system was generated from.
+    /// @param systemIndex The index of the system within its batch.
+    /// @param system The evaluated system.
+    /// @return The number of bytes written, or 0 if `buffer` is too small.
+    static size_t Write(void* buffer, size_t bufferSize, uint64_t seed, uint64_t systemIndex, const SolarSystem& system);
+};
+
+}
+}
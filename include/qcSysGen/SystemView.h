@@ -0,0 +1,253 @@
+/*****************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Questionable Coding
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************/
+#pragma once
+
+#include "SystemRecord.h"
+
+#include <cstdint>
+
+namespace qc
+{
+
+namespace SystemGenerator
+{
+
+/// @brief Read-only access to a PlanetRecord, with the getters of Planet.
+///
+/// A view is a pointer: the getters read the record where it lies, such as in a RecordFileReader mapping,
+/// so only the bytes of the fields read are touched.  materialize() builds a full Planet when one is needed.
+class PlanetView
+{
+    public:
+    /// @brief Constructor.
+    /// @param record_ The record.  It must outlive the view.
+    explicit PlanetView(const PlanetRecord& record_) : record(&record_) { }
+
+    /// @brief Returns the apoapsis of the planet's orbit.
+    /// @return Apoapsis, in AU.
+    double getApoapsis() const { return record->apoapsis; }
+
+    /// @brief Returns a major component of the atmosphere.  Components are sorted largest first.
+    /// @param index The component, [0, getAtmosphereCount()).
+    /// @return The component.
+    const AtmosphereComponent& getAtmosphere(uint32_t index) const { return record->atmosphere[index]; }
+
+    /// @brief Returns the number of major components of the atmosphere.
+    uint32_t getAtmosphereCount() const { return record->atmosphereCount; }
+
+    /// @brief The percentage of the planet obscured by clouds.
+    /// @return The cloud coverage, in the range [0.0, 1.0].
+    float getCloudPercentage() const { return record->cloudCoverage; }
+
+    /// @brief The density of the planet.
+    /// @return Density, in g/cc.
+    float getDensity() const { return record->density; }
+
+    /// @brief The dust/rocky component of the planet's mass.
+    /// @return Dust mass, in Solar masses.
+    double getDustMassComponent() const { return record->dustMass; }
+
+    /// @brief Returns the Earth Similarity Index.
+    /// @return The ESI, in the range [0.0, 1.0].
+    float getEarthSimilarityIndex() const { return record->earthSimilarityIndex; }
+
+    /// @brief Returns the orbital eccentricity.
+    /// @return Eccentricity.
+    float getEccentricity() const { return record->eccentricity; }
+
+    /// @brief The gaseous component of the planet's mass.
+    /// @return Gas mass, in Solar masses.
+    double getGasMassComponent() const { return record->gasMass; }
+
+    /// @brief Percentage of the planet covered with liquid water.
+    /// @return The hydrosphere percentage, in the range [0.0, 1.0].
+    float getHydroPercentage() const { return record->hydrosphere; }
+
+    /// @brief Percentage of the planet covered with ices.
+    /// @return The ice percentage, in the range [0.0, 1.0].
+    float getIcePercentage() const { return record->iceCoverage; }
+
+    /// @brief Returns the inclination of the planet's orbit.
+    /// @return Inclination, in degrees.
+    float getInclination() const { return record->inclination; }
+
+    /// @brief Mass of the planet.
+    /// @return Mass, in Solar masses.
+    double getMass() const { return record->mass; }
+
+    /// @brief Return the orbital zone classification of this planet.
+    /// @return The OrbitalZone.
+    OrbitalZone getOrbitalZone() const { return static_cast<OrbitalZone>(record->orbitalZone); }
+
+    /// @brief Returns the periapsis of the planet's orbit.
+    /// @return Periapsis, in AU.
+    double getPeriapsis() const { return record->periapsis; }
+
+    /// @brief Returns the enumerated classification of the planet type.
+    /// @return The planet type.
+    PlanetType getPlanetType() const { return static_cast<PlanetType>(record->planetType); }
+
+    /// @brief Returns the radius of the planet.
+    /// @return The radius, in km.
+    float getRadius() const { return record->radius; }
+
+    /// @brief Returns the record viewed.
+    const PlanetRecord& getRecord() const { return *record; }
+
+    /// @brief Semimajor axis of the orbit, in AU.
+    /// @return SMA of the orbit, in AU
+    double getSemimajorAxis() const { return record->semimajorAxis; }
+
+    /// @brief The sphere of influence of the planet.
+    /// @return The sphere of influence, in AU.
+    double getSphereOfInfluence() const { return record->sphereOfInfluence; }
+
+    /// @brief Returns the surface acceleration of gravity in G's.
+    /// @return Acceleration in G's.
+    double getSurfaceGravity() const { return record->surfaceGravity; }
+
+    /// @brief Return the surface atmospheric pressure.
+    /// @return The surface pressure, in millibars.
+    float getSurfacePressure() const { return record->surfacePressure; }
+
+    /// @brief Return the mean surface temperature.
+    /// @return Mean surface temperature, in Kelvin.
+    float getSurfaceTemperature() const { return record->surfaceTemperature; }
+
+    /// @brief Is this planet a gaseous planet (gas giant, ice giant, etc)
+    /// @return true if the planet is one of the gaseous types.
+    bool isGaseous() const
+    {
+        const PlanetType type = getPlanetType();
+        return
+            (type == PlanetType::Gaseous) ||
+            (type == PlanetType::IceGiant) ||
+            (type == PlanetType::GasGiant) ||
+            (type == PlanetType::BrownDwarf);
+    }
+
+    /// @brief Build a Planet from the record.
+    ///
+    /// The fields stored in a PlanetRecord are restored and the planet is marked evaluated; the values a
+    /// record does not hold (day length, albedo, temperature extremes, ...) are left reset, and the planet
+    /// has no name.
+    /// @param planet The planet to overwrite.
+    void materialize(Planet& planet) const;
+
+    private:
+    const PlanetRecord* record; //!< The record.
+};
+
+/// @brief Read-only access to a StarRecord, with the getters of Star.
+class StarView
+{
+    public:
+    /// @brief Constructor.
+    /// @param record_ The record.  It must outlive the view.
+    explicit StarView(const StarRecord& record_) : record(&record_) { }
+
+    /// @brief Return the age of the star.
+    /// @return Age of the star, in years.
+    double getAge() const { return record->age; }
+
+    /// @brief Return the ideal habitable radius of the star.
+    /// @return The ecosphere radius, in AU.
+    double getEcosphere() const { return record->ecosphere; }
+
+    /// @brief Return the habitable zone of the star.
+    /// @return The inner and outer edges, in AU.
+    BandLimit_t getHabitableZone() const { return BandLimit_t(record->habitableZone[0], record->habitableZone[1]); }
+
+    /// @brief Return the luminosity of the star.
+    /// @return Luminosity, in Solar luminosities.
+    double getLuminosity() const { return record->luminosity; }
+
+    /// @brief Return the mass of the star.
+    /// @return Mass, in Solar masses.
+    double getMass() const { return record->mass; }
+
+    /// @brief Returns the record viewed.
+    const StarRecord& getRecord() const { return *record; }
+
+    /// @brief Return the snow line of the star.
+    /// @return The snow line, in AU.
+    double getSnowLine() const { return record->snowLine; }
+
+    /// @brief Return the radius of the star.
+    /// @return Radius, in Solar radii.
+    double getSolarRadius() const { return record->radius; }
+
+    /// @brief Return the classification of the star.
+    /// @return The classification and subtype.
+    StarType_t getStarType() const { return StarType_t(static_cast<StarClassification>(record->starClass), record->subtype); }
+
+    /// @brief Return the surface temperature of the star.
+    /// @return Temperature, in Kelvin.
+    double getTemperature() const { return record->temperature; }
+
+    /// @brief Build a Star from the record.
+    ///
+    /// A Star is fully determined by its type and age, so the star is set up from those and evaluated.
+    /// @param star The star to overwrite.
+    void materialize(Star& star) const;
+
+    private:
+    const StarRecord* record; //!< The record.
+};
+
+/// @brief Read-only access to a SystemRecord, with a view of its star and of each planet.
+class SystemView
+{
+    public:
+    /// @brief Constructor.
+    /// @param record_ The record.  It must outlive the view.
+    explicit SystemView(const SystemRecord& record_) : record(&record_) { }
+
+    /// @brief Returns a planet.
+    /// @param index The 0-based position of the planet, [0, getPlanetCount()).
+    /// @return The view of the planet.
+    PlanetView getPlanet(uint32_t index) const { return PlanetView(record->getPlanets()[index]); }
+
+    /// @brief Returns the number of planets.
+    uint32_t getPlanetCount() const { return record->planetCount; }
+
+    /// @brief Returns the record viewed.
+    const SystemRecord& getRecord() const { return *record; }
+
+    /// @brief Returns the seed the system was generated from.
+    uint64_t getSeed() const { return record->seed; }
+
+    /// @brief Returns the central star.
+    StarView getStar() const { return StarView(record->star); }
+
+    /// @brief Returns the index of the system within its batch.
+    uint64_t getSystemIndex() const { return record->systemIndex; }
+
+    private:
+    const SystemRecord* record; //!< The record.
+};
+
+}
+}
@@ -0,0 +1,246 @@
+/*****************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Questionable Coding
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************/
+#include <qcSysGen/Batch.h>
+#include <qcSysGen/Generator.h>
+#include <qcSysGen/PhaseCounters.h>
+#include <qcSysGen/SeedStrategy.h>
+#include <qcSysGen/System.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <new>
+#include <vector>
+
+using namespace qc::SystemGenerator;
+
+// Compares the seed strategies for throughput and for the quality of the systems they produce.
+//
+//   seedBench [--systems N] [--first-seed S] [--workers W] [--star G2] [--generate-star] [--generate2] [--counters]
+//
+// Every strategy generates the same range of seeds.  For each one, the report lists the systems
+// generated per second, the mean number of planets per system, the fraction of systems with a planet
+// whose ESI is at least EarthLikeEsi, and the mean ESI of the best planet of each system.
+//
+// With --counters, the hardware events and allocations of each GenerationPhase are counted over the
+// batch (see PhaseCounters) and reported after each strategy.  Counting slows generation down, so the
+// systems per second are not comparable with a run without it.
+
+// Allocations made by the calling thread, counted for PhaseCounters.
+static thread_local uint64_t threadAllocations = 0u;
+
+//----------------------------------------------------------------------------
+void* operator new(size_t size)
+{
+    ++threadAllocations;
+    void* p = malloc(size ? size : 1u);
+    if (!p)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+//----------------------------------------------------------------------------
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+//----------------------------------------------------------------------------
+void operator delete(void* p, size_t) noexcept
+{
+    free(p);
+}
+
+namespace
+{
+
+/// @brief ESI above which a planet counts as Earth-like in the report.
+static constexpr float EarthLikeEsi = 0.8f;
+
+/// @brief Statistics collected by one worker.
+struct WorkerStats
+{
+    uint64_t systems = 0u;
+    uint64_t planets = 0u;
+    uint64_t earthLike = 0u;
+    double bestEsi = 0.0;
+
+    // Padding, so workers don't share a cache line.
+    uint8_t padding[32];
+};
+
+//----------------------------------------------------------------------------
+// Returns the calling thread's allocation count.
+uint64_t GetThreadAllocations()
+{
+    return threadAllocations;
+}
+
+//----------------------------------------------------------------------------
+// Parse a star type such as "G2" or "K5V".
+bool ParseStar(const char* text, Star& star)
+{
+    static const char Classes[] = "OBAFGKM";
+
+    const char* c = (*text) ? strchr(Classes, *text) : nullptr;
+    if (!c || text[1] < '0' || text[1] > '9' || (text[2] && strcmp(text + 2, "V")))
+    {
+        return false;
+    }
+
+    star.setType(static_cast<StarClassification>(c - Classes), text[1] - '0');
+    return true;
+}
+
+//----------------------------------------------------------------------------
+// Generate the batch with one strategy and report the results.
+void Run(const char* name, const BatchGenerator& batch, const Config& config, BatchSettings settings, bool counters)
+{
+    PhaseCounters phaseCounters;
+    settings.phaseCounters = (counters) ? &phaseCounters : nullptr;
+
+    std::vector<WorkerStats> stats(batch.getWorkerCount());
+
+    const auto start = std::chrono::steady_clock::now();
+
+    batch.run(config, settings, [&](uint32_t worker, uint64_t, uint64_t, const SolarSystem& system, const Generator&)
+    {
+        WorkerStats& s = stats[worker];
+        float best = 0.0f;
+        for (const auto& p : system.getPlanets())
+        {
+            best = std::max(best, p.getEarthSimilarityIndex());
+        }
+
+        ++s.systems;
+        s.planets += system.getPlanets().size();
+        s.earthLike += (best >= EarthLikeEsi) ? 1u : 0u;
+        s.bestEsi += best;
+    });
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    WorkerStats total;
+    for (const auto& s : stats)
+    {
+        total.systems += s.systems;
+        total.planets += s.planets;
+        total.earthLike += s.earthLike;
+        total.bestEsi += s.bestEsi;
+    }
+
+    const double systems = static_cast<double>(std::max<uint64_t>(total.systems, 1u));
+    printf("%-16s %12.0f %10.2f %12.4f %10.4f\n", name, total.systems / std::max(seconds, 1.0e-9), total.planets / systems,
+           total.earthLike / systems, total.bestEsi / systems);
+
+    if (counters)
+    {
+        putchar('\n');
+        phaseCounters.report(stdout);
+        putchar('\n');
+    }
+}
+
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+    Config config;
+    BatchSettings settings;
+    settings.firstSeed = 1u;
+    settings.systemCount = 10000u;
+    uint32_t workerCount = 0u;
+    bool counters = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : "";
+
+        if (!strcmp(arg, "--systems")) { settings.systemCount = strtoull(value, nullptr, 10); ++i; }
+        else if (!strcmp(arg, "--first-seed")) { settings.firstSeed = strtoull(value, nullptr, 10); ++i; }
+        else if (!strcmp(arg, "--workers")) { workerCount = static_cast<uint32_t>(strtoul(value, nullptr, 10)); ++i; }
+        else if (!strcmp(arg, "--star"))
+        {
+            if (!ParseStar(value, settings.star))
+            {
+                fprintf(stderr, "Invalid star type '%s'\n", value);
+                return 1;
+            }
+            ++i;
+        }
+        else if (!strcmp(arg, "--generate-star")) { config.generateStar = true; }
+        else if (!strcmp(arg, "--generate2")) { settings.useGenerate2 = true; }
+        else if (!strcmp(arg, "--counters")) { counters = true; }
+        else
+        {
+            printf("Usage:\n"
+                   "  seedBench [--systems N] [--first-seed S] [--workers W] [--star G2] [--generate-star] [--generate2] [--counters]\n");
+            return 1;
+        }
+    }
+
+    const BatchGenerator batch(workerCount);
+
+    if (counters)
+    {
+        PhaseCounters::SetAllocationCounter(GetThreadAllocations);
+    }
+
+    // A Solar System-like table, in units of the ecosphere radius.
+    std::vector<ProtoplanetSeed> solarTable;
+    for (double sma : { 0.39, 0.72, 1.0, 1.52, 2.8, 5.2, 9.58, 19.2, 30.1 })
+    {
+        ProtoplanetSeed s;
+        s.semiMajorAxis = sma;
+        s.eccentricity = -1.0f;
+        solarTable.emplace_back(s);
+    }
+
+    const BodeSeedStrategy bode;
+    const UniformSeedStrategy uniform(10u);
+    const LogUniformSeedStrategy logUniform(10u);
+    const TableSeedStrategy table(solarTable, 0.05f);
+    const ResonantChainSeedStrategy resonant;
+
+    const SeedStrategy* strategies[] = { nullptr, &bode, &uniform, &logUniform, &table, &resonant };
+
+    printf("%llu systems from seed %llu, %u workers\n", static_cast<unsigned long long>(settings.systemCount),
+           static_cast<unsigned long long>(settings.firstSeed), batch.getWorkerCount());
+    printf("%-16s %12s %10s %12s %10s\n", "Strategy", "Systems/s", "Planets", "Earth-like", "Best ESI");
+
+    for (const SeedStrategy* strategy : strategies)
+    {
+        config.seedStrategy = strategy;
+        Run(strategy ? strategy->getName() : "None", batch, config, settings, counters);
+    }
+
+    return 0;
+}
@@ -0,0 +1,518 @@
+/*****************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Questionable Coding
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************/
+#include <qcSysGen/Batch.h>
+#include <qcSysGen/Catalog.h>
+#include <qcSysGen/Generator.h>
+#include <qcSysGen/Statistics.h>
+#include <qcSysGen/System.h>
+
+#include <algorithm>
+#include <atomic>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace qc::SystemGenerator;
+
+// Splits a range of seeds into shards, runs each shard in its own process, and merges the results.
+//
+//   shardRunner run <dir> [--first-seed N] [--count N] [--shards N] [--jobs N] [--only A-B]
+//                         [--protoplanets N] [--generate-star] [--bode] [--moons] [--generate2]
+//   shardRunner worker <dir> <shard>
+//   shardRunner merge <dir>
+//   shardRunner status <dir>
+//
+// `run` writes the job description to <dir>/job.txt (or reads it, if the directory already holds a job),
+// launches `shardRunner worker` for every shard that isn't done yet, up to --jobs at a time, and merges
+// the results once all of the shards are done.  Each worker writes shard-NNNN.cat (a Catalog) and
+// shard-NNNN.stats (PopulationStatistics), then shard-NNNN.done.  The done marker is written last, so
+// after a crash `run` can simply be started again and will only redo the unfinished shards.
+//
+// Several machines can share a job through a shared filesystem by giving each one a different --only
+// range of shards.  `merge` (or a final `run`) combines everything once all shards are done.
+//
+// Each worker generates its systems in seed order on a single thread, and the merge always processes
+// shards in shard order, so the merged catalog is identical no matter how many processes were used or in
+// which order they finished.  The same holds for the counts, histograms and quantiles of the statistics.
+// The means and variances are merged in floating point, so they can differ in the last digits between
+// shard counts; for a given shard count they are reproducible.
+
+namespace
+{
+
+/// @brief Version of the job.txt layout.
+static constexpr uint32_t JobVersion = 1u;
+
+/// @brief Everything needed to generate a shard.
+struct Job
+{
+    uint64_t firstSeed = 1u;
+    uint64_t systemCount = 100000u;
+    uint32_t shardCount = 16u;
+    bool useGenerate2 = false;
+    Config config;
+};
+
+//----------------------------------------------------------------------------
+// Returns the path of a file in the job directory.
+std::string JobPath(const std::string& dir, const char* name)
+{
+    return dir + "/" + name;
+}
+
+//----------------------------------------------------------------------------
+// Returns the path of one of a shard's files.
+std::string ShardPath(const std::string& dir, uint32_t shard, const char* extension)
+{
+    char name[64];
+    sprintf_s(name, "shard-%04u.%s", shard, extension);
+
+    return JobPath(dir, name);
+}
+
+//----------------------------------------------------------------------------
+// Returns true if a file exists.
+bool FileExists(const std::string& path)
+{
+    FILE* fp = nullptr;
+    if (fopen_s(&fp, path.c_str(), "rb"))
+    {
+        return false;
+    }
+    fclose(fp);
+
+    return true;
+}
+
+//----------------------------------------------------------------------------
+// Move a finished file into place, replacing any existing file.
+bool ReplaceFile(const std::string& from, const std::string& to)
+{
+    remove(to.c_str());
+
+    return rename(from.c_str(), to.c_str()) == 0;
+}
+
+//----------------------------------------------------------------------------
+// Returns the first seed offset and the number of systems in a shard.
+void GetShardRange(const Job& job, uint32_t shard, uint64_t& first, uint64_t& count)
+{
+    const uint64_t base = job.systemCount / job.shardCount;
+    const uint64_t remainder = job.systemCount % job.shardCount;
+
+    first = base * shard + std::min<uint64_t>(shard, remainder);
+    count = base + ((shard < remainder) ? 1u : 0u);
+}
+
+//----------------------------------------------------------------------------
+// Write the job description.
+bool WriteJob(const std::string& dir, const Job& job)
+{
+    const std::string path = JobPath(dir, "job.txt");
+    const std::string tmp = path + ".tmp";
+
+    FILE* fp = nullptr;
+    if (fopen_s(&fp, tmp.c_str(), "wt"))
+    {
+        return false;
+    }
+
+    fprintf(fp, "version=%u\n", JobVersion);
+    fprintf(fp, "firstSeed=%llu\n", static_cast<unsigned long long>(job.firstSeed));
+    fprintf(fp, "systemCount=%llu\n", static_cast<unsigned long long>(job.systemCount));
+    fprintf(fp, "shardCount=%u\n", job.shardCount);
+    fprintf(fp, "generate2=%d\n", job.useGenerate2 ? 1 : 0);
+    fprintf(fp, "protoplanetSeedMass=%.17g\n", job.config.protoplanetSeedMass);
+    fprintf(fp, "densityVariation=%.9g\n", job.config.densityVariation);
+    fprintf(fp, "inclinationMean=%.9g\n", job.config.inclinationMean);
+    fprintf(fp, "inclinationStdDev=%.9g\n", job.config.inclinationStdDev);
+    fprintf(fp, "protoplanetCount=%u\n", job.config.protoplanetCount);
+    fprintf(fp, "generateBodeSeeds=%d\n", job.config.generateBodeSeeds ? 1 : 0);
+    fprintf(fp, "generateMoons=%d\n", job.config.generateMoons ? 1 : 0);
+    fprintf(fp, "generateMoonsOnCollision=%d\n", job.config.generateMoonsOnCollision ? 1 : 0);
+    fprintf(fp, "generateStar=%d\n", job.config.generateStar ? 1 : 0);
+
+    const bool ok = (fclose(fp) == 0);
+
+    return ok && ReplaceFile(tmp, path);
+}
+
+//----------------------------------------------------------------------------
+// Read the job description.
+bool ReadJob(const std::string& dir, Job& job)
+{
+    FILE* fp = nullptr;
+    if (fopen_s(&fp, JobPath(dir, "job.txt").c_str(), "rt"))
+    {
+        return false;
+    }
+
+    uint32_t version = 0u;
+    char line[256];
+    while (fgets(line, sizeof(line), fp))
+    {
+        char* value = strchr(line, '=');
+        if (value == nullptr)
+        {
+            continue;
+        }
+        *value++ = '\0';
+
+        if (!strcmp(line, "version")) { version = static_cast<uint32_t>(strtoul(value, nullptr, 10)); }
+        else if (!strcmp(line, "firstSeed")) { job.firstSeed = strtoull(value, nullptr, 10); }
+        else if (!strcmp(line, "systemCount")) { job.systemCount = strtoull(value, nullptr, 10); }
+        else if (!strcmp(line, "shardCount")) { job.shardCount = static_cast<uint32_t>(strtoul(value, nullptr, 10)); }
+        else if (!strcmp(line, "generate2")) { job.useGenerate2 = atoi(value) != 0; }
+        else if (!strcmp(line, "protoplanetSeedMass")) { job.config.protoplanetSeedMass = strtod(value, nullptr); }
+        else if (!strcmp(line, "densityVariation")) { job.config.densityVariation = strtof(value, nullptr); }
+        else if (!strcmp(line, "inclinationMean")) { job.config.inclinationMean = strtof(value, nullptr); }
+        else if (!strcmp(line, "inclinationStdDev")) { job.config.inclinationStdDev = strtof(value, nullptr); }
+        else if (!strcmp(line, "protoplanetCount")) { job.config.protoplanetCount = static_cast<uint32_t>(strtoul(value, nullptr, 10)); }
+        else if (!strcmp(line, "generateBodeSeeds")) { job.config.generateBodeSeeds = atoi(value) != 0; }
+        else if (!strcmp(line, "generateMoons")) { job.config.generateMoons = atoi(value) != 0; }
+        else if (!strcmp(line, "generateMoonsOnCollision")) { job.config.generateMoonsOnCollision = atoi(value) != 0; }
+        else if (!strcmp(line, "generateStar")) { job.config.generateStar = atoi(value) != 0; }
+    }
+    fclose(fp);
+
+    return version == JobVersion && job.shardCount > 0u;
+}
+
+//----------------------------------------------------------------------------
+// Generate one shard and write its results.
+int RunWorker(const std::string& dir, uint32_t shard)
+{
+    Job job;
+    if (!ReadJob(dir, job) || shard >= job.shardCount)
+    {
+        fprintf(stderr, "worker: invalid job or shard %u in %s\n", shard, dir.c_str());
+        return 1;
+    }
+
+    BatchSettings settings;
+    uint64_t first;
+    GetShardRange(job, shard, first, settings.systemCount);
+    settings.firstSeed = job.firstSeed + first;
+    settings.useGenerate2 = job.useGenerate2;
+
+    Catalog catalog;
+    PopulationStatistics statistics;
+
+    // A single thread keeps the shard in seed order, which keeps the output deterministic.
+    BatchGenerator batch(1u);
+    batch.run(job.config, settings, [&](uint32_t, uint64_t seed, uint64_t systemIndex, const SolarSystem& system, const Generator& generator)
+    {
+        catalog.append(seed, first + systemIndex, system);
+        statistics.add(system, generator);
+    });
+
+    const std::string catalogPath = ShardPath(dir, shard, "cat");
+    const std::string statisticsPath = ShardPath(dir, shard, "stats");
+
+    bool ok = catalog.save((catalogPath + ".tmp").c_str());
+
+    FILE* fp = nullptr;
+    if (ok && !fopen_s(&fp, (statisticsPath + ".tmp").c_str(), "wb"))
+    {
+        ok = statistics.write(fp);
+        ok = (fclose(fp) == 0) && ok;
+    }
+    else
+    {
+        ok = false;
+    }
+
+    ok = ok && ReplaceFile(catalogPath + ".tmp", catalogPath) && ReplaceFile(statisticsPath + ".tmp", statisticsPath);
+
+    // The done marker goes last: its presence means the other files are complete.
+    if (ok && !fopen_s(&fp, ShardPath(dir, shard, "done").c_str(), "wt"))
+    {
+        fprintf(fp, "%llu\n", static_cast<unsigned long long>(settings.systemCount));
+        ok = (fclose(fp) == 0);
+    }
+    else
+    {
+        ok = false;
+    }
+
+    if (!ok)
+    {
+        fprintf(stderr, "worker: failed to write the results of shard %u\n", shard);
+        return 1;
+    }
+
+    return 0;
+}
+
+//----------------------------------------------------------------------------
+// Merge every shard, in shard order.
+int RunMerge(const std::string& dir)
+{
+    Job job;
+    if (!ReadJob(dir, job))
+    {
+        fprintf(stderr, "merge: no job in %s\n", dir.c_str());
+        return 1;
+    }
+
+    Catalog catalog;
+    PopulationStatistics statistics;
+
+    for (uint32_t shard = 0; shard < job.shardCount; ++shard)
+    {
+        if (!FileExists(ShardPath(dir, shard, "done")))
+        {
+            fprintf(stderr, "merge: shard %u is not done\n", shard);
+            return 1;
+        }
+
+        Catalog shardCatalog;
+        if (!shardCatalog.load(ShardPath(dir, shard, "cat").c_str()))
+        {
+            fprintf(stderr, "merge: failed to read the catalog of shard %u\n", shard);
+            return 1;
+        }
+        catalog.append(shardCatalog);
+
+        PopulationStatistics shardStatistics;
+        FILE* fp = nullptr;
+        bool ok = !fopen_s(&fp, ShardPath(dir, shard, "stats").c_str(), "rb");
+        if (ok)
+        {
+            ok = shardStatistics.read(fp);
+            fclose(fp);
+        }
+        if (!ok)
+        {
+            fprintf(stderr, "merge: failed to read the statistics of shard %u\n", shard);
+            return 1;
+        }
+        statistics.merge(shardStatistics);
+    }
+
+    bool ok = catalog.save(JobPath(dir, "catalog.cat").c_str());
+
+    FILE* fp = nullptr;
+    if (ok && !fopen_s(&fp, JobPath(dir, "statistics.stats").c_str(), "wb"))
+    {
+        ok = statistics.write(fp);
+        ok = (fclose(fp) == 0) && ok;
+    }
+    if (ok && !fopen_s(&fp, JobPath(dir, "report.txt").c_str(), "wt"))
+    {
+        statistics.report(fp);
+        ok = (fclose(fp) == 0);
+    }
+
+    if (!ok)
+    {
+        fprintf(stderr, "merge: failed to write the merged results\n");
+        return 1;
+    }
+
+    printf("merged %u shards: %llu systems, %llu planets\n", job.shardCount,
+        static_cast<unsigned long long>(catalog.getSystems().size()), static_cast<unsigned long long>(catalog.getPlanets().size()));
+
+    return 0;
+}
+
+//----------------------------------------------------------------------------
+// Print the state of each shard.
+int RunStatus(const std::string& dir)
+{
+    Job job;
+    if (!ReadJob(dir, job))
+    {
+        fprintf(stderr, "status: no job in %s\n", dir.c_str());
+        return 1;
+    }
+
+    uint32_t done = 0u;
+    for (uint32_t shard = 0; shard < job.shardCount; ++shard)
+    {
+        if (FileExists(ShardPath(dir, shard, "done")))
+        {
+            ++done;
+        }
+    }
+    printf("%u of %u shards done (seeds %llu + %llu)\n", done, job.shardCount,
+        static_cast<unsigned long long>(job.firstSeed), static_cast<unsigned long long>(job.systemCount));
+
+    return (done == job.shardCount) ? 0 : 2;
+}
+
+//----------------------------------------------------------------------------
+// Launch workers for every unfinished shard, then merge.
+int RunCoordinator(const char* self, const std::string& dir, int argc, char** argv)
+{
+    Job job;
+    bool jobSpecified = false;
+    uint32_t jobs = std::max(1u, std::thread::hardware_concurrency());
+    uint32_t onlyFirst = 0u;
+    uint32_t onlyLast = UINT32_MAX;
+
+    for (int i = 0; i < argc; ++i)
+    {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : "";
+
+        if (!strcmp(arg, "--first-seed")) { job.firstSeed = strtoull(value, nullptr, 10); jobSpecified = true; ++i; }
+        else if (!strcmp(arg, "--count")) { job.systemCount = strtoull(value, nullptr, 10); jobSpecified = true; ++i; }
+        else if (!strcmp(arg, "--shards")) { job.shardCount = static_cast<uint32_t>(strtoul(value, nullptr, 10)); jobSpecified = true; ++i; }
+        else if (!strcmp(arg, "--protoplanets")) { job.config.protoplanetCount = static_cast<uint32_t>(strtoul(value, nullptr, 10)); jobSpecified = true; ++i; }
+        else if (!strcmp(arg, "--generate-star")) { job.config.generateStar = true; jobSpecified = true; }
+        else if (!strcmp(arg, "--bode")) { job.config.generateBodeSeeds = true; jobSpecified = true; }
+        else if (!strcmp(arg, "--moons")) { job.config.generateMoons = true; jobSpecified = true; }
+        else if (!strcmp(arg, "--generate2")) { job.useGenerate2 = true; jobSpecified = true; }
+        else if (!strcmp(arg, "--jobs")) { jobs = std::max(1u, static_cast<uint32_t>(strtoul(value, nullptr, 10))); ++i; }
+        else if (!strcmp(arg, "--only"))
+        {
+            if (sscanf_s(value, "%u-%u", &onlyFirst, &onlyLast) != 2)
+            {
+                fprintf(stderr, "run: --only expects A-B\n");
+                return 1;
+            }
+            ++i;
+        }
+        else
+        {
+            fprintf(stderr, "run: unknown option %s\n", arg);
+            return 1;
+        }
+    }
+
+    if (job.shardCount == 0u)
+    {
+        fprintf(stderr, "run: --shards must be at least 1\n");
+        return 1;
+    }
+
+    Job existing;
+    if (ReadJob(dir, existing))
+    {
+        // Restarting: the directory's job wins.  Refuse to mix results from different jobs.
+        if (jobSpecified && (existing.firstSeed != job.firstSeed || existing.systemCount != job.systemCount ||
+            existing.shardCount != job.shardCount || existing.useGenerate2 != job.useGenerate2 ||
+            existing.config.protoplanetCount != job.config.protoplanetCount ||
+            existing.config.generateStar != job.config.generateStar ||
+            existing.config.generateBodeSeeds != job.config.generateBodeSeeds ||
+            existing.config.generateMoons != job.config.generateMoons))
+        {
+            fprintf(stderr, "run: %s already holds a different job\n", dir.c_str());
+            return 1;
+        }
+        job = existing;
+    }
+    else if (!WriteJob(dir, job))
+    {
+        fprintf(stderr, "run: unable to write the job to %s\n", dir.c_str());
+        return 1;
+    }
+
+    std::vector<uint32_t> pending;
+    for (uint32_t shard = std::min(onlyFirst, job.shardCount); shard <= std::min(onlyLast, job.shardCount - 1u); ++shard)
+    {
+        if (!FileExists(ShardPath(dir, shard, "done")))
+        {
+            pending.emplace_back(shard);
+        }
+    }
+
+    printf("%llu pending shards, %u at a time\n", static_cast<unsigned long long>(pending.size()), jobs);
+
+    std::atomic<size_t> next(0u);
+    std::atomic<uint32_t> failed(0u);
+    auto launcher = [&]()
+    {
+        for (size_t i = next++; i < pending.size(); i = next++)
+        {
+            const std::string command = std::string("\"") + self + "\" worker \"" + dir + "\" " + std::to_string(pending[i]);
+            if (system(command.c_str()) != 0)
+            {
+                fprintf(stderr, "run: shard %u failed\n", pending[i]);
+                ++failed;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (uint32_t i = 0; i < std::min<size_t>(jobs, pending.size()); ++i)
+    {
+        threads.emplace_back(launcher);
+    }
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+
+    if (failed > 0u)
+    {
+        fprintf(stderr, "run: %u shards failed; run again to retry them\n", failed.load());
+        return 1;
+    }
+
+    if (RunStatus(dir) != 0)
+    {
+        // Other shards belong to another machine (--only).
+        return 0;
+    }
+
+    return RunMerge(dir);
+}
+
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+    if (argc >= 3 && !strcmp(argv[1], "run"))
+    {
+        return RunCoordinator(argv[0], argv[2], argc - 3, argv + 3);
+    }
+    else if (argc == 4 && !strcmp(argv[1], "worker"))
+    {
+        return RunWorker(argv[2], static_cast<uint32_t>(strtoul(argv[3], nullptr, 10)));
+    }
+    else if (argc == 3 && !strcmp(argv[1], "merge"))
+    {
+        return RunMerge(argv[2]);
+    }
+    else if (argc == 3 && !strcmp(argv[1], "status"))
+    {
+        return RunStatus(argv[2]);
+    }
+
+    fprintf(stderr,
+        "usage: shardRunner run <dir> [--first-seed N] [--count N] [--shards N] [--jobs N] [--only A-B]\n"
+        "                         [--protoplanets N] [--generate-star] [--bode] [--moons] [--generate2]\n"
+        "       shardRunner worker <dir> <shard>\n"
+        "       shardRunner merge <dir>\n"
+        "       shardRunner status <dir>\n");
+
+    return 1;
+}
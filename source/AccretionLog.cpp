@@ -0,0 +1,139 @@
+/*****************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Questionable Coding
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************/
+#include <qcSysGen/AccretionLog.h>
+
+namespace
+{
+
+/// @brief Magic number at the start of every serialized AccretionLog ("QCAL").
+static constexpr uint32_t AccretionLogMagic = 0x4C414351u;
+
+/// @brief Version of the serialized AccretionLog layout.
+static constexpr uint32_t AccretionLogVersion = 1u;
+
+/// @brief Serialized header of an AccretionLog.
+struct AccretionLogHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t seed;
+    uint32_t eventCount;
+    uint32_t eventSize;
+};
+
+//----------------------------------------------------------------------------
+// Returns the number of bytes from the current position to the end of the file, or 0 if it can't be
+// determined.  The position is left unchanged.
+uint64_t RemainingBytes(FILE* fp)
+{
+#if defined(_WIN32)
+    const int64_t position = _ftelli64(fp);
+    if (position < 0 || _fseeki64(fp, 0, SEEK_END) != 0)
+    {
+        return 0u;
+    }
+    const int64_t end = _ftelli64(fp);
+    if (_fseeki64(fp, position, SEEK_SET) != 0 || end < position)
+    {
+        return 0u;
+    }
+#else
+    const off_t position = ftello(fp);
+    if (position < 0 || fseeko(fp, 0, SEEK_END) != 0)
+    {
+        return 0u;
+    }
+    const off_t end = ftello(fp);
+    if (fseeko(fp, position, SEEK_SET) != 0 || end < position)
+    {
+        return 0u;
+    }
+#endif
+    return static_cast<uint64_t>(end - position);
+}
+
+}
+
+namespace qc
+{
+
+namespace SystemGenerator
+{
+
+//----------------------------------------------------------------------------
+const char* AccretionEventTypeName(AccretionEventType type)
+{
+    static const char* Names[AccretionEventTypeCount] =
+    {
+        "SystemBegin",
+        "ProtoplanetInjected",
+        "DustCollected",
+        "DustLanesUpdated",
+        "Collision",
+        "PlanetCommitted",
+        "SystemEnd",
+    };
+
+    const uint32_t t = static_cast<uint32_t>(type);
+    return (t < AccretionEventTypeCount) ? Names[t] : "Unknown";
+}
+
+//----------------------------------------------------------------------------
+bool AccretionLog::read(FILE* fp)
+{
+    AccretionLogHeader header;
+    if (fread(&header, sizeof(header), 1u, fp) != 1u ||
+        header.magic != AccretionLogMagic || header.version != AccretionLogVersion || header.eventSize != sizeof(AccretionEvent))
+    {
+        return false;
+    }
+
+    // A truncated or corrupt log can claim any count, so check the events are there before allocating them.
+    if (header.eventCount > RemainingBytes(fp) / sizeof(AccretionEvent))
+    {
+        return false;
+    }
+
+    seed = header.seed;
+    events.resize(header.eventCount);
+    return fread(events.data(), sizeof(AccretionEvent), events.size(), fp) == events.size();
+}
+
+//----------------------------------------------------------------------------
+bool AccretionLog::write(FILE* fp) const
+{
+    AccretionLogHeader header;
+    header.magic = AccretionLogMagic;
+    header.version = AccretionLogVersion;
+    header.seed = seed;
+    header.eventCount = static_cast<uint32_t>(events.size());
+    header.eventSize = sizeof(AccretionEvent);
+
+    return fwrite(&header, sizeof(header), 1u, fp) == 1u &&
+        fwrite(events.data(), sizeof(AccretionEvent), events.size(), fp) == events.size();
+}
+
+}
+}
@@ -0,0 +1,394 @@
+/*****************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Questionable Coding
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************/
+#include <qcSysGen/AdaptiveSearch.h>
+
+#include <qcSysGen/Generator.h>
+#include <qcSysGen/PlanetColumns.h>
+#include <qcSysGen/PlanetFilter.h>
+#include <qcSysGen/System.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <math.h>
+#include <thread>
+
+namespace
+{
+
+/// @brief Number of samples a worker claims at a time.
+static constexpr uint32_t SampleBlockSize = 16u;
+
+/// @brief Number of attempts to draw a normal value inside [0, 1] before clamping it.
+static constexpr uint32_t TruncatedNormalAttempts = 16u;
+
+/// @brief The result of generating one sample.
+struct SampleResult
+{
+    float score; //!< Ranking score: the best ESI of the system, plus 1 if it is a hit.
+    uint32_t planetOrdinal; //!< Ordinal of the best matching planet, or 0 if there is none.
+    float earthSimilarityIndex; //!< ESI of the best matching planet.
+};
+
+//----------------------------------------------------------------------------
+// Draw a value from a normal distribution truncated to [0, 1].
+double TruncatedNormal(double mean, double sigma, std::mt19937_64& rng)
+{
+    std::normal_distribution<double> nd(mean, sigma);
+    for (uint32_t i = 0; i < TruncatedNormalAttempts; ++i)
+    {
+        const double x = nd(rng);
+        if (x >= 0.0 && x <= 1.0)
+        {
+            return x;
+        }
+    }
+
+    return std::min(1.0, std::max(0.0, mean));
+}
+
+}
+
+namespace qc
+{
+
+namespace SystemGenerator
+{
+
+//----------------------------------------------------------------------------
+AdaptiveSearch::AdaptiveSearch(const SearchSpace& space_, uint32_t workerCount_)
+    : space(space_)
+    , workerCount(workerCount_)
+{
+    if (workerCount == 0u)
+    {
+        workerCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    space.minSubtype = std::min(9, std::max(0, space.minSubtype));
+    space.maxSubtype = std::min(9, std::max(space.minSubtype, space.maxSubtype));
+    space.maxEccentricity = std::min(0.9f, std::max(0.0f, space.maxEccentricity));
+
+    for (int32_t subtype = space.minSubtype; subtype <= space.maxSubtype; ++subtype)
+    {
+        stars.emplace_back(space.starClass, subtype);
+        stars.back().evaluate();
+    }
+}
+
+//----------------------------------------------------------------------------
+void AdaptiveSearch::draw(const Proposal& proposal, bool uniform, uint64_t seed, std::mt19937_64& rng, SearchSample& sample, double* inputs) const
+{
+    const uint32_t inputCount = static_cast<uint32_t>(proposal.mean.size());
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+    // Subtype.
+    size_t starIndex = 0u;
+    if (uniform)
+    {
+        std::uniform_int_distribution<size_t> pick(0u, stars.size() - 1u);
+        starIndex = pick(rng);
+    }
+    else
+    {
+        std::discrete_distribution<size_t> pick(proposal.subtypeWeight.begin(), proposal.subtypeWeight.end());
+        starIndex = pick(rng);
+    }
+
+    for (uint32_t i = 0; i < inputCount; ++i)
+    {
+        inputs[i] = uniform ? unit(rng) : TruncatedNormal(proposal.mean[i], proposal.sigma[i], rng);
+    }
+
+    const Star& star = stars[starIndex];
+    const StarType_t type = star.getStarType();
+
+    sample.seed = seed;
+    sample.starClass = type.first;
+    sample.subtype = type.second;
+    sample.age = Star::MinimumStellarAge + inputs[0] * std::max(0.0, star.getMaximumAge() - Star::MinimumStellarAge);
+
+    // Seeds are placed on a log scale across the protoplanet zone.
+    const BandLimit_t& zone = star.getProtoplanetZone();
+    const double logInner = log(zone.first);
+    const double logOuter = log(zone.second);
+
+    sample.seeds.resize(space.seedCount);
+    for (uint32_t s = 0; s < space.seedCount; ++s)
+    {
+        const double sma = exp(logInner + inputs[1u + 2u * s] * (logOuter - logInner));
+        sample.seeds[s].semiMajorAxis = std::min(zone.second, std::max(zone.first, sma));
+        sample.seeds[s].eccentricity = static_cast<float>(inputs[2u + 2u * s]) * space.maxEccentricity;
+    }
+}
+
+//----------------------------------------------------------------------------
+double AdaptiveSearch::getHitsPerSecond() const
+{
+    uint64_t hitCount = 0u;
+    double seconds = 0.0;
+    for (const auto& r : rounds)
+    {
+        hitCount += r.hits;
+        seconds += r.seconds;
+    }
+
+    return (seconds > 0.0) ? static_cast<double>(hitCount) / seconds : 0.0;
+}
+
+//----------------------------------------------------------------------------
+void AdaptiveSearch::regenerate(const SearchSample& sample, const Config& config, bool useGenerate2, Generator& generator, SolarSystem& system)
+{
+    Config sampleConfig(config);
+    sampleConfig.generateStar = false;
+    sampleConfig.protoplanetSeeds = sample.seeds;
+
+    Star star(sample.starClass, sample.subtype);
+    star.setAge(sample.age);
+
+    system.add(star);
+    generator.seed(sample.seed);
+    if (useGenerate2)
+    {
+        generator.generate2(system, sampleConfig);
+    }
+    else
+    {
+        generator.generate(system, sampleConfig);
+    }
+}
+
+//----------------------------------------------------------------------------
+void AdaptiveSearch::run(const Config& config, const PlanetFilter& target, const AdaptiveSearchSettings& settings)
+{
+    hits.clear();
+    rounds.clear();
+
+    const uint32_t samplesPerRound = settings.samplesPerRound;
+    if (samplesPerRound == 0u || !target.isValid())
+    {
+        return;
+    }
+
+    // The age, then the semi-major axis and eccentricity of each seed.
+    const uint32_t inputCount = 1u + 2u * space.seedCount;
+
+    // Start from the moments of the uniform distribution.
+    Proposal proposal;
+    proposal.subtypeWeight.assign(stars.size(), 1.0 / static_cast<double>(stars.size()));
+    proposal.mean.assign(inputCount, 0.5);
+    proposal.sigma.assign(inputCount, sqrt(1.0 / 12.0));
+
+    std::mt19937_64 rng(settings.searchSeed);
+
+    std::vector<SearchSample> samples(samplesPerRound);
+    std::vector<double> inputs(static_cast<size_t>(samplesPerRound) * inputCount);
+    std::vector<SampleResult> results(samplesPerRound);
+    std::vector<uint32_t> order(samplesPerRound);
+    std::vector<uint32_t> elite;
+    std::vector<double> workerSeconds(workerCount);
+
+    const uint32_t eliteCount = std::max(1u, static_cast<uint32_t>(settings.eliteFraction * samplesPerRound));
+
+    for (uint32_t round = 0; round < settings.roundCount; ++round)
+    {
+        const bool uniform = (round == 0u || !settings.adaptive);
+        const uint64_t firstSeed = settings.firstSeed + static_cast<uint64_t>(round) * samplesPerRound;
+        for (uint32_t i = 0; i < samplesPerRound; ++i)
+        {
+            draw(proposal, uniform, firstSeed + i, rng, samples[i], &inputs[static_cast<size_t>(i) * inputCount]);
+        }
+
+        std::atomic<uint32_t> next(0u);
+        std::fill(workerSeconds.begin(), workerSeconds.end(), 0.0);
+
+        auto worker = [&](uint32_t workerIndex)
+        {
+            Generator generator;
+            SolarSystem system;
+            PlanetColumns columns;
+            std::vector<uint32_t> rows;
+
+            for (;;)
+            {
+                const uint32_t first = next.fetch_add(SampleBlockSize, std::memory_order_relaxed);
+                if (first >= samplesPerRound)
+                {
+                    break;
+                }
+                const uint32_t last = std::min(first + SampleBlockSize, samplesPerRound);
+
+                const auto start = std::chrono::steady_clock::now();
+                for (uint32_t i = first; i < last; ++i)
+                {
+                    regenerate(samples[i], config, settings.useGenerate2, generator, system);
+
+                    columns.clear();
+                    columns.append(0u, system);
+                    target.select(columns, rows);
+
+                    SampleResult& r = results[i];
+                    r.score = 0.0f;
+                    r.planetOrdinal = 0u;
+                    r.earthSimilarityIndex = 0.0f;
+                    for (const auto& esi : columns.earthSimilarityIndex)
+                    {
+                        r.score = std::max(r.score, esi);
+                    }
+
+                    for (uint32_t row : rows)
+                    {
+                        if (r.planetOrdinal == 0u || columns.earthSimilarityIndex[row] > r.earthSimilarityIndex)
+                        {
+                            r.planetOrdinal = columns.ordinal[row];
+                            r.earthSimilarityIndex = columns.earthSimilarityIndex[row];
+                        }
+                    }
+
+                    if (r.planetOrdinal != 0u)
+                    {
+                        r.score += 1.0f;
+                    }
+                }
+                workerSeconds[workerIndex] += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            }
+        };
+
+        if (workerCount == 1u)
+        {
+            worker(0u);
+        }
+        else
+        {
+            std::vector<std::thread> threads;
+            threads.reserve(workerCount);
+            for (uint32_t i = 0; i < workerCount; ++i)
+            {
+                threads.emplace_back(worker, i);
+            }
+
+            for (auto& t : threads)
+            {
+                t.join();
+            }
+        }
+
+        SearchRound stats;
+        stats.samples = samplesPerRound;
+        stats.hits = 0u;
+        stats.seconds = 0.0;
+        for (double s : workerSeconds)
+        {
+            stats.seconds += s;
+        }
+
+        for (uint32_t i = 0; i < samplesPerRound; ++i)
+        {
+            if (results[i].planetOrdinal != 0u)
+            {
+                SearchHit h;
+                h.sample = samples[i];
+                h.round = round;
+                h.planetOrdinal = results[i].planetOrdinal;
+                h.earthSimilarityIndex = results[i].earthSimilarityIndex;
+                hits.emplace_back(h);
+                ++stats.hits;
+            }
+            order[i] = i;
+        }
+
+        // Rank the samples, best first.  Ties are broken by index so the ranking does not depend on the workers.
+        std::sort(order.begin(), order.end(), [&results](uint32_t lhs, uint32_t rhs)
+        {
+            return (results[lhs].score != results[rhs].score) ? (results[lhs].score > results[rhs].score) : (lhs < rhs);
+        });
+
+        elite.clear();
+        for (uint32_t i = 0; i < eliteCount && results[order[i]].score > 0.0f; ++i)
+        {
+            elite.emplace_back(order[i]);
+        }
+        stats.eliteScore = elite.empty() ? 0.0f : results[elite.back()].score;
+        rounds.emplace_back(stats);
+
+        if (settings.adaptive && !elite.empty())
+        {
+            update(proposal, settings, elite, samples, inputs);
+        }
+    }
+}
+
+//----------------------------------------------------------------------------
+void AdaptiveSearch::update(Proposal& proposal, const AdaptiveSearchSettings& settings, const std::vector<uint32_t>& elite, const std::vector<SearchSample>& samples, const std::vector<double>& inputs) const
+{
+    const size_t inputCount = proposal.mean.size();
+    const double alpha = std::min(1.0, std::max(0.0, static_cast<double>(settings.smoothing)));
+    const double eliteCount = static_cast<double>(elite.size());
+
+    // Subtypes: move towards the elite frequencies, and keep every subtype reachable.
+    std::vector<double> frequency(proposal.subtypeWeight.size(), 0.0);
+    for (uint32_t e : elite)
+    {
+        frequency[samples[e].subtype - space.minSubtype] += 1.0 / eliteCount;
+    }
+
+    const double minWeight = settings.minSubtypeWeight / static_cast<double>(frequency.size());
+    double total = 0.0;
+    for (size_t i = 0; i < frequency.size(); ++i)
+    {
+        double& w = proposal.subtypeWeight[i];
+        w = std::max(minWeight, alpha * frequency[i] + (1.0 - alpha) * w);
+        total += w;
+    }
+    for (auto& w : proposal.subtypeWeight)
+    {
+        w /= total;
+    }
+
+    // Continuous inputs: move towards the elite mean and standard deviation.
+    for (size_t i = 0; i < inputCount; ++i)
+    {
+        double mean = 0.0;
+        for (uint32_t e : elite)
+        {
+            mean += inputs[e * inputCount + i];
+        }
+        mean /= eliteCount;
+
+        double variance = 0.0;
+        for (uint32_t e : elite)
+        {
+            const double d = inputs[e * inputCount + i] - mean;
+            variance += d * d;
+        }
+        variance /= eliteCount;
+
+        proposal.mean[i] = alpha * mean + (1.0 - alpha) * proposal.mean[i];
+        proposal.sigma[i] = std::max(static_cast<double>(settings.minSigma), alpha * sqrt(variance) + (1.0 - alpha) * proposal.sigma[i]);
+    }
+}
+
+}
+}
@@ -0,0 +1,389 @@
+/*****************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Questionable Coding
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************/
+#include <qcSysGen/Batch.h>
+
+#include <qcSysGen/CostProfiler.h>
+#include <qcSysGen/Generator.h>
+#include <qcSysGen/Metrics.h>
+#include <qcSysGen/PhaseCounters.h>
+#include <qcSysGen/RecordWriter.h>
+#include <qcSysGen/System.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+/// @brief Number of systems a worker claims at a time.  Small enough to balance the load
+/// between workers, large enough that the shared counter isn't contended.
+static constexpr uint64_t BatchBlockSize = 16u;
+
+/// @brief One node's share of the batch.  Padded to a cache line, so the nodes' counters are a cache line apart
+/// and never share one, wherever new[] places the array.
+struct NodeRange
+{
+    std::atomic<uint64_t> next; //!< Next unclaimed system index.
+    uint64_t end; //!< One past the last system index of the share.
+    uint8_t padding[48]; //!< Keeps each counter on its own cache line.
+};
+static_assert(sizeof(NodeRange) == 64u, "NodeRange must fill exactly one cache line");
+
+}
+
+namespace qc
+{
+
+namespace SystemGenerator
+{
+
+//----------------------------------------------------------------------------
+BatchGenerator::BatchGenerator(uint32_t workerCount_, bool numaAware_)
+    : workerCount(workerCount_)
+    , numaAware(numaAware_)
+{
+    if (numaAware)
+    {
+        std::vector<NumaNode> topology = GetNumaTopology();
+
+        // Lay the processors of every node end to end, and hand out workers in that order, so each
+        // node receives workers in proportion to its processor count.
+        std::vector<uint32_t> slotNode;
+        for (uint32_t n = 0; n < topology.size(); ++n)
+        {
+            slotNode.insert(slotNode.end(), topology[n].processor.size(), n);
+        }
+
+        if (workerCount == 0u)
+        {
+            workerCount = static_cast<uint32_t>(slotNode.size());
+        }
+
+        // Spread the workers over the whole list, rather than filling the first node, when there
+        // are fewer workers than processors.
+        std::vector<uint32_t> topologyNode(workerCount);
+        std::vector<bool> used(topology.size(), false);
+        for (uint32_t i = 0; i < workerCount; ++i)
+        {
+            const uint64_t slot = (static_cast<uint64_t>(i) * slotNode.size() / workerCount) % slotNode.size();
+            topologyNode[i] = slotNode[static_cast<size_t>(slot)];
+            used[topologyNode[i]] = true;
+        }
+
+        // Drop the nodes that didn't receive a worker.
+        std::vector<uint32_t> remap(topology.size(), 0u);
+        for (uint32_t n = 0; n < topology.size(); ++n)
+        {
+            if (used[n])
+            {
+                remap[n] = static_cast<uint32_t>(nodes.size());
+                nodes.emplace_back(topology[n]);
+            }
+        }
+
+        workerNode.resize(workerCount);
+        nodeWorkerCount.resize(nodes.size(), 0u);
+        for (uint32_t i = 0; i < workerCount; ++i)
+        {
+            workerNode[i] = remap[topologyNode[i]];
+            ++nodeWorkerCount[workerNode[i]];
+        }
+    }
+    else
+    {
+        if (workerCount == 0u)
+        {
+            workerCount = std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        nodes.resize(1u);
+        nodes[0].id = 0u;
+        nodes[0].group = 0u;
+        workerNode.resize(workerCount, 0u);
+        nodeWorkerCount.resize(1u, workerCount);
+    }
+}
+
+//----------------------------------------------------------------------------
+void BatchGenerator::run(const Config& config, const BatchSettings& settings, const FilterCallback& filter, const SystemCallback& callback) const
+{
+    const uint32_t nodeCount = getNodeCount();
+
+    // Split the batch between the nodes in proportion to their worker counts.
+    std::unique_ptr<NodeRange[]> ranges(new NodeRange[nodeCount]);
+    uint64_t begin = 0u;
+    uint32_t workersBefore = 0u;
+    for (uint32_t n = 0; n < nodeCount; ++n)
+    {
+        workersBefore += nodeWorkerCount[n];
+
+        // Avoid overflowing when the system count is very large.
+        const uint64_t end = (n + 1u == nodeCount) ? settings.systemCount :
+            settings.systemCount / workerCount * workersBefore + settings.systemCount % workerCount * workersBefore / workerCount;
+
+        ranges[n].next.store(begin, std::memory_order_relaxed);
+        ranges[n].end = end;
+        begin = end;
+    }
+
+    // Normalized once, and shared by every worker.
+    const PreparedConfig prepared(config, settings.star);
+
+    // Guards settings.phaseCounters while the workers add their counts.
+    std::mutex phaseCountersMutex;
+
+    // Systems each worker skipped when the batch was cancelled.
+    std::vector<uint64_t> skipped(workerCount, 0u);
+
+    if (settings.metrics)
+    {
+        settings.metrics->queueDepth.add(static_cast<double>(settings.systemCount));
+    }
+
+    auto worker = [&](uint32_t workerIndex)
+    {
+        const uint32_t node = workerNode[workerIndex];
+        if (numaAware)
+        {
+            PinThreadToNode(nodes[node]);
+        }
+
+        // Created after pinning, so their memory is first touched on the worker's node.
+        Generator generator;
+        SolarSystem system;
+        AccretionLog accretionLog;
+        SystemCost systemCost;
+        if (settings.profileCosts)
+        {
+            generator.setSystemCost(&systemCost);
+        }
+
+        // Hardware counters only count the thread that opened them.
+        PhaseCounters phaseCounters;
+        if (settings.phaseCounters)
+        {
+            phaseCounters.open();
+            generator.setPhaseCounters(&phaseCounters);
+        }
+
+        // Work through this node's share first, then help the other nodes.
+        const bool timed = settings.profileCosts || settings.metrics;
+        bool cancelled = false;
+        for (uint32_t r = 0; r < nodeCount && !cancelled; ++r)
+        {
+            NodeRange& range = ranges[(node + r) % nodeCount];
+
+            while (!cancelled)
+            {
+                if (range.next.load(std::memory_order_relaxed) >= range.end)
+                {
+                    break;
+                }
+
+                const uint64_t first = range.next.fetch_add(BatchBlockSize, std::memory_order_relaxed);
+                if (first >= range.end)
+                {
+                    break;
+                }
+                const uint64_t last = std::min(first + BatchBlockSize, range.end);
+
+                if (settings.metrics)
+                {
+                    settings.metrics->queueDepth.add(-static_cast<double>(last - first));
+                }
+
+                for (uint64_t systemIndex = first; systemIndex < last; ++systemIndex)
+                {
+                    if (settings.cancel && settings.cancel->load(std::memory_order_relaxed))
+                    {
+                        skipped[workerIndex] += last - systemIndex;
+                        cancelled = true;
+                        break;
+                    }
+
+                    const uint64_t seed = settings.firstSeed + systemIndex;
+
+                    std::chrono::steady_clock::time_point start;
+                    if (timed)
+                    {
+                        systemCost.systemIndex = systemIndex;
+                        start = std::chrono::steady_clock::now();
+                    }
+
+                    system.add(settings.star);
+                    generator.seed(seed);
+                    if (settings.accretionLogInterval > 0u)
+                    {
+                        generator.setAccretionLog((systemIndex % settings.accretionLogInterval == 0u) ? &accretionLog : nullptr);
+                    }
+                    if (settings.useGenerate2)
+                    {
+                        generator.accrete2(system, prepared);
+                    }
+                    else
+                    {
+                        generator.accrete(system, prepared);
+                    }
+
+                    std::chrono::steady_clock::time_point accreted;
+                    if (timed)
+                    {
+                        accreted = std::chrono::steady_clock::now();
+                        systemCost.seconds = std::chrono::duration<double>(accreted - start).count();
+                        if (settings.metrics)
+                        {
+                            settings.metrics->accretionSeconds.observe(systemCost.seconds);
+                        }
+                    }
+
+                    if (filter && !filter(workerIndex, seed, systemIndex, system, generator))
+                    {
+                        if (settings.metrics)
+                        {
+                            settings.metrics->systemsDiscarded.add();
+                        }
+                        if (settings.output)
+                        {
+                            settings.output->skip(workerIndex, systemIndex);
+                        }
+                        continue;
+                    }
+
+                    system.evaluate(generator);
+
+                    if (timed)
+                    {
+                        const std::chrono::steady_clock::time_point evaluated = std::chrono::steady_clock::now();
+                        systemCost.seconds = std::chrono::duration<double>(evaluated - start).count();
+                        if (settings.metrics)
+                        {
+                            settings.metrics->evaluationSeconds.observe(std::chrono::duration<double>(evaluated - accreted).count());
+                            settings.metrics->planetsPerSystem.observe(static_cast<double>(system.getPlanets().size()));
+                            settings.metrics->systemsGenerated.add();
+                        }
+                    }
+
+                    if (settings.output)
+                    {
+                        settings.output->append(workerIndex, seed, systemIndex, system);
+                    }
+
+                    callback(workerIndex, seed, systemIndex, system, generator);
+                }
+            }
+        }
+
+        if (settings.output)
+        {
+            settings.output->flush(workerIndex);
+        }
+
+        if (settings.phaseCounters)
+        {
+            phaseCounters.close();
+
+            std::lock_guard<std::mutex> guard(phaseCountersMutex);
+            settings.phaseCounters->merge(phaseCounters);
+        }
+    };
+
+    // A single worker runs on the calling thread, unless it would have to pin it.
+    if (workerCount == 1u && !numaAware)
+    {
+        worker(0u);
+    }
+    else
+    {
+        std::vector<std::thread> threads;
+        threads.reserve(workerCount);
+        for (uint32_t i = 0; i < workerCount; ++i)
+        {
+            threads.emplace_back(worker, i);
+        }
+
+        for (auto& t : threads)
+        {
+            t.join();
+        }
+    }
+
+    if (settings.cancel)
+    {
+        // Systems skipped inside claimed blocks, and the blocks nobody claimed.
+        uint64_t cancelledCount = 0u;
+        for (uint64_t s : skipped)
+        {
+            cancelledCount += s;
+        }
+
+        uint64_t unclaimed = 0u;
+        for (uint32_t n = 0; n < nodeCount; ++n)
+        {
+            const uint64_t next = ranges[n].next.load(std::memory_order_relaxed);
+            unclaimed += (next < ranges[n].end) ? ranges[n].end - next : 0u;
+        }
+        cancelledCount += unclaimed;
+
+        if (settings.metrics)
+        {
+            settings.metrics->systemsCancelled.add(cancelledCount);
+            settings.metrics->queueDepth.add(-static_cast<double>(unclaimed));
+        }
+    }
+}
+
+//----------------------------------------------------------------------------
+void BatchGenerator::runOnNodes(const NodeCallback& callback) const
+{
+    if (!numaAware)
+    {
+        callback(0u);
+        return;
+    }
+
+    std::vector<std::thread> threads;
+    threads.reserve(nodes.size());
+    for (uint32_t n = 0; n < nodes.size(); ++n)
+    {
+        threads.emplace_back([this, &callback](uint32_t node)
+        {
+            PinThreadToNode(nodes[node]);
+            callback(node);
+        }, n);
+    }
+
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+}
+
+}
+}
@@ -0,0 +1,281 @@
+/*****************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Questionable Coding
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************/
+#include <qcSysGen/Catalog.h>
+
+#include <qcSysGen/System.h>
+
+#include <stdio.h>
+
+namespace
+{
+
+/// @brief Identifies a catalog file ("QCSC").
+static constexpr uint32_t CatalogMagic = 0x43534351u;
+
+/// @brief Version of the catalog file layout.  Increment when the layout changes.
+static constexpr uint32_t CatalogFileVersion = 1u;
+
+/// @brief The first bytes of a catalog file.
+struct CatalogFileHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t systemCount;
+    uint64_t planetCount;
+};
+
+//----------------------------------------------------------------------------
+// Write a column to the file.
+template <typename T_>
+bool WriteColumn(FILE* fp, const std::vector<T_>& column)
+{
+    return column.empty() || fwrite(column.data(), sizeof(T_), column.size(), fp) == column.size();
+}
+
+//----------------------------------------------------------------------------
+// Read a column of `count` rows from the file.
+template <typename T_>
+bool ReadColumn(FILE* fp, std::vector<T_>& column, size_t count)
+{
+    column.resize(count);
+    return count == 0u || fread(column.data(), sizeof(T_), count, fp) == count;
+}
+
+//----------------------------------------------------------------------------
+// Returns the number of bytes from the current position to the end of the file, or 0 if it can't be
+// determined.  The position is left unchanged.
+uint64_t RemainingBytes(FILE* fp)
+{
+#if defined(_WIN32)
+    const int64_t position = _ftelli64(fp);
+    if (position < 0 || _fseeki64(fp, 0, SEEK_END) != 0)
+    {
+        return 0u;
+    }
+    const int64_t end = _ftelli64(fp);
+    if (_fseeki64(fp, position, SEEK_SET) != 0 || end < position)
+    {
+        return 0u;
+    }
+#else
+    const off_t position = ftello(fp);
+    if (position < 0 || fseeko(fp, 0, SEEK_END) != 0)
+    {
+        return 0u;
+    }
+    const off_t end = ftello(fp);
+    if (fseeko(fp, position, SEEK_SET) != 0 || end < position)
+    {
+        return 0u;
+    }
+#endif
+    return static_cast<uint64_t>(end - position);
+}
+
+}
+
+namespace qc
+{
+
+namespace SystemGenerator
+{
+
+//----------------------------------------------------------------------------
+void Catalog::append(uint64_t seed, uint64_t systemIndex, const SolarSystem& system)
+{
+    const StarType_t starType = system.getStar().getStarType();
+    const PlanetVector& planet = system.getPlanets();
+
+    CatalogSystem s;
+    s.seed = seed;
+    s.systemIndex = systemIndex;
+    s.firstPlanet = static_cast<uint32_t>(planets.size());
+    s.planetCount = static_cast<uint32_t>(planet.size());
+    s.starClass = static_cast<uint8_t>(starType.first);
+    s.starSubtype = static_cast<uint8_t>(starType.second);
+    s.reserved = 0u;
+
+    const uint32_t systemRow = static_cast<uint32_t>(systems.size());
+    systems.emplace_back(s);
+
+    planets.append(systemRow, system);
+
+    index.append(planets);
+}
+
+//----------------------------------------------------------------------------
+void Catalog::append(const Catalog& rhs)
+{
+    const uint32_t systemOffset = static_cast<uint32_t>(systems.size());
+    const uint32_t planetOffset = static_cast<uint32_t>(planets.size());
+
+    systems.insert(systems.end(), rhs.systems.begin(), rhs.systems.end());
+    for (size_t i = systemOffset; i < systems.size(); ++i)
+    {
+        systems[i].firstPlanet += planetOffset;
+    }
+
+    planets.append(rhs.planets, systemOffset);
+
+    index.append(planets);
+}
+
+//----------------------------------------------------------------------------
+void Catalog::clear()
+{
+    systems.clear();
+    planets.clear();
+    index.clear();
+}
+
+//----------------------------------------------------------------------------
+void Catalog::findSystems(const CatalogQuery& query, std::vector<uint32_t>& rows) const
+{
+    std::vector<uint32_t> planetRows;
+    index.find(planets, query, planetRows);
+
+    // Planet rows are grouped by system, so the matching systems come out in order.
+    rows.clear();
+    for (uint32_t p : planetRows)
+    {
+        const uint32_t s = planets.system[p];
+        if (rows.empty() || rows.back() != s)
+        {
+            rows.emplace_back(s);
+        }
+    }
+}
+
+//----------------------------------------------------------------------------
+bool Catalog::load(const char* filename)
+{
+    clear();
+
+    FILE* fp = nullptr;
+    if (fopen_s(&fp, filename, "rb"))
+    {
+        return false;
+    }
+
+    CatalogFileHeader header;
+    bool ok = (fread(&header, sizeof(header), 1u, fp) == 1u) &&
+        header.magic == CatalogMagic &&
+        header.version == CatalogFileVersion;
+
+    // The counts size the columns, so check that the file holds that many rows before allocating them.
+    if (ok)
+    {
+        const PlanetColumns& p = planets;
+        const uint64_t planetBytes = sizeof(p.system[0]) + sizeof(p.ordinal[0]) + sizeof(p.starClass[0]) + sizeof(p.planetType[0]) +
+            sizeof(p.orbitalZone[0]) + sizeof(p.semimajorAxis[0]) + sizeof(p.mass[0]) + sizeof(p.radius[0]) +
+            sizeof(p.earthSimilarityIndex[0]) + sizeof(p.surfaceTemperature[0]) + sizeof(p.hydrosphere[0]) + sizeof(p.surfacePressure[0]);
+        const uint64_t remaining = RemainingBytes(fp);
+        ok = header.systemCount <= remaining / sizeof(CatalogSystem) &&
+            header.planetCount <= (remaining - header.systemCount * sizeof(CatalogSystem)) / planetBytes &&
+            header.planetCount <= UINT32_MAX && header.systemCount <= UINT32_MAX;
+    }
+
+    if (ok)
+    {
+        const size_t planetCount = static_cast<size_t>(header.planetCount);
+        ok = ReadColumn(fp, systems, static_cast<size_t>(header.systemCount)) &&
+            ReadColumn(fp, planets.system, planetCount) &&
+            ReadColumn(fp, planets.ordinal, planetCount) &&
+            ReadColumn(fp, planets.starClass, planetCount) &&
+            ReadColumn(fp, planets.planetType, planetCount) &&
+            ReadColumn(fp, planets.orbitalZone, planetCount) &&
+            ReadColumn(fp, planets.semimajorAxis, planetCount) &&
+            ReadColumn(fp, planets.mass, planetCount) &&
+            ReadColumn(fp, planets.radius, planetCount) &&
+            ReadColumn(fp, planets.earthSimilarityIndex, planetCount) &&
+            ReadColumn(fp, planets.surfaceTemperature, planetCount) &&
+            ReadColumn(fp, planets.hydrosphere, planetCount) &&
+            ReadColumn(fp, planets.surfacePressure, planetCount);
+    }
+
+    fclose(fp);
+
+    // The index and the queries use these as array indices, so reject anything out of range rather than
+    // trusting the file.
+    for (size_t i = 0; ok && i < systems.size(); ++i)
+    {
+        const CatalogSystem& s = systems[i];
+        ok = s.starClass < StarClassificationCount &&
+            s.firstPlanet <= planets.size() && s.planetCount <= planets.size() - s.firstPlanet;
+    }
+    for (size_t i = 0; ok && i < planets.size(); ++i)
+    {
+        ok = planets.system[i] < systems.size() &&
+            planets.starClass[i] < StarClassificationCount &&
+            planets.planetType[i] < PlanetTypeCount &&
+            planets.orbitalZone[i] < OrbitalZoneCount;
+    }
+
+    if (!ok)
+    {
+        clear();
+        return false;
+    }
+
+    index.append(planets);
+
+    return true;
+}
+
+//----------------------------------------------------------------------------
+bool Catalog::save(const char* filename) const
+{
+    FILE* fp = nullptr;
+    if (fopen_s(&fp, filename, "wb"))
+    {
+        return false;
+    }
+
+    CatalogFileHeader header;
+    header.magic = CatalogMagic;
+    header.version = CatalogFileVersion;
+    header.systemCount = systems.size();
+    header.planetCount = planets.size();
+
+    const bool ok = (fwrite(&header, sizeof(header), 1u, fp) == 1u) &&
+        WriteColumn(fp, systems) &&
+        WriteColumn(fp, planets.system) &&
+        WriteColumn(fp, planets.ordinal) &&
+        WriteColumn(fp, planets.starClass) &&
+        WriteColumn(fp, planets.planetType) &&
+        WriteColumn(fp, planets.orbitalZone) &&
+        WriteColumn(fp, planets.semimajorAxis) &&
+        WriteColumn(fp, planets.mass) &&
+        WriteColumn(fp, planets.radius) &&
+        WriteColumn(fp, planets.earthSimilarityIndex) &&
+        WriteColumn(fp, planets.surfaceTemperature) &&
+        WriteColumn(fp, planets.hydrosphere) &&
+        WriteColumn(fp, planets.surfacePressure);
+
+    return (fclose(fp) == 0) && ok;
+}
+
+}
+}
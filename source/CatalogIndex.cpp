@@ -0,0 +1,343 @@
+/*****************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Questionable Coding
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************/
+#include <qcSysGen/CatalogIndex.h>
+
+#include <algorithm>
+#include <assert.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Returns the index of the lowest set bit.  `value` must not be 0.
+__inline uint32_t LowestBit(uint64_t value)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return index;
+#else
+    return static_cast<uint32_t>(__builtin_ctzll(value));
+#endif
+}
+
+//----------------------------------------------------------------------------
+// Build the union of the bitmaps selected by `mask`.
+void UniteSelected(qc::SystemGenerator::Bitmap& out, const qc::SystemGenerator::Bitmap* bitmap, uint32_t bitmapCount, uint32_t mask, size_t rowCount)
+{
+    out.resize(0u);
+    out.resize(rowCount);
+    for (uint32_t i = 0; i < bitmapCount; ++i)
+    {
+        if (mask & (1u << i))
+        {
+            out.unite(bitmap[i]);
+        }
+    }
+}
+
+}
+
+namespace qc
+{
+
+namespace SystemGenerator
+{
+
+//----------------------------------------------------------------------------
+size_t Bitmap::count() const
+{
+    size_t total = 0u;
+    for (uint64_t w : word)
+    {
+        while (w != 0u)
+        {
+            w &= w - 1u;
+            ++total;
+        }
+    }
+
+    return total;
+}
+
+//----------------------------------------------------------------------------
+void Bitmap::intersect(const Bitmap& rhs)
+{
+    const size_t common = std::min(word.size(), rhs.word.size());
+    for (size_t i = 0; i < common; ++i)
+    {
+        word[i] &= rhs.word[i];
+    }
+    std::fill(word.begin() + common, word.end(), 0u);
+}
+
+//----------------------------------------------------------------------------
+void Bitmap::resize(size_t bitCount_)
+{
+    bitCount = bitCount_;
+    word.resize((bitCount + 63u) >> 6u, 0u);
+
+    // Keep the bits past the end clear, so growing the bitmap again doesn't resurrect them.
+    if (bitCount & 63u)
+    {
+        word.back() &= (1ull << (bitCount & 63u)) - 1u;
+    }
+}
+
+//----------------------------------------------------------------------------
+void Bitmap::setAll()
+{
+    std::fill(word.begin(), word.end(), ~0ull);
+    if (bitCount & 63u)
+    {
+        word.back() = (1ull << (bitCount & 63u)) - 1u;
+    }
+}
+
+//----------------------------------------------------------------------------
+void Bitmap::unite(const Bitmap& rhs)
+{
+    assert(rhs.word.size() <= word.size());
+
+    for (size_t i = 0; i < rhs.word.size(); ++i)
+    {
+        word[i] |= rhs.word[i];
+    }
+}
+
+//----------------------------------------------------------------------------
+void ZoneMap::append(float value)
+{
+    if ((rowCount % BlockSize) == 0u)
+    {
+        minimum.emplace_back(value);
+        maximum.emplace_back(value);
+    }
+    else
+    {
+        minimum.back() = std::min(minimum.back(), value);
+        maximum.back() = std::max(maximum.back(), value);
+    }
+    ++rowCount;
+}
+
+//----------------------------------------------------------------------------
+void ZoneMap::clear()
+{
+    minimum.clear();
+    maximum.clear();
+    rowCount = 0u;
+}
+
+//----------------------------------------------------------------------------
+void CatalogIndex::append(const PlanetColumns& planets)
+{
+    const size_t first = rowCount;
+    const size_t last = planets.size();
+    assert(last >= first);
+
+    for (auto& b : starClass)
+    {
+        b.resize(last);
+    }
+    for (auto& b : planetType)
+    {
+        b.resize(last);
+    }
+    for (auto& b : orbitalZone)
+    {
+        b.resize(last);
+    }
+
+    for (size_t i = first; i < last; ++i)
+    {
+        assert(planets.starClass[i] < StarClassificationCount && planets.planetType[i] < PlanetTypeCount && planets.orbitalZone[i] < OrbitalZoneCount);
+
+        starClass[planets.starClass[i]].set(i);
+        planetType[planets.planetType[i]].set(i);
+        orbitalZone[planets.orbitalZone[i]].set(i);
+
+        earthSimilarityIndex.append(planets.earthSimilarityIndex[i]);
+        mass.append(planets.mass[i]);
+        surfaceTemperature.append(planets.surfaceTemperature[i]);
+    }
+
+    rowCount = last;
+}
+
+//----------------------------------------------------------------------------
+void CatalogIndex::clear()
+{
+    rowCount = 0u;
+
+    for (auto& b : starClass)
+    {
+        b.resize(0u);
+    }
+    for (auto& b : planetType)
+    {
+        b.resize(0u);
+    }
+    for (auto& b : orbitalZone)
+    {
+        b.resize(0u);
+    }
+
+    earthSimilarityIndex.clear();
+    mass.clear();
+    surfaceTemperature.clear();
+}
+
+//----------------------------------------------------------------------------
+void CatalogIndex::find(const PlanetColumns& planets, const CatalogQuery& query, std::vector<uint32_t>& rows) const
+{
+    rows.clear();
+
+    assert(planets.size() >= rowCount);
+
+    Bitmap candidates;
+    if (!selectCandidates(query, candidates))
+    {
+        candidates.resize(rowCount);
+        candidates.setAll();
+    }
+
+    struct RangeTerm
+    {
+        const CatalogRange* range;
+        const ZoneMap* zoneMap;
+        const float* column;
+    };
+    RangeTerm term[3];
+    uint32_t termCount = 0u;
+
+    if (query.earthSimilarityIndex.isBounded())
+    {
+        term[termCount++] = { &query.earthSimilarityIndex, &earthSimilarityIndex, planets.earthSimilarityIndex.data() };
+    }
+    if (query.mass.isBounded())
+    {
+        term[termCount++] = { &query.mass, &mass, planets.mass.data() };
+    }
+    if (query.surfaceTemperature.isBounded())
+    {
+        term[termCount++] = { &query.surfaceTemperature, &surfaceTemperature, planets.surfaceTemperature.data() };
+    }
+
+    const std::vector<uint64_t>& word = candidates.getWords();
+    static constexpr size_t WordsPerBlock = ZoneMap::BlockSize / 64u;
+    const size_t blockCount = (rowCount + ZoneMap::BlockSize - 1u) / ZoneMap::BlockSize;
+
+    for (size_t block = 0; block < blockCount; ++block)
+    {
+        // Classify the block against each range: skip it if any range excludes every row, and only
+        // read the columns of the ranges that the block straddles.
+        RangeTerm straddled[3];
+        uint32_t straddledCount = 0u;
+        bool excluded = false;
+        for (uint32_t t = 0; t < termCount && !excluded; ++t)
+        {
+            const float lower = term[t].zoneMap->getMinimum(block);
+            const float upper = term[t].zoneMap->getMaximum(block);
+            if (upper < term[t].range->lower || lower > term[t].range->upper)
+            {
+                excluded = true;
+            }
+            else if (lower < term[t].range->lower || upper > term[t].range->upper)
+            {
+                straddled[straddledCount++] = term[t];
+            }
+        }
+
+        if (excluded)
+        {
+            continue;
+        }
+
+        const size_t lastWord = std::min((block + 1u) * WordsPerBlock, word.size());
+        for (size_t w = block * WordsPerBlock; w < lastWord; ++w)
+        {
+            uint64_t bits = word[w];
+            while (bits != 0u)
+            {
+                const uint32_t row = static_cast<uint32_t>((w << 6u) + LowestBit(bits));
+                bits &= bits - 1u;
+
+                bool match = true;
+                for (uint32_t t = 0; t < straddledCount && match; ++t)
+                {
+                    match = straddled[t].range->contains(straddled[t].column[row]);
+                }
+
+                if (match)
+                {
+                    rows.emplace_back(row);
+                }
+            }
+        }
+    }
+}
+
+//----------------------------------------------------------------------------
+bool CatalogIndex::selectCandidates(const CatalogQuery& query, Bitmap& candidates) const
+{
+    bool restricted = false;
+    Bitmap selected;
+
+    if (query.starClasses != 0u)
+    {
+        UniteSelected(candidates, starClass, StarClassificationCount, query.starClasses, rowCount);
+        restricted = true;
+    }
+
+    if (query.planetTypes != 0u)
+    {
+        UniteSelected((restricted) ? selected : candidates, planetType, PlanetTypeCount, query.planetTypes, rowCount);
+        if (restricted)
+        {
+            candidates.intersect(selected);
+        }
+        restricted = true;
+    }
+
+    if (query.orbitalZones != 0u)
+    {
+        UniteSelected((restricted) ? selected : candidates, orbitalZone, OrbitalZoneCount, query.orbitalZones, rowCount);
+        if (restricted)
+        {
+            candidates.intersect(selected);
+        }
+        restricted = true;
+    }
+
+    return restricted;
+}
+
+}
+}
@@ -0,0 +1,321 @@
+/*****************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Questionable Coding
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************/
+#include <qcSysGen/CostProfiler.h>
+
+#include <qcSysGen/Generator.h>
+#include <qcSysGen/System.h>
+
+#include <algorithm>
+#include <inttypes.h>
+#include <string.h>
+
+namespace
+{
+
+/// @brief First line of every corpus.
+static const char CorpusSignature[] = "# qcSysGen cost corpus v1";
+
+/// @brief Column names of a corpus.
+static const char CorpusColumns[] = "seed,systemIndex,starClass,subtype,starAge,generate2,configFingerprint,version,"
+    "seconds,dustSweeps,protoplanets,wastedProtoplanets,dustBands,peakDustBands,collisions,evaluationRounds,planets";
+
+/// @brief Relative accuracy of the quantile sketches.
+static constexpr double CostQuantileAccuracy = 0.01;
+
+//----------------------------------------------------------------------------
+// Create an empty quantile sketch for every CostMetric.
+std::vector<qc::SystemGenerator::QuantileSketch> MakeCostQuantiles()
+{
+    using namespace qc::SystemGenerator;
+
+    std::vector<QuantileSketch> sketches;
+    sketches.reserve(CostMetricCount);
+    for (uint32_t m = 0; m < CostMetricCount; ++m)
+    {
+        if (CostMetric(m) == CostMetric::WallTime)
+        {
+            sketches.emplace_back(1.0e-7, 100.0, CostQuantileAccuracy);
+        }
+        else
+        {
+            sketches.emplace_back(1.0, 1.0e7, CostQuantileAccuracy);
+        }
+    }
+
+    return sketches;
+}
+
+//----------------------------------------------------------------------------
+// Read one line into `line`, dropping the line ending.  Returns false at the end of the stream, or if
+// the line does not fit.
+bool ReadLine(FILE* fp, char* line, size_t size)
+{
+    if (!fgets(line, static_cast<int>(size), fp))
+    {
+        return false;
+    }
+
+    size_t length = strlen(line);
+    if (length + 1u == size && line[length - 1u] != '\n')
+    {
+        return false;
+    }
+    while (length > 0u && (line[length - 1u] == '\n' || line[length - 1u] == '\r'))
+    {
+        line[--length] = '\0';
+    }
+
+    return true;
+}
+
+}
+
+namespace qc
+{
+
+namespace SystemGenerator
+{
+
+//----------------------------------------------------------------------------
+const char* CostMetricName(CostMetric metric)
+{
+    static const char* Names[CostMetricCount] =
+    {
+        "WallTime",
+        "DustSweeps",
+        "WastedProtoplanets",
+        "PeakDustBands",
+        "Collisions",
+        "EvaluationRounds",
+    };
+
+    const uint32_t m = static_cast<uint32_t>(metric);
+    return (m < CostMetricCount) ? Names[m] : "Unknown";
+}
+
+//----------------------------------------------------------------------------
+double GetCostMetric(const SystemCost& cost, CostMetric metric)
+{
+    switch (metric)
+    {
+        case CostMetric::WallTime: return cost.seconds;
+        case CostMetric::DustSweeps: return static_cast<double>(cost.dustSweeps);
+        case CostMetric::WastedProtoplanets: return static_cast<double>(cost.wastedProtoplanets);
+        case CostMetric::PeakDustBands: return static_cast<double>(cost.peakDustBands);
+        case CostMetric::Collisions: return static_cast<double>(cost.collisions);
+        case CostMetric::EvaluationRounds: return static_cast<double>(cost.evaluationRounds);
+    }
+
+    return 0.0;
+}
+
+//----------------------------------------------------------------------------
+bool ReadCostCorpus(FILE* fp, std::vector<CostCorpusEntry>& corpus)
+{
+    corpus.clear();
+
+    char line[512];
+    if (!ReadLine(fp, line, sizeof(line)) || strcmp(line, CorpusSignature))
+    {
+        return false;
+    }
+
+    while (ReadLine(fp, line, sizeof(line)))
+    {
+        if (line[0] == '#' || line[0] == '\0' || !strcmp(line, CorpusColumns))
+        {
+            continue;
+        }
+
+        CostCorpusEntry e;
+        memset(&e.key, 0, sizeof(e.key));
+
+        unsigned starClass, generate2;
+        int subtype;
+        const int fields = sscanf_s(line, "%" SCNu64 ",%" SCNu64 ",%u,%d,%lf,%u,%" SCNx64 ",%" SCNx32 ",%lf,%" SCNu32 ",%" SCNu32 ",%" SCNu32 ",%" SCNu32 ",%" SCNu32 ",%" SCNu32 ",%" SCNu32 ",%" SCNu32,
+                                  &e.key.seed, &e.cost.systemIndex, &starClass, &subtype, &e.key.starAge, &generate2,
+                                  &e.key.configFingerprint, &e.key.version,
+                                  &e.cost.seconds, &e.cost.dustSweeps, &e.cost.protoplanets, &e.cost.wastedProtoplanets,
+                                  &e.cost.dustBands, &e.cost.peakDustBands, &e.cost.collisions, &e.cost.evaluationRounds, &e.cost.planetCount);
+        if (fields != 17)
+        {
+            return false;
+        }
+
+        e.key.starClass = static_cast<uint8_t>(starClass);
+        e.key.subtype = static_cast<int8_t>(subtype);
+        e.key.flags = (generate2 != 0u) ? GenerationCacheKey::UseGenerate2 : 0u;
+        e.cost.seed = e.key.seed;
+
+        corpus.emplace_back(e);
+    }
+
+    return true;
+}
+
+//----------------------------------------------------------------------------
+CostProfiler::CostProfiler(uint32_t k_, CostMetric metric_)
+    : k(k_)
+    , metric(metric_)
+{
+    memset(&key, 0, sizeof(key));
+
+    moments.resize(CostMetricCount);
+    quantiles = MakeCostQuantiles();
+}
+
+//----------------------------------------------------------------------------
+void CostProfiler::report(FILE* fp) const
+{
+    fprintf(fp, "=== Generation cost: %llu systems ===\n\n", static_cast<unsigned long long>(getSystemCount()));
+
+    fprintf(fp, "%-20s %12s %12s %12s %12s %12s\n", "Measure", "Mean", "p50", "p90", "p99", "Max");
+    for (uint32_t m = 0; m < CostMetricCount; ++m)
+    {
+        // Wall time is reported in microseconds.
+        const double scale = (CostMetric(m) == CostMetric::WallTime) ? 1.0e6 : 1.0;
+        fprintf(fp, "%-20s %12.1f %12.1f %12.1f %12.1f %12.1f\n", CostMetricName(CostMetric(m)),
+                moments[m].getMean() * scale, quantiles[m].getQuantile(0.5) * scale, quantiles[m].getQuantile(0.9) * scale,
+                quantiles[m].getQuantile(0.99) * scale, moments[m].getMax() * scale);
+    }
+
+    const double median = quantiles[static_cast<uint32_t>(CostMetric::WallTime)].getQuantile(0.5);
+
+    fprintf(fp, "\nMost expensive systems by %s:\n", CostMetricName(metric));
+    fprintf(fp, "%20s %10s %8s %6s %8s %6s %6s %6s %8s %7s\n", "Seed", "Time(us)", "xMedian",
+            "Sweeps", "Consumed", "Wasted", "Bands", "Colls", "EvalRnds", "Planets");
+    for (const auto& c : worst)
+    {
+        fprintf(fp, "%20llu %10.1f %8.1f %6u %8u %6u %6u %6u %8u %7u\n", static_cast<unsigned long long>(c.seed),
+                c.seconds * 1.0e6, (median > 0.0) ? c.seconds / median : 0.0,
+                c.dustSweeps, c.getConsumedProtoplanets(), c.wastedProtoplanets, c.peakDustBands, c.collisions,
+                c.evaluationRounds, c.planetCount);
+    }
+}
+
+//----------------------------------------------------------------------------
+void CostProfiler::run(const BatchGenerator& batch, const Config& config, const BatchSettings& settings)
+{
+    worst.clear();
+    key = GenerationCacheKey::Make(0u, config, settings.star, settings.useGenerate2);
+
+    const uint32_t workerCount = batch.getWorkerCount();
+
+    // Ranks the most expensive system first.  Ties are broken by seed, so the ranking is a total order.
+    const CostMetric rankMetric = metric;
+    auto isMoreExpensive = [rankMetric](const SystemCost& lhs, const SystemCost& rhs)
+    {
+        const double lhsCost = GetCostMetric(lhs, rankMetric);
+        const double rhsCost = GetCostMetric(rhs, rankMetric);
+        if (lhsCost != rhsCost)
+        {
+            return lhsCost > rhsCost;
+        }
+
+        return lhs.seed < rhs.seed;
+    };
+
+    // One heap, and one set of moments and sketches, per worker.  With isMoreExpensive as the
+    // comparison, the front of the heap is the cheapest system the worker is holding.
+    std::vector<std::vector<SystemCost>> heap(workerCount);
+    std::vector<std::vector<RunningMoments>> workerMoments(workerCount, std::vector<RunningMoments>(CostMetricCount));
+    std::vector<std::vector<QuantileSketch>> workerQuantiles(workerCount, MakeCostQuantiles());
+
+    auto collect = [&](uint32_t worker, uint64_t, uint64_t, const SolarSystem&, const Generator& generator)
+    {
+        const SystemCost& cost = *generator.getSystemCost();
+
+        for (uint32_t m = 0; m < CostMetricCount; ++m)
+        {
+            const double value = GetCostMetric(cost, CostMetric(m));
+            workerMoments[worker][m].add(value);
+            workerQuantiles[worker][m].add(value);
+        }
+
+        std::vector<SystemCost>& w = heap[worker];
+        if (w.size() < k)
+        {
+            w.emplace_back(cost);
+            std::push_heap(w.begin(), w.end(), isMoreExpensive);
+        }
+        else if (k > 0u && isMoreExpensive(cost, w.front()))
+        {
+            std::pop_heap(w.begin(), w.end(), isMoreExpensive);
+            w.back() = cost;
+            std::push_heap(w.begin(), w.end(), isMoreExpensive);
+        }
+    };
+
+    BatchSettings profiled = settings;
+    profiled.profileCosts = true;
+
+    batch.run(config, profiled, collect);
+
+    quantiles = MakeCostQuantiles();
+    for (uint32_t m = 0; m < CostMetricCount; ++m)
+    {
+        moments[m] = RunningMoments();
+        for (uint32_t i = 0; i < workerCount; ++i)
+        {
+            moments[m].merge(workerMoments[i][m]);
+            quantiles[m].merge(workerQuantiles[i][m]);
+        }
+    }
+
+    for (const auto& w : heap)
+    {
+        worst.insert(worst.end(), w.begin(), w.end());
+    }
+    if (worst.size() > k)
+    {
+        std::nth_element(worst.begin(), worst.begin() + (k - 1u), worst.end(), isMoreExpensive);
+        worst.resize(k);
+    }
+    std::sort(worst.begin(), worst.end(), isMoreExpensive);
+}
+
+//----------------------------------------------------------------------------
+bool CostProfiler::writeCorpus(FILE* fp) const
+{
+    fprintf(fp, "%s\n", CorpusSignature);
+    fprintf(fp, "# %llu systems profiled, ranked by %s\n", static_cast<unsigned long long>(getSystemCount()), CostMetricName(metric));
+    fprintf(fp, "%s\n", CorpusColumns);
+
+    for (const auto& c : worst)
+    {
+        fprintf(fp, "%llu,%llu,%u,%d,%.17g,%u,%016llx,%08x,%.9g,%u,%u,%u,%u,%u,%u,%u,%u\n",
+                static_cast<unsigned long long>(c.seed), static_cast<unsigned long long>(c.systemIndex),
+                static_cast<unsigned>(key.starClass), static_cast<int>(key.subtype), key.starAge,
+                (key.flags & GenerationCacheKey::UseGenerate2) ? 1u : 0u,
+                static_cast<unsigned long long>(key.configFingerprint), key.version,
+                c.seconds, c.dustSweeps, c.protoplanets, c.wastedProtoplanets, c.dustBands, c.peakDustBands,
+                c.collisions, c.evaluationRounds, c.planetCount);
+    }
+
+    return ferror(fp) == 0;
+}
+
+}
+}
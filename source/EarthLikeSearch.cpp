@@ -0,0 +1,216 @@
+/*****************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Questionable Coding
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************/
+#include <qcSysGen/EarthLikeSearch.h>
+
+#include <qcSysGen/Consts.h>
+#include <qcSysGen/Generator.h>
+#include <qcSysGen/System.h>
+
+#include <algorithm>
+#include <atomic>
+#include <math.h>
+
+namespace
+{
+
+/// @brief Percentage of Earth's surface covered with liquid water.
+static constexpr float EarthHydrosphere = 0.708f;
+
+//----------------------------------------------------------------------------
+// Raise `threshold` to `value` if `value` is larger.
+void RaiseThreshold(std::atomic<float>& threshold, float value)
+{
+    float current = threshold.load(std::memory_order_relaxed);
+    while (value > current && !threshold.compare_exchange_weak(current, value, std::memory_order_relaxed))
+    {
+    }
+}
+
+}
+
+namespace qc
+{
+
+namespace SystemGenerator
+{
+
+//----------------------------------------------------------------------------
+bool IsBetterCandidate(const EarthLikeCandidate& lhs, const EarthLikeCandidate& rhs)
+{
+    if (lhs.earthSimilarityIndex != rhs.earthSimilarityIndex)
+    {
+        return lhs.earthSimilarityIndex > rhs.earthSimilarityIndex;
+    }
+
+    const float lhsHydro = fabsf(lhs.hydrosphere - EarthHydrosphere);
+    const float rhsHydro = fabsf(rhs.hydrosphere - EarthHydrosphere);
+    if (lhsHydro != rhsHydro)
+    {
+        return lhsHydro < rhsHydro;
+    }
+
+    const float lhsPressure = fabsf(lhs.surfacePressure - EarthSurfacePressureMb);
+    const float rhsPressure = fabsf(rhs.surfacePressure - EarthSurfacePressureMb);
+    if (lhsPressure != rhsPressure)
+    {
+        return lhsPressure < rhsPressure;
+    }
+
+    if (lhs.seed != rhs.seed)
+    {
+        return lhs.seed < rhs.seed;
+    }
+
+    return lhs.planetOrdinal < rhs.planetOrdinal;
+}
+
+//----------------------------------------------------------------------------
+void EarthLikeSearch::run(const BatchGenerator& batch, const Config& config, const BatchSettings& settings)
+{
+    results.clear();
+    evaluatedCount = prunedCount = 0u;
+
+    if (k == 0u)
+    {
+        return;
+    }
+
+    const uint32_t workerCount = batch.getWorkerCount();
+
+    // One heap per worker.  With IsBetterCandidate as the comparison, the front of the heap is the
+    // worst candidate the worker is holding.
+    std::vector<std::vector<EarthLikeCandidate>> heap(workerCount);
+    std::vector<uint64_t> evaluated(workerCount, 0u);
+    std::vector<uint64_t> pruned(workerCount, 0u);
+
+    // The best known lower bound on the K-th best ESI across all workers.
+    std::atomic<float> threshold(0.0f);
+
+    auto filter = [&](uint32_t worker, uint64_t, uint64_t, const SolarSystem& system, const Generator& generator)
+    {
+        const float currentThreshold = threshold.load(std::memory_order_relaxed);
+        if (currentThreshold > 0.0f)
+        {
+            for (const auto& p : system.getPlanets())
+            {
+                // Ties are resolved by the other criteria, so only discard planets that are strictly worse.
+                if (p.getEarthSimilarityLimit(system.getStar(), generator.getDensityVariation()) >= currentThreshold)
+                {
+                    ++evaluated[worker];
+                    return true;
+                }
+            }
+
+            ++pruned[worker];
+            return false;
+        }
+
+        ++evaluated[worker];
+        return true;
+    };
+
+    auto collect = [&](uint32_t worker, uint64_t seed, uint64_t systemIndex, const SolarSystem& system, const Generator&)
+    {
+        std::vector<EarthLikeCandidate>& best = heap[worker];
+
+        uint32_t ordinal = 1u;
+        for (const auto& p : system.getPlanets())
+        {
+            if (p.getEarthSimilarityIndex() > 0.0f)
+            {
+                EarthLikeCandidate c;
+                c.seed = seed;
+                c.systemIndex = systemIndex;
+                c.planetOrdinal = ordinal;
+                c.earthSimilarityIndex = p.getEarthSimilarityIndex();
+                c.hydrosphere = p.getHydroPercentage();
+                c.surfacePressure = p.getSurfacePressure();
+
+                if (best.size() < k)
+                {
+                    best.emplace_back(c);
+                    std::push_heap(best.begin(), best.end(), IsBetterCandidate);
+                }
+                else if (IsBetterCandidate(c, best.front()))
+                {
+                    std::pop_heap(best.begin(), best.end(), IsBetterCandidate);
+                    best.back() = c;
+                    std::push_heap(best.begin(), best.end(), IsBetterCandidate);
+                }
+
+                if (best.size() == k)
+                {
+                    RaiseThreshold(threshold, best.front().earthSimilarityIndex);
+                }
+            }
+            ++ordinal;
+        }
+    };
+
+    batch.run(config, settings, filter, collect);
+
+    // Merge the heaps of each node's workers on that node, so only K candidates per node cross
+    // between nodes.
+    const uint32_t nodeCount = batch.getNodeCount();
+    std::vector<std::vector<EarthLikeCandidate>> nodeResults(nodeCount);
+
+    batch.runOnNodes([&](uint32_t node)
+    {
+        std::vector<EarthLikeCandidate>& merged = nodeResults[node];
+        for (uint32_t i = 0; i < workerCount; ++i)
+        {
+            if (batch.getWorkerNode(i) == node)
+            {
+                merged.insert(merged.end(), heap[i].begin(), heap[i].end());
+            }
+        }
+
+        if (merged.size() > k)
+        {
+            std::nth_element(merged.begin(), merged.begin() + (k - 1u), merged.end(), IsBetterCandidate);
+            merged.resize(k);
+        }
+    });
+
+    for (uint32_t n = 0; n < nodeCount; ++n)
+    {
+        results.insert(results.end(), nodeResults[n].begin(), nodeResults[n].end());
+    }
+
+    for (uint32_t i = 0; i < workerCount; ++i)
+    {
+        evaluatedCount += evaluated[i];
+        prunedCount += pruned[i];
+    }
+
+    std::sort(results.begin(), results.end(), IsBetterCandidate);
+    if (results.size() > k)
+    {
+        results.resize(k);
+    }
+}
+
+}
+}
@@ -24,6 +24,20 @@
 ****************************************************************************/
 #include <qcSysGen/Equations.h>
 
+namespace
+{
+
+// Where do the dust density values come from?
+// Per acrete.cc - "See Sagan's article for insight into changing them."
+// Per Dole 1969, they were picked because the tended to generate planetary systems similar to our Solar System.
+
+/// @brief The density of the dust cloud in solar masses per cubic AU (A in Dole 1969).
+///
+/// Dole 1969 used 0.0015, most of the later implementations use 0.002.
+static constexpr double DustCloudDensity = 0.0020;
+
+}
+
 namespace qc
 {
 
@@ -33,12 +47,19 @@ namespace SystemGenerator
 //----------------------------------------------------------------------------
 double CriticalLimit(double sma, double eccentricity, double stellarLuminosity)
 {
-    static constexpr double B = 1.2e-5;
+    return ScaledCriticalLimit(sma, eccentricity, CriticalLimitScalar(stellarLuminosity));
+}
 
-    const double perihelion = (sma - sma * eccentricity);
-    const double term = perihelion * sqrt(stellarLuminosity);
+//----------------------------------------------------------------------------
+double DustDensity(double sma, double stellarMass)
+{
+    return ScaledDustDensity(sma, DustDensityScalar(stellarMass));
+}
 
-    return B * pow(term, -0.75);
+//----------------------------------------------------------------------------
+double DustDensityScalar(double stellarMass)
+{
+    return DustCloudDensity * sqrt(stellarMass);
 }
 
 //----------------------------------------------------------------------------
@@ -113,6 +134,33 @@ double Period(double distance, double mass1, double mass2)
     return periodYears * DaysPerYear;
 }
 
+//----------------------------------------------------------------------------
+double ScaledCriticalLimit(double sma, double eccentricity, double criticalLimitScalar)
+{
+    static constexpr double B = 1.2e-5;
+
+    const double perihelion = (sma - sma * eccentricity);
+    const double term = perihelion * criticalLimitScalar;
+
+    return B * pow(term, -0.75);
+}
+
+//----------------------------------------------------------------------------
+double ScaledDustDensity(double sma, double dustDensityScalar)
+{
+    // Alpha moves where the highest density of the dust tends to be.  Per Issacman 1977,
+    // 5.0 is roughly 5.8AU (Jupiter) for a G2V.  Larger values will tend to make outer
+    // planets smaller.  The equation is extremely sensitive to these values,
+    // and degenerate conditions are common if they change too much.
+    static constexpr double Alpha = 5.0;
+
+    // N is the denominator of the exponent in Dole 1969's dust density equation.  Issacman 1977
+    // varied it to see how it affected the outcome.
+    static constexpr double N = 3.0;
+
+    return dustDensityScalar * exp(-Alpha * pow(sma, 1.0 / N));
+}
+
 //----------------------------------------------------------------------------
 double VolumeDensity(double mass, double radius)
 {
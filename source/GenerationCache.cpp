@@ -0,0 +1,771 @@
+/*****************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Questionable Coding
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************/
+#include <qcSysGen/GenerationCache.h>
+
+#include <qcSysGen/Consts.h>
+#include <qcSysGen/Fingerprint.h>
+#include <qcSysGen/Generator.h>
+#include <qcSysGen/Metrics.h>
+#include <qcSysGen/SeedStrategy.h>
+#include <qcSysGen/System.h>
+
+#include <algorithm>
+#include <atomic>
+#include <string.h>
+
+#if !defined(_WIN32)
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+
+using qc::SystemGenerator::GenerationCacheKey;
+
+/// @brief Identifies an initialized index ("QCGC").
+static constexpr uint32_t CacheIndexMagic = 0x43474351u;
+
+/// @brief Layout version of the index and data files.
+static constexpr uint32_t CacheFileVersion = 1u;
+
+/// @brief Identifies an entry in the data file ("QCGE").
+static constexpr uint32_t CacheEntryMagic = 0x45474351u;
+
+/// @brief When evicting, entries are removed until the cache is this far below its limits, so every
+/// insert doesn't have to evict.
+static constexpr double EvictionHeadroom = 0.9;
+
+/// @brief Slot states.
+enum : uint32_t
+{
+    SlotEmpty = 0u, //!< Never used.  Ends a probe sequence.
+    SlotUsed = 1u, //!< Holds an entry.
+    SlotDeleted = 2u, //!< Held an entry that was evicted.  Probe sequences continue past it.
+};
+
+/// @brief One slot of the index hash table.
+struct CacheSlot
+{
+    GenerationCacheKey key; //!< The key of the entry.
+    uint64_t offset; //!< Offset of the entry in the data file.
+    uint32_t size; //!< Size of the entry, including its header.
+    uint32_t state; //!< SlotEmpty, SlotUsed or SlotDeleted.
+    std::atomic<uint64_t> lastUse; //!< Value of the index clock when the entry was last used.
+    uint64_t reserved; //!< Padding.
+};
+
+/// @brief The header of each entry in the data file.  Followed by the SystemRecord, padded to 8 bytes.
+struct CacheEntryHeader
+{
+    uint32_t magic; //!< CacheEntryMagic.
+    uint32_t recordSize; //!< Size of the SystemRecord.
+    GenerationCacheKey key; //!< The key of the entry.
+};
+
+//----------------------------------------------------------------------------
+// Returns the hash of a key.
+uint64_t HashKey(const GenerationCacheKey& key)
+{
+    qc::SystemGenerator::Fingerprint fingerprint;
+    fingerprint.add(key);
+    return fingerprint.get();
+}
+
+//----------------------------------------------------------------------------
+// Returns the size of a data file entry holding a record of `recordSize` bytes.
+uint64_t EntrySize(uint64_t recordSize)
+{
+    return sizeof(CacheEntryHeader) + ((recordSize + 7u) & ~static_cast<uint64_t>(7u));
+}
+
+#if !defined(_WIN32)
+//----------------------------------------------------------------------------
+// Read exactly `size` bytes at `offset`.
+bool ReadAt(int fd, void* buffer, size_t size, uint64_t offset)
+{
+    uint8_t* p = static_cast<uint8_t*>(buffer);
+    while (size > 0u)
+    {
+        const ssize_t n = pread(fd, p, size, static_cast<off_t>(offset));
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            return false;
+        }
+        p += n;
+        size -= static_cast<size_t>(n);
+        offset += static_cast<uint64_t>(n);
+    }
+
+    return true;
+}
+
+//----------------------------------------------------------------------------
+// Write exactly `size` bytes at `offset`.
+bool WriteAt(int fd, const void* buffer, size_t size, uint64_t offset)
+{
+    const uint8_t* p = static_cast<const uint8_t*>(buffer);
+    while (size > 0u)
+    {
+        const ssize_t n = pwrite(fd, p, size, static_cast<off_t>(offset));
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            return false;
+        }
+        p += n;
+        size -= static_cast<size_t>(n);
+        offset += static_cast<uint64_t>(n);
+    }
+
+    return true;
+}
+#endif
+
+}
+
+namespace qc
+{
+
+namespace SystemGenerator
+{
+
+/// @brief The header of the memory-mapped index.  Followed by `slotCount` CacheSlots.
+struct GenerationCacheIndex
+{
+    uint32_t magic; //!< CacheIndexMagic once the index is initialized.
+    uint32_t version; //!< CacheFileVersion.
+    uint32_t slotCount; //!< Number of slots.
+    uint32_t reserved; //!< Padding.
+    uint64_t maxBytes; //!< Size limit of the live entries.
+    uint64_t liveBytes; //!< Size of the live entries.
+    uint64_t liveCount; //!< Number of live entries.
+    uint64_t occupiedSlots; //!< Number of slots that are not SlotEmpty.
+    uint64_t dataSize; //!< End of the last entry in the data file.
+    uint64_t dataGeneration; //!< Incremented each time the data file is replaced.
+    std::atomic<uint64_t> clock; //!< Advanced on every use, to order the entries for eviction.
+    uint64_t padding[7]; //!< Pads the header to 128 bytes.
+
+    /// @brief Access the slots that follow the header.
+    /// @return The first slot.
+    CacheSlot* getSlots() { return reinterpret_cast<CacheSlot*>(this + 1); }
+};
+
+//----------------------------------------------------------------------------
+uint64_t GetConfigFingerprint(const Config& config)
+{
+    Fingerprint fingerprint;
+
+    fingerprint.add(config.protoplanetSeedMass);
+    fingerprint.add(config.densityVariation);
+    fingerprint.add(config.inclinationMean);
+    fingerprint.add(config.inclinationStdDev);
+    fingerprint.add(config.protoplanetCount);
+    fingerprint.add(config.generateBodeSeeds);
+    fingerprint.add(config.generateMoons);
+    fingerprint.add(config.generateMoonsOnCollision);
+    fingerprint.add(config.generateStar);
+
+    const uint64_t seedCount = config.protoplanetSeeds.size();
+    fingerprint.add(seedCount);
+    for (const auto& seed : config.protoplanetSeeds)
+    {
+        fingerprint.add(seed.semiMajorAxis);
+        fingerprint.add(seed.eccentricity);
+    }
+
+    if (config.seedStrategy)
+    {
+        config.seedStrategy->addFingerprint(fingerprint);
+    }
+
+    return fingerprint.get();
+}
+
+//----------------------------------------------------------------------------
+GenerationCacheKey GenerationCacheKey::Make(uint64_t seed, const Config& config, const Star& star, bool useGenerate2)
+{
+    GenerationCacheKey key;
+    memset(&key, 0, sizeof(key));
+
+    key.seed = seed;
+    key.configFingerprint = GetConfigFingerprint(config);
+    key.version = SysGenVersion;
+    key.flags = useGenerate2 ? UseGenerate2 : 0u;
+    if (!config.generateStar)
+    {
+        const StarType_t type = star.getStarType();
+        key.starClass = static_cast<uint8_t>(type.first);
+        key.subtype = static_cast<int8_t>(type.second);
+        key.starAge = star.getAge();
+    }
+
+    return key;
+}
+
+//----------------------------------------------------------------------------
+void GenerationCache::close()
+{
+    std::lock_guard<std::mutex> guard(mutex);
+
+#if !defined(_WIN32)
+    if (index)
+    {
+        munmap(index, mappedSize);
+        index = nullptr;
+        mappedSize = 0u;
+    }
+    if (dataFile >= 0)
+    {
+        ::close(dataFile);
+        dataFile = -1;
+    }
+    if (indexFile >= 0)
+    {
+        ::close(indexFile);
+        indexFile = -1;
+    }
+#endif
+}
+
+//----------------------------------------------------------------------------
+bool GenerationCache::compact()
+{
+#if defined(_WIN32)
+    return false;
+#else
+    const std::string dataPath = directory + "/cache.dat";
+    const std::string tempPath = directory + "/cache.dat.tmp";
+
+    const int fd = ::open(tempPath.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    CacheSlot* slots = index->getSlots();
+
+    // Copy the live entries in file order.
+    std::vector<uint32_t> live;
+    for (uint32_t i = 0; i < index->slotCount; ++i)
+    {
+        if (slots[i].state == SlotUsed)
+        {
+            live.emplace_back(i);
+        }
+    }
+    std::sort(live.begin(), live.end(), [slots](uint32_t lhs, uint32_t rhs) { return slots[lhs].offset < slots[rhs].offset; });
+
+    std::vector<uint64_t> newOffset(live.size());
+    std::vector<uint8_t> buffer;
+    uint64_t size = 0u;
+    for (size_t i = 0; i < live.size(); ++i)
+    {
+        const CacheSlot& s = slots[live[i]];
+        buffer.resize(s.size);
+        if (!ReadAt(dataFile, buffer.data(), s.size, s.offset) || !WriteAt(fd, buffer.data(), s.size, size))
+        {
+            ::close(fd);
+            unlink(tempPath.c_str());
+            return false;
+        }
+        newOffset[i] = size;
+        size += s.size;
+    }
+
+    if (fsync(fd) != 0 || rename(tempPath.c_str(), dataPath.c_str()) != 0)
+    {
+        ::close(fd);
+        unlink(tempPath.c_str());
+        return false;
+    }
+
+    ::close(dataFile);
+    dataFile = fd;
+
+    // Rebuild the table without the deleted slots.
+    struct LiveEntry
+    {
+        GenerationCacheKey key;
+        uint64_t offset;
+        uint32_t size;
+        uint64_t lastUse;
+    };
+    std::vector<LiveEntry> entries(live.size());
+    for (size_t i = 0; i < live.size(); ++i)
+    {
+        const CacheSlot& s = slots[live[i]];
+        entries[i].key = s.key;
+        entries[i].offset = newOffset[i];
+        entries[i].size = s.size;
+        entries[i].lastUse = s.lastUse.load(std::memory_order_relaxed);
+    }
+
+    for (uint32_t i = 0; i < index->slotCount; ++i)
+    {
+        slots[i].state = SlotEmpty;
+    }
+
+    for (const auto& e : entries)
+    {
+        bool found = false;
+        CacheSlot& s = slots[findSlot(HashKey(e.key), e.key, found)];
+        s.key = e.key;
+        s.offset = e.offset;
+        s.size = e.size;
+        s.lastUse.store(e.lastUse, std::memory_order_relaxed);
+        s.state = SlotUsed;
+    }
+
+    index->occupiedSlots = entries.size();
+    index->dataSize = size;
+    dataGeneration = ++index->dataGeneration;
+
+    return true;
+#endif
+}
+
+//----------------------------------------------------------------------------
+void GenerationCache::evict(uint64_t bytes)
+{
+    const uint64_t maxCount = static_cast<uint64_t>(index->slotCount * MaxLoadFactor);
+
+    if (index->liveBytes + bytes > index->maxBytes || index->liveCount + 1u > maxCount)
+    {
+        const uint64_t targetBytes = static_cast<uint64_t>(index->maxBytes * EvictionHeadroom);
+        const uint64_t targetCount = static_cast<uint64_t>(maxCount * EvictionHeadroom);
+
+        CacheSlot* slots = index->getSlots();
+        std::vector<std::pair<uint64_t, uint32_t>> byAge;
+        for (uint32_t i = 0; i < index->slotCount; ++i)
+        {
+            if (slots[i].state == SlotUsed)
+            {
+                byAge.emplace_back(slots[i].lastUse.load(std::memory_order_relaxed), i);
+            }
+        }
+        std::sort(byAge.begin(), byAge.end());
+
+        for (const auto& a : byAge)
+        {
+            if (index->liveBytes + bytes <= targetBytes && index->liveCount + 1u <= targetCount)
+            {
+                break;
+            }
+
+            CacheSlot& s = slots[a.second];
+            s.state = SlotDeleted;
+            index->liveBytes -= s.size;
+            --index->liveCount;
+        }
+    }
+
+    // Deleted slots lengthen the probe sequences, and evicted entries waste space in the data file.
+    if (index->occupiedSlots + 1u > maxCount || index->dataSize - index->liveBytes > index->maxBytes)
+    {
+        compact();
+    }
+}
+
+//----------------------------------------------------------------------------
+bool GenerationCache::find(const GenerationCacheKey& key, std::vector<uint8_t>& record)
+{
+    std::lock_guard<std::mutex> guard(mutex);
+
+    if (!index || !lock(false))
+    {
+        return false;
+    }
+
+    bool hit = false;
+#if !defined(_WIN32)
+    bool found = false;
+    if (syncDataFile())
+    {
+        const uint32_t slot = findSlot(HashKey(key), key, found);
+        if (found)
+        {
+            CacheSlot& s = index->getSlots()[slot];
+            CacheEntryHeader header;
+            if (ReadAt(dataFile, &header, sizeof(header), s.offset) && header.magic == CacheEntryMagic &&
+                !memcmp(&header.key, &key, sizeof(key)) && EntrySize(header.recordSize) == s.size)
+            {
+                record.resize(header.recordSize);
+                hit = ReadAt(dataFile, record.data(), header.recordSize, s.offset + sizeof(header));
+            }
+
+            if (hit)
+            {
+                s.lastUse.store(index->clock.fetch_add(1u, std::memory_order_relaxed), std::memory_order_relaxed);
+            }
+        }
+    }
+#endif
+    if (metrics)
+    {
+        metrics->cacheBytes.set(static_cast<double>(index->liveBytes));
+        metrics->cacheEntries.set(static_cast<double>(index->liveCount));
+    }
+    unlock();
+
+    if (hit)
+    {
+        ++hitCount;
+    }
+    else
+    {
+        ++missCount;
+    }
+    if (metrics)
+    {
+        (hit ? metrics->cacheHits : metrics->cacheMisses).add();
+    }
+
+    return hit;
+}
+
+//----------------------------------------------------------------------------
+uint32_t GenerationCache::findSlot(uint64_t hash, const GenerationCacheKey& key, bool& found)
+{
+    CacheSlot* slots = index->getSlots();
+    const uint32_t slotCount = index->slotCount;
+
+    uint32_t firstDeleted = slotCount;
+    uint32_t i = static_cast<uint32_t>(hash % slotCount);
+    for (uint32_t probe = 0; probe < slotCount; ++probe)
+    {
+        const CacheSlot& s = slots[i];
+        if (s.state == SlotEmpty)
+        {
+            found = false;
+            return (firstDeleted < slotCount) ? firstDeleted : i;
+        }
+        else if (s.state == SlotUsed && !memcmp(&s.key, &key, sizeof(key)))
+        {
+            found = true;
+            return i;
+        }
+        else if (s.state == SlotDeleted && firstDeleted == slotCount)
+        {
+            firstDeleted = i;
+        }
+
+        i = (i + 1u == slotCount) ? 0u : i + 1u;
+    }
+
+    // Only a failed compact() leaves the table without an empty slot.  Without a deleted one either, every
+    // slot is live and there is nowhere to insert.
+    found = false;
+    return firstDeleted;
+}
+
+//----------------------------------------------------------------------------
+bool GenerationCache::getOrGenerate(uint64_t seed, const Config& config, const Star& star, bool useGenerate2, Generator& generator, SolarSystem& system, std::vector<uint8_t>& record)
+{
+    const GenerationCacheKey key = GenerationCacheKey::Make(seed, config, star, useGenerate2);
+    if (find(key, record))
+    {
+        return true;
+    }
+
+    system.add(star);
+    generator.seed(seed);
+    if (useGenerate2)
+    {
+        generator.generate2(system, config);
+    }
+    else
+    {
+        generator.generate(system, config);
+    }
+
+    insert(key, system);
+
+    record.resize(SystemRecord::GetSize(system));
+    SystemRecord::Write(record.data(), record.size(), seed, 0u, system);
+
+    return false;
+}
+
+//----------------------------------------------------------------------------
+bool GenerationCache::insert(const GenerationCacheKey& key, const SolarSystem& system)
+{
+    std::lock_guard<std::mutex> guard(mutex);
+
+    if (!index)
+    {
+        return false;
+    }
+
+    const size_t recordSize = SystemRecord::GetSize(system);
+    const uint64_t entrySize = EntrySize(recordSize);
+    if (entrySize > index->maxBytes)
+    {
+        return false;
+    }
+
+    // The entry header, then the record, in one 8-byte aligned buffer.
+    recordScratch.assign(static_cast<size_t>(entrySize / sizeof(uint64_t)), 0u);
+    CacheEntryHeader* header = reinterpret_cast<CacheEntryHeader*>(recordScratch.data());
+    header->magic = CacheEntryMagic;
+    header->recordSize = static_cast<uint32_t>(recordSize);
+    header->key = key;
+    SystemRecord::Write(header + 1, recordSize, key.seed, 0u, system);
+
+    if (!lock(true))
+    {
+        return false;
+    }
+
+    bool stored = false;
+#if !defined(_WIN32)
+    bool found = false;
+    if (syncDataFile())
+    {
+        const uint64_t hash = HashKey(key);
+        findSlot(hash, key, found);
+        if (found)
+        {
+            stored = true;
+        }
+        else
+        {
+            evict(entrySize);
+
+            const uint32_t slot = findSlot(hash, key, found);
+            if (slot < index->slotCount && WriteAt(dataFile, recordScratch.data(), static_cast<size_t>(entrySize), index->dataSize))
+            {
+                CacheSlot& s = index->getSlots()[slot];
+                if (s.state == SlotEmpty)
+                {
+                    ++index->occupiedSlots;
+                }
+
+                s.key = key;
+                s.offset = index->dataSize;
+                s.size = static_cast<uint32_t>(entrySize);
+                s.lastUse.store(index->clock.fetch_add(1u, std::memory_order_relaxed), std::memory_order_relaxed);
+                s.state = SlotUsed;
+
+                index->dataSize += entrySize;
+                index->liveBytes += entrySize;
+                ++index->liveCount;
+                stored = true;
+            }
+        }
+    }
+#endif
+    if (metrics)
+    {
+        metrics->cacheBytes.set(static_cast<double>(index->liveBytes));
+        metrics->cacheEntries.set(static_cast<double>(index->liveCount));
+    }
+    unlock();
+
+    return stored;
+}
+
+//----------------------------------------------------------------------------
+bool GenerationCache::lock(bool exclusive)
+{
+#if defined(_WIN32)
+    (void)exclusive;
+    return false;
+#else
+    struct flock fl;
+    memset(&fl, 0, sizeof(fl));
+    fl.l_type = exclusive ? F_WRLCK : F_RDLCK;
+    fl.l_whence = SEEK_SET;
+
+    while (fcntl(indexFile, F_SETLKW, &fl) != 0)
+    {
+        if (errno != EINTR)
+        {
+            return false;
+        }
+    }
+
+    return true;
+#endif
+}
+
+//----------------------------------------------------------------------------
+bool GenerationCache::open(const char* directory_, uint64_t maxBytes, uint32_t slotCount)
+{
+    close();
+
+#if defined(_WIN32)
+    (void)directory_;
+    (void)maxBytes;
+    (void)slotCount;
+    return false;
+#else
+    std::lock_guard<std::mutex> guard(mutex);
+
+    if (slotCount == 0u || maxBytes == 0u)
+    {
+        return false;
+    }
+
+    if (mkdir(directory_, 0777) != 0 && errno != EEXIST)
+    {
+        return false;
+    }
+
+    directory = directory_;
+    const std::string indexPath = directory + "/cache.idx";
+    const std::string dataPath = directory + "/cache.dat";
+
+    indexFile = ::open(indexPath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+    if (indexFile < 0 || !lock(true))
+    {
+        if (indexFile >= 0)
+        {
+            ::close(indexFile);
+            indexFile = -1;
+        }
+        return false;
+    }
+
+    // The first process to lock the index initializes it, along with an empty data file.
+    GenerationCacheIndex existing = {};
+    const bool initialized = ReadAt(indexFile, &existing, sizeof(existing), 0u) && existing.magic == CacheIndexMagic &&
+        existing.version == CacheFileVersion && existing.slotCount > 0u;
+
+    if (initialized)
+    {
+        slotCount = existing.slotCount;
+    }
+
+    const size_t size = sizeof(GenerationCacheIndex) + static_cast<size_t>(slotCount) * sizeof(CacheSlot);
+    bool success = initialized || ftruncate(indexFile, 0) == 0;
+    success = success && ftruncate(indexFile, static_cast<off_t>(size)) == 0;
+
+    void* p = success ? mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, indexFile, 0) : MAP_FAILED;
+    if (p != MAP_FAILED)
+    {
+        index = static_cast<GenerationCacheIndex*>(p);
+        mappedSize = size;
+
+        if (!initialized)
+        {
+            // The truncated file is zero-filled, so every slot is SlotEmpty.
+            const int fd = ::open(dataPath.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+            if (fd >= 0)
+            {
+                ::close(fd);
+                index->version = CacheFileVersion;
+                index->slotCount = slotCount;
+                index->maxBytes = maxBytes;
+                index->clock.store(1u, std::memory_order_relaxed);
+                index->magic = CacheIndexMagic;
+            }
+        }
+
+        success = index->magic == CacheIndexMagic;
+        if (success)
+        {
+            dataGeneration = index->dataGeneration;
+            dataFile = ::open(dataPath.c_str(), O_RDWR | O_CLOEXEC);
+            success = dataFile >= 0;
+        }
+    }
+    else
+    {
+        success = false;
+    }
+
+    unlock();
+
+    if (!success)
+    {
+        if (index)
+        {
+            munmap(index, mappedSize);
+            index = nullptr;
+            mappedSize = 0u;
+        }
+        ::close(indexFile);
+        indexFile = -1;
+    }
+
+    return success;
+#endif
+}
+
+//----------------------------------------------------------------------------
+bool GenerationCache::syncDataFile()
+{
+#if defined(_WIN32)
+    return false;
+#else
+    if (dataGeneration == index->dataGeneration && dataFile >= 0)
+    {
+        return true;
+    }
+
+    const std::string dataPath = directory + "/cache.dat";
+    const int fd = ::open(dataPath.c_str(), O_RDWR | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    if (dataFile >= 0)
+    {
+        ::close(dataFile);
+    }
+    dataFile = fd;
+    dataGeneration = index->dataGeneration;
+
+    return true;
+#endif
+}
+
+//----------------------------------------------------------------------------
+void GenerationCache::unlock()
+{
+#if !defined(_WIN32)
+    struct flock fl;
+    memset(&fl, 0, sizeof(fl));
+    fl.l_type = F_UNLCK;
+    fl.l_whence = SEEK_SET;
+    fcntl(indexFile, F_SETLK, &fl);
+#endif
+}
+
+}
+}
@@ -0,0 +1,755 @@
+/*****************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Questionable Coding
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************/
+#include <qcSysGen/GenerationService.h>
+
+#include <qcSysGen/GenerationCache.h>
+#include <qcSysGen/Generator.h>
+#include <qcSysGen/Metrics.h>
+#include <qcSysGen/System.h>
+#include <qcSysGen/SystemRecord.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string.h>
+
+#if !defined(_WIN32)
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+
+#if !defined(_WIN32)
+//----------------------------------------------------------------------------
+// Read exactly `size` bytes from a socket.  Returns false if the connection closed or failed first.
+bool ReceiveAll(int fd, void* data, size_t size)
+{
+    uint8_t* p = static_cast<uint8_t*>(data);
+    while (size > 0u)
+    {
+        const ssize_t received = recv(fd, p, size, 0);
+        if (received < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (received <= 0)
+        {
+            return false;
+        }
+        p += received;
+        size -= static_cast<size_t>(received);
+    }
+
+    return true;
+}
+
+//----------------------------------------------------------------------------
+// Write exactly `size` bytes to a socket.
+bool SendAll(int fd, const void* data, size_t size)
+{
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    while (size > 0u)
+    {
+        const ssize_t sent = send(fd, p, size, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (sent <= 0)
+        {
+            return false;
+        }
+        p += sent;
+        size -= static_cast<size_t>(sent);
+    }
+
+    return true;
+}
+
+//----------------------------------------------------------------------------
+// Fill in a Unix domain socket address.  Returns false if the path is too long.
+bool MakeAddress(const char* path, sockaddr_un& address)
+{
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(address.sun_path))
+    {
+        return false;
+    }
+    strcpy(address.sun_path, path);
+
+    return true;
+}
+#endif
+
+//----------------------------------------------------------------------------
+// Clear the fields of a request that do not affect the system it describes, so identical requests
+// compare equal.
+void NormalizeRequest(qc::SystemGenerator::GenerationRequest& request)
+{
+    using qc::SystemGenerator::GenerationRequest;
+
+    request.requestId = 0u;
+    request.priority = 0u;
+    memset(request.reserved, 0, sizeof(request.reserved));
+    if (request.flags & GenerationRequest::GenerateStar)
+    {
+        request.starClass = 0u;
+        request.subtype = 0;
+        request.starAge = 0.0;
+    }
+    if (!(request.overrideMask & GenerationRequest::OverrideProtoplanetSeedMass)) { request.protoplanetSeedMass = 0.0; }
+    if (!(request.overrideMask & GenerationRequest::OverrideDensityVariation)) { request.densityVariation = 0.0f; }
+    if (!(request.overrideMask & GenerationRequest::OverrideInclinationMean)) { request.inclinationMean = 0.0f; }
+    if (!(request.overrideMask & GenerationRequest::OverrideInclinationStdDev)) { request.inclinationStdDev = 0.0f; }
+    if (!(request.overrideMask & GenerationRequest::OverrideProtoplanetCount)) { request.protoplanetCount = 0u; }
+}
+
+}
+
+namespace qc
+{
+
+namespace SystemGenerator
+{
+
+/// @brief A client connection of a GenerationServer.  The socket is closed with the last reference, once
+/// neither the reader nor a job waiting to answer it holds the connection.
+struct GenerationServer::Connection
+{
+    ~Connection()
+    {
+#if !defined(_WIN32)
+        if (socket >= 0)
+        {
+            ::close(socket);
+        }
+#endif
+    }
+
+    int socket = -1; //!< The connection.
+    std::mutex writeMutex; //!< Serializes the responses written by the workers.
+    std::thread reader; //!< Reads the requests.  Joined by stop(), or detached when the client disconnects.
+};
+
+/// @brief One distinct request, and everyone waiting for it.
+struct GenerationServer::Job
+{
+    GenerationRequest request; //!< The normalized request.
+    RequestPriority priority; //!< The class of the job: the highest of its requests while it was queued.
+    bool queued; //!< Still waiting for a worker.
+
+    /// @brief A requester waiting for the job.
+    struct Waiter
+    {
+        std::shared_ptr<Connection> connection; //!< The requester's connection.
+        uint64_t requestId; //!< The requester's ID.
+    };
+    std::vector<Waiter> waiters; //!< Everyone to answer, the first requester first.
+};
+
+/// @brief The state of a worker, and the interactive work it runs at the safe points of its bulk systems.
+struct GenerationServer::Worker : public Preemptor
+{
+    explicit Worker(GenerationServer& server_)
+        : Preemptor(server_.interactivePending)
+        , server(server_)
+    { }
+
+    void preempt() override;
+
+    GenerationServer& server; //!< The server.
+    Generator generator; //!< Generates the worker's jobs.  Preempted at its safe points.
+    SolarSystem system; //!< The system of `generator`.
+    std::vector<uint8_t> record; //!< The record of `system`.
+    Generator interactiveGenerator; //!< Generates the interactive jobs run by preempt().
+    SolarSystem interactiveSystem; //!< The system of `interactiveGenerator`.
+    std::vector<uint8_t> interactiveRecord; //!< The record of `interactiveSystem`.
+};
+
+//----------------------------------------------------------------------------
+void GenerationServer::Worker::preempt()
+{
+    const uint32_t interactive = static_cast<uint32_t>(RequestPriority::Interactive);
+    bool first = true;
+
+    for (;;)
+    {
+        std::shared_ptr<Job> job;
+        {
+            std::lock_guard<std::mutex> guard(server.queueMutex);
+            if (server.stopping || server.queue[interactive].empty() || server.running[interactive] >= server.concurrencyLimit[interactive])
+            {
+                break;
+            }
+
+            job = server.queue[interactive].front();
+            server.queue[interactive].pop_front();
+            job->queued = false;
+            ++server.running[interactive];
+            server.updatePending();
+        }
+        if (server.metrics)
+        {
+            server.metrics->queueDepth.add(-1.0);
+        }
+        if (first)
+        {
+            server.preemptionCount.fetch_add(1u, std::memory_order_relaxed);
+            first = false;
+        }
+
+        server.run(*job, interactiveGenerator, interactiveSystem, interactiveRecord);
+
+        {
+            std::lock_guard<std::mutex> guard(server.queueMutex);
+            --server.running[interactive];
+            server.updatePending();
+        }
+        server.queueReady.notify_all();
+    }
+}
+
+//----------------------------------------------------------------------------
+GenerationRequest GenerationRequest::Make(uint64_t requestId_, uint64_t seed_, const Star& star, EvaluationLevel level_, RequestPriority priority_)
+{
+    GenerationRequest request;
+    memset(&request, 0, sizeof(request));
+
+    const StarType_t type = star.getStarType();
+
+    request.magic = Magic;
+    request.version = ProtocolVersion;
+    request.level = static_cast<uint8_t>(level_);
+    request.starClass = static_cast<uint8_t>(type.first);
+    request.requestId = requestId_;
+    request.seed = seed_;
+    request.starAge = star.getAge();
+    request.subtype = static_cast<int8_t>(type.second);
+    request.priority = static_cast<uint8_t>(priority_);
+
+    return request;
+}
+
+//----------------------------------------------------------------------------
+void GenerationClient::close()
+{
+#if !defined(_WIN32)
+    if (socket >= 0)
+    {
+        ::close(socket);
+        socket = -1;
+    }
+#endif
+}
+
+//----------------------------------------------------------------------------
+bool GenerationClient::connect(const char* path)
+{
+    close();
+
+#if defined(_WIN32)
+    (void)path;
+    return false;
+#else
+    sockaddr_un address;
+    if (!MakeAddress(path, address))
+    {
+        return false;
+    }
+
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    if (::connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    socket = fd;
+    return true;
+#endif
+}
+
+//----------------------------------------------------------------------------
+bool GenerationClient::generate(const GenerationRequest& request, GenerationResponse& response, std::vector<uint8_t>& record)
+{
+    return send(request) && receive(response, record);
+}
+
+//----------------------------------------------------------------------------
+bool GenerationClient::receive(GenerationResponse& response, std::vector<uint8_t>& record)
+{
+#if defined(_WIN32)
+    (void)response;
+    (void)record;
+    return false;
+#else
+    if (socket < 0 || !ReceiveAll(socket, &response, sizeof(response)) || response.magic != GenerationResponse::Magic)
+    {
+        close();
+        return false;
+    }
+
+    record.resize(response.recordSize);
+    if (response.recordSize > 0u && !ReceiveAll(socket, record.data(), record.size()))
+    {
+        close();
+        return false;
+    }
+
+    return true;
+#endif
+}
+
+//----------------------------------------------------------------------------
+bool GenerationClient::send(const GenerationRequest& request)
+{
+#if defined(_WIN32)
+    (void)request;
+    return false;
+#else
+    if (socket < 0 || !SendAll(socket, &request, sizeof(request)))
+    {
+        close();
+        return false;
+    }
+
+    return true;
+#endif
+}
+
+//----------------------------------------------------------------------------
+GenerationServer::GenerationServer(uint32_t workerCount_)
+    : workerCount(workerCount_)
+{
+    if (workerCount == 0u)
+    {
+        workerCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+}
+
+//----------------------------------------------------------------------------
+void GenerationServer::acceptConnections()
+{
+#if !defined(_WIN32)
+    for (;;)
+    {
+        const int fd = accept4(listenSocket, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+            {
+                continue;
+            }
+            // stop() shut the socket down.
+            break;
+        }
+
+        std::shared_ptr<Connection> connection = std::make_shared<Connection>();
+        connection->socket = fd;
+
+        std::lock_guard<std::mutex> guard(connectionMutex);
+        connections.emplace_back(connection);
+        connection->reader = std::thread(&GenerationServer::readRequests, this, connection);
+    }
+#endif
+}
+
+//----------------------------------------------------------------------------
+void GenerationServer::readRequests(std::shared_ptr<Connection> connection)
+{
+#if !defined(_WIN32)
+    GenerationRequest request;
+    while (ReceiveAll(connection->socket, &request, sizeof(request)))
+    {
+        requestCount.fetch_add(1u, std::memory_order_relaxed);
+
+        if (request.magic != GenerationRequest::Magic || request.version != GenerationRequest::ProtocolVersion ||
+            request.level > static_cast<uint8_t>(EvaluationLevel::Evaluated) || request.starClass > static_cast<uint8_t>(StarClassification::M_V) ||
+            request.priority >= RequestPriorityCount)
+        {
+            GenerationResponse response;
+            memset(&response, 0, sizeof(response));
+            response.magic = GenerationResponse::Magic;
+            response.status = GenerationResponse::BadRequest;
+            response.requestId = request.requestId;
+
+            std::lock_guard<std::mutex> guard(connection->writeMutex);
+            SendAll(connection->socket, &response, sizeof(response));
+
+            // The stream can not be trusted after a malformed request.
+            if (request.magic != GenerationRequest::Magic)
+            {
+                break;
+            }
+            continue;
+        }
+
+        submit(connection, request);
+    }
+
+    // Wake the workers' sends, and stop() if it is waiting.
+    shutdown(connection->socket, SHUT_RDWR);
+
+    // Unless stop() has taken the connection to join the reader, forget it now, so a long-running server
+    // does not keep a thread and a socket per client that ever connected.
+    std::lock_guard<std::mutex> guard(connectionMutex);
+    auto c = std::find(connections.begin(), connections.end(), connection);
+    if (c != connections.end())
+    {
+        connections.erase(c);
+        connection->reader.detach();
+    }
+#else
+    (void)connection;
+#endif
+}
+
+//----------------------------------------------------------------------------
+bool GenerationServer::start(const char* path)
+{
+    stop();
+
+#if defined(_WIN32)
+    (void)path;
+    return false;
+#else
+    sockaddr_un address;
+    if (!MakeAddress(path, address))
+    {
+        return false;
+    }
+
+    const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    unlink(path);
+    if (bind(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || listen(fd, 64) != 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    listenSocket = fd;
+    socketPath = path;
+    stopping = false;
+
+    workers.reserve(workerCount);
+    for (uint32_t i = 0; i < workerCount; ++i)
+    {
+        workers.emplace_back(&GenerationServer::work, this);
+    }
+    acceptor = std::thread(&GenerationServer::acceptConnections, this);
+
+    return true;
+#endif
+}
+
+//----------------------------------------------------------------------------
+void GenerationServer::stop()
+{
+#if !defined(_WIN32)
+    if (listenSocket < 0)
+    {
+        return;
+    }
+
+    // Stop accepting, then stop the workers, then close the connections once nothing writes to them.
+    shutdown(listenSocket, SHUT_RDWR);
+    acceptor.join();
+    ::close(listenSocket);
+    unlink(socketPath.c_str());
+    listenSocket = -1;
+    socketPath.clear();
+
+    {
+        std::lock_guard<std::mutex> guard(queueMutex);
+        stopping = true;
+        for (auto& q : queue)
+        {
+            if (metrics)
+            {
+                metrics->queueDepth.add(-static_cast<double>(q.size()));
+            }
+            q.clear();
+        }
+        inFlight.clear();
+        interactivePending = 0u;
+    }
+    queueReady.notify_all();
+    for (auto& w : workers)
+    {
+        w.join();
+    }
+    workers.clear();
+
+    std::vector<std::shared_ptr<Connection>> closing;
+    {
+        std::lock_guard<std::mutex> guard(connectionMutex);
+        closing.swap(connections);
+    }
+    for (auto& c : closing)
+    {
+        shutdown(c->socket, SHUT_RDWR);
+        c->reader.join();
+    }
+#endif
+}
+
+//----------------------------------------------------------------------------
+void GenerationServer::submit(const std::shared_ptr<Connection>& connection, const GenerationRequest& request)
+{
+    GenerationRequest normalized = request;
+    NormalizeRequest(normalized);
+    const std::string key(reinterpret_cast<const char*>(&normalized), sizeof(normalized));
+
+    Job::Waiter waiter = { connection, request.requestId };
+    const RequestPriority priority = static_cast<RequestPriority>(request.priority);
+
+    {
+        std::lock_guard<std::mutex> guard(queueMutex);
+        if (stopping)
+        {
+            return;
+        }
+
+        auto existing = inFlight.find(key);
+        if (existing != inFlight.end())
+        {
+            Job& job = *existing->second;
+            job.waiters.emplace_back(waiter);
+            sharedCount.fetch_add(1u, std::memory_order_relaxed);
+
+            // Someone is waiting for a queued bulk job now: move it to the interactive queue.
+            if (job.queued && priority < job.priority)
+            {
+                auto& from = queue[static_cast<uint32_t>(job.priority)];
+                from.erase(std::find(from.begin(), from.end(), existing->second));
+                queue[static_cast<uint32_t>(priority)].emplace_back(existing->second);
+                job.priority = priority;
+                updatePending();
+            }
+            return;
+        }
+
+        std::shared_ptr<Job> job = std::make_shared<Job>();
+        job->request = normalized;
+        job->priority = priority;
+        job->queued = true;
+        job->waiters.emplace_back(waiter);
+        inFlight.emplace(key, job);
+        queue[static_cast<uint32_t>(priority)].emplace_back(job);
+        updatePending();
+    }
+    if (metrics)
+    {
+        metrics->queueDepth.add(1.0);
+    }
+    queueReady.notify_one();
+}
+
+//----------------------------------------------------------------------------
+void GenerationServer::updatePending()
+{
+    const uint32_t interactive = static_cast<uint32_t>(RequestPriority::Interactive);
+    interactivePending.store((!queue[interactive].empty() && running[interactive] < concurrencyLimit[interactive]) ? 1u : 0u, std::memory_order_relaxed);
+}
+
+//----------------------------------------------------------------------------
+void GenerationServer::run(Job& job, Generator& generator, SolarSystem& system, std::vector<uint8_t>& record)
+{
+    const GenerationRequest& request = job.request;
+
+    Config config = baseConfig;
+    config.generateStar = (request.flags & GenerationRequest::GenerateStar) != 0u;
+    config.generateBodeSeeds = (request.flags & GenerationRequest::GenerateBodeSeeds) != 0u;
+    if (request.overrideMask & GenerationRequest::OverrideProtoplanetSeedMass) { config.protoplanetSeedMass = request.protoplanetSeedMass; }
+    if (request.overrideMask & GenerationRequest::OverrideDensityVariation) { config.densityVariation = request.densityVariation; }
+    if (request.overrideMask & GenerationRequest::OverrideInclinationMean) { config.inclinationMean = request.inclinationMean; }
+    if (request.overrideMask & GenerationRequest::OverrideInclinationStdDev) { config.inclinationStdDev = request.inclinationStdDev; }
+    if (request.overrideMask & GenerationRequest::OverrideProtoplanetCount) { config.protoplanetCount = request.protoplanetCount; }
+
+    Star star(static_cast<StarClassification>(request.starClass), request.subtype);
+    star.setAge(request.starAge);
+
+    const bool useGenerate2 = (request.flags & GenerationRequest::UseGenerate2) != 0u;
+    const bool evaluated = request.level == static_cast<uint8_t>(EvaluationLevel::Evaluated);
+
+    GenerationResponse response;
+    memset(&response, 0, sizeof(response));
+    response.magic = GenerationResponse::Magic;
+    response.status = GenerationResponse::Ok;
+
+    const auto start = std::chrono::steady_clock::now();
+    bool generated = true;
+    if (evaluated && cache)
+    {
+        if (cache->getOrGenerate(request.seed, config, star, useGenerate2, generator, system, record))
+        {
+            response.flags |= GenerationResponse::FromCache;
+            generated = false;
+        }
+    }
+    else
+    {
+        system.add(star);
+        generator.seed(request.seed);
+        if (useGenerate2)
+        {
+            generator.accrete2(system, config);
+        }
+        else
+        {
+            generator.accrete(system, config);
+        }
+
+        const auto accreted = std::chrono::steady_clock::now();
+        if (metrics)
+        {
+            metrics->accretionSeconds.observe(std::chrono::duration<double>(accreted - start).count());
+        }
+        if (evaluated)
+        {
+            system.evaluate(generator);
+            if (metrics)
+            {
+                metrics->evaluationSeconds.observe(std::chrono::duration<double>(std::chrono::steady_clock::now() - accreted).count());
+            }
+        }
+
+        record.resize(SystemRecord::GetSize(system));
+        if (SystemRecord::Write(record.data(), record.size(), request.seed, 0u, system) == 0u)
+        {
+            response.status = GenerationResponse::Failed;
+            record.clear();
+        }
+    }
+
+    if (metrics && generated)
+    {
+        metrics->planetsPerSystem.observe(static_cast<double>(system.getPlanets().size()));
+        metrics->systemsGenerated.add();
+    }
+
+    // Once the job leaves inFlight, nobody else can join it.
+    std::vector<Job::Waiter> waiters;
+    {
+        std::lock_guard<std::mutex> guard(queueMutex);
+        inFlight.erase(std::string(reinterpret_cast<const char*>(&request), sizeof(request)));
+        waiters.swap(job.waiters);
+    }
+
+    response.recordSize = static_cast<uint32_t>(record.size());
+    for (size_t w = 0; w < waiters.size(); ++w)
+    {
+        response.requestId = waiters[w].requestId;
+        if (w == 1u)
+        {
+            response.flags |= GenerationResponse::Shared;
+        }
+
+#if !defined(_WIN32)
+        Connection& c = *waiters[w].connection;
+        std::lock_guard<std::mutex> guard(c.writeMutex);
+        if (SendAll(c.socket, &response, sizeof(response)) && !record.empty())
+        {
+            SendAll(c.socket, record.data(), record.size());
+        }
+#endif
+    }
+}
+
+//----------------------------------------------------------------------------
+void GenerationServer::work()
+{
+    Worker worker(*this);
+
+    for (;;)
+    {
+        uint32_t priority = 0u;
+        std::shared_ptr<Job> job;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueReady.wait(lock, [this, &priority]()
+            {
+                if (stopping)
+                {
+                    return true;
+                }
+                for (priority = 0u; priority < RequestPriorityCount; ++priority)
+                {
+                    if (!queue[priority].empty() && running[priority] < concurrencyLimit[priority])
+                    {
+                        return true;
+                    }
+                }
+                return false;
+            });
+            if (stopping)
+            {
+                return;
+            }
+
+            // Jobs are taken one at a time: a bulk job left in the queue can still be promoted by an
+            // identical interactive request, and the next job does not wait behind this one.
+            auto& q = queue[priority];
+            job = q.front();
+            q.pop_front();
+            job->queued = false;
+            ++running[priority];
+            updatePending();
+        }
+        if (metrics)
+        {
+            metrics->queueDepth.add(-1.0);
+        }
+
+        // Only bulk systems give way to interactive ones; an interactive job runs to completion.
+        worker.generator.setPreemptor((priority == static_cast<uint32_t>(RequestPriority::Bulk)) ? &worker : nullptr);
+        run(*job, worker.generator, worker.system, worker.record);
+        job.reset();
+
+        {
+            std::lock_guard<std::mutex> guard(queueMutex);
+            --running[priority];
+            updatePending();
+        }
+        queueReady.notify_all();
+    }
+}
+
+}
+}
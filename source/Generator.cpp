@@ -24,44 +24,23 @@
 ****************************************************************************/
 #include <qcSysGen/Generator.h>
 
+#include <qcSysGen/CostProfiler.h>
+#include <qcSysGen/Equations.h>
+#include <qcSysGen/PhaseCounters.h>
 #include <qcSysGen/Star.h>
 #include <qcSysGen/System.h>
 
+#include <algorithm>
 #include <assert.h>
 
 namespace
 {
 
-//----------------------------------------------------------------------------
-// Apply the Blagg's formumation of the Bode Law using the specified parameters.
-double BodeSequence(int n, double A, double B, float alpha, float beta)
-{
-    const float theta = alpha + n * beta;
-    // f(theta) = 0.249 + 0.86 * ( cos(theta)/(3 - cos(2 * theta)) + 1/(6 - 4*cos(2 * (theta - pi/6))) )
-    const double f = 0.249 + 0.86 * (cosf(theta) / (3.0 - cosf(2.0f * theta)) + 1.0 / (6.0 - 4.0 * cosf(theta - 0.52359877559829887307710723054658f)));
-
-    return A * (B + f) * powf(1.7275f, float(n));
-}
-
-//----------------------------------------------------------------------------
-// "reduced_mass" in the original accrete implementation.  Provides a number
-// in the range [0, 1) based on the provided mass (in Solar masses).
-inline double EffectLimitScalar(double mass)
-{
-    return pow(mass / (1.0 + mass), (1.0 / 4.0));
-}
-
 //----------------------------------------------------------------------------
 // Returns the inner and outer effect limit for a given protoplanet.
 std::pair<double, double> GetEffectLimits(double sma, double e, double mass)
 {
-    /// Mean eccentricity of the nebular dust in Dole 1969.
-    /// The original value was 0.25, but it looks like the various versions afterwards used 0.2 instead.
-    static constexpr double CloudEccentricity = 0.2;
-
-    const double scalar = EffectLimitScalar(mass);
-
-    return std::make_pair(sma * (1.0 - e) * (1.0 - scalar) / (1.0 + CloudEccentricity), sma * (1.0 + e) * (1.0 + scalar) / (1.0 - CloudEccentricity));
+    return qc::SystemGenerator::EffectLimits(sma, e, qc::SystemGenerator::EffectLimitScalar(mass));
 }
 
 }
@@ -75,10 +54,15 @@ namespace SystemGenerator
 //----------------------------------------------------------------------------
 void Generator::accreteDust(Protoplanet& protoplanet)
 {
-    protoplanet.criticalMass = CriticalLimit(protoplanet.sma, protoplanet.eccentricity, stellarLuminosity);
+    protoplanet.criticalMass = ScaledCriticalLimit(protoplanet.sma, protoplanet.eccentricity, criticalLimitScalar);
+
+    if (accretionLog)
+    {
+        accretionLog->record(AccretionEventType::ProtoplanetInjected, 0u, protoplanet.sma, protoplanet.eccentricity, protoplanet.mass, protoplanet.criticalMass);
+    }
 
 #ifdef ALLOW_DEBUG_PRINTF
-    if (config.verboseLogging)
+    if (config->verboseLogging)
     {
         printf(__FUNCTION__"(): sma @ %.3lf\n", protoplanet.sma);
     }
@@ -91,6 +75,8 @@ void Generator::accreteDust(Protoplanet& protoplanet)
     
     double oldMass;
 
+    uint32_t sweep = 0u;
+
     // Accumulate dust.  When we exit this loop, addedMass is the total mass collected by the
     // protoplanet, and addedDustMass and addedGasMass are the additional dust and gas masses.
     do
@@ -102,6 +88,16 @@ void Generator::accreteDust(Protoplanet& protoplanet)
         oldMass = addedMass;
         addedMass = collectDust(protoplanet.mass + addedMass, addedDustMass, addedGasMass, protoplanet, availableDust.begin());
 
+        if (accretionLog)
+        {
+            accretionLog->record(AccretionEventType::DustCollected, sweep, addedMass, addedGasMass, protoplanet.r_inner, protoplanet.r_outer);
+        }
+        ++sweep;
+        if (systemCost)
+        {
+            ++systemCost->dustSweeps;
+        }
+
         // Keep trying to collect dust until we're not adding much per iteration.
     } while (addedMass > 0.0 && (addedMass - oldMass) >= 0.0001 * oldMass);
     
@@ -120,10 +116,10 @@ void Generator::accreteDust(Protoplanet& protoplanet)
     }
 
     // If the protoplanet is heavier than the initial seed mass, let's try to turn it into a planet.
-    if (protoplanet.mass > config.protoplanetSeedMass)
+    if (protoplanet.mass > config->protoplanetSeedMass)
     {
 #ifdef ALLOW_DEBUG_PRINTF
-        if (config.verboseLogging && !availableDust.empty())
+        if (config->verboseLogging && !availableDust.empty())
         {
             printf("Updated dust bands:\n");
             for (const auto& d : availableDust)
@@ -158,21 +154,28 @@ void Generator::accreteDust(Protoplanet& protoplanet)
         ++protoPlanetCount;
         coalescePlanetisimals(protoplanet);
     }
-#ifdef ALLOW_DEBUG_PRINTF
-    else if (config.verboseLogging)
+    else
     {
-        printf(" ... No dust collected.  Discarding\n");
-    }
+        if (systemCost)
+        {
+            ++systemCost->wastedProtoplanets;
+        }
+#ifdef ALLOW_DEBUG_PRINTF
+        if (config->verboseLogging)
+        {
+            printf(" ... No dust collected.  Discarding\n");
+        }
 #endif
+    }
 }
 
 //----------------------------------------------------------------------------
 bool Generator::accreteDust2(Protoplanet& protoplanet)
 {
-    protoplanet.criticalMass = CriticalLimit(protoplanet.sma, protoplanet.eccentricity, stellarLuminosity);
+    protoplanet.criticalMass = ScaledCriticalLimit(protoplanet.sma, protoplanet.eccentricity, criticalLimitScalar);
 
 #ifdef ALLOW_DEBUG_PRINTF
-    if (config.verboseLogging)
+    if (config->verboseLogging)
     {
         printf(__FUNCTION__"(): sma @ %.3lf\n", protoplanet.sma);
     }
@@ -186,6 +189,15 @@ bool Generator::accreteDust2(Protoplanet& protoplanet)
     double addedDustMass, addedGasMass;
     const double addedMass = collectDust(protoplanet.mass, addedDustMass, addedGasMass, protoplanet, availableDust.begin());
 
+    if (accretionLog)
+    {
+        accretionLog->record(AccretionEventType::DustCollected, 0u, addedMass, addedGasMass, protoplanet.r_inner, protoplanet.r_outer);
+    }
+    if (systemCost)
+    {
+        ++systemCost->dustSweeps;
+    }
+
     // If any mass wass was added, add it to the protoplanet and update the dust lanes.
     if (addedMass > 0.0)
     {
@@ -211,16 +223,79 @@ bool Generator::accreteDust2(Protoplanet& protoplanet)
     }
 }
 
+//----------------------------------------------------------------------------
+void Generator::addPlanet(const Protoplanet& protoplanet)
+{
+    Planet newPlanet(protoplanet.sma, static_cast<float>(protoplanet.eccentricity), protoplanet.dustMass, protoplanet.gasMass);
+#ifdef ALLOW_DEBUG_PRINTF
+    if (config->verboseLogging)
+    {
+        printf(" ... Adding new planet.\n");
+    }
+#endif
+    if (accretionLog)
+    {
+        accretionLog->record(AccretionEventType::PlanetCommitted, 0u, protoplanet.sma, protoplanet.eccentricity, protoplanet.dustMass, protoplanet.gasMass);
+    }
+    if (planetList.empty() || planetList.front().getSemimajorAxis() > newPlanet.getSemimajorAxis())
+    {
+        planetList.emplace_front(newPlanet);
+    }
+    else
+    {
+        auto currentPlanet = planetList.begin();
+        auto nextPlanet = currentPlanet;
+        ++nextPlanet;
+
+        while (currentPlanet != planetList.end())
+        {
+            if (nextPlanet == planetList.end())
+            {
+                planetList.emplace_after(currentPlanet, newPlanet);
+                break;
+            }
+            else if (currentPlanet->getSemimajorAxis() < newPlanet.getSemimajorAxis() && nextPlanet->getSemimajorAxis() >= newPlanet.getSemimajorAxis())
+            {
+                planetList.emplace_after(currentPlanet, newPlanet);
+                break;
+            }
+            ++currentPlanet;
+            ++nextPlanet;
+        }
+    }
+}
+
 //----------------------------------------------------------------------------
 void Generator::coalescePlanetisimals(const Protoplanet& protoplanet)
 {
 #ifdef ALLOW_DEBUG_PRINTF
-    if (config.verboseLogging)
+    if (config->verboseLogging)
     {
         printf(__FUNCTION__"():\n");
     }
 #endif
 
+    PhaseScope phase(phaseCounters, GenerationPhase::Coalescence);
+
+    Protoplanet newProtoplanet;
+    const Collision collision = collidePlanetisimals(protoplanet, newProtoplanet);
+    if (collision == Collision::Merged)
+    {
+        // Sweep the dustbands with the protoplanet that represents the merged mass.
+        phase.change(GenerationPhase::Accretion);
+        accreteDust(newProtoplanet);
+    }
+    else if (collision == Collision::None)
+    {
+        // The protoplanet didn't interact with anything already in the planetary system, so we need to add it as a new
+        // body.
+        addPlanet(protoplanet);
+    }
+}
+
+//----------------------------------------------------------------------------
+Generator::Collision Generator::collidePlanetisimals(const Protoplanet& protoplanet, Protoplanet& newProtoplanet)
+{
     PlanetList::iterator planet = planetList.begin();
     while (planet != planetList.end())
     {
@@ -260,7 +335,7 @@ void Generator::coalescePlanetisimals(const Protoplanet& protoplanet)
 
             const float newE = static_cast<float>(sqrt(e2));
 
-            if (config.generateMoonsOnCollision)
+            if (config->generateMoonsOnCollision)
             {
 #if 0
                 if (protoplanet.mass < protoplanet.criticalMass)
@@ -277,7 +352,7 @@ void Generator::coalescePlanetisimals(const Protoplanet& protoplanet)
                         if (protoplanet.mass > planet->getMass())
                         {
 #ifdef ALLOW_DEBUG_PRINTF
-                            if (config.verboseLogging)
+                            if (config->verboseLogging)
                             {
                                 printf("... Protoplanet collision.  New planet @ %.3lfAU has captured existing planet @ %.3lfAU as a moon.\n",
                                        protoplanet.sma, planet->getSemimajorAxis());
@@ -291,7 +366,7 @@ void Generator::coalescePlanetisimals(const Protoplanet& protoplanet)
                         else
                         {
 #ifdef ALLOW_DEBUG_PRINTF
-                            if (config.verboseLogging)
+                            if (config->verboseLogging)
                             {
                                 printf("... Protoplanet collision.  New planet @ %.3lfAU has become a moon of existing planet @ %.3lfAU.\n",
                                        protoplanet.sma, planet->getSemimajorAxis());
@@ -301,14 +376,13 @@ void Generator::coalescePlanetisimals(const Protoplanet& protoplanet)
                         }
 
                         // Early return - the planet captured the protoplanet or vice-versa
-                        return;
+                        return Collision::Captured;
                     }
                 }
 #endif
             }
 
             // Protoplanet collision
-            Protoplanet newProtoplanet;
             newProtoplanet.sma = newSMA;
             newProtoplanet.eccentricity = newE;
             newProtoplanet.mass = planet->getMass() + protoplanet.mass;
@@ -316,61 +390,32 @@ void Generator::coalescePlanetisimals(const Protoplanet& protoplanet)
             newProtoplanet.gasMass = planet->getGasMassComponent() + protoplanet.gasMass;
 
 #ifdef ALLOW_DEBUG_PRINTF
-            if (config.verboseLogging)
+            if (config->verboseLogging)
             {
                 printf("... Protoplanet collision.  New planet @ %.3lfAU has merged with existing planet @ %.3lfAU.  Rechecking dust accretion.\n",
                        protoplanet.sma, planet->getSemimajorAxis());
             }
 #endif
 
-            // Remove planet from the list - accreteDust() will replace it with the merged protoplanet.
-            planetList.remove_if([planet](Planet& p) { return (p.getSemimajorAxis() == planet->getSemimajorAxis()); });
+            if (accretionLog)
+            {
+                accretionLog->record(AccretionEventType::Collision, 0u, planet->getSemimajorAxis(), planet->getMass(), newProtoplanet.sma, newProtoplanet.mass);
+            }
+            if (systemCost)
+            {
+                ++systemCost->collisions;
+            }
 
-            // Sweep the dustbands with the protoplanet that represents the merged mass.
-            accreteDust(newProtoplanet);
+            // Remove planet from the list - the caller will replace it with the merged protoplanet.
+            planetList.remove_if([planet](Planet& p) { return (p.getSemimajorAxis() == planet->getSemimajorAxis()); });
 
-            // Return early - finished, and we added the merged planetisimal in accreteDust
-            return;
+            return Collision::Merged;
         }
 
         ++planet;
     }
 
-    // The protoplanet didn't interact with anything already in the planetary system, so we need to add it as a new
-    // body.
-    Planet newPlanet(protoplanet.sma, static_cast<float>(protoplanet.eccentricity), protoplanet.dustMass, protoplanet.gasMass);
-#ifdef ALLOW_DEBUG_PRINTF
-    if (config.verboseLogging)
-    {
-        printf(" ... Adding new planet.\n");
-    }
-#endif
-    if (planetList.empty() || planetList.front().getSemimajorAxis() > newPlanet.getSemimajorAxis())
-    {
-        planetList.emplace_front(newPlanet);
-    }
-    else
-    {
-        auto currentPlanet = planetList.begin();
-        auto nextPlanet = currentPlanet;
-        ++nextPlanet;
-
-        while (currentPlanet != planetList.end())
-        {
-            if (nextPlanet == planetList.end())
-            {
-                planetList.emplace_after(currentPlanet, newPlanet);
-                break;
-            }
-            else if (currentPlanet->getSemimajorAxis() < newPlanet.getSemimajorAxis() && nextPlanet->getSemimajorAxis() >= newPlanet.getSemimajorAxis())
-            {
-                planetList.emplace_after(currentPlanet, newPlanet);
-                break;
-            }
-            ++currentPlanet;
-            ++nextPlanet;
-        }
-    }
+    return Collision::None;
 }
 
 //----------------------------------------------------------------------------
@@ -391,26 +436,7 @@ double Generator::collectDust(double lastMass, double& additionalDustMass, doubl
         return collectDust(lastMass, additionalDustMass, additionalGasMass, protoplanet, ++dustband);
     }
 
-    // Where do these values come from?
-    // Per acrete.cc - "See Sagan's article for insight into changing them."
-    // Per Dole 1969, they were picked because the tended to generate planetary systems similar to our Solar System.
-
-    // A is the density of the dust cloud in solar masses per cubic AU.
-    //
-    // Dole 1969 used 0.0015, most of the later implementations use 0.002.
-    static constexpr double A = 0.0020;
-
-    // Alpha moves where the highest density of the dust tends to be.  Per Issacman 1977,
-    // 5.0 is roughly 5.8AU (Jupiter) for a G2V.  Larger values will tend to make outer
-    // planets smaller.  The equation is extremely sensitive to these values,
-    // and degenerate conditions are common if they change too much.
-    static constexpr double Alpha = 5.0;
-
-    // N is the denominator of the exponent in Dole 1969's dust density equation.  Issacman 1977
-    // varied it to see how it affected the outcome.
-    static constexpr double N = 3.0;
-
-    const double dustDensity = A * sqrt(stellarMass) * exp(-Alpha * pow(protoplanet.sma, 1.0 / N));
+    const double dustDensity = ScaledDustDensity(protoplanet.sma, dustDensityScalar);
     const double tempDensity = (dustband->dustPresent) ? dustDensity : 0.0;
 
     double massDensity;
@@ -464,84 +490,31 @@ double Generator::collectDust(double lastMass, double& additionalDustMass, doubl
 }
 
 //----------------------------------------------------------------------------
-void Generator::generate(SolarSystem& system, const Config& config_)
+void Generator::accrete(SolarSystem& system, const Config& config_)
 {
-    system.planet.clear();
-    availableDust.clear();
-    protoPlanetCount = 0;
+    ownConfig.prepare(config_);
+    accrete(system, ownConfig);
+}
 
-    config = config_;
+//----------------------------------------------------------------------------
+void Generator::accrete(SolarSystem& system, const PreparedConfig& config_)
+{
+    std::vector<ProtoplanetSeed>& protoplanetSeeds = protoplanetSeedScratch;
+    protoplanetSeeds.clear();
+    beginAccretion(system, config_, protoplanetSeeds);
 
-    // Sanity clamps:
-    config.inclinationMean = fabsf(config.inclinationMean);
-    while (config.inclinationMean >= 180.0f)
-    {
-        config.inclinationMean -= 180.0f;
-    }
-    config.inclinationStdDev = fabsf(config.inclinationStdDev);
+    PhaseScope phase(phaseCounters, GenerationPhase::Accretion);
 
 #ifdef ALLOW_DEBUG_PRINTF
-    if (config.verboseLogging)
+    if (config->verboseLogging)
     {
         printf(__FUNCTION__"():\n");
     }
 #endif
-    if (config.generateStar)
-    {
-        generateStar(system);
-    }
-    else
-    {
-        // Make sure the star's evaluataed before we start using it.
-        system.star.evaluate(this);
-        if (config.verboseLogging)
-        {
-            char st[6];
-            system.star.getStellarClass(st, sizeof(st));
-            printf("using supplied star %s\n", st);
-        }
-    }
-
-    const Star& star = system.star;
-
-    // Store shadow values
-    protoplanetZone = star.getProtoplanetZone();
-    stellarLuminosity = star.getLuminosity();
-    stellarMass = star.getMass();
-
-    std::vector<ProtoplanetSeed> protoplanetSeeds;
-    if (!config.protoplanetSeeds.empty())
-    {
-#ifdef ALLOW_DEBUG_PRINTF
-        if (config.verboseLogging)
-        {
-            printf("%Iu protoplanet seeds provided in Config\n", config.protoplanetSeeds.size());
-        }
-#endif
-        protoplanetSeeds.assign(config.protoplanetSeeds.begin(), config.protoplanetSeeds.end());
-
-        // Assign random eccentricity where needed:
-        for (auto& s : protoplanetSeeds)
-        {
-            if (s.eccentricity < 0.0f || s.eccentricity > 0.9f)
-            {
-                s.eccentricity = randomEccentricity();
-            }
-        }
-    }
-    else if (config.generateBodeSeeds)
-    {
-        generateBodeSeeds(protoplanetSeeds, star);
-    }
-
-    // Initialize dust bands
-    const BandLimit_t& dustZone = star.getDustZone();
-    availableDust.emplace_front(Dust(dustZone.first, dustZone.second, true, true));
-    dustRemains = true;
 
     // Apply seeds
 #ifdef ALLOW_DEBUG_PRINTF
-    if (!protoplanetSeeds.empty() && config.verboseLogging)
+    if (!protoplanetSeeds.empty() && config->verboseLogging)
     {
         printf("Applying protoplanet seeds:\n");
     }
@@ -554,14 +527,19 @@ void Generator::generate(SolarSystem& system, const Config& config_)
             Protoplanet protoplanet;
             protoplanet.sma = s.semiMajorAxis;
             protoplanet.eccentricity = s.eccentricity;
-            protoplanet.mass = protoplanet.dustMass = config.protoplanetSeedMass;
+            protoplanet.mass = protoplanet.dustMass = config->protoplanetSeedMass;
 
+            if (systemCost)
+            {
+                ++systemCost->protoplanets;
+            }
+            preemptionPoint();
             accreteDust(protoplanet);
         }
 #ifdef ALLOW_DEBUG_PRINTF
         else
         {
-            if (config.verboseLogging)
+            if (config->verboseLogging)
             {
                 printf("Discarded protoplanet at SMA %.3lf: outside of protoplanet zone\n", s.semiMajorAxis);
             }
@@ -570,7 +548,7 @@ void Generator::generate(SolarSystem& system, const Config& config_)
     }
 
 #ifdef ALLOW_DEBUG_PRINTF
-    if (dustRemains && config.verboseLogging)
+    if (dustRemains && config->verboseLogging)
     {
         printf("Consuming remaining dust:\n");
     }
@@ -580,111 +558,43 @@ void Generator::generate(SolarSystem& system, const Config& config_)
         Protoplanet protoplanet;
         protoplanet.sma = randomUniform(protoplanetZone.first, protoplanetZone.second);
         protoplanet.eccentricity = randomEccentricity();
-        protoplanet.mass = protoplanet.dustMass = config.protoplanetSeedMass;
-
-        accreteDust(protoplanet);
-    }
-
-    // Generate moons
-    if (config.generateMoons)
-    {
-        // TODO: Generate moons
-    }
-
+        protoplanet.mass = protoplanet.dustMass = config->protoplanetSeedMass;
 
-    // Copy the planet list across to the solar system.
-    system.planet.reserve(std::distance(planetList.begin(), planetList.end()));
-    for (auto& p : planetList)
-    {
-        // Finalize values for the planet:
-        p.inclination = randomNear(config.inclinationMean, 3.0f * config.inclinationStdDev);
-        p.inclination = fabsf(p.inclination);
-        while (p.inclination >= 180.0f)
+        if (systemCost)
         {
-            p.inclination -= 180.0f;
+            ++systemCost->protoplanets;
         }
-        p.longitudeAscendingNode = randomTwoPi();
-        p.argumentOfPeriapsis = randomTwoPi();
-        p.meanAnomalyAtEpoch = randomTwoPi(); // mean anomaly is a double, but I think promoting a float is good enough for initializing it here.
-
-        system.planet.emplace_back(p);
+        preemptionPoint();
+        accreteDust(protoplanet);
     }
 
-    system.evaluate(*this);
+    finishAccretion(system);
 }
 
 //----------------------------------------------------------------------------
-void Generator::generate2(SolarSystem& system, const Config& config_)
+void Generator::accrete2(SolarSystem& system, const Config& config_)
 {
-    system.planet.clear();
-    availableDust.clear();
-    protoPlanetCount = 0;
+    ownConfig.prepare(config_);
+    accrete2(system, ownConfig);
+}
 
-    config = config_;
+//----------------------------------------------------------------------------
+void Generator::accrete2(SolarSystem& system, const PreparedConfig& config_)
+{
+    std::vector<ProtoplanetSeed>& protoplanetSeeds = protoplanetSeedScratch;
+    protoplanetSeeds.clear();
+    beginAccretion(system, config_, protoplanetSeeds);
 
-    // Sanity clamps:
-    config.inclinationMean = fabsf(config.inclinationMean);
-    while (config.inclinationMean >= 180.0f)
-    {
-        config.inclinationMean -= 180.0f;
-    }
-    config.inclinationStdDev = fabsf(config.inclinationStdDev);
+    PhaseScope phase(phaseCounters, GenerationPhase::Accretion);
 
 #ifdef ALLOW_DEBUG_PRINTF
-    if (config.verboseLogging)
+    if (config->verboseLogging)
     {
         printf(__FUNCTION__"():\n");
     }
 #endif
-    if (config.generateStar)
-    {
-        generateStar(system);
-    }
-    else
-    {
-        // Make sure the star's evaluataed before we start using it.
-        system.star.evaluate(this);
-        if (config.verboseLogging)
-        {
-            char st[6];
-            system.star.getStellarClass(st, sizeof(st));
-            printf("using supplied star %s\n", st);
-        }
-    }
-
-    const Star& star = system.star;
 
-    // Store shadow values
-    protoplanetZone = star.getProtoplanetZone();
-    stellarLuminosity = star.getLuminosity();
-    stellarMass = star.getMass();
-
-    std::vector<ProtoplanetSeed> protoplanetSeeds;
     std::vector<Protoplanet> protoplanets;
-    if (!config.protoplanetSeeds.empty())
-    {
-#ifdef ALLOW_DEBUG_PRINTF
-        if (config.verboseLogging)
-        {
-            printf("%Iu protoplanet seeds provided in Config\n", config.protoplanetSeeds.size());
-        }
-#endif
-        protoplanetSeeds.assign(config.protoplanetSeeds.begin(), config.protoplanetSeeds.end());
-
-        // Assign random eccentricity where needed:
-        for (auto& s : protoplanetSeeds)
-        {
-            if (s.eccentricity < 0.0f || s.eccentricity > 0.9f)
-            {
-                s.eccentricity = randomEccentricity();
-            }
-        }
-    }
-    else if (config.generateBodeSeeds)
-    {
-        generateBodeSeeds(protoplanetSeeds, star);
-    }
-
     for (const auto& s : protoplanetSeeds)
     {
         if (s.semiMajorAxis >= protoplanetZone.first && s.semiMajorAxis <= protoplanetZone.second)
@@ -699,34 +609,46 @@ void Generator::generate2(SolarSystem& system, const Config& config_)
             {
                 protoplanet.eccentricity = s.eccentricity;
             }
-            protoplanet.mass = protoplanet.dustMass = config.protoplanetSeedMass;
+            protoplanet.mass = protoplanet.dustMass = config->protoplanetSeedMass;
             protoplanets.emplace_back(protoplanet);
+
+            if (accretionLog)
+            {
+                accretionLog->record(AccretionEventType::ProtoplanetInjected, 0u, protoplanet.sma, protoplanet.eccentricity, protoplanet.mass,
+                                     ScaledCriticalLimit(protoplanet.sma, protoplanet.eccentricity, criticalLimitScalar));
+            }
         }
 #ifdef ALLOW_DEBUG_PRINTF
-        else if (config.verboseLogging)
+        else if (config->verboseLogging)
         {
             printf("Discarded protoplanet at SMA %.3lf: outside of protoplanet zone\n", s.semiMajorAxis);
         }
 #endif
     }
 
-    for (uint32_t i = 0; i < config.protoplanetCount; ++i)
+    for (uint32_t i = 0; i < config->protoplanetCount; ++i)
     {
         Protoplanet protoplanet;
         protoplanet.sma = randomUniform(protoplanetZone.first, protoplanetZone.second);
         protoplanet.eccentricity = randomEccentricity();
-        protoplanet.mass = protoplanet.dustMass = config.protoplanetSeedMass;
+        protoplanet.mass = protoplanet.dustMass = config->protoplanetSeedMass;
         protoplanets.emplace_back(protoplanet);
+
+        if (accretionLog)
+        {
+            accretionLog->record(AccretionEventType::ProtoplanetInjected, 0u, protoplanet.sma, protoplanet.eccentricity, protoplanet.mass,
+                                 ScaledCriticalLimit(protoplanet.sma, protoplanet.eccentricity, criticalLimitScalar));
+        }
     }
 
-    // Initialize dust bands
-    const BandLimit_t& dustZone = star.getDustZone();
-    availableDust.emplace_front(Dust(dustZone.first, dustZone.second, true, true));
-    dustRemains = true;
+    if (systemCost)
+    {
+        systemCost->protoplanets += static_cast<uint32_t>(protoplanets.size());
+    }
 
     // Apply seeds
 #ifdef ALLOW_DEBUG_PRINTF
-    if (config.verboseLogging)
+    if (config->verboseLogging)
     {
         printf("Applying %Iu protoplanet seeds:\n", protoplanets.size());
     }
@@ -737,7 +659,7 @@ void Generator::generate2(SolarSystem& system, const Config& config_)
     do
     {
 #ifdef ALLOW_DEBUG_PRINTF
-        if (config.verboseLogging)
+        if (config->verboseLogging)
         {
             printf("Accretion iteration %u:\n", iteratorCount);
         }
@@ -748,6 +670,7 @@ void Generator::generate2(SolarSystem& system, const Config& config_)
         {
             if (protoplanet.active)
             {
+                preemptionPoint();
                 if (accreteDust2(protoplanet))
                 {
                     anyAccrued = true;
@@ -756,7 +679,7 @@ void Generator::generate2(SolarSystem& system, const Config& config_)
                 {
                     protoplanet.active = false;
 #ifdef ALLOW_DEBUG_PRINTF
-                    if (config.verboseLogging)
+                    if (config->verboseLogging)
                     {
                         printf(" ... protoplanet %3u has stopped accreting.\n", idx);
                     }
@@ -770,7 +693,7 @@ void Generator::generate2(SolarSystem& system, const Config& config_)
     } while (anyAccrued);
 
 #ifdef ALLOW_DEBUG_PRINTF
-    if (config.verboseLogging)
+    if (config->verboseLogging)
     {
         printf("%u accrual cycles before all protoplanets stopped accreting.\n", iteratorCount);
     }
@@ -778,14 +701,18 @@ void Generator::generate2(SolarSystem& system, const Config& config_)
     
     for (auto& protoplanet : protoplanets)
     {
-        if (protoplanet.mass > config.protoplanetSeedMass)
+        if (protoplanet.mass > config->protoplanetSeedMass)
         {
             coalescePlanetisimals(protoplanet);
         }
+        else if (systemCost)
+        {
+            ++systemCost->wastedProtoplanets;
+        }
     }
 
 #ifdef ALLOW_DEBUG_PRINTF
-    if (dustRemains && config.verboseLogging)
+    if (dustRemains && config->verboseLogging)
     {
         printf("Consuming remaining dust:\n");
     }
@@ -797,13 +724,130 @@ void Generator::generate2(SolarSystem& system, const Config& config_)
         Protoplanet protoplanet;
         protoplanet.sma = randomUniform(protoplanetZone.first, protoplanetZone.second);
         protoplanet.eccentricity = randomEccentricity();
-        protoplanet.mass = protoplanet.dustMass = config.protoplanetSeedMass;
+        protoplanet.mass = protoplanet.dustMass = config->protoplanetSeedMass;
 
+        if (systemCost)
+        {
+            ++systemCost->protoplanets;
+        }
+        preemptionPoint();
         accreteDust(protoplanet);
     }
     
+    finishAccretion(system);
+}
+
+//----------------------------------------------------------------------------
+void Generator::beginAccretion(SolarSystem& system, const PreparedConfig& config_, std::vector<ProtoplanetSeed>& protoplanetSeeds)
+{
+    system.planet.clear();
+    availableDust.clear();
+    planetList.clear();
+    protoPlanetCount = 0;
+
+    config = &config_.getConfig();
+    densityVariation = config->densityVariation;
+    verboseLogging = config->verboseLogging;
+
+    PhaseScope phase(phaseCounters, GenerationPhase::Star);
+
+    if (config->generateStar)
+    {
+        generateStar(system);
+    }
+    else
+    {
+        // Make sure the star's evaluataed before we start using it.
+        system.star.evaluate(this);
+#ifdef ALLOW_DEBUG_PRINTF
+        if (config->verboseLogging)
+        {
+            char st[6];
+            system.star.getStellarClass(st, sizeof(st));
+            printf("using supplied star %s\n", st);
+        }
+#endif
+    }
+
+    const Star& star = system.star;
+
+    // Store shadow values
+    protoplanetZone = star.getProtoplanetZone();
+    stellarLuminosity = star.getLuminosity();
+    stellarMass = star.getMass();
+
+    // The prepared star-specific values only apply to the star the config was prepared with.
+    const bool preparedStar = config_.hasStar() &&
+        stellarLuminosity == config_.getStar().getLuminosity() && stellarMass == config_.getStar().getMass();
+    if (preparedStar)
+    {
+        criticalLimitScalar = config_.getCriticalLimitScalar();
+        dustDensityScalar = config_.getDustDensityScalar();
+    }
+    else
+    {
+        criticalLimitScalar = CriticalLimitScalar(stellarLuminosity);
+        dustDensityScalar = DustDensityScalar(stellarMass);
+    }
+
+    phase.change(GenerationPhase::Seeds);
+
+    if (!config->protoplanetSeeds.empty())
+    {
+#ifdef ALLOW_DEBUG_PRINTF
+        if (config->verboseLogging)
+        {
+            printf("%Iu protoplanet seeds provided in Config\n", config->protoplanetSeeds.size());
+        }
+#endif
+        protoplanetSeeds.assign(config->protoplanetSeeds.begin(), config->protoplanetSeeds.end());
+
+        // Assign random eccentricity where needed:
+        if (config_.hasRandomSeedEccentricity())
+        {
+            for (auto& s : protoplanetSeeds)
+            {
+                if (s.eccentricity < 0.0f || s.eccentricity > 0.9f)
+                {
+                    s.eccentricity = randomEccentricity();
+                }
+            }
+        }
+    }
+    else if (const SeedStrategy* seedStrategy = config_.getSeedStrategy())
+    {
+        if (preparedStar)
+        {
+            seedStrategy->generate(*this, star, config_.getSeedLayout(), protoplanetSeeds);
+        }
+        else
+        {
+            seedStrategy->prepare(star, seedLayoutScratch);
+            seedStrategy->generate(*this, star, seedLayoutScratch, protoplanetSeeds);
+        }
+    }
+
+    // Initialize dust bands
+    const BandLimit_t& dustZone = star.getDustZone();
+    availableDust.emplace_front(Dust(dustZone.first, dustZone.second, true, true));
+    dustRemains = true;
+
+    if (accretionLog)
+    {
+        accretionLog->begin(seedVal);
+        accretionLog->record(AccretionEventType::SystemBegin, static_cast<uint32_t>(protoplanetSeeds.size()), stellarMass, stellarLuminosity, dustZone.first, dustZone.second);
+    }
+    if (systemCost)
+    {
+        systemCost->begin(seedVal);
+    }
+}
+
+//----------------------------------------------------------------------------
+void Generator::finishAccretion(SolarSystem& system)
+{
     // Generate moons
-    if (config.generateMoons)
+    if (config->generateMoons)
     {
         // TODO: Generate moons
     }
@@ -814,7 +858,7 @@ void Generator::generate2(SolarSystem& system, const Config& config_)
     for (auto& p : planetList)
     {
         // Finalize values for the planet:
-        p.inclination = randomNear(config.inclinationMean, 3.0f * config.inclinationStdDev);
+        p.inclination = randomNear(config->inclinationMean, 3.0f * config->inclinationStdDev);
         p.inclination = fabsf(p.inclination);
         while (p.inclination >= 180.0f)
         {
@@ -827,118 +871,46 @@ void Generator::generate2(SolarSystem& system, const Config& config_)
         system.planet.emplace_back(p);
     }
 
+    if (accretionLog)
+    {
+        accretionLog->record(AccretionEventType::SystemEnd, static_cast<uint32_t>(system.planet.size()), static_cast<double>(protoPlanetCount));
+    }
+    if (systemCost)
+    {
+        systemCost->planetCount = static_cast<uint32_t>(system.planet.size());
+    }
+}
+
+//----------------------------------------------------------------------------
+void Generator::generate(SolarSystem& system, const Config& config_)
+{
+    accrete(system, config_);
+
     system.evaluate(*this);
 }
 
 //----------------------------------------------------------------------------
-void Generator::generateBodeSeeds(std::vector<ProtoplanetSeed>& protoplanetSeeds, const Star& star)
+void Generator::generate(SolarSystem& system, const PreparedConfig& config_)
 {
-#ifdef ALLOW_DEBUG_PRINTF
-    if (config.verboseLogging)
-    {
-        printf("Generating Bode seeds:\n");
-    }
-#endif
+    accrete(system, config_);
 
-    // The Blagg formulation of Bode's Law is:
-    // SMA (AU) = A * (B + f(a + nb)) * 1.7275 ^ n
-    // where:
-    // f(theta) = 0.249 + 0.86 * ( cos(theta)/(3 - cos(2 * theta)) + 1/(6 - 4*cos(2 * (theta - pi/6))) )
-    // A = 0.4162
-    // B = 2.025
-    // a =  84.9*
-    // b =  56.6*
-    // n = integer (-2, -1, 0, 1, 2, ...)
-    //
-    // This formulation is pretty accurate for the solar system - within 5% on all of the major planets except
-    // Neptune (which is 5.6%).  It also is reasonable for the moons of the gas giants with tweaking of the constants.
-    //
-    // For this simulation's sake, we'll vary A and B within a small range (+/- 5%), with additional scaling
-    // of A based on the ideal ecosphere of the central star.  This way, we can more-or-less guarantee that the first
-    // protoplanet (n = 0) is within or close to the ecosphere.
-
-    // A in the Blagg formulation, initially 0.4162.
-    // We scale that value by the ecosphere radius, and then apply a random
-    // Gaussian distribution within a few percent of that result.
-    const double A = 0.4162 * star.getEcosphere() * randomNear(1.0f, 0.04f);
-
-    // B in the Blagg formulation, initially 2.025.
-    const double B = 2.025 * randomNear(1.0f, 0.04f);
-
-    // alpha in the Blagg formulation.  For our solar system, it's 84.9 degrees (~1.4818).
-    // We'll use a completely random value here.
-    const float a = randomTwoPi();
-
-    // beta in the Blagg formulation.  For our solar system, it's 56.6 degrees (~0.9879).
-    const float b = 0.9879f;
-
-    // Generate the seeds:
-    ProtoplanetSeed s;
-
-    s.semiMajorAxis = BodeSequence(0, A, B, a, b);
-    s.eccentricity = randomEccentricity();
-
-    protoplanetSeeds.emplace_back(s);
-#ifdef ALLOW_DEBUG_PRINTF
-    if (config.verboseLogging)
-    {
-        printf(" ... n =  0 - SMA = %.3lf, ecc = %.3f\n", s.semiMajorAxis, s.eccentricity);
-    }
-#endif
+    system.evaluate(*this);
+}
 
-    int32_t n = 1;
-    bool added = false;
-    do
-    {
-        added = false;
-        s.semiMajorAxis = BodeSequence(-n, A, B, a, b);
-        s.eccentricity = randomEccentricity();
-        if (s.semiMajorAxis >= protoplanetZone.first)
-        {
-            protoplanetSeeds.emplace_back(s);
-            added = true;
-#ifdef ALLOW_DEBUG_PRINTF
-            if (config.verboseLogging)
-            {
-                printf(" ... n = %2d - SMA = %.3lf, ecc = %.3f\n", -n, s.semiMajorAxis, s.eccentricity);
-            }
-#endif
-        }
+//----------------------------------------------------------------------------
+void Generator::generate2(SolarSystem& system, const Config& config_)
+{
+    accrete2(system, config_);
 
-        s.semiMajorAxis = BodeSequence(n, A, B, a, b);
-        s.eccentricity = randomEccentricity();
-        if (s.semiMajorAxis <= protoplanetZone.second)
-        {
-            protoplanetSeeds.emplace_back(s);
-            added = true;
-#ifdef ALLOW_DEBUG_PRINTF
-            if (config.verboseLogging)
-            {
-                printf(" ... n = %2d - SMA = %.3lf, ecc = %.3f\n", n, s.semiMajorAxis, s.eccentricity);
-            }
-#endif
-        }
+    system.evaluate(*this);
+}
 
-        ++n;
-    } while (added);
+//----------------------------------------------------------------------------
+void Generator::generate2(SolarSystem& system, const PreparedConfig& config_)
+{
+    accrete2(system, config_);
 
-    // Reorder them?
-    size_t i = 1u;
-    while (i < protoplanetSeeds.size() - 1u)
-    {
-        const size_t otherIdx = randomUniformInt(1ull, protoplanetSeeds.size() - 1u);
-        if (i != otherIdx)
-        {
-#ifdef ALLOW_DEBUG_PRINTF
-            if (config.verboseLogging)
-            {
-                printf(" ... Swapping [%Iu] and [%Iu]\n", i, otherIdx);
-            }
-#endif
-            std::swap(protoplanetSeeds[i], protoplanetSeeds[otherIdx]);
-        }
-        ++i;
-    }
+    system.evaluate(*this);
 }
 
 //----------------------------------------------------------------------------
@@ -957,7 +929,7 @@ void Generator::generateStar(SolarSystem& system)
 
     system.add(star);
 #ifdef ALLOW_DEBUG_PRINTF
-    if (config.verboseLogging)
+    if (config->verboseLogging)
     {
         char st[6];
         star.getStellarClass(st, sizeof(st));
@@ -977,6 +949,9 @@ void Generator::updateDustLanes(const Protoplanet& protoplanet)
 
     AvailableDust::iterator currentBand = availableDust.begin();
 
+    uint32_t splits = 0u;
+    uint32_t merges = 0u;
+
     while (currentBand != availableDust.end())
     {
         if (currentBand->innerEdge < protoplanet.r_inner && currentBand->outerEdge > protoplanet.r_outer)
@@ -999,6 +974,8 @@ void Generator::updateDustLanes(const Protoplanet& protoplanet)
             availableDust.emplace_after(currentBand, outerBand);
             ++currentBand;
             // now points at the outer band.
+
+            splits += 2u;
         }
         else if (currentBand->innerEdge < protoplanet.r_outer && currentBand->outerEdge >= protoplanet.r_outer)
         {
@@ -1013,6 +990,8 @@ void Generator::updateDustLanes(const Protoplanet& protoplanet)
 
             availableDust.emplace_after(currentBand, newBand);
             ++currentBand;
+
+            ++splits;
         }
         else if (currentBand->innerEdge <= protoplanet.r_inner && currentBand->outerEdge > protoplanet.r_inner)
         {
@@ -1030,6 +1009,8 @@ void Generator::updateDustLanes(const Protoplanet& protoplanet)
 
             availableDust.emplace_after(currentBand, newBand);
             ++currentBand;
+
+            ++splits;
         }
         else if (currentBand->innerEdge >= protoplanet.r_inner && currentBand->outerEdge <= protoplanet.r_outer)
         {
@@ -1065,6 +1046,7 @@ void Generator::updateDustLanes(const Protoplanet& protoplanet)
             {
                 currentBand->outerEdge = nextBand->outerEdge;
                 availableDust.erase_after(currentBand);
+                ++merges;
 
                 // Don't advance the current band iterator, in case we can coalesce multiple bands.
             }
@@ -1078,6 +1060,17 @@ void Generator::updateDustLanes(const Protoplanet& protoplanet)
             ++currentBand;
         }
     }
+
+    if (accretionLog)
+    {
+        accretionLog->record(AccretionEventType::DustLanesUpdated, (splits & 0xffffu) | (merges << 16u), protoplanet.r_inner, protoplanet.r_outer, protoplanet.mass, protoplanet.criticalMass);
+    }
+    if (systemCost)
+    {
+        // Every split happens before the first merge, so the band count peaks between the two passes.
+        systemCost->peakDustBands = std::max(systemCost->peakDustBands, systemCost->dustBands + splits);
+        systemCost->dustBands += splits - merges;
+    }
 }
 
 }
@@ -0,0 +1,406 @@
+/*****************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Questionable Coding
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************/
+#include <qcSysGen/LaneAccretor.h>
+
+#include <qcSysGen/Equations.h>
+
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+
+/// @brief Edge of the empty bands that pad the band table.  Lies beyond every effect limit.
+static constexpr double EmptyBandEdge = std::numeric_limits<double>::max();
+
+/// @brief Minimum number of rows allocated for the band table.
+static constexpr uint32_t MinimumBandCapacity = 16u;
+
+/// @brief Gas-to-dust ratio (see Generator::collectDust()).
+static constexpr double K = 50.0;
+
+}
+
+namespace qc
+{
+
+namespace SystemGenerator
+{
+
+//----------------------------------------------------------------------------
+LaneAccretor::LaneAccretor()
+    : generator(LaneCount)
+    , system(LaneCount)
+{
+    for (uint32_t l = 0; l < LaneCount; ++l)
+    {
+        sma[l] = eccentricity[l] = mass[l] = dustMass[l] = gasMass[l] = 0.0;
+        criticalMass[l] = dustDensity[l] = areaScale[l] = 0.0;
+        addedMass[l] = addedDustMass[l] = addedGasMass[l] = 0.0;
+        rInner[l] = rOuter[l] = 0.0;
+        sweeping[l] = false;
+
+        bandCount[l] = 0u;
+
+        nextProtoplanetSeed[l] = 0u;
+        systemIndex[l] = 0u;
+        busy[l] = false;
+    }
+}
+
+//----------------------------------------------------------------------------
+bool LaneAccretor::advance(uint32_t lane)
+{
+    Generator& g = generator[lane];
+
+    for (;;)
+    {
+        if (!busy[lane])
+        {
+            if (nextSystem >= settings->systemCount)
+            {
+                return false;
+            }
+
+            systemIndex[lane] = nextSystem++;
+            system[lane].add(settings->star);
+            g.seed(settings->firstSeed + systemIndex[lane]);
+
+            protoplanetSeeds[lane].clear();
+            g.beginAccretion(system[lane], config, protoplanetSeeds[lane]);
+            nextProtoplanetSeed[lane] = 0u;
+            scatterBands(lane);
+
+            busy[lane] = true;
+        }
+
+        // Apply the seeds while dust remains, then consume the remaining dust, as Generator::accrete() does.
+        while (nextProtoplanetSeed[lane] < protoplanetSeeds[lane].size())
+        {
+            const ProtoplanetSeed& s = protoplanetSeeds[lane][nextProtoplanetSeed[lane]++];
+            if (s.semiMajorAxis >= g.protoplanetZone.first && s.semiMajorAxis <= g.protoplanetZone.second && g.dustRemains)
+            {
+                loadProtoplanet(lane, s.semiMajorAxis, s.eccentricity, g.config->protoplanetSeedMass, g.config->protoplanetSeedMass, 0.0);
+                return true;
+            }
+        }
+
+        if (g.dustRemains)
+        {
+            const double protoplanetSma = g.randomUniform(g.protoplanetZone.first, g.protoplanetZone.second);
+            const float protoplanetEccentricity = g.randomEccentricity();
+            loadProtoplanet(lane, protoplanetSma, protoplanetEccentricity, g.config->protoplanetSeedMass, g.config->protoplanetSeedMass, 0.0);
+            return true;
+        }
+
+        // The system is complete.
+        g.finishAccretion(system[lane]);
+        system[lane].evaluate(g);
+
+        (*callback)(0u, settings->firstSeed + systemIndex[lane], systemIndex[lane], system[lane], g);
+
+        busy[lane] = false;
+    }
+}
+
+//----------------------------------------------------------------------------
+void LaneAccretor::finishProtoplanet(uint32_t lane)
+{
+    Generator& g = generator[lane];
+
+    Generator::Protoplanet protoplanet;
+    protoplanet.sma = sma[lane];
+    protoplanet.eccentricity = static_cast<float>(eccentricity[lane]);
+    protoplanet.mass = mass[lane];
+    protoplanet.dustMass = dustMass[lane];
+    protoplanet.gasMass = gasMass[lane];
+    protoplanet.criticalMass = criticalMass[lane];
+    protoplanet.r_inner = rInner[lane];
+    protoplanet.r_outer = rOuter[lane];
+
+    // If any mass wass was added, add it to the protoplanet and update the dust lanes.
+    if (addedMass[lane] > 0.0)
+    {
+        protoplanet.mass += addedMass[lane];
+        protoplanet.dustMass += addedDustMass[lane];
+        protoplanet.gasMass += addedGasMass[lane];
+
+        const std::pair<double, double> effectLimits = EffectLimits(protoplanet.sma, protoplanet.eccentricity, EffectLimitScalar(protoplanet.mass));
+        protoplanet.r_inner = effectLimits.first;
+        protoplanet.r_outer = effectLimits.second;
+
+        g.updateDustLanes(protoplanet);
+        scatterBands(lane);
+    }
+
+    sweeping[lane] = false;
+
+    if (protoplanet.mass > g.config->protoplanetSeedMass)
+    {
+        ++g.protoPlanetCount;
+
+        Generator::Protoplanet newProtoplanet;
+        const Generator::Collision collision = g.collidePlanetisimals(protoplanet, newProtoplanet);
+        if (collision == Generator::Collision::Merged)
+        {
+            // Keep sweeping with the merged body.
+            loadProtoplanet(lane, newProtoplanet.sma, newProtoplanet.eccentricity, newProtoplanet.mass, newProtoplanet.dustMass, newProtoplanet.gasMass);
+        }
+        else if (collision == Generator::Collision::None)
+        {
+            g.addPlanet(protoplanet);
+        }
+    }
+}
+
+//----------------------------------------------------------------------------
+void LaneAccretor::loadProtoplanet(uint32_t lane, double sma_, float eccentricity_, double mass_, double dustMass_, double gasMass_)
+{
+    const Generator& g = generator[lane];
+
+    sma[lane] = sma_;
+    eccentricity[lane] = eccentricity_;
+    mass[lane] = mass_;
+    dustMass[lane] = dustMass_;
+    gasMass[lane] = gasMass_;
+    criticalMass[lane] = ScaledCriticalLimit(sma_, eccentricity_, g.criticalLimitScalar);
+    dustDensity[lane] = ScaledDustDensity(sma_, g.dustDensityScalar);
+    areaScale[lane] = 4.0 * PI * pow(sma_, 2.0);
+    addedMass[lane] = addedDustMass[lane] = addedGasMass[lane] = 0.0;
+
+    sweeping[lane] = true;
+}
+
+//----------------------------------------------------------------------------
+void LaneAccretor::run(const Config& config_, const BatchSettings& settings_, const BatchGenerator::SystemCallback& callback_)
+{
+    stepCount = laneStepCount = 0u;
+
+    config.prepare(config_, settings_.star);
+
+    if (settings_.useGenerate2)
+    {
+        Generator& g = generator[0];
+        SolarSystem& s = system[0];
+        for (uint64_t i = 0; i < settings_.systemCount; ++i)
+        {
+            s.add(settings_.star);
+            g.seed(settings_.firstSeed + i);
+            g.generate2(s, config);
+
+            callback_(0u, settings_.firstSeed + i, i, s, g);
+        }
+        return;
+    }
+
+    settings = &settings_;
+    callback = &callback_;
+    nextSystem = 0u;
+
+    for (uint32_t l = 0; l < LaneCount; ++l)
+    {
+        sweeping[l] = false;
+        busy[l] = false;
+    }
+
+    for (;;)
+    {
+        bool anySweeping = false;
+        for (uint32_t l = 0; l < LaneCount; ++l)
+        {
+            if (!sweeping[l])
+            {
+                advance(l);
+            }
+            anySweeping = anySweeping || sweeping[l];
+        }
+
+        if (!anySweeping)
+        {
+            break;
+        }
+
+        sweep();
+    }
+
+    settings = nullptr;
+    callback = nullptr;
+}
+
+//----------------------------------------------------------------------------
+void LaneAccretor::scatterBands(uint32_t lane)
+{
+    const Generator::AvailableDust& dust = generator[lane].availableDust;
+    const uint32_t count = static_cast<uint32_t>(std::distance(dust.begin(), dust.end()));
+
+    if (count > bandCapacity)
+    {
+        const uint32_t capacity = std::max(std::max(count, bandCapacity * 2u), MinimumBandCapacity);
+
+        bandInner.resize(capacity * LaneCount, EmptyBandEdge);
+        bandOuter.resize(capacity * LaneCount, EmptyBandEdge);
+        bandDust.resize(capacity * LaneCount, 0.0);
+        bandGas.resize(capacity * LaneCount, 0.0);
+        bandCapacity = capacity;
+    }
+
+    uint32_t row = 0u;
+    for (const auto& d : dust)
+    {
+        const size_t i = row * LaneCount + lane;
+        bandInner[i] = d.innerEdge;
+        bandOuter[i] = d.outerEdge;
+        bandDust[i] = d.dustPresent ? 1.0 : 0.0;
+        bandGas[i] = d.gasPresent ? 1.0 : 0.0;
+        ++row;
+    }
+
+    // Clear the rows the lane no longer uses.
+    for (; row < bandCount[lane]; ++row)
+    {
+        const size_t i = row * LaneCount + lane;
+        bandInner[i] = bandOuter[i] = EmptyBandEdge;
+        bandDust[i] = bandGas[i] = 0.0;
+    }
+
+    bandCount[lane] = count;
+}
+
+//----------------------------------------------------------------------------
+void LaneAccretor::sweep()
+{
+    // Per-lane setup.  pow() and sqrt() are evaluated per lane, so they round exactly as they do in
+    // Generator::collectDust().  Lanes that aren't sweeping get effect limits that miss every band.
+    double effectLimitScalar[LaneCount];
+    double inner[LaneCount];
+    double outer[LaneCount];
+    double bandWidth[LaneCount];
+    double gasMassDensity[LaneCount];
+    double gasDensity[LaneCount];
+    bool accretesGas[LaneCount];
+
+    bandRows = 0u;
+    for (uint32_t l = 0; l < LaneCount; ++l)
+    {
+        if (sweeping[l])
+        {
+            const double lastMass = mass[l] + addedMass[l];
+
+            effectLimitScalar[l] = EffectLimitScalar(lastMass);
+            const std::pair<double, double> effectLimits = EffectLimits(sma[l], eccentricity[l], effectLimitScalar[l]);
+            inner[l] = effectLimits.first;
+            outer[l] = effectLimits.second;
+            bandWidth[l] = outer[l] - inner[l];
+
+            accretesGas[l] = !(lastMass < criticalMass[l]);
+            if (accretesGas[l])
+            {
+                gasMassDensity[l] = K * dustDensity[l] / (1.0 + sqrt(criticalMass[l] / lastMass) * (K - 1.0));
+                gasDensity[l] = gasMassDensity[l] - dustDensity[l];
+            }
+            else
+            {
+                gasMassDensity[l] = gasDensity[l] = 0.0;
+            }
+
+            bandRows = std::max(bandRows, bandCount[l]);
+        }
+        else
+        {
+            effectLimitScalar[l] = 0.0;
+            inner[l] = outer[l] = 0.0;
+            bandWidth[l] = 1.0;
+            accretesGas[l] = false;
+            gasMassDensity[l] = gasDensity[l] = 0.0;
+        }
+    }
+
+    // collectDust() adds each band's mass to the sum of the bands after it, so walk the bands from the
+    // last one to the first to add in the same order.
+    double sumMass[LaneCount] = {};
+    double sumDust[LaneCount] = {};
+    double sumGas[LaneCount] = {};
+
+    for (uint32_t row = bandRows; row-- > 0u; )
+    {
+        const double* __restrict bandInnerRow = &bandInner[row * LaneCount];
+        const double* __restrict bandOuterRow = &bandOuter[row * LaneCount];
+        const double* __restrict bandDustRow = &bandDust[row * LaneCount];
+        const double* __restrict bandGasRow = &bandGas[row * LaneCount];
+
+        for (uint32_t l = 0; l < LaneCount; ++l)
+        {
+            const bool inRange = !(bandOuterRow[l] <= inner[l] || bandInnerRow[l] >= outer[l]);
+            const bool hasDust = (bandDustRow[l] != 0.0);
+            const bool hasGas = accretesGas[l] && (bandGasRow[l] != 0.0);
+
+            const double massDensity = hasDust ? (hasGas ? gasMassDensity[l] : dustDensity[l]) : 0.0;
+            const double bandGasDensity = (hasDust && hasGas) ? gasDensity[l] : 0.0;
+
+            const double outerOverlap = outer[l] - bandOuterRow[l];
+            const double outerTemp = (outerOverlap > 0.0) ? outerOverlap : 0.0;
+            const double innerOverlap = bandInnerRow[l] - inner[l];
+            const double innerTemp = (innerOverlap > 0.0) ? innerOverlap : 0.0;
+
+            const double width = (bandWidth[l] - outerTemp) - innerTemp;
+            const double area = areaScale[l] * effectLimitScalar[l] * (1.0 - eccentricity[l] * (outerTemp - innerTemp) / bandWidth[l]);
+            const double volume = area * width;
+
+            const double newMass = volume * massDensity;
+            const double newGas = volume * bandGasDensity;
+            const double newDust = newMass - newGas;
+
+            sumMass[l] = inRange ? (newMass + sumMass[l]) : sumMass[l];
+            sumDust[l] = inRange ? (newDust + sumDust[l]) : sumDust[l];
+            sumGas[l] = inRange ? (newGas + sumGas[l]) : sumGas[l];
+        }
+    }
+
+    ++stepCount;
+
+    for (uint32_t l = 0; l < LaneCount; ++l)
+    {
+        if (sweeping[l])
+        {
+            ++laneStepCount;
+
+            const double oldMass = addedMass[l];
+            addedMass[l] = sumMass[l];
+            addedDustMass[l] = sumDust[l];
+            addedGasMass[l] = sumGas[l];
+            rInner[l] = inner[l];
+            rOuter[l] = outer[l];
+
+            // Keep sweeping until we're not adding much per iteration.
+            if (!(addedMass[l] > 0.0 && (addedMass[l] - oldMass) >= 0.0001 * oldMass))
+            {
+                finishProtoplanet(l);
+            }
+        }
+    }
+}
+
+}
+}
@@ -0,0 +1,510 @@
+/*****************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Questionable Coding
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************/
+#include <qcSysGen/Metrics.h>
+
+#include <algorithm>
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#if !defined(_WIN32)
+#include <errno.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Returns the bit pattern of a double.
+uint64_t DoubleToBits(double v)
+{
+    uint64_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    return bits;
+}
+
+//----------------------------------------------------------------------------
+// Returns the double with the given bit pattern.
+double BitsToDouble(uint64_t bits)
+{
+    double v;
+    memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+//----------------------------------------------------------------------------
+// Add to a double stored as bits.
+void AddDouble(std::atomic<uint64_t>& bits, double delta)
+{
+    uint64_t current = bits.load(std::memory_order_relaxed);
+    while (!bits.compare_exchange_weak(current, DoubleToBits(BitsToDouble(current) + delta), std::memory_order_relaxed))
+    {
+    }
+}
+
+//----------------------------------------------------------------------------
+// Append a value in the Prometheus text format.
+void AppendValue(std::string& out, double v)
+{
+    if (isnan(v))
+    {
+        out.append("NaN");
+    }
+    else if (isinf(v))
+    {
+        out.append((v > 0.0) ? "+Inf" : "-Inf");
+    }
+    else
+    {
+        char text[32];
+        snprintf(text, sizeof(text), "%.17g", v);
+        out.append(text);
+    }
+}
+
+//----------------------------------------------------------------------------
+// Append an integer value.
+void AppendValue(std::string& out, uint64_t v)
+{
+    char text[24];
+    snprintf(text, sizeof(text), "%llu", static_cast<unsigned long long>(v));
+    out.append(text);
+}
+
+//----------------------------------------------------------------------------
+// Append `name{labels}` (or `name` without labels) and a space.
+void AppendSeries(std::string& out, const std::string& name, const char* suffix, const std::string& labels, const char* extraLabel = nullptr)
+{
+    out.append(name);
+    out.append(suffix);
+    if (!labels.empty() || extraLabel)
+    {
+        out.push_back('{');
+        out.append(labels);
+        if (extraLabel)
+        {
+            if (!labels.empty())
+            {
+                out.push_back(',');
+            }
+            out.append(extraLabel);
+        }
+        out.push_back('}');
+    }
+    out.push_back(' ');
+}
+
+#if !defined(_WIN32)
+//----------------------------------------------------------------------------
+// Write all of a buffer to a socket.
+bool SendAll(int fd, const char* data, size_t size)
+{
+    while (size > 0u)
+    {
+        const ssize_t sent = send(fd, data, size, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (sent <= 0)
+        {
+            return false;
+        }
+        data += sent;
+        size -= static_cast<size_t>(sent);
+    }
+
+    return true;
+}
+#endif
+
+}
+
+namespace qc
+{
+
+namespace SystemGenerator
+{
+
+//----------------------------------------------------------------------------
+void MetricCounter::writeSamples(std::string& out) const
+{
+    AppendSeries(out, name, "", labels);
+    AppendValue(out, get());
+    out.push_back('\n');
+}
+
+//----------------------------------------------------------------------------
+void MetricGauge::add(double delta)
+{
+    AddDouble(bits, delta);
+}
+
+//----------------------------------------------------------------------------
+double MetricGauge::get() const
+{
+    return BitsToDouble(bits.load(std::memory_order_relaxed));
+}
+
+//----------------------------------------------------------------------------
+void MetricGauge::set(double v)
+{
+    bits.store(DoubleToBits(v), std::memory_order_relaxed);
+}
+
+//----------------------------------------------------------------------------
+void MetricGauge::writeSamples(std::string& out) const
+{
+    AppendSeries(out, name, "", labels);
+    AppendValue(out, get());
+    out.push_back('\n');
+}
+
+//----------------------------------------------------------------------------
+MetricHistogram::MetricHistogram(const char* name_, const char* help_, const char* labels_, const std::vector<double>& bounds_)
+    : Metric(name_, help_, labels_)
+    , bounds(bounds_)
+    , bucket(new std::atomic<uint64_t>[bounds_.size() + 1u])
+{
+    assert(std::is_sorted(bounds.begin(), bounds.end()));
+
+    for (size_t i = 0; i <= bounds.size(); ++i)
+    {
+        bucket[i].store(0u, std::memory_order_relaxed);
+    }
+}
+
+//----------------------------------------------------------------------------
+uint64_t MetricHistogram::getCount() const
+{
+    uint64_t count = 0u;
+    for (size_t i = 0; i <= bounds.size(); ++i)
+    {
+        count += bucket[i].load(std::memory_order_relaxed);
+    }
+
+    return count;
+}
+
+//----------------------------------------------------------------------------
+double MetricHistogram::getSum() const
+{
+    return BitsToDouble(sumBits.load(std::memory_order_relaxed));
+}
+
+//----------------------------------------------------------------------------
+void MetricHistogram::observe(double v)
+{
+    // Buckets are inclusive of their upper bound.
+    const size_t idx = static_cast<size_t>(std::lower_bound(bounds.begin(), bounds.end(), v) - bounds.begin());
+    bucket[idx].fetch_add(1u, std::memory_order_relaxed);
+    AddDouble(sumBits, v);
+}
+
+//----------------------------------------------------------------------------
+void MetricHistogram::writeSamples(std::string& out) const
+{
+    uint64_t cumulative = 0u;
+    for (size_t i = 0; i <= bounds.size(); ++i)
+    {
+        cumulative += bucket[i].load(std::memory_order_relaxed);
+
+        std::string le("le=\"");
+        if (i < bounds.size())
+        {
+            AppendValue(le, bounds[i]);
+        }
+        else
+        {
+            le.append("+Inf");
+        }
+        le.push_back('"');
+
+        AppendSeries(out, name, "_bucket", labels, le.c_str());
+        AppendValue(out, cumulative);
+        out.push_back('\n');
+    }
+
+    AppendSeries(out, name, "_sum", labels);
+    AppendValue(out, getSum());
+    out.push_back('\n');
+
+    // The count is the +Inf bucket, so the two always agree.
+    AppendSeries(out, name, "_count", labels);
+    AppendValue(out, cumulative);
+    out.push_back('\n');
+}
+
+//----------------------------------------------------------------------------
+std::vector<double> ExponentialBuckets(double start, double factor, uint32_t count)
+{
+    assert(start > 0.0 && factor > 1.0);
+
+    std::vector<double> bounds(count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        bounds[i] = start;
+        start *= factor;
+    }
+
+    return bounds;
+}
+
+//----------------------------------------------------------------------------
+std::vector<double> LinearBuckets(double start, double width, uint32_t count)
+{
+    assert(width > 0.0);
+
+    std::vector<double> bounds(count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        bounds[i] = start + width * i;
+    }
+
+    return bounds;
+}
+
+//----------------------------------------------------------------------------
+void MetricsRegistry::add(Metric* metric)
+{
+    std::lock_guard<std::mutex> guard(mutex);
+
+    for (const auto& m : metrics)
+    {
+        // Series of one name must share a type.
+        assert(m->getName() != metric->getName() || !strcmp(m->getTypeName(), metric->getTypeName()));
+        (void)m;
+    }
+
+    metrics.emplace_back(metric);
+}
+
+//----------------------------------------------------------------------------
+MetricCounter& MetricsRegistry::addCounter(const char* name, const char* help, const char* labels)
+{
+    MetricCounter* counter = new MetricCounter(name, help, labels);
+    add(counter);
+
+    return *counter;
+}
+
+//----------------------------------------------------------------------------
+MetricGauge& MetricsRegistry::addGauge(const char* name, const char* help, const char* labels)
+{
+    MetricGauge* gauge = new MetricGauge(name, help, labels);
+    add(gauge);
+
+    return *gauge;
+}
+
+//----------------------------------------------------------------------------
+MetricHistogram& MetricsRegistry::addHistogram(const char* name, const char* help, const std::vector<double>& bounds, const char* labels)
+{
+    MetricHistogram* histogram = new MetricHistogram(name, help, labels, bounds);
+    add(histogram);
+
+    return *histogram;
+}
+
+//----------------------------------------------------------------------------
+bool MetricsRegistry::serve(const char* path)
+{
+    stopServing();
+
+#if defined(_WIN32)
+    (void)path;
+    return false;
+#else
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(address.sun_path))
+    {
+        return false;
+    }
+    strcpy(address.sun_path, path);
+
+    const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    unlink(path);
+    if (bind(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || listen(fd, 16) != 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    listenSocket = fd;
+    socketPath = path;
+
+    server = std::thread([this, fd]()
+    {
+        std::string body;
+        std::string response;
+        for (;;)
+        {
+            const int client = accept4(fd, nullptr, nullptr, SOCK_CLOEXEC);
+            if (client < 0)
+            {
+                if (errno == EINTR || errno == ECONNABORTED)
+                {
+                    continue;
+                }
+                // stopServing() shut the socket down.
+                break;
+            }
+
+            // Consume the request, if the client sends one, so closing the connection doesn't reset it.
+            pollfd p = { client, POLLIN, 0 };
+            if (poll(&p, 1, 100) > 0)
+            {
+                char request[4096];
+                (void)recv(client, request, sizeof(request), MSG_DONTWAIT);
+            }
+
+            body.clear();
+            write(body);
+
+            char header[128];
+            snprintf(header, sizeof(header), "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: %zu\r\n\r\n", body.size());
+            response.assign(header);
+            response.append(body);
+            SendAll(client, response.data(), response.size());
+
+            ::close(client);
+        }
+    });
+
+    return true;
+#endif
+}
+
+//----------------------------------------------------------------------------
+void MetricsRegistry::stopServing()
+{
+#if !defined(_WIN32)
+    if (listenSocket >= 0)
+    {
+        shutdown(listenSocket, SHUT_RDWR);
+        if (server.joinable())
+        {
+            server.join();
+        }
+        ::close(listenSocket);
+        unlink(socketPath.c_str());
+
+        listenSocket = -1;
+        socketPath.clear();
+    }
+#endif
+}
+
+//----------------------------------------------------------------------------
+void MetricsRegistry::write(std::string& out) const
+{
+    std::lock_guard<std::mutex> guard(mutex);
+
+    // Metrics sharing a name are written together, in the order the name first appears.
+    std::vector<bool> written(metrics.size(), false);
+    for (size_t i = 0; i < metrics.size(); ++i)
+    {
+        if (written[i])
+        {
+            continue;
+        }
+
+        const Metric& first = *metrics[i];
+        out.append("# HELP ").append(first.getName()).push_back(' ');
+        out.append(first.getHelp()).push_back('\n');
+        out.append("# TYPE ").append(first.getName()).push_back(' ');
+        out.append(first.getTypeName()).push_back('\n');
+
+        for (size_t j = i; j < metrics.size(); ++j)
+        {
+            if (!written[j] && metrics[j]->getName() == first.getName())
+            {
+                metrics[j]->writeSamples(out);
+                written[j] = true;
+            }
+        }
+    }
+}
+
+//----------------------------------------------------------------------------
+bool MetricsRegistry::writeFile(const char* path) const
+{
+    std::string text;
+    write(text);
+
+    const std::string temporary = std::string(path) + ".tmp";
+    FILE* fp = nullptr;
+    if (fopen_s(&fp, temporary.c_str(), "wb") || !fp)
+    {
+        return false;
+    }
+
+    const bool written = fwrite(text.data(), 1u, text.size(), fp) == text.size();
+    if (fclose(fp) != 0 || !written)
+    {
+        remove(temporary.c_str());
+        return false;
+    }
+
+#if defined(_WIN32)
+    // rename() does not replace an existing file on Windows.
+    remove(path);
+#endif
+    return rename(temporary.c_str(), path) == 0;
+}
+
+//----------------------------------------------------------------------------
+GenerationMetrics::GenerationMetrics(MetricsRegistry& registry, const char* prefix)
+    : systemsGenerated(registry.addCounter((std::string(prefix) + "_systems_generated_total").c_str(), "Systems generated and evaluated."))
+    , systemsDiscarded(registry.addCounter((std::string(prefix) + "_systems_discarded_total").c_str(), "Systems discarded by a filter before evaluation."))
+    , systemsCancelled(registry.addCounter((std::string(prefix) + "_systems_cancelled_total").c_str(), "Systems not generated because their batch was cancelled."))
+    , accretionSeconds(registry.addHistogram((std::string(prefix) + "_phase_seconds").c_str(), "Time spent per system in each phase.",
+                                             ExponentialBuckets(1.0e-5, 2.0, 16), "phase=\"accretion\""))
+    , evaluationSeconds(registry.addHistogram((std::string(prefix) + "_phase_seconds").c_str(), "Time spent per system in each phase.",
+                                              ExponentialBuckets(1.0e-5, 2.0, 16), "phase=\"evaluation\""))
+    , planetsPerSystem(registry.addHistogram((std::string(prefix) + "_planets_per_system").c_str(), "Planets per generated system.",
+                                             LinearBuckets(0.0, 2.0, 16)))
+    , queueDepth(registry.addGauge((std::string(prefix) + "_queue_depth").c_str(), "Systems of the running batches not yet claimed by a worker."))
+    , cacheHits(registry.addCounter((std::string(prefix) + "_cache_hits_total").c_str(), "Generation cache lookups that hit."))
+    , cacheMisses(registry.addCounter((std::string(prefix) + "_cache_misses_total").c_str(), "Generation cache lookups that missed."))
+    , cacheBytes(registry.addGauge((std::string(prefix) + "_cache_bytes").c_str(), "Size of the live entries of the generation cache."))
+    , cacheEntries(registry.addGauge((std::string(prefix) + "_cache_entries").c_str(), "Live entries of the generation cache."))
+{
+}
+
+}
+}
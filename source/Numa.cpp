@@ -0,0 +1,191 @@
+/*****************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Questionable Coding
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************/
+#include <qcSysGen/Numa.h>
+
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace
+{
+
+#if !defined(_WIN32)
+//----------------------------------------------------------------------------
+// Parse a Linux cpulist ("0-3,8,10-11").
+void ParseCpuList(const char* text, std::vector<uint32_t>& processor)
+{
+    while (*text)
+    {
+        char* end;
+        const unsigned long first = strtoul(text, &end, 10);
+        if (end == text)
+        {
+            break;
+        }
+        unsigned long last = first;
+        text = end;
+        if (*text == '-')
+        {
+            last = strtoul(text + 1, &end, 10);
+            text = end;
+        }
+        for (unsigned long cpu = first; cpu <= last; ++cpu)
+        {
+            processor.emplace_back(static_cast<uint32_t>(cpu));
+        }
+        if (*text == ',')
+        {
+            ++text;
+        }
+        else
+        {
+            break;
+        }
+    }
+}
+#endif
+
+}
+
+namespace qc
+{
+
+namespace SystemGenerator
+{
+
+//----------------------------------------------------------------------------
+std::vector<NumaNode> GetNumaTopology()
+{
+    std::vector<NumaNode> nodes;
+
+#if defined(_WIN32)
+    ULONG highest = 0;
+    if (GetNumaHighestNodeNumber(&highest))
+    {
+        for (ULONG n = 0; n <= highest; ++n)
+        {
+            GROUP_AFFINITY affinity;
+            if (!GetNumaNodeProcessorMaskEx(static_cast<USHORT>(n), &affinity) || affinity.Mask == 0)
+            {
+                continue;
+            }
+
+            NumaNode node;
+            node.id = n;
+            node.group = affinity.Group;
+            for (uint32_t p = 0; p < sizeof(KAFFINITY) * 8u; ++p)
+            {
+                if (affinity.Mask & (static_cast<KAFFINITY>(1) << p))
+                {
+                    node.processor.emplace_back(p);
+                }
+            }
+            nodes.emplace_back(node);
+        }
+    }
+#else
+    // Nodes may be sparsely numbered, so probe a generous range.
+    for (uint32_t n = 0; n < 1024u; ++n)
+    {
+        char path[96];
+        sprintf_s(path, "/sys/devices/system/node/node%u/cpulist", n);
+
+        FILE* fp = nullptr;
+        if (fopen_s(&fp, path, "rt"))
+        {
+            continue;
+        }
+
+        char text[4096];
+        NumaNode node;
+        node.id = n;
+        node.group = 0u;
+        if (fgets(text, sizeof(text), fp))
+        {
+            ParseCpuList(text, node.processor);
+        }
+        fclose(fp);
+
+        if (!node.processor.empty())
+        {
+            nodes.emplace_back(node);
+        }
+    }
+#endif
+
+    if (nodes.empty())
+    {
+        NumaNode node;
+        node.id = 0u;
+        node.group = 0u;
+        const uint32_t count = std::max(1u, std::thread::hardware_concurrency());
+        for (uint32_t p = 0; p < count; ++p)
+        {
+            node.processor.emplace_back(p);
+        }
+        nodes.emplace_back(node);
+    }
+
+    return nodes;
+}
+
+//----------------------------------------------------------------------------
+bool PinThreadToNode(const NumaNode& node)
+{
+#if defined(_WIN32)
+    GROUP_AFFINITY affinity = {};
+    affinity.Group = node.group;
+    for (uint32_t p : node.processor)
+    {
+        affinity.Mask |= static_cast<KAFFINITY>(1) << p;
+    }
+
+    return SetThreadGroupAffinity(GetCurrentThread(), &affinity, nullptr) != 0;
+#else
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (uint32_t p : node.processor)
+    {
+        if (p < CPU_SETSIZE)
+        {
+            CPU_SET(p, &set);
+        }
+    }
+
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#endif
+}
+
+}
+}
@@ -0,0 +1,372 @@
+/*****************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Questionable Coding
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************/
+#include <qcSysGen/PhaseCounters.h>
+
+#include <assert.h>
+#include <atomic>
+#include <string.h>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+
+/// @brief The function returning the calling thread's allocation count, if installed.
+std::atomic<qc::SystemGenerator::PhaseCounters::AllocationCounter> allocationCounter(nullptr);
+
+/// @brief Index of PhaseCounter::Allocations, the only counter that is not a hardware event.
+static constexpr uint32_t AllocationsIndex = static_cast<uint32_t>(qc::SystemGenerator::PhaseCounter::Allocations);
+
+#if defined(__linux__)
+/// @brief The perf_event hardware event of each PhaseCounter before Allocations.
+static const uint64_t HardwareEvents[AllocationsIndex] =
+{
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES,
+};
+#endif
+
+//----------------------------------------------------------------------------
+// Print `value / divisor`, or a dash when it is not available.
+void PrintRatio(FILE* fp, bool available, double value, double divisor, double scale)
+{
+    if (available && divisor > 0.0)
+    {
+        fprintf(fp, " %10.3f", value / divisor * scale);
+    }
+    else
+    {
+        fprintf(fp, " %10s", "-");
+    }
+}
+
+//----------------------------------------------------------------------------
+// Print a count, or a dash when it is not available.
+void PrintCount(FILE* fp, bool available, uint64_t value)
+{
+    if (available)
+    {
+        fprintf(fp, " %14llu", static_cast<unsigned long long>(value));
+    }
+    else
+    {
+        fprintf(fp, " %14s", "-");
+    }
+}
+
+}
+
+namespace qc
+{
+
+namespace SystemGenerator
+{
+
+//----------------------------------------------------------------------------
+const char* GenerationPhaseName(GenerationPhase phase)
+{
+    static const char* Names[GenerationPhaseCount] =
+    {
+        "Star",
+        "Seeds",
+        "Accretion",
+        "Coalescence",
+        "Planet",
+        "SurfaceConditions",
+        "Gases",
+    };
+
+    const uint32_t p = static_cast<uint32_t>(phase);
+    return (p < GenerationPhaseCount) ? Names[p] : "Unknown";
+}
+
+//----------------------------------------------------------------------------
+const char* PhaseCounterName(PhaseCounter counter)
+{
+    static const char* Names[PhaseCounterCount] =
+    {
+        "Cycles",
+        "Instructions",
+        "CacheMisses",
+        "BranchMisses",
+        "Allocations",
+    };
+
+    const uint32_t c = static_cast<uint32_t>(counter);
+    return (c < PhaseCounterCount) ? Names[c] : "Unknown";
+}
+
+//----------------------------------------------------------------------------
+PhaseCounters::PhaseCounters()
+    : groupFd(-1)
+    , openCount(0u)
+    , countedMask(0u)
+{
+    for (uint32_t i = 0; i < PhaseCounterCount; ++i)
+    {
+        eventFd[i] = -1;
+        eventSlot[i] = 0u;
+    }
+    reset();
+}
+
+//----------------------------------------------------------------------------
+void PhaseCounters::close()
+{
+#if defined(__linux__)
+    for (uint32_t i = 0; i < PhaseCounterCount; ++i)
+    {
+        if (eventFd[i] >= 0)
+        {
+            ::close(eventFd[i]);
+        }
+    }
+#endif
+
+    for (uint32_t i = 0; i < PhaseCounterCount; ++i)
+    {
+        eventFd[i] = -1;
+    }
+    groupFd = -1;
+    openCount = 0u;
+}
+
+//----------------------------------------------------------------------------
+void PhaseCounters::enter(GenerationPhase phase)
+{
+    sample();
+
+    ++entries[static_cast<uint32_t>(phase)];
+    stack.push_back(phase);
+}
+
+//----------------------------------------------------------------------------
+bool PhaseCounters::isCounting(PhaseCounter counter) const
+{
+    return (countedMask & (1u << static_cast<uint32_t>(counter))) != 0u;
+}
+
+//----------------------------------------------------------------------------
+void PhaseCounters::leave()
+{
+    assert(!stack.empty());
+
+    sample();
+
+    stack.pop_back();
+}
+
+//----------------------------------------------------------------------------
+void PhaseCounters::merge(const PhaseCounters& rhs)
+{
+    for (uint32_t p = 0; p < GenerationPhaseCount; ++p)
+    {
+        for (uint32_t c = 0; c < PhaseCounterCount; ++c)
+        {
+            count[p][c] += rhs.count[p][c];
+        }
+        entries[p] += rhs.entries[p];
+    }
+    countedMask |= rhs.countedMask;
+}
+
+//----------------------------------------------------------------------------
+bool PhaseCounters::open()
+{
+    close();
+
+#if defined(__linux__)
+    for (uint32_t i = 0; i < AllocationsIndex; ++i)
+    {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = HardwareEvents[i];
+        attr.disabled = (groupFd < 0) ? 1u : 0u; // The leader starts the whole group.
+        attr.exclude_kernel = 1u;
+        attr.exclude_hv = 1u;
+        attr.read_format = PERF_FORMAT_GROUP;
+
+        // Not every PMU has every event, so the group is made of whichever events open.
+        const int fd = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, groupFd, PERF_FLAG_FD_CLOEXEC));
+        if (fd < 0)
+        {
+            continue;
+        }
+
+        if (groupFd < 0)
+        {
+            groupFd = fd;
+        }
+        eventFd[i] = fd;
+        eventSlot[i] = openCount++;
+        countedMask |= 1u << i;
+    }
+
+    if (groupFd >= 0)
+    {
+        ioctl(groupFd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(groupFd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+#endif
+
+    // Start from the current values, without attributing them to any phase.
+    std::vector<GenerationPhase> entered;
+    entered.swap(stack);
+    sample();
+    entered.swap(stack);
+
+    return openCount > 0u;
+}
+
+//----------------------------------------------------------------------------
+void PhaseCounters::report(FILE* fp) const
+{
+    uint64_t total[PhaseCounterCount] = { };
+    for (uint32_t p = 0; p < GenerationPhaseCount; ++p)
+    {
+        for (uint32_t c = 0; c < PhaseCounterCount; ++c)
+        {
+            total[c] += count[p][c];
+        }
+    }
+
+    const bool cycles = isCounting(PhaseCounter::Cycles);
+    const bool instructions = isCounting(PhaseCounter::Instructions);
+    const bool cacheMisses = isCounting(PhaseCounter::CacheMisses);
+    const bool branchMisses = isCounting(PhaseCounter::BranchMisses);
+    const bool allocations = isCounting(PhaseCounter::Allocations);
+
+    fprintf(fp, "%-18s %12s %14s %14s %10s %10s %10s %14s %10s\n", "Phase", "Entries", "Cycles", "Instructions",
+            "IPC", "LLC/kInst", "Br/kInst", "Allocations", "Cycles%");
+
+    auto row = [&](const char* name, uint64_t entryCount, const uint64_t* value)
+    {
+        const double inst = static_cast<double>(value[static_cast<uint32_t>(PhaseCounter::Instructions)]);
+
+        fprintf(fp, "%-18s %12llu", name, static_cast<unsigned long long>(entryCount));
+        PrintCount(fp, cycles, value[static_cast<uint32_t>(PhaseCounter::Cycles)]);
+        PrintCount(fp, instructions, value[static_cast<uint32_t>(PhaseCounter::Instructions)]);
+        PrintRatio(fp, cycles && instructions, inst, static_cast<double>(value[static_cast<uint32_t>(PhaseCounter::Cycles)]), 1.0);
+        PrintRatio(fp, cacheMisses && instructions, static_cast<double>(value[static_cast<uint32_t>(PhaseCounter::CacheMisses)]), inst, 1000.0);
+        PrintRatio(fp, branchMisses && instructions, static_cast<double>(value[static_cast<uint32_t>(PhaseCounter::BranchMisses)]), inst, 1000.0);
+        PrintCount(fp, allocations, value[static_cast<uint32_t>(PhaseCounter::Allocations)]);
+        PrintRatio(fp, cycles, static_cast<double>(value[static_cast<uint32_t>(PhaseCounter::Cycles)]),
+                   static_cast<double>(total[static_cast<uint32_t>(PhaseCounter::Cycles)]), 100.0);
+        fputc('\n', fp);
+    };
+
+    uint64_t totalEntries = 0u;
+    for (uint32_t p = 0; p < GenerationPhaseCount; ++p)
+    {
+        row(GenerationPhaseName(GenerationPhase(p)), entries[p], count[p]);
+        totalEntries += entries[p];
+    }
+    row("Total", totalEntries, total);
+
+    if (!cycles && !instructions && !cacheMisses && !branchMisses)
+    {
+        fprintf(fp, "(hardware counters unavailable)\n");
+    }
+}
+
+//----------------------------------------------------------------------------
+void PhaseCounters::reset()
+{
+    memset(last, 0, sizeof(last));
+    memset(count, 0, sizeof(count));
+    memset(entries, 0, sizeof(entries));
+    stack.clear();
+    countedMask = 0u;
+
+    for (uint32_t i = 0; i < AllocationsIndex; ++i)
+    {
+        if (eventFd[i] >= 0)
+        {
+            countedMask |= 1u << i;
+        }
+    }
+    sample();
+}
+
+//----------------------------------------------------------------------------
+void PhaseCounters::sample()
+{
+    uint64_t* phaseCount = (stack.empty()) ? nullptr : count[static_cast<uint32_t>(stack.back())];
+
+#if defined(__linux__)
+    if (groupFd >= 0)
+    {
+        // PERF_FORMAT_GROUP: the number of events, followed by each value in the order the events were opened.
+        uint64_t values[1u + PhaseCounterCount];
+        const ssize_t size = read(groupFd, values, sizeof(values));
+        if (size >= static_cast<ssize_t>(sizeof(uint64_t) * (1u + openCount)))
+        {
+            for (uint32_t i = 0; i < AllocationsIndex; ++i)
+            {
+                if (eventFd[i] >= 0)
+                {
+                    const uint64_t value = values[1u + eventSlot[i]];
+                    if (phaseCount)
+                    {
+                        phaseCount[i] += value - last[i];
+                    }
+                    last[i] = value;
+                }
+            }
+        }
+    }
+#endif
+
+    const AllocationCounter allocations = allocationCounter.load(std::memory_order_relaxed);
+    if (allocations)
+    {
+        // The first sample after the counter is installed only sets the starting point.
+        const uint64_t value = allocations();
+        if (phaseCount && isCounting(PhaseCounter::Allocations))
+        {
+            phaseCount[AllocationsIndex] += value - last[AllocationsIndex];
+        }
+        last[AllocationsIndex] = value;
+        countedMask |= 1u << AllocationsIndex;
+    }
+}
+
+//----------------------------------------------------------------------------
+void PhaseCounters::SetAllocationCounter(AllocationCounter counter)
+{
+    allocationCounter.store(counter, std::memory_order_relaxed);
+}
+
+}
+}
@@ -25,8 +25,10 @@
 #include <qcSysGen/Planet.h>
 
 #include <qcSysGen/Config.h>
+#include <qcSysGen/CostProfiler.h>
 #include <qcSysGen/Equations.h>
 #include <qcSysGen/Generator.h>
+#include <qcSysGen/PhaseCounters.h>
 #include <qcSysGen/Star.h>
 
 #include <assert.h>
@@ -96,6 +98,18 @@ static constexpr double EarthRadiusKm = 6378.0;
 static constexpr float EarthPartialPressureOxygen = qc::SystemGenerator::EarthSurfacePressureMb * 0.2095f;
 
 
+//--- Earth Similarity Index weights, from https://phl.upr.edu/projects/earth-similarity-index-esi
+
+/// @brief ESI weight of the radius term.
+static constexpr float EsiWeight_Radius = 0.57f;
+
+/// @brief ESI weight of the density term.
+static constexpr float EsiWeight_Density = 1.07f;
+
+/// @brief ESI weight of the escape velocity term.
+static constexpr float EsiWeight_EscapeVelocity = 0.70f;
+
+
 //--- Reference Values
 
 /// @brief The freezing point of water at 1 atm, in Kelvin.
@@ -497,6 +511,7 @@ void Planet::calculateDayLength(const EvaluationState& evaluationState)
     }
 
     spinResonanceFactor = 0.0f;
+    resonant = false;
     if (dayLength >= yearHours)
     {
         resonant = true;
@@ -522,19 +537,15 @@ float Planet::calculateEarthSimilarity() const
         return 0.0f;
     }
 
-    // Criteria for earth similarity.  All weights from
-    // https://phl.upr.edu/projects/earth-similarity-index-esi
+    // Criteria for earth similarity.  See the EsiWeight_ constants.
 
     const float NumberOfWeights = (!atmosphere.empty()) ? 5.0f : 4.0f;
 
-    static constexpr float RadiusWeight = 0.57f;
-    const float radiusRating = powf(1.0f - static_cast<float>(fabs(radius - EarthRadiusKm) / (radius + EarthRadiusKm)), RadiusWeight / NumberOfWeights);
+    const float radiusRating = powf(1.0f - static_cast<float>(fabs(radius - EarthRadiusKm) / (radius + EarthRadiusKm)), EsiWeight_Radius / NumberOfWeights);
 
-    static constexpr float DensityWeight = 1.07f;
-    const float densityRating = powf(1.0f - static_cast<float>(fabs(density - EarthDensity) / (density + EarthDensity)), DensityWeight / NumberOfWeights);
+    const float densityRating = powf(1.0f - static_cast<float>(fabs(density - EarthDensity) / (density + EarthDensity)), EsiWeight_Density / NumberOfWeights);
 
-    static constexpr float EvWeight = 0.70f;
-    const float escapeVelocityRating = powf(1.0f - fabsf(escapeVelocity - EarthEscapeVelocity) / (escapeVelocity + EarthEscapeVelocity), EvWeight / NumberOfWeights);
+    const float escapeVelocityRating = powf(1.0f - fabsf(escapeVelocity - EarthEscapeVelocity) / (escapeVelocity + EarthEscapeVelocity), EsiWeight_EscapeVelocity / NumberOfWeights);
 
     static constexpr float TemperatureWeight = 5.58f;
     const float surfaceTempRating = powf(1.0f - fabsf(meanSurfaceTemperature - EarthAverageTemperature) / (meanSurfaceTemperature + EarthAverageTemperature), TemperatureWeight / NumberOfWeights);
@@ -666,6 +677,8 @@ void Planet::evaluate(Generator& generator, const Star& star)
     }
 #endif
 
+    PhaseScope phase(generator.getPhaseCounters(), GenerationPhase::Planet);
+
     EvaluationState evaluationState;
     evaluationState.ecosphereRatio = semimajorAxis / star.getEcosphere();
     evaluationState.stellarMass = star.getMass();
@@ -834,7 +847,6 @@ void Planet::evaluate(Generator& generator, const Star& star)
         // Categorize the type of gaseous planet.  Cutoffs from
         // Chen, et al. 2017:
         const double jovianMass = totalMass * SolarMassToJovianMass;
-        const double earthMass = totalMass * SolarMassToEarthMass;
         if (jovianMass > BrownDwarfTransition)
         {
             type = PlanetType::BrownDwarf;
@@ -856,7 +868,7 @@ void Planet::evaluate(Generator& generator, const Star& star)
             {
                 printf(" ... Planet is a %s (MJ = %lf; ME = %lf).\n",
                        (jovianMass > IceGiantTransition) ? "Gas giant" : "Ice Giant",
-                       jovianMass, earthMass);
+                       jovianMass, totalMass * SolarMassToEarthMass);
             }
 #endif
             // Rocky / Gaseous = 2.04 (+0.66/-0.59)x M(Earth)
@@ -916,6 +928,7 @@ void Planet::evaluate(Generator& generator, const Star& star)
                 printf(" ... Evaluating atmosphere\n");
             }
 #endif
+            PhaseScope gasesPhase(generator.getPhaseCounters(), GenerationPhase::Gases);
             calculateGases(evaluationState);
         }
 
@@ -1116,6 +1129,45 @@ void Planet::exchange(Planet& p)
 }
 #endif
 
+//----------------------------------------------------------------------------
+float Planet::getEarthSimilarityLimit(const Star& star, float densityVariation) const
+{
+    if (totalMass <= 0.0)
+    {
+        return 0.0f;
+    }
+
+    // The largest rating a single ESI term can have when its value is somewhere in [lower, upper].
+    // The exponent uses 5 weights, since that yields the larger rating of the two cases in
+    // calculateEarthSimilarity().
+    auto ratingLimit = [](double lower, double upper, double reference, float weight)
+    {
+        const double closest = Clamp(reference, lower, upper);
+        return powf(1.0f - static_cast<float>(fabs(closest - reference) / (closest + reference)), weight / 5.0f);
+    };
+
+    // Planets heavier than the rocky transition may lose H2 and He during evaluation, but never more than
+    // their gas mass.
+    const double upperMass = totalMass;
+    const double lowerMass = (totalMass > RockyTransition) ? dustMass : totalMass;
+
+    const float materialZone = star.getMaterialZone(semimajorAxis);
+    const double radiusA = KothariRadius(lowerMass, semimajorAxis, false, materialZone);
+    const double radiusB = KothariRadius(upperMass, semimajorAxis, false, materialZone);
+
+    // VaryRadius() scales the density, so the radius scales with the inverse cube root.
+    const double variation = Clamp(double(densityVariation), 0.0, 0.99);
+    const double lowerRadius = std::min(radiusA, radiusB) * pow(1.0 + variation, -1.0 / 3.0);
+    const double upperRadius = std::max(radiusA, radiusB) * pow(1.0 - variation, -1.0 / 3.0);
+
+    const float radiusRating = ratingLimit(lowerRadius, upperRadius, EarthRadiusKm, EsiWeight_Radius);
+    const float densityRating = ratingLimit(VolumeDensity(lowerMass, upperRadius), VolumeDensity(upperMass, lowerRadius), EarthDensity, EsiWeight_Density);
+    const float escapeVelocityRating = ratingLimit(EscapeVelocity(lowerMass, upperRadius), EscapeVelocity(upperMass, lowerRadius), EarthEscapeVelocity, EsiWeight_EscapeVelocity);
+
+    // Pad the result slightly so float rounding in evaluate() can not push the real ESI above the limit.
+    return std::min(1.0f, radiusRating * densityRating * escapeVelocityRating * 1.0001f);
+}
+
 //----------------------------------------------------------------------------
 double Planet::getGasLife(float molecularMass) const
 {
@@ -1172,6 +1224,8 @@ void Planet::initializeSurfaceConditions(const EvaluationState& evaluationState)
 //----------------------------------------------------------------------------
 void Planet::iterateSurfaceConditions(Generator& generator, const EvaluationState& evaluationState)
 {
+    PhaseScope phase(generator.getPhaseCounters(), GenerationPhase::SurfaceConditions);
+
     // Set initial conditions:
     initializeSurfaceConditions(evaluationState);
     updateSurfaceConditions(generator, evaluationState);
@@ -1179,10 +1233,12 @@ void Planet::iterateSurfaceConditions(Generator& generator, const EvaluationStat
     bool converged = false;
     float previousTemperature;
     static constexpr int MaxConvergenceIterations = 25;
+    uint32_t rounds = 1u;
     for (int i = 0; i < MaxConvergenceIterations; ++i)
     {
         previousTemperature = meanSurfaceTemperature;
         updateSurfaceConditions(generator, evaluationState);
+        ++rounds;
 
         // Do I want to use only absolute temperature?
         if (fabsf(previousTemperature - meanSurfaceTemperature) < 0.25f)
@@ -1193,6 +1249,11 @@ void Planet::iterateSurfaceConditions(Generator& generator, const EvaluationStat
         }
     }
 
+    if (generator.getSystemCost())
+    {
+        generator.getSystemCost()->evaluationRounds += rounds;
+    }
+
 #ifdef ALLOW_DEBUG_PRINTF
     if (!converged && generator.getVerbose())
     {
@@ -0,0 +1,138 @@
+/*****************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Questionable Coding
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************/
+#include <qcSysGen/PlanetColumns.h>
+
+#include <qcSysGen/Consts.h>
+#include <qcSysGen/Planet.h>
+#include <qcSysGen/System.h>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Append the contents of one column to another.
+template <typename T_>
+void AppendColumn(std::vector<T_>& lhs, const std::vector<T_>& rhs)
+{
+    lhs.insert(lhs.end(), rhs.begin(), rhs.end());
+}
+
+}
+
+namespace qc
+{
+
+namespace SystemGenerator
+{
+
+//----------------------------------------------------------------------------
+void PlanetColumns::append(uint32_t systemRow, uint32_t ordinal_, StarClassification starClass_, const Planet& planet)
+{
+    system.emplace_back(systemRow);
+    ordinal.emplace_back(static_cast<uint8_t>(ordinal_));
+    starClass.emplace_back(static_cast<uint8_t>(starClass_));
+    planetType.emplace_back(static_cast<uint8_t>(planet.getPlanetType()));
+    orbitalZone.emplace_back(static_cast<uint8_t>(planet.getOrbitalZone()));
+    semimajorAxis.emplace_back(static_cast<float>(planet.getSemimajorAxis()));
+    mass.emplace_back(static_cast<float>(planet.getMass() * SolarMassToEarthMass));
+    radius.emplace_back(planet.getRadius());
+    earthSimilarityIndex.emplace_back(planet.getEarthSimilarityIndex());
+    surfaceTemperature.emplace_back(planet.getSurfaceTemperature());
+    hydrosphere.emplace_back(planet.getHydroPercentage());
+    surfacePressure.emplace_back(planet.getSurfacePressure());
+}
+
+//----------------------------------------------------------------------------
+void PlanetColumns::append(uint32_t systemRow, const SolarSystem& solarSystem)
+{
+    const StarClassification starClass_ = solarSystem.getStar().getStarType().first;
+    const PlanetVector& planet = solarSystem.getPlanets();
+
+    for (size_t i = 0; i < planet.size(); ++i)
+    {
+        append(systemRow, static_cast<uint32_t>(i + 1u), starClass_, planet[i]);
+    }
+}
+
+//----------------------------------------------------------------------------
+void PlanetColumns::append(const PlanetColumns& rhs, uint32_t systemOffset)
+{
+    const size_t first = system.size();
+
+    AppendColumn(system, rhs.system);
+    for (size_t i = first; i < system.size(); ++i)
+    {
+        system[i] += systemOffset;
+    }
+
+    AppendColumn(ordinal, rhs.ordinal);
+    AppendColumn(starClass, rhs.starClass);
+    AppendColumn(planetType, rhs.planetType);
+    AppendColumn(orbitalZone, rhs.orbitalZone);
+    AppendColumn(semimajorAxis, rhs.semimajorAxis);
+    AppendColumn(mass, rhs.mass);
+    AppendColumn(radius, rhs.radius);
+    AppendColumn(earthSimilarityIndex, rhs.earthSimilarityIndex);
+    AppendColumn(surfaceTemperature, rhs.surfaceTemperature);
+    AppendColumn(hydrosphere, rhs.hydrosphere);
+    AppendColumn(surfacePressure, rhs.surfacePressure);
+}
+
+//----------------------------------------------------------------------------
+void PlanetColumns::clear()
+{
+    system.clear();
+    ordinal.clear();
+    starClass.clear();
+    planetType.clear();
+    orbitalZone.clear();
+    semimajorAxis.clear();
+    mass.clear();
+    radius.clear();
+    earthSimilarityIndex.clear();
+    surfaceTemperature.clear();
+    hydrosphere.clear();
+    surfacePressure.clear();
+}
+
+//----------------------------------------------------------------------------
+void PlanetColumns::reserve(size_t count)
+{
+    system.reserve(count);
+    ordinal.reserve(count);
+    starClass.reserve(count);
+    planetType.reserve(count);
+    orbitalZone.reserve(count);
+    semimajorAxis.reserve(count);
+    mass.reserve(count);
+    radius.reserve(count);
+    earthSimilarityIndex.reserve(count);
+    surfaceTemperature.reserve(count);
+    hydrosphere.reserve(count);
+    surfacePressure.reserve(count);
+}
+
+}
+}
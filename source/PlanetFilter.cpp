@@ -0,0 +1,582 @@
+/*****************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Questionable Coding
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************/
+#include <qcSysGen/PlanetFilter.h>
+
+#include <algorithm>
+#include <assert.h>
+#include <ctype.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace
+{
+
+/// @brief Enumerator names accepted for `star`, in StarClassification order.
+static const char* StarClassNames[] = { "O_V", "B_V", "A_V", "F_V", "G_V", "K_V", "M_V" };
+
+/// @brief Enumerator names accepted for `type`, in PlanetType order.
+static const char* PlanetTypeNames[] = { "Unknown", "Rocky", "AsteroidBelt", "DwarfPlanet", "IcePlanet", "Terrestrial", "Ocean", "Gaseous", "IceGiant", "GasGiant", "BrownDwarf" };
+
+/// @brief Enumerator names accepted for `zone`, in OrbitalZone order.
+static const char* OrbitalZoneNames[] = { "Inner", "Habitable", "Middle", "Outer" };
+
+/// @brief Describes a field that may appear in an expression.
+struct FieldInfo
+{
+    const char* name; //!< Name used in expressions.
+    const char** enumerator; //!< Enumerator names, or nullptr for numeric fields.
+    uint32_t enumeratorCount; //!< Number of enumerator names.
+};
+
+/// @brief The fields, in PlanetFilter::Field order.
+static const FieldInfo Fields[] =
+{
+    { "star", StarClassNames, static_cast<uint32_t>(_countof(StarClassNames)) },
+    { "type", PlanetTypeNames, static_cast<uint32_t>(_countof(PlanetTypeNames)) },
+    { "zone", OrbitalZoneNames, static_cast<uint32_t>(_countof(OrbitalZoneNames)) },
+    { "sma", nullptr, 0u },
+    { "mass", nullptr, 0u },
+    { "radius", nullptr, 0u },
+    { "esi", nullptr, 0u },
+    { "temp", nullptr, 0u },
+    { "hydro", nullptr, 0u },
+    { "pressure", nullptr, 0u },
+};
+
+//----------------------------------------------------------------------------
+// Advance past whitespace.
+void SkipSpace(const char*& cursor)
+{
+    while (isspace(static_cast<unsigned char>(*cursor)))
+    {
+        ++cursor;
+    }
+}
+
+//----------------------------------------------------------------------------
+// If the next token is `token`, consume it and return true.
+bool Accept(const char*& cursor, const char* token)
+{
+    SkipSpace(cursor);
+    const size_t length = strlen(token);
+    if (strncmp(cursor, token, length) == 0)
+    {
+        cursor += length;
+        return true;
+    }
+
+    return false;
+}
+
+//----------------------------------------------------------------------------
+// Read an identifier ([A-Za-z_][A-Za-z0-9_]*).  Returns false if there isn't one.
+bool ReadIdentifier(const char*& cursor, std::string& identifier)
+{
+    SkipSpace(cursor);
+    if (!isalpha(static_cast<unsigned char>(*cursor)) && *cursor != '_')
+    {
+        return false;
+    }
+
+    const char* start = cursor;
+    while (isalnum(static_cast<unsigned char>(*cursor)) || *cursor == '_')
+    {
+        ++cursor;
+    }
+    identifier.assign(start, cursor);
+
+    return true;
+}
+
+//----------------------------------------------------------------------------
+// Read a number.  Returns false if there isn't one.
+bool ReadNumber(const char*& cursor, float& value)
+{
+    SkipSpace(cursor);
+    char* end = nullptr;
+    const double d = strtod(cursor, &end);
+    if (end == cursor)
+    {
+        return false;
+    }
+
+    cursor = end;
+    value = static_cast<float>(d);
+
+    return true;
+}
+
+//----------------------------------------------------------------------------
+// Read an enumerator name for `field` and return its bit.  Returns 0 if the name isn't valid.
+uint32_t ReadEnumerator(const char*& cursor, const FieldInfo& field)
+{
+    std::string identifier;
+    if (ReadIdentifier(cursor, identifier))
+    {
+        for (uint32_t i = 0; i < field.enumeratorCount; ++i)
+        {
+            if (identifier == field.enumerator[i])
+            {
+                return 1u << i;
+            }
+        }
+    }
+
+    return 0u;
+}
+
+//----------------------------------------------------------------------------
+// Returns a pointer to the first row of a float column.
+const float* FloatColumn(const qc::SystemGenerator::PlanetColumns& planets, uint32_t field)
+{
+    const std::vector<float>* columns[] =
+    {
+        nullptr,
+        nullptr,
+        nullptr,
+        &planets.semimajorAxis,
+        &planets.mass,
+        &planets.radius,
+        &planets.earthSimilarityIndex,
+        &planets.surfaceTemperature,
+        &planets.hydrosphere,
+        &planets.surfacePressure,
+    };
+    assert(field < _countof(columns) && columns[field] != nullptr);
+
+    return columns[field]->data();
+}
+
+//----------------------------------------------------------------------------
+// Returns a pointer to the first row of an enumerated column.
+const uint8_t* EnumColumn(const qc::SystemGenerator::PlanetColumns& planets, uint32_t field)
+{
+    const std::vector<uint8_t>* columns[] =
+    {
+        &planets.starClass,
+        &planets.planetType,
+        &planets.orbitalZone,
+    };
+    assert(field < _countof(columns));
+
+    return columns[field]->data();
+}
+
+}
+
+namespace qc
+{
+
+namespace SystemGenerator
+{
+
+//----------------------------------------------------------------------------
+bool PlanetFilter::compile(const char* expression, std::string* error)
+{
+    program.clear();
+    stackDepth = 0u;
+
+    std::string message;
+    const char* cursor = expression;
+    uint32_t depth = 0u;
+
+    bool ok = parseOr(cursor, message, depth);
+    if (ok)
+    {
+        SkipSpace(cursor);
+        if (*cursor != '\0')
+        {
+            message = "unexpected text";
+            ok = false;
+        }
+    }
+
+    if (!ok)
+    {
+        if (error)
+        {
+            *error = message + " at offset " + std::to_string(cursor - expression);
+        }
+        program.clear();
+        stackDepth = 0u;
+        return false;
+    }
+
+    assert(depth == 1u);
+
+    return true;
+}
+
+//----------------------------------------------------------------------------
+bool PlanetFilter::parseAnd(const char*& cursor, std::string& error, uint32_t& depth)
+{
+    if (!parseUnary(cursor, error, depth))
+    {
+        return false;
+    }
+
+    while (Accept(cursor, "&&"))
+    {
+        if (!parseUnary(cursor, error, depth))
+        {
+            return false;
+        }
+
+        Instruction ins = { Opcode::And, Field::StarClass, 0u, 0.0f, 0.0f };
+        program.emplace_back(ins);
+        --depth;
+    }
+
+    return true;
+}
+
+//----------------------------------------------------------------------------
+bool PlanetFilter::parseComparison(const char*& cursor, std::string& error, uint32_t& depth)
+{
+    std::string name;
+    uint32_t fieldIndex = 0u;
+    if (!ReadIdentifier(cursor, name))
+    {
+        error = "expected a field name";
+        return false;
+    }
+    while (fieldIndex < _countof(Fields) && name != Fields[fieldIndex].name)
+    {
+        ++fieldIndex;
+    }
+    if (fieldIndex == _countof(Fields))
+    {
+        error = "unknown field '" + name + "'";
+        return false;
+    }
+
+    const FieldInfo& field = Fields[fieldIndex];
+    Instruction ins = { Opcode::InRange, static_cast<Field>(fieldIndex), 0u, -INFINITY, INFINITY };
+    bool negate = false;
+
+    if (field.enumerator)
+    {
+        ins.op = Opcode::InSet;
+
+        if (Accept(cursor, "=="))
+        {
+            ins.set = ReadEnumerator(cursor, field);
+        }
+        else if (Accept(cursor, "!="))
+        {
+            ins.set = ReadEnumerator(cursor, field);
+            negate = true;
+        }
+        else if (Accept(cursor, "in"))
+        {
+            if (!Accept(cursor, "{"))
+            {
+                error = "expected '{'";
+                return false;
+            }
+            do
+            {
+                const uint32_t bit = ReadEnumerator(cursor, field);
+                if (bit == 0u)
+                {
+                    error = std::string("expected a ") + field.name + " value";
+                    return false;
+                }
+                ins.set |= bit;
+            } while (Accept(cursor, ","));
+            if (!Accept(cursor, "}"))
+            {
+                error = "expected '}'";
+                return false;
+            }
+        }
+        else
+        {
+            error = std::string("'") + field.name + "' supports ==, != and in {...}";
+            return false;
+        }
+
+        if (ins.set == 0u)
+        {
+            error = std::string("expected a ") + field.name + " value";
+            return false;
+        }
+    }
+    else if (Accept(cursor, "in"))
+    {
+        if (!Accept(cursor, "[") || !ReadNumber(cursor, ins.lower) || !Accept(cursor, ",") || !ReadNumber(cursor, ins.upper) || !Accept(cursor, "]"))
+        {
+            error = "expected [lower, upper]";
+            return false;
+        }
+    }
+    else
+    {
+        // Test the two-character operators first so '<' doesn't consume the start of '<='.
+        enum class Comparison { Equal, NotEqual, LessEqual, GreaterEqual, Less, Greater } comparison;
+        if (Accept(cursor, "=="))
+        {
+            comparison = Comparison::Equal;
+        }
+        else if (Accept(cursor, "!="))
+        {
+            comparison = Comparison::NotEqual;
+        }
+        else if (Accept(cursor, "<="))
+        {
+            comparison = Comparison::LessEqual;
+        }
+        else if (Accept(cursor, ">="))
+        {
+            comparison = Comparison::GreaterEqual;
+        }
+        else if (Accept(cursor, "<"))
+        {
+            comparison = Comparison::Less;
+        }
+        else if (Accept(cursor, ">"))
+        {
+            comparison = Comparison::Greater;
+        }
+        else
+        {
+            error = "expected a comparison operator";
+            return false;
+        }
+
+        float value;
+        if (!ReadNumber(cursor, value))
+        {
+            error = "expected a number";
+            return false;
+        }
+
+        // Every comparison becomes an inclusive range.  Strict comparisons move the bound to the
+        // neighboring float, and != is the inverse of ==.
+        switch (comparison)
+        {
+        case Comparison::Equal:
+            ins.lower = ins.upper = value;
+            break;
+        case Comparison::NotEqual:
+            ins.lower = ins.upper = value;
+            negate = true;
+            break;
+        case Comparison::LessEqual:
+            ins.upper = value;
+            break;
+        case Comparison::GreaterEqual:
+            ins.lower = value;
+            break;
+        case Comparison::Less:
+            ins.upper = nextafterf(value, -INFINITY);
+            break;
+        case Comparison::Greater:
+            ins.lower = nextafterf(value, INFINITY);
+            break;
+        }
+    }
+
+    program.emplace_back(ins);
+    push(depth);
+
+    if (negate)
+    {
+        Instruction notIns = { Opcode::Not, Field::StarClass, 0u, 0.0f, 0.0f };
+        program.emplace_back(notIns);
+    }
+
+    return true;
+}
+
+//----------------------------------------------------------------------------
+bool PlanetFilter::parseOr(const char*& cursor, std::string& error, uint32_t& depth)
+{
+    if (!parseAnd(cursor, error, depth))
+    {
+        return false;
+    }
+
+    while (Accept(cursor, "||"))
+    {
+        if (!parseAnd(cursor, error, depth))
+        {
+            return false;
+        }
+
+        Instruction ins = { Opcode::Or, Field::StarClass, 0u, 0.0f, 0.0f };
+        program.emplace_back(ins);
+        --depth;
+    }
+
+    return true;
+}
+
+//----------------------------------------------------------------------------
+bool PlanetFilter::parseUnary(const char*& cursor, std::string& error, uint32_t& depth)
+{
+    if (Accept(cursor, "!"))
+    {
+        if (!parseUnary(cursor, error, depth))
+        {
+            return false;
+        }
+
+        Instruction ins = { Opcode::Not, Field::StarClass, 0u, 0.0f, 0.0f };
+        program.emplace_back(ins);
+        return true;
+    }
+
+    if (Accept(cursor, "("))
+    {
+        if (!parseOr(cursor, error, depth))
+        {
+            return false;
+        }
+        if (!Accept(cursor, ")"))
+        {
+            error = "expected ')'";
+            return false;
+        }
+        return true;
+    }
+
+    return parseComparison(cursor, error, depth);
+}
+
+//----------------------------------------------------------------------------
+void PlanetFilter::push(uint32_t& depth)
+{
+    ++depth;
+    stackDepth = std::max(stackDepth, depth);
+}
+
+//----------------------------------------------------------------------------
+void PlanetFilter::select(const PlanetColumns& planets, size_t first, size_t last, std::vector<uint32_t>& rows) const
+{
+    rows.clear();
+
+    if (program.empty())
+    {
+        return;
+    }
+
+    last = std::min(last, planets.size());
+
+    // One ChunkSize-byte mask per stack slot.
+    std::vector<uint8_t> stack(stackDepth * ChunkSize);
+    uint8_t* const base = stack.data();
+
+    for (size_t chunk = first; chunk < last; chunk += ChunkSize)
+    {
+        const size_t count = std::min(static_cast<size_t>(ChunkSize), last - chunk);
+        // Number of masks on the stack; the top one starts at (depth - 1) * ChunkSize.
+        size_t depth = 0u;
+
+        for (const auto& ins : program)
+        {
+            switch (ins.op)
+            {
+            case Opcode::InRange:
+            {
+                uint8_t* __restrict out = base + depth * ChunkSize;
+                ++depth;
+                const float* __restrict column = FloatColumn(planets, static_cast<uint32_t>(ins.field)) + chunk;
+                const float lower = ins.lower;
+                const float upper = ins.upper;
+                for (size_t i = 0; i < count; ++i)
+                {
+                    out[i] = static_cast<uint8_t>(column[i] >= lower) & static_cast<uint8_t>(column[i] <= upper);
+                }
+                break;
+            }
+
+            case Opcode::InSet:
+            {
+                uint8_t* __restrict out = base + depth * ChunkSize;
+                ++depth;
+                const uint8_t* __restrict column = EnumColumn(planets, static_cast<uint32_t>(ins.field)) + chunk;
+                const uint32_t set = ins.set;
+                for (size_t i = 0; i < count; ++i)
+                {
+                    out[i] = static_cast<uint8_t>((set >> column[i]) & 1u);
+                }
+                break;
+            }
+
+            case Opcode::And:
+            {
+                --depth;
+                const uint8_t* __restrict rhs = base + depth * ChunkSize;
+                uint8_t* __restrict lhs = base + (depth - 1u) * ChunkSize;
+                for (size_t i = 0; i < count; ++i)
+                {
+                    lhs[i] &= rhs[i];
+                }
+                break;
+            }
+
+            case Opcode::Or:
+            {
+                --depth;
+                const uint8_t* __restrict rhs = base + depth * ChunkSize;
+                uint8_t* __restrict lhs = base + (depth - 1u) * ChunkSize;
+                for (size_t i = 0; i < count; ++i)
+                {
+                    lhs[i] |= rhs[i];
+                }
+                break;
+            }
+
+            case Opcode::Not:
+            {
+                uint8_t* __restrict top = base + (depth - 1u) * ChunkSize;
+                for (size_t i = 0; i < count; ++i)
+                {
+                    top[i] ^= 1u;
+                }
+                break;
+            }
+            }
+        }
+
+        assert(depth == 1u);
+        const uint8_t* top = base;
+
+        // Branch-free compaction: always write the row, only advance when it matched.
+        size_t matched = rows.size();
+        rows.resize(matched + count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            rows[matched] = static_cast<uint32_t>(chunk + i);
+            matched += top[i];
+        }
+        rows.resize(matched);
+    }
+}
+
+}
+}
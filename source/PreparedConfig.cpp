@@ -0,0 +1,107 @@
+/*****************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Questionable Coding
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************/
+#include <qcSysGen/PreparedConfig.h>
+
+#include <qcSysGen/Equations.h>
+
+#include <math.h>
+
+namespace
+{
+
+/// @brief The strategy used for Config::generateBodeSeeds.
+static const qc::SystemGenerator::BodeSeedStrategy DefaultBodeSeedStrategy;
+
+}
+
+namespace qc
+{
+
+namespace SystemGenerator
+{
+
+//----------------------------------------------------------------------------
+void PreparedConfig::prepare(const Config& config_)
+{
+    config = config_;
+
+    // Sanity clamps:
+    config.inclinationMean = fabsf(config.inclinationMean);
+    while (config.inclinationMean >= 180.0f)
+    {
+        config.inclinationMean -= 180.0f;
+    }
+    config.inclinationStdDev = fabsf(config.inclinationStdDev);
+
+    // The random eccentricities themselves are drawn for each system, so they come from that system's seed.
+    randomSeedEccentricity = false;
+    for (const auto& s : config.protoplanetSeeds)
+    {
+        if (s.eccentricity < 0.0f || s.eccentricity > 0.9f)
+        {
+            randomSeedEccentricity = true;
+            break;
+        }
+    }
+
+    if (!config.protoplanetSeeds.empty())
+    {
+        seedStrategy = nullptr;
+    }
+    else if (config.seedStrategy)
+    {
+        seedStrategy = config.seedStrategy;
+    }
+    else
+    {
+        seedStrategy = config.generateBodeSeeds ? &DefaultBodeSeedStrategy : nullptr;
+    }
+
+    starPrepared = false;
+}
+
+//----------------------------------------------------------------------------
+void PreparedConfig::prepare(const Config& config_, const Star& star_)
+{
+    prepare(config_);
+
+    if (!config.generateStar)
+    {
+        // Evaluated the same way SolarSystem::add() evaluates it.
+        star = star_;
+        star.evaluate();
+
+        criticalLimitScalar = CriticalLimitScalar(star.getLuminosity());
+        dustDensityScalar = DustDensityScalar(star.getMass());
+        if (seedStrategy)
+        {
+            seedStrategy->prepare(star, seedLayout);
+        }
+        starPrepared = true;
+    }
+}
+
+}
+}
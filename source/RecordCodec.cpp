@@ -0,0 +1,519 @@
+/*****************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Questionable Coding
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************/
+#include <qcSysGen/RecordCodec.h>
+
+#include <algorithm>
+#include <string.h>
+
+namespace
+{
+
+using qc::SystemGenerator::PlanetRecord;
+
+/// @brief Largest size of a varint, in bytes.
+static constexpr size_t MaxVarintSize = 10u;
+
+/// @brief Largest encoded size of the record header and star, in bytes.
+static constexpr size_t MaxSystemSize = 3u * MaxVarintSize + 1u + 9u * MaxVarintSize;
+
+/// @brief Largest encoded size of a planet, in bytes.
+static constexpr size_t MaxPlanetSize = 1u + 18u * MaxVarintSize + 3u + PlanetRecord::MaxAtmosphere * MaxVarintSize;
+
+/// @brief Largest planet count accepted by the decoder.
+static constexpr uint64_t MaxDecodedPlanets = 1u << 16;
+
+// Bits of the planet flag byte.
+static constexpr uint8_t ExplicitApsides = 0x40u; //!< Periapsis and apoapsis are stored.
+static constexpr uint8_t ExplicitMass = 0x80u; //!< The total mass is stored.
+
+//----------------------------------------------------------------------------
+inline uint64_t ZigZag(int64_t v)
+{
+    return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+}
+
+//----------------------------------------------------------------------------
+inline int64_t UnZigZag(uint64_t v)
+{
+    return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1u);
+}
+
+//----------------------------------------------------------------------------
+// Round the mantissa of a double to (52 - shift) bits, and return the bits that remain.  The result is
+// monotonic in the value for positive values, so neighbouring values have small differences.
+inline uint64_t QuantizeRelative(double v, uint32_t shift)
+{
+    uint64_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    return (shift > 0u) ? (bits + (1ull << (shift - 1u))) >> shift : bits;
+}
+
+//----------------------------------------------------------------------------
+inline double DequantizeRelative(uint64_t q, uint32_t shift)
+{
+    const uint64_t bits = q << shift;
+    double v;
+    memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+//----------------------------------------------------------------------------
+// Round a value to a multiple of a step.  Values too large to represent become 0.
+inline int64_t QuantizeLinear(double v, double inverseStep)
+{
+    const double x = v * inverseStep;
+    return (x > -9.0e18 && x < 9.0e18) ? static_cast<int64_t>(x + ((x < 0.0) ? -0.5 : 0.5)) : 0;
+}
+
+//----------------------------------------------------------------------------
+// Returns the shift that keeps `bits` mantissa bits of a value with `mantissaBits` bits.
+inline uint32_t RelativeShift(uint32_t bits, uint32_t mantissaBits)
+{
+    return 52u - std::min(std::max(bits, 1u), mantissaBits);
+}
+
+/// @brief Appends varints.
+struct VarintWriter
+{
+    uint8_t* p; //!< The next byte.
+
+    //----------------------------------------------------------------------------
+    void put(uint64_t v)
+    {
+        while (v >= 0x80u)
+        {
+            *p++ = static_cast<uint8_t>(v | 0x80u);
+            v >>= 7;
+        }
+        *p++ = static_cast<uint8_t>(v);
+    }
+
+    //----------------------------------------------------------------------------
+    void putSigned(int64_t v)
+    {
+        put(ZigZag(v));
+    }
+
+    //----------------------------------------------------------------------------
+    // A value kept to a relative precision, as the difference from `previous`, which is then updated.
+    // Zero is stored as the single byte 0 and leaves `previous` alone.
+    void putRelative(double v, uint32_t shift, uint64_t& previous)
+    {
+        if (v == 0.0)
+        {
+            put(0u);
+            return;
+        }
+
+        const uint64_t q = QuantizeRelative(v, shift);
+        put(ZigZag(static_cast<int64_t>(q - previous)) + 1u);
+        previous = q;
+    }
+};
+
+/// @brief Reads varints, failing once the data runs out.
+struct VarintReader
+{
+    const uint8_t* p; //!< The next byte.
+    const uint8_t* end; //!< The end of the data.
+    bool valid = true; //!< Cleared when the data is truncated or malformed.
+
+    //----------------------------------------------------------------------------
+    uint64_t get()
+    {
+        uint64_t v = 0u;
+        for (uint32_t shift = 0u; shift < 64u; shift += 7u)
+        {
+            if (p == end)
+            {
+                break;
+            }
+            const uint8_t b = *p++;
+            v |= static_cast<uint64_t>(b & 0x7fu) << shift;
+            if (b < 0x80u)
+            {
+                return v;
+            }
+        }
+
+        valid = false;
+        return 0u;
+    }
+
+    //----------------------------------------------------------------------------
+    int64_t getSigned()
+    {
+        return UnZigZag(get());
+    }
+
+    //----------------------------------------------------------------------------
+    double getRelative(uint32_t shift, uint64_t& previous)
+    {
+        const uint64_t v = get();
+        if (v == 0u)
+        {
+            return 0.0;
+        }
+
+        previous += static_cast<uint64_t>(UnZigZag(v - 1u));
+        return DequantizeRelative(previous, shift);
+    }
+};
+
+}
+
+namespace qc
+{
+
+namespace SystemGenerator
+{
+
+//----------------------------------------------------------------------------
+RecordStreamHeader RecordStreamHeader::Make(const RecordCodecPrecision& precision_)
+{
+    RecordStreamHeader header = {};
+    header.magic = Magic;
+    header.version = CodecVersion;
+    header.precision = precision_;
+    return header;
+}
+
+//----------------------------------------------------------------------------
+RecordEncoder::RecordEncoder(const RecordCodecPrecision& precision_)
+    : precision(precision_)
+{
+}
+
+//----------------------------------------------------------------------------
+size_t RecordEncoder::encode(const SystemRecord& record, uint8_t* out)
+{
+    const uint32_t orbitShift = RelativeShift(precision.orbitBits, 52u);
+    const uint32_t massShift = RelativeShift(precision.massBits, 52u);
+    const uint32_t sizeShift = RelativeShift(precision.sizeBits, 52u);
+    const uint32_t floatSizeShift = RelativeShift(precision.sizeBits, 23u);
+    const double fractionScale = static_cast<double>((1ull << std::min(std::max(precision.fractionBits, 1u), 31u)) - 1u);
+    const double inverseTemperature = 1.0 / precision.temperatureStep;
+    const double inverseEccentricity = 1.0 / precision.eccentricityStep;
+    const double inverseInclination = 1.0 / precision.inclinationStep;
+
+    VarintWriter w = { out };
+    w.put(record.planetCount);
+    w.putSigned(static_cast<int64_t>(record.seed - previousSeed));
+    w.putSigned(static_cast<int64_t>(record.systemIndex - previousIndex));
+    previousSeed = record.seed;
+    previousIndex = record.systemIndex;
+
+    // The star.  Its distances are stored relative to the ecosphere.
+    const StarRecord& star = record.star;
+    *w.p++ = static_cast<uint8_t>((star.starClass << 4) | (static_cast<uint8_t>(star.subtype) & 0x0fu));
+    w.putSigned(QuantizeLinear(star.temperature, inverseTemperature));
+    uint64_t one = QuantizeRelative(1.0, massShift);
+    uint64_t previous = one;
+    w.putRelative(star.age, massShift, previous);
+    previous = one;
+    w.putRelative(star.mass, massShift, previous);
+    previous = one;
+    w.putRelative(star.luminosity, massShift, previous);
+    previous = one;
+    w.putRelative(star.radius, massShift, previous);
+    one = QuantizeRelative(1.0, orbitShift);
+    previous = one;
+    w.putRelative(star.ecosphere, orbitShift, previous);
+    const uint64_t ecosphere = previous;
+    w.putRelative(star.snowLine, orbitShift, previous);
+    previous = ecosphere;
+    w.putRelative(star.habitableZone[0], orbitShift, previous);
+    previous = ecosphere;
+    w.putRelative(star.habitableZone[1], orbitShift, previous);
+
+    // Each planet field is predicted by the same field of the previous planet.
+    uint64_t sma = one;
+    uint64_t dustMass = QuantizeRelative(1.0e-6, massShift);
+    uint64_t gasMass = dustMass;
+    uint64_t sphereOfInfluence = QuantizeRelative(1.0e-3, sizeShift);
+    uint64_t surfaceGravity = QuantizeRelative(1.0, sizeShift);
+    uint64_t radius = QuantizeRelative(6378.0, floatSizeShift);
+    uint64_t density = QuantizeRelative(5.5, floatSizeShift);
+    uint64_t surfacePressure = QuantizeRelative(1000.0, floatSizeShift);
+    int64_t surfaceTemperature = 0;
+
+    const PlanetRecord* planets = record.getPlanets();
+    for (uint32_t i = 0; i < record.planetCount; ++i)
+    {
+        const PlanetRecord& p = planets[i];
+
+        const bool derivedApsides = p.periapsis == p.semimajorAxis * (1.0f - p.eccentricity) &&
+            p.apoapsis == p.semimajorAxis * (1.0f + p.eccentricity);
+        const bool derivedMass = p.mass == p.dustMass + p.gasMass;
+        *w.p++ = static_cast<uint8_t>((p.planetType & 0x0fu) | ((p.orbitalZone & 0x03u) << 4) |
+                                      (derivedApsides ? 0u : ExplicitApsides) | (derivedMass ? 0u : ExplicitMass));
+
+        w.putRelative(p.semimajorAxis, orbitShift, sma);
+        if (!derivedApsides)
+        {
+            previous = sma;
+            w.putRelative(p.periapsis, orbitShift, previous);
+            previous = sma;
+            w.putRelative(p.apoapsis, orbitShift, previous);
+        }
+        w.putSigned(QuantizeLinear(p.eccentricity, inverseEccentricity));
+        w.putSigned(QuantizeLinear(p.inclination, inverseInclination));
+
+        w.putRelative(p.dustMass, massShift, dustMass);
+        w.putRelative(p.gasMass, massShift, gasMass);
+        if (!derivedMass)
+        {
+            previous = QuantizeRelative(p.dustMass + p.gasMass, massShift);
+            w.putRelative(p.mass, massShift, previous);
+        }
+
+        w.putRelative(p.sphereOfInfluence, sizeShift, sphereOfInfluence);
+        w.putRelative(p.surfaceGravity, sizeShift, surfaceGravity);
+        w.putRelative(p.radius, floatSizeShift, radius);
+        w.putRelative(p.density, floatSizeShift, density);
+        w.putRelative(p.surfacePressure, floatSizeShift, surfacePressure);
+
+        const int64_t temperature = QuantizeLinear(p.surfaceTemperature, inverseTemperature);
+        w.putSigned(temperature - surfaceTemperature);
+        surfaceTemperature = temperature;
+
+        w.putSigned(QuantizeLinear(p.hydrosphere, fractionScale));
+        w.putSigned(QuantizeLinear(p.iceCoverage, fractionScale));
+        w.putSigned(QuantizeLinear(p.cloudCoverage, fractionScale));
+        w.putSigned(QuantizeLinear(p.earthSimilarityIndex, fractionScale));
+
+        // The gases present, then their fractions in Gas order.  A gas listed twice keeps its first entry.
+        float fractions[PlanetRecord::MaxAtmosphere];
+        uint32_t mask = 0u;
+        const uint32_t atmosphereCount = std::min<uint32_t>(p.atmosphereCount, PlanetRecord::MaxAtmosphere);
+        for (uint32_t a = 0; a < atmosphereCount; ++a)
+        {
+            const uint32_t gas = static_cast<uint32_t>(p.atmosphere[a].gas);
+            if (gas < PlanetRecord::MaxAtmosphere && !(mask & (1u << gas)))
+            {
+                mask |= 1u << gas;
+                fractions[gas] = p.atmosphere[a].fraction;
+            }
+        }
+        w.put(mask);
+        uint64_t fraction = QuantizeRelative(0.01, floatSizeShift);
+        for (uint32_t gas = 0; mask >> gas; ++gas)
+        {
+            if (mask & (1u << gas))
+            {
+                w.putRelative(fractions[gas], floatSizeShift, fraction);
+            }
+        }
+    }
+
+    return static_cast<size_t>(w.p - out);
+}
+
+//----------------------------------------------------------------------------
+size_t RecordEncoder::GetMaxSize(uint32_t planetCount)
+{
+    return MaxSystemSize + planetCount * MaxPlanetSize;
+}
+
+//----------------------------------------------------------------------------
+RecordDecoder::RecordDecoder(const RecordCodecPrecision& precision_)
+    : precision(precision_)
+{
+}
+
+//----------------------------------------------------------------------------
+size_t RecordDecoder::decode(const uint8_t* data, size_t size, void* record, size_t recordSize)
+{
+    const uint32_t orbitShift = RelativeShift(precision.orbitBits, 52u);
+    const uint32_t massShift = RelativeShift(precision.massBits, 52u);
+    const uint32_t sizeShift = RelativeShift(precision.sizeBits, 52u);
+    const uint32_t floatSizeShift = RelativeShift(precision.sizeBits, 23u);
+    const double fractionStep = 1.0 / static_cast<double>((1ull << std::min(std::max(precision.fractionBits, 1u), 31u)) - 1u);
+    const double temperatureStep = precision.temperatureStep;
+    const double eccentricityStep = precision.eccentricityStep;
+    const double inclinationStep = precision.inclinationStep;
+
+    VarintReader r = { data, data + size };
+    const uint64_t planetCount = r.get();
+    const size_t decodedSize = sizeof(SystemRecord) + planetCount * sizeof(PlanetRecord);
+    if (!r.valid || planetCount > MaxDecodedPlanets || decodedSize > recordSize || r.p == r.end)
+    {
+        return 0u;
+    }
+
+    SystemRecord& out = *static_cast<SystemRecord*>(record);
+    memset(&out, 0, decodedSize);
+    out.size = static_cast<uint32_t>(decodedSize);
+    out.planetCount = static_cast<uint32_t>(planetCount);
+    out.seed = previousSeed + static_cast<uint64_t>(r.getSigned());
+    out.systemIndex = previousIndex + static_cast<uint64_t>(r.getSigned());
+    if (resuming)
+    {
+        out.seed = previousSeed;
+        out.systemIndex = previousIndex;
+    }
+
+    StarRecord& star = out.star;
+    if (r.p == r.end)
+    {
+        return 0u;
+    }
+    const uint8_t type = *r.p++;
+    star.starClass = type >> 4;
+    star.subtype = static_cast<int8_t>(type & 0x0fu);
+    star.temperature = static_cast<float>(r.getSigned() * temperatureStep);
+    uint64_t one = QuantizeRelative(1.0, massShift);
+    uint64_t previous = one;
+    star.age = r.getRelative(massShift, previous);
+    previous = one;
+    star.mass = r.getRelative(massShift, previous);
+    previous = one;
+    star.luminosity = r.getRelative(massShift, previous);
+    previous = one;
+    star.radius = r.getRelative(massShift, previous);
+    one = QuantizeRelative(1.0, orbitShift);
+    previous = one;
+    star.ecosphere = r.getRelative(orbitShift, previous);
+    const uint64_t ecosphere = previous;
+    star.snowLine = r.getRelative(orbitShift, previous);
+    previous = ecosphere;
+    star.habitableZone[0] = r.getRelative(orbitShift, previous);
+    previous = ecosphere;
+    star.habitableZone[1] = r.getRelative(orbitShift, previous);
+
+    uint64_t sma = one;
+    uint64_t dustMass = QuantizeRelative(1.0e-6, massShift);
+    uint64_t gasMass = dustMass;
+    uint64_t sphereOfInfluence = QuantizeRelative(1.0e-3, sizeShift);
+    uint64_t surfaceGravity = QuantizeRelative(1.0, sizeShift);
+    uint64_t radius = QuantizeRelative(6378.0, floatSizeShift);
+    uint64_t density = QuantizeRelative(5.5, floatSizeShift);
+    uint64_t surfacePressure = QuantizeRelative(1000.0, floatSizeShift);
+    int64_t surfaceTemperature = 0;
+
+    PlanetRecord* planets = reinterpret_cast<PlanetRecord*>(&out + 1);
+    for (uint32_t i = 0; i < planetCount && r.valid; ++i)
+    {
+        PlanetRecord& p = planets[i];
+
+        if (r.p == r.end)
+        {
+            return 0u;
+        }
+        const uint8_t flags = *r.p++;
+        p.planetType = flags & 0x0fu;
+        p.orbitalZone = (flags >> 4) & 0x03u;
+
+        p.semimajorAxis = r.getRelative(orbitShift, sma);
+        if (flags & ExplicitApsides)
+        {
+            previous = sma;
+            p.periapsis = r.getRelative(orbitShift, previous);
+            previous = sma;
+            p.apoapsis = r.getRelative(orbitShift, previous);
+        }
+        p.eccentricity = static_cast<float>(r.getSigned() * eccentricityStep);
+        p.inclination = static_cast<float>(r.getSigned() * inclinationStep);
+        if (!(flags & ExplicitApsides))
+        {
+            p.periapsis = p.semimajorAxis * (1.0f - p.eccentricity);
+            p.apoapsis = p.semimajorAxis * (1.0f + p.eccentricity);
+        }
+
+        p.dustMass = r.getRelative(massShift, dustMass);
+        p.gasMass = r.getRelative(massShift, gasMass);
+        p.mass = p.dustMass + p.gasMass;
+        if (flags & ExplicitMass)
+        {
+            previous = QuantizeRelative(p.mass, massShift);
+            p.mass = r.getRelative(massShift, previous);
+        }
+
+        p.sphereOfInfluence = r.getRelative(sizeShift, sphereOfInfluence);
+        p.surfaceGravity = r.getRelative(sizeShift, surfaceGravity);
+        p.radius = static_cast<float>(r.getRelative(floatSizeShift, radius));
+        p.density = static_cast<float>(r.getRelative(floatSizeShift, density));
+        p.surfacePressure = static_cast<float>(r.getRelative(floatSizeShift, surfacePressure));
+
+        surfaceTemperature += r.getSigned();
+        p.surfaceTemperature = static_cast<float>(surfaceTemperature * temperatureStep);
+
+        p.hydrosphere = static_cast<float>(r.getSigned() * fractionStep);
+        p.iceCoverage = static_cast<float>(r.getSigned() * fractionStep);
+        p.cloudCoverage = static_cast<float>(r.getSigned() * fractionStep);
+        p.earthSimilarityIndex = static_cast<float>(r.getSigned() * fractionStep);
+
+        const uint64_t mask = r.get();
+        if (mask >> PlanetRecord::MaxAtmosphere)
+        {
+            return 0u;
+        }
+        uint32_t count = 0u;
+        uint64_t fraction = QuantizeRelative(0.01, floatSizeShift);
+        for (uint32_t gas = 0; mask >> gas; ++gas)
+        {
+            if (mask & (1u << gas))
+            {
+                AtmosphereComponent& c = p.atmosphere[count++];
+                c.gas = static_cast<Gas>(gas);
+                c.fraction = static_cast<float>(r.getRelative(floatSizeShift, fraction));
+            }
+        }
+        p.atmosphereCount = static_cast<uint8_t>(count);
+
+        // Largest fraction first, as the planets keep them.
+        for (uint32_t a = 1; a < count; ++a)
+        {
+            const AtmosphereComponent c = p.atmosphere[a];
+            uint32_t b = a;
+            for (; b > 0u && p.atmosphere[b - 1u].fraction < c.fraction; --b)
+            {
+                p.atmosphere[b] = p.atmosphere[b - 1u];
+            }
+            p.atmosphere[b] = c;
+        }
+    }
+
+    if (!r.valid)
+    {
+        return 0u;
+    }
+
+    previousSeed = out.seed;
+    previousIndex = out.systemIndex;
+    resuming = false;
+    return static_cast<size_t>(r.p - data);
+}
+
+//----------------------------------------------------------------------------
+size_t RecordDecoder::GetDecodedSize(const uint8_t* data, size_t size)
+{
+    VarintReader r = { data, data + size };
+    const uint64_t planetCount = r.get();
+    return (r.valid && planetCount <= MaxDecodedPlanets) ? sizeof(SystemRecord) + planetCount * sizeof(PlanetRecord) : 0u;
+}
+
+}
+}
@@ -0,0 +1,325 @@
+/*****************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Questionable Coding
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************/
+#include <qcSysGen/RecordFile.h>
+
+#include <qcSysGen/SystemRecord.h>
+
+#include <algorithm>
+#include <string.h>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace qc
+{
+
+namespace SystemGenerator
+{
+
+//----------------------------------------------------------------------------
+RecordCursor::RecordCursor(const RecordFileReader& file_) :
+    file(file_),
+    decoder(file_.decoder)
+{
+    rewind();
+}
+
+//----------------------------------------------------------------------------
+const SystemRecord* RecordCursor::next()
+{
+    if (!file.compressed)
+    {
+        if (position + sizeof(SystemRecord) > file.dataEnd)
+        {
+            return nullptr;
+        }
+        const SystemRecord* record = reinterpret_cast<const SystemRecord*>(file.map + position);
+        if (record->size < sizeof(SystemRecord) || record->size > file.dataEnd - position)
+        {
+            position = file.dataEnd;
+            return nullptr;
+        }
+        position += record->size;
+        return record;
+    }
+
+    // Start the next block once this one is used up.
+    while (position == blockEnd)
+    {
+        RecordBlockHeader header;
+        if (position + sizeof(header) > file.dataEnd)
+        {
+            return nullptr;
+        }
+        memcpy(&header, file.map + position, sizeof(header));
+        position += sizeof(header);
+        if (header.size > file.dataEnd - position)
+        {
+            position = blockEnd = file.dataEnd;
+            return nullptr;
+        }
+        blockEnd = position + header.size;
+        decoder.reset();
+    }
+
+    const uint8_t* p = file.map + position;
+    const size_t size = RecordDecoder::GetDecodedSize(p, blockEnd - position);
+    if (size == 0u)
+    {
+        position = blockEnd = file.dataEnd;
+        return nullptr;
+    }
+    scratch.resize((size + sizeof(uint64_t) - 1u) / sizeof(uint64_t));
+    const size_t used = decoder.decode(p, blockEnd - position, scratch.data(), size);
+    if (used == 0u)
+    {
+        position = blockEnd = file.dataEnd;
+        return nullptr;
+    }
+    position += used;
+
+    return reinterpret_cast<const SystemRecord*>(scratch.data());
+}
+
+//----------------------------------------------------------------------------
+void RecordCursor::rewind()
+{
+    position = blockEnd = file.dataBegin;
+}
+
+//----------------------------------------------------------------------------
+RecordFileReader::RecordFileReader()
+{
+}
+
+//----------------------------------------------------------------------------
+RecordFileReader::~RecordFileReader()
+{
+    close();
+}
+
+//----------------------------------------------------------------------------
+void RecordFileReader::close()
+{
+#if !defined(_WIN32)
+    if (map)
+    {
+        munmap(const_cast<uint8_t*>(map), mapSize);
+    }
+#endif
+    map = nullptr;
+    mapSize = dataBegin = dataEnd = 0u;
+    compressed = false;
+    seedEntries = indexEntries = nullptr;
+    seekEntryCount = 0u;
+    seekInterval = 0u;
+    seedFences.clear();
+    indexFences.clear();
+}
+
+//----------------------------------------------------------------------------
+const SystemRecord* RecordFileReader::find(const RecordSeekEntry* entries, const std::vector<uint64_t>& fences, uint64_t RecordSeekEntry::* key, uint64_t value)
+{
+    if (!entries || fences.empty() || value < fences.front())
+    {
+        return nullptr;
+    }
+
+    // The fences give the page of entries, then the page gives the entry following the key.
+    const uint64_t page = static_cast<uint64_t>(std::upper_bound(fences.begin(), fences.end(), value) - fences.begin()) - 1u;
+    const RecordSeekEntry* begin = entries + page * RecordSeekTrailer::EntriesPerPage;
+    const RecordSeekEntry* end = entries + std::min(seekEntryCount, (page + 1u) * RecordSeekTrailer::EntriesPerPage);
+    const RecordSeekEntry* e = std::upper_bound(begin, end, value,
+        [key](uint64_t v, const RecordSeekEntry& entry) { return v < entry.*key; });
+
+    // Runs are at most seekInterval long, so only the entries that close to the key can cover it.  There
+    // is more than one candidate when batches of the file overlap.
+    while (e != entries)
+    {
+        --e;
+        const uint64_t position = value - (*e).*key;
+        if (position >= seekInterval)
+        {
+            break;
+        }
+        if (position < e->recordCount)
+        {
+            return read(*e, position);
+        }
+    }
+
+    return nullptr;
+}
+
+//----------------------------------------------------------------------------
+const SystemRecord* RecordFileReader::findSeed(uint64_t seed)
+{
+    return find(seedEntries, seedFences, &RecordSeekEntry::seed, seed);
+}
+
+//----------------------------------------------------------------------------
+const SystemRecord* RecordFileReader::findSystemIndex(uint64_t systemIndex)
+{
+    return find(indexEntries, indexFences, &RecordSeekEntry::systemIndex, systemIndex);
+}
+
+//----------------------------------------------------------------------------
+bool RecordFileReader::open(const char* path)
+{
+    close();
+
+#if defined(_WIN32)
+    (void)path;
+    return false;
+#else
+    const int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    mapSize = static_cast<size_t>(st.st_size);
+    void* p = mmap(nullptr, mapSize, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED)
+    {
+        mapSize = 0u;
+        return false;
+    }
+    map = static_cast<const uint8_t*>(p);
+
+    // Lookups touch a few scattered pages; read-ahead would only add latency.
+    madvise(p, mapSize, MADV_RANDOM);
+
+    dataEnd = mapSize;
+    RecordSeekTrailer trailer;
+    if (mapSize >= sizeof(trailer))
+    {
+        memcpy(&trailer, map + mapSize - sizeof(trailer), sizeof(trailer));
+        const uint64_t entryBytes = trailer.entryCount * sizeof(RecordSeekEntry);
+        const uint64_t fenceBytes = 2u * trailer.getFenceCount() * sizeof(uint64_t);
+        if (trailer.magic == RecordSeekTrailer::Magic && trailer.version == RecordSeekTrailer::SeekVersion &&
+            trailer.entryCount < mapSize / sizeof(RecordSeekEntry) &&
+            trailer.seedOffset <= mapSize && trailer.indexOffset <= mapSize && trailer.fenceOffset <= mapSize &&
+            trailer.dataSize <= trailer.seedOffset && trailer.seedOffset % RecordSeekTrailer::PageSize == 0u &&
+            trailer.seedOffset + entryBytes <= trailer.indexOffset && trailer.indexOffset % RecordSeekTrailer::PageSize == 0u &&
+            trailer.indexOffset + entryBytes <= trailer.fenceOffset &&
+            trailer.fenceOffset + fenceBytes <= mapSize - sizeof(trailer))
+        {
+            dataEnd = static_cast<size_t>(trailer.dataSize);
+            seekEntryCount = trailer.entryCount;
+            seekInterval = trailer.interval;
+            seedEntries = reinterpret_cast<const RecordSeekEntry*>(map + trailer.seedOffset);
+            indexEntries = reinterpret_cast<const RecordSeekEntry*>(map + trailer.indexOffset);
+
+            const uint64_t fenceCount = trailer.getFenceCount();
+            const uint64_t* fences = reinterpret_cast<const uint64_t*>(map + trailer.fenceOffset);
+            seedFences.assign(fences, fences + fenceCount);
+            indexFences.assign(fences + fenceCount, fences + 2u * fenceCount);
+        }
+    }
+
+    RecordStreamHeader header;
+    if (dataEnd >= sizeof(header))
+    {
+        memcpy(&header, map, sizeof(header));
+        if (header.isValid())
+        {
+            compressed = true;
+            dataBegin = sizeof(header);
+            decoder = RecordDecoder(header.precision);
+        }
+    }
+
+    return true;
+#endif
+}
+
+//----------------------------------------------------------------------------
+const SystemRecord* RecordFileReader::read(const RecordSeekEntry& entry, uint64_t position)
+{
+    if (entry.offset < dataBegin || entry.offset >= dataEnd)
+    {
+        return nullptr;
+    }
+
+    const uint8_t* p = map + entry.offset;
+    const uint8_t* end = map + dataEnd;
+
+    if (!compressed)
+    {
+        for (uint64_t i = 0;; ++i)
+        {
+            if (static_cast<size_t>(end - p) < sizeof(SystemRecord))
+            {
+                return nullptr;
+            }
+            const SystemRecord* record = reinterpret_cast<const SystemRecord*>(p);
+            if (record->size < sizeof(SystemRecord) || record->size > static_cast<size_t>(end - p))
+            {
+                return nullptr;
+            }
+            if (i == position)
+            {
+                return record;
+            }
+            p += record->size;
+        }
+    }
+
+    // Deltas run through the block, so decoding starts at the entry, whose seed and systemIndex are known.
+    decoder.resume(entry.seed, entry.systemIndex);
+    for (uint64_t i = 0; i <= position; ++i)
+    {
+        const size_t size = RecordDecoder::GetDecodedSize(p, static_cast<size_t>(end - p));
+        if (size == 0u)
+        {
+            return nullptr;
+        }
+        scratch.resize((size + sizeof(uint64_t) - 1u) / sizeof(uint64_t));
+        const size_t used = decoder.decode(p, static_cast<size_t>(end - p), scratch.data(), size);
+        if (used == 0u)
+        {
+            return nullptr;
+        }
+        p += used;
+    }
+
+    return reinterpret_cast<const SystemRecord*>(scratch.data());
+}
+
+}
+}
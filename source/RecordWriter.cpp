@@ -0,0 +1,885 @@
+/*****************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Questionable Coding
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************/
+#include <qcSysGen/RecordWriter.h>
+
+#include <qcSysGen/System.h>
+#include <qcSysGen/SystemRecord.h>
+
+#include <algorithm>
+#include <new>
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined(_WIN32)
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+namespace
+{
+
+/// @brief Alignment of the output buffers.
+static constexpr size_t RecordWriterAlignment = 4096u;
+
+#if !defined(_WIN32)
+//----------------------------------------------------------------------------
+// Write a whole buffer at an offset.
+bool WriteAll(int fd, const uint8_t* data, size_t size, uint64_t offset)
+{
+    while (size > 0u)
+    {
+        const ssize_t written = pwrite(fd, data, size, static_cast<off_t>(offset));
+        if (written < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (written <= 0)
+        {
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+        offset += static_cast<uint64_t>(written);
+    }
+
+    return true;
+}
+#endif
+
+//----------------------------------------------------------------------------
+// Account for a record in the seek index entries of its block, starting a new entry unless it continues
+// the last run.
+void AddSeekEntry(std::vector<qc::SystemGenerator::RecordSeekEntry>& entries, uint32_t interval, uint64_t seed, uint64_t systemIndex, size_t offset)
+{
+    if (interval == 0u)
+    {
+        return;
+    }
+
+    if (!entries.empty())
+    {
+        qc::SystemGenerator::RecordSeekEntry& last = entries.back();
+        if (last.recordCount < interval && seed == last.seed + last.recordCount && systemIndex == last.systemIndex + last.recordCount)
+        {
+            ++last.recordCount;
+            return;
+        }
+    }
+
+    qc::SystemGenerator::RecordSeekEntry entry;
+    entry.seed = seed;
+    entry.systemIndex = systemIndex;
+    entry.offset = offset;
+    entry.recordCount = 1u;
+    entry.reserved = 0u;
+    entries.emplace_back(entry);
+}
+
+}
+
+namespace qc
+{
+
+namespace SystemGenerator
+{
+
+/// @brief An output buffer.
+struct RecordWriter::Buffer
+{
+    uint8_t* data = nullptr; //!< RecordWriterAlignment aligned storage of RecordWriterSettings::bufferSize bytes.
+    size_t used = 0u; //!< Bytes filled.
+    uint32_t recordCount = 0u; //!< Records appended by a producer.
+    uint64_t offset = 0u; //!< File offset, once submitted.
+    std::vector<RecordSeekEntry> seekEntries; //!< Runs of the records, at offsets from the start of the buffer.
+#if !defined(_WIN32)
+    iovec vector; //!< The io_uring write of the buffer.
+#endif
+};
+
+/// @brief Records of consecutive indices staged by one producer in ordered mode.
+struct RecordWriter::Chunk
+{
+    uint64_t first = 0u; //!< The first index covered.
+    uint64_t next = 0u; //!< The index following the last one covered.
+    uint32_t recordCount = 0u; //!< Number of records.
+    std::vector<uint8_t> bytes; //!< The records.
+    std::vector<RecordSeekEntry> seekEntries; //!< Runs of the records, at offsets from the start of `bytes`.
+};
+
+/// @brief The state of a producer.  Aligned, and so padded, to a cache line; each one is allocated on its own
+/// with posix_memalign(), since new and std::allocator ignore the alignment before C++17.
+struct alignas(64) RecordWriter::Producer
+{
+    Buffer* buffer = nullptr; //!< The buffer being filled, when not ordered.
+    Chunk* chunk = nullptr; //!< The chunk being filled, when ordered.
+    RecordEncoder encoder; //!< Compresses the records, when compressing.
+    std::vector<uint64_t> scratch; //!< The SystemRecord being compressed.
+};
+
+#if defined(__linux__)
+/// @brief A minimal io_uring: the mapped submission and completion rings.
+struct RecordWriter::IoRing
+{
+    int fd = -1; //!< The ring.
+    uint32_t entries = 0u; //!< Number of submission queue entries.
+
+    void* sqMap = MAP_FAILED; //!< Mapping of the submission ring.
+    size_t sqMapSize = 0u; //!< Size of `sqMap`.
+    void* cqMap = MAP_FAILED; //!< Mapping of the completion ring.  May be `sqMap`.
+    size_t cqMapSize = 0u; //!< Size of `cqMap`.
+    io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED); //!< The submission queue entries.
+    size_t sqesSize = 0u; //!< Size of `sqes`.
+
+    uint32_t* sqTail = nullptr; //!< Submission ring tail, written by us.
+    uint32_t sqMask = 0u; //!< Submission ring mask.
+    uint32_t* sqArray = nullptr; //!< Submission ring entries.
+    uint32_t* cqHead = nullptr; //!< Completion ring head, written by us.
+    uint32_t* cqTail = nullptr; //!< Completion ring tail, written by the kernel.
+    uint32_t cqMask = 0u; //!< Completion ring mask.
+    io_uring_cqe* cqes = nullptr; //!< The completion queue entries.
+
+    ~IoRing()
+    {
+        if (sqes != MAP_FAILED) { munmap(sqes, sqesSize); }
+        if (cqMap != MAP_FAILED && cqMap != sqMap) { munmap(cqMap, cqMapSize); }
+        if (sqMap != MAP_FAILED) { munmap(sqMap, sqMapSize); }
+        if (fd >= 0) { ::close(fd); }
+    }
+
+    //----------------------------------------------------------------------------
+    // Create the ring.  Returns false if the kernel does not support io_uring.
+    bool setup(uint32_t entries_)
+    {
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        fd = static_cast<int>(syscall(__NR_io_uring_setup, entries_, &params));
+        if (fd < 0)
+        {
+            return false;
+        }
+        entries = params.sq_entries;
+
+        sqMapSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+        cqMapSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0u;
+        if (singleMap)
+        {
+            sqMapSize = cqMapSize = std::max(sqMapSize, cqMapSize);
+        }
+
+        sqMap = mmap(nullptr, sqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        if (sqMap == MAP_FAILED)
+        {
+            return false;
+        }
+        cqMap = singleMap ? sqMap : mmap(nullptr, cqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (cqMap == MAP_FAILED)
+        {
+            return false;
+        }
+        sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        sqes = static_cast<io_uring_sqe*>(mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+        if (sqes == MAP_FAILED)
+        {
+            return false;
+        }
+
+        uint8_t* sq = static_cast<uint8_t*>(sqMap);
+        sqTail = reinterpret_cast<uint32_t*>(sq + params.sq_off.tail);
+        sqMask = *reinterpret_cast<uint32_t*>(sq + params.sq_off.ring_mask);
+        sqArray = reinterpret_cast<uint32_t*>(sq + params.sq_off.array);
+
+        uint8_t* cq = static_cast<uint8_t*>(cqMap);
+        cqHead = reinterpret_cast<uint32_t*>(cq + params.cq_off.head);
+        cqTail = reinterpret_cast<uint32_t*>(cq + params.cq_off.tail);
+        cqMask = *reinterpret_cast<uint32_t*>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+        return true;
+    }
+
+    //----------------------------------------------------------------------------
+    // Queue the write of a buffer.  The caller keeps the number of writes in flight within `entries`.
+    void queueWrite(int file, Buffer* buffer)
+    {
+        const uint32_t tail = *sqTail;
+        const uint32_t index = tail & sqMask;
+
+        buffer->vector.iov_base = buffer->data;
+        buffer->vector.iov_len = buffer->used;
+
+        io_uring_sqe& sqe = sqes[index];
+        memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = IORING_OP_WRITEV;
+        sqe.fd = file;
+        sqe.off = buffer->offset;
+        sqe.addr = reinterpret_cast<uint64_t>(&buffer->vector);
+        sqe.len = 1u;
+        sqe.user_data = reinterpret_cast<uint64_t>(buffer);
+
+        sqArray[index] = index;
+        __atomic_store_n(sqTail, tail + 1u, __ATOMIC_RELEASE);
+    }
+
+    //----------------------------------------------------------------------------
+    // Submit the queued writes, and wait for at least `minComplete` completions.
+    bool enter(uint32_t submitCount, uint32_t minComplete)
+    {
+        for (;;)
+        {
+            const long result = syscall(__NR_io_uring_enter, fd, submitCount, minComplete, IORING_ENTER_GETEVENTS, nullptr, 0);
+            if (result >= 0)
+            {
+                return true;
+            }
+            if (errno != EINTR && errno != EAGAIN && errno != EBUSY)
+            {
+                return false;
+            }
+        }
+    }
+
+    //----------------------------------------------------------------------------
+    // Take back the last writes queued, which enter() failed to submit.
+    void unqueue(uint32_t count)
+    {
+        __atomic_store_n(sqTail, *sqTail - count, __ATOMIC_RELEASE);
+    }
+};
+#else
+struct RecordWriter::IoRing
+{
+};
+#endif
+
+//----------------------------------------------------------------------------
+RecordWriter::RecordWriter()
+{
+}
+
+//----------------------------------------------------------------------------
+RecordWriter::~RecordWriter()
+{
+    close();
+}
+
+//----------------------------------------------------------------------------
+RecordWriter::Buffer* RecordWriter::acquireBuffer()
+{
+    std::unique_lock<std::mutex> lock(bufferMutex);
+    bufferFreed.wait(lock, [this]() { return !freeBuffers.empty(); });
+
+    Buffer* buffer = freeBuffers.back();
+    freeBuffers.pop_back();
+    return buffer;
+}
+
+//----------------------------------------------------------------------------
+RecordWriter::Chunk* RecordWriter::acquireChunk(Producer& producer, uint64_t systemIndex)
+{
+    Chunk* chunk;
+    {
+        std::lock_guard<std::mutex> guard(orderMutex);
+        if (freeChunks.empty())
+        {
+            chunks.emplace_back(new Chunk);
+            chunk = chunks.back();
+        }
+        else
+        {
+            chunk = freeChunks.back();
+            freeChunks.pop_back();
+        }
+    }
+
+    chunk->first = chunk->next = systemIndex;
+    chunk->recordCount = 0u;
+    chunk->seekEntries.clear();
+    if (settings.compress)
+    {
+        chunk->bytes.resize(sizeof(RecordBlockHeader));
+        producer.encoder.reset();
+    }
+
+    return chunk;
+}
+
+//----------------------------------------------------------------------------
+bool RecordWriter::append(uint32_t producer, uint64_t seed, uint64_t systemIndex, const SolarSystem& system)
+{
+    const size_t recordSize = SystemRecord::GetSize(system);
+    const size_t size = settings.compress ? RecordEncoder::GetMaxSize(static_cast<uint32_t>(system.getPlanets().size())) + sizeof(RecordBlockHeader) : recordSize;
+    if (file < 0 || size > settings.bufferSize || failed.load(std::memory_order_relaxed))
+    {
+        return false;
+    }
+
+    Producer& p = *producers[producer];
+
+    // With compression, the record is built in the scratch buffer and encoded at the destination.
+    const SystemRecord* record = nullptr;
+    if (settings.compress)
+    {
+        p.scratch.resize((recordSize + sizeof(uint64_t) - 1u) / sizeof(uint64_t));
+        SystemRecord::Write(p.scratch.data(), recordSize, seed, systemIndex, system);
+        record = reinterpret_cast<const SystemRecord*>(p.scratch.data());
+    }
+
+    if (!settings.ordered)
+    {
+        if (p.buffer && p.buffer->used + size > settings.bufferSize)
+        {
+            closeBlock(p.buffer->data, p.buffer->used, p.buffer->recordCount);
+            submit(p.buffer);
+            p.buffer = nullptr;
+        }
+        if (!p.buffer)
+        {
+            p.buffer = acquireBuffer();
+            if (settings.compress)
+            {
+                p.buffer->used = sizeof(RecordBlockHeader);
+                p.encoder.reset();
+            }
+        }
+
+        AddSeekEntry(p.buffer->seekEntries, settings.seekInterval, seed, systemIndex, p.buffer->used);
+        uint8_t* out = p.buffer->data + p.buffer->used;
+        p.buffer->used += record ? p.encoder.encode(*record, out) : SystemRecord::Write(out, recordSize, seed, systemIndex, system);
+        ++p.buffer->recordCount;
+        return true;
+    }
+
+    if (p.chunk && (p.chunk->next != systemIndex || p.chunk->bytes.size() + size > settings.bufferSize))
+    {
+        seal(p.chunk);
+        p.chunk = nullptr;
+    }
+    if (!p.chunk)
+    {
+        p.chunk = acquireChunk(p, systemIndex);
+    }
+
+    const size_t offset = p.chunk->bytes.size();
+    AddSeekEntry(p.chunk->seekEntries, settings.seekInterval, seed, systemIndex, offset);
+    p.chunk->bytes.resize(offset + size);
+    uint8_t* out = p.chunk->bytes.data() + offset;
+    p.chunk->bytes.resize(offset + (record ? p.encoder.encode(*record, out) : SystemRecord::Write(out, recordSize, seed, systemIndex, system)));
+    p.chunk->next = systemIndex + 1u;
+    ++p.chunk->recordCount;
+
+    return true;
+}
+
+//----------------------------------------------------------------------------
+bool RecordWriter::close()
+{
+#if !defined(_WIN32)
+    if (file < 0)
+    {
+        return true;
+    }
+
+    for (uint32_t i = 0; i < producers.size(); ++i)
+    {
+        flush(i);
+    }
+
+    if (settings.ordered)
+    {
+        std::lock_guard<std::mutex> guard(orderMutex);
+        for (auto& c : waitingChunks)
+        {
+            pack(c.second);
+        }
+        waitingChunks.clear();
+        if (packing)
+        {
+            submit(packing);
+            packing = nullptr;
+        }
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(bufferMutex);
+        bufferFreed.wait(lock, [this]() { return pendingWrites == 0u; });
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(writeMutex);
+        stopping = true;
+    }
+    writeQueued.notify_all();
+    for (auto& t : ioThreads)
+    {
+        t.join();
+    }
+    ioThreads.clear();
+    delete ring;
+    ring = nullptr;
+
+    if (settings.seekInterval > 0u && !failed.load(std::memory_order_relaxed) && !writeSeekIndex())
+    {
+        failed = true;
+    }
+    seekEntries.clear();
+    seekEntries.shrink_to_fit();
+
+    for (auto& b : buffers)
+    {
+        free(b.data);
+    }
+    buffers.clear();
+    freeBuffers.clear();
+    for (Chunk* c : chunks)
+    {
+        delete c;
+    }
+    chunks.clear();
+    freeChunks.clear();
+    for (Producer* p : producers)
+    {
+        p->~Producer();
+        free(p);
+    }
+    producers.clear();
+
+    ::close(file);
+    file = -1;
+#endif
+
+    return !failed.load(std::memory_order_relaxed);
+}
+
+//----------------------------------------------------------------------------
+void RecordWriter::closeBlock(uint8_t* block, size_t& used, uint32_t recordCount)
+{
+    if (!settings.compress)
+    {
+        return;
+    }
+
+    if (recordCount == 0u)
+    {
+        used = 0u;
+        return;
+    }
+
+    RecordBlockHeader header;
+    header.size = static_cast<uint32_t>(used - sizeof(RecordBlockHeader));
+    header.recordCount = recordCount;
+    memcpy(block, &header, sizeof(header));
+}
+
+//----------------------------------------------------------------------------
+void RecordWriter::completeWrite(Buffer* buffer, bool succeeded)
+{
+    if (!succeeded)
+    {
+        failed = true;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(bufferMutex);
+        buffer->used = 0u;
+        buffer->recordCount = 0u;
+        buffer->seekEntries.clear();
+        freeBuffers.emplace_back(buffer);
+        --pendingWrites;
+    }
+    bufferFreed.notify_all();
+}
+
+//----------------------------------------------------------------------------
+void RecordWriter::flush(uint32_t producer)
+{
+    Producer& p = *producers[producer];
+    if (p.buffer)
+    {
+        closeBlock(p.buffer->data, p.buffer->used, p.buffer->recordCount);
+        submit(p.buffer);
+        p.buffer = nullptr;
+    }
+    if (p.chunk)
+    {
+        seal(p.chunk);
+        p.chunk = nullptr;
+    }
+}
+
+//----------------------------------------------------------------------------
+bool RecordWriter::open(const char* path, const RecordWriterSettings& settings_)
+{
+    close();
+
+#if defined(_WIN32)
+    (void)path;
+    (void)settings_;
+    return false;
+#else
+    settings = settings_;
+    settings.producerCount = std::max(1u, settings.producerCount);
+    settings.buffersInFlight = std::max(1u, settings.buffersInFlight);
+    settings.ioThreadCount = std::max(1u, settings.ioThreadCount);
+    settings.bufferSize = (std::max(settings.bufferSize, sizeof(SystemRecord)) + RecordWriterAlignment - 1u) & ~(RecordWriterAlignment - 1u);
+
+    file = ::open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (file < 0)
+    {
+        return false;
+    }
+
+    // Enough buffers for every one that may be filling, plus the ones in flight.
+    const uint32_t bufferCount = settings.buffersInFlight + (settings.ordered ? 1u : settings.producerCount);
+    buffers.resize(bufferCount);
+    freeBuffers.reserve(bufferCount);
+    for (auto& b : buffers)
+    {
+        void* data = nullptr;
+        if (posix_memalign(&data, RecordWriterAlignment, settings.bufferSize) != 0)
+        {
+            close();
+            return false;
+        }
+        b.data = static_cast<uint8_t*>(data);
+        freeBuffers.emplace_back(&b);
+    }
+    producers.reserve(settings.producerCount);
+    for (uint32_t i = 0; i < settings.producerCount; ++i)
+    {
+        void* memory = nullptr;
+        if (posix_memalign(&memory, alignof(Producer), sizeof(Producer)) != 0)
+        {
+            close();
+            return false;
+        }
+        Producer* p = new (memory) Producer;
+        p->encoder = RecordEncoder(settings.precision);
+        producers.emplace_back(p);
+    }
+
+    pendingWrites = 0u;
+    stopping = false;
+    fileSize = 0u;
+
+    if (settings.compress)
+    {
+        const RecordStreamHeader header = RecordStreamHeader::Make(settings.precision);
+        if (!WriteAll(file, reinterpret_cast<const uint8_t*>(&header), sizeof(header), 0u))
+        {
+            close();
+            return false;
+        }
+        fileSize = sizeof(header);
+    }
+    failed = false;
+    nextIndex = settings.firstIndex;
+
+    backend = RecordWriterBackend::ThreadPool;
+#if defined(__linux__)
+    if (settings.useIoUring)
+    {
+        ring = new IoRing;
+        if (ring->setup(settings.buffersInFlight))
+        {
+            backend = RecordWriterBackend::IoUring;
+            ioThreads.emplace_back(&RecordWriter::runIoRing, this);
+        }
+        else
+        {
+            delete ring;
+            ring = nullptr;
+        }
+    }
+#endif
+    if (backend == RecordWriterBackend::ThreadPool)
+    {
+        for (uint32_t i = 0; i < settings.ioThreadCount; ++i)
+        {
+            ioThreads.emplace_back(&RecordWriter::runIoThread, this);
+        }
+    }
+
+    return true;
+#endif
+}
+
+//----------------------------------------------------------------------------
+void RecordWriter::pack(Chunk* chunk)
+{
+    const uint8_t* bytes = chunk->bytes.data();
+    size_t remaining = chunk->bytes.size();
+
+    // Ordered files are written strictly in sequence, so the chunk lands after the buffer being packed.
+    if (!chunk->seekEntries.empty())
+    {
+        const uint64_t offset = fileSize.load(std::memory_order_relaxed) + (packing ? packing->used : 0u);
+        std::lock_guard<std::mutex> guard(writeMutex);
+        for (RecordSeekEntry e : chunk->seekEntries)
+        {
+            e.offset += offset;
+            seekEntries.emplace_back(e);
+        }
+    }
+
+    // The file is contiguous, so a chunk may straddle two buffers.
+    while (remaining > 0u)
+    {
+        if (!packing)
+        {
+            packing = acquireBuffer();
+        }
+
+        const size_t count = std::min(remaining, settings.bufferSize - packing->used);
+        memcpy(packing->data + packing->used, bytes, count);
+        packing->used += count;
+        bytes += count;
+        remaining -= count;
+
+        if (packing->used == settings.bufferSize)
+        {
+            submit(packing);
+            packing = nullptr;
+        }
+    }
+
+    chunk->bytes.clear();
+    freeChunks.emplace_back(chunk);
+}
+
+//----------------------------------------------------------------------------
+void RecordWriter::runIoRing()
+{
+#if defined(__linux__)
+    uint32_t inFlight = 0u;
+    std::vector<Buffer*> batch;
+    batch.reserve(ring->entries);
+
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(writeMutex);
+            if (inFlight == 0u)
+            {
+                writeQueued.wait(lock, [this]() { return stopping || !writes.empty(); });
+                if (writes.empty())
+                {
+                    return;
+                }
+            }
+            while (!writes.empty() && inFlight + batch.size() < ring->entries)
+            {
+                batch.emplace_back(writes.front());
+                writes.pop_front();
+            }
+        }
+
+        for (Buffer* b : batch)
+        {
+            ring->queueWrite(file, b);
+        }
+
+        // Submit the new writes and wait for at least one to complete, so the next pass can queue more.
+        if (ring->enter(static_cast<uint32_t>(batch.size()), 1u))
+        {
+            inFlight += static_cast<uint32_t>(batch.size());
+        }
+        else
+        {
+            // Nothing was submitted: take the writes back and make them synchronously.  The writes already in
+            // flight still complete on their own.
+            ring->unqueue(static_cast<uint32_t>(batch.size()));
+            for (Buffer* b : batch)
+            {
+                completeWrite(b, WriteAll(file, b->data, b->used, b->offset));
+            }
+            std::this_thread::yield();
+        }
+        batch.clear();
+
+        uint32_t head = *ring->cqHead;
+        const uint32_t tail = __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE);
+        while (head != tail)
+        {
+            const io_uring_cqe& cqe = ring->cqes[head & ring->cqMask];
+            Buffer* buffer = reinterpret_cast<Buffer*>(cqe.user_data);
+
+            // Finish short or rejected writes with pwrite().
+            const size_t written = (cqe.res > 0) ? static_cast<size_t>(cqe.res) : 0u;
+            const bool succeeded = (written == buffer->used) ||
+                WriteAll(file, buffer->data + written, buffer->used - written, buffer->offset + written);
+
+            completeWrite(buffer, succeeded);
+            --inFlight;
+            ++head;
+        }
+        __atomic_store_n(ring->cqHead, head, __ATOMIC_RELEASE);
+    }
+#endif
+}
+
+//----------------------------------------------------------------------------
+void RecordWriter::runIoThread()
+{
+#if !defined(_WIN32)
+    for (;;)
+    {
+        Buffer* buffer;
+        {
+            std::unique_lock<std::mutex> lock(writeMutex);
+            writeQueued.wait(lock, [this]() { return stopping || !writes.empty(); });
+            if (writes.empty())
+            {
+                return;
+            }
+            buffer = writes.front();
+            writes.pop_front();
+        }
+
+        completeWrite(buffer, WriteAll(file, buffer->data, buffer->used, buffer->offset));
+    }
+#endif
+}
+
+//----------------------------------------------------------------------------
+void RecordWriter::seal(Chunk* chunk)
+{
+    size_t used = chunk->bytes.size();
+    closeBlock(chunk->bytes.data(), used, chunk->recordCount);
+    chunk->bytes.resize(used);
+
+    std::lock_guard<std::mutex> guard(orderMutex);
+    waitingChunks.emplace(chunk->first, chunk);
+
+    // Pack every chunk that continues the run written so far.
+    while (!waitingChunks.empty() && waitingChunks.begin()->first <= nextIndex)
+    {
+        Chunk* c = waitingChunks.begin()->second;
+        waitingChunks.erase(waitingChunks.begin());
+        nextIndex = std::max(nextIndex, c->next);
+        pack(c);
+    }
+}
+
+//----------------------------------------------------------------------------
+void RecordWriter::skip(uint32_t producer, uint64_t systemIndex)
+{
+    if (file < 0 || !settings.ordered)
+    {
+        return;
+    }
+
+    Producer& p = *producers[producer];
+    if (p.chunk && p.chunk->next != systemIndex)
+    {
+        seal(p.chunk);
+        p.chunk = nullptr;
+    }
+    if (!p.chunk)
+    {
+        p.chunk = acquireChunk(p, systemIndex);
+    }
+    p.chunk->next = systemIndex + 1u;
+}
+
+//----------------------------------------------------------------------------
+void RecordWriter::submit(Buffer* buffer)
+{
+    if (buffer->used == 0u)
+    {
+        std::lock_guard<std::mutex> guard(bufferMutex);
+        freeBuffers.emplace_back(buffer);
+        bufferFreed.notify_all();
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(bufferMutex);
+        ++pendingWrites;
+    }
+    {
+        std::lock_guard<std::mutex> guard(writeMutex);
+        buffer->offset = fileSize.load(std::memory_order_relaxed);
+        fileSize.store(buffer->offset + buffer->used, std::memory_order_relaxed);
+        for (RecordSeekEntry e : buffer->seekEntries)
+        {
+            e.offset += buffer->offset;
+            seekEntries.emplace_back(e);
+        }
+        writes.emplace_back(buffer);
+    }
+    writeQueued.notify_one();
+}
+//----------------------------------------------------------------------------
+bool RecordWriter::writeSeekIndex()
+{
+#if defined(_WIN32)
+    return false;
+#else
+    const size_t entryBytes = seekEntries.size() * sizeof(RecordSeekEntry);
+    const uint64_t pageMask = RecordSeekTrailer::PageSize - 1u;
+
+    RecordSeekTrailer trailer;
+    memset(&trailer, 0, sizeof(trailer));
+    trailer.dataSize = fileSize.load(std::memory_order_relaxed);
+    trailer.entryCount = seekEntries.size();
+    trailer.seedOffset = (trailer.dataSize + pageMask) & ~pageMask;
+    trailer.indexOffset = (trailer.seedOffset + entryBytes + pageMask) & ~pageMask;
+    trailer.fenceOffset = trailer.indexOffset + entryBytes;
+    trailer.interval = settings.seekInterval;
+    trailer.version = RecordSeekTrailer::SeekVersion;
+    trailer.magic = RecordSeekTrailer::Magic;
+
+    // Both orders are kept stable by file offset, so equal keys are found in file order.
+    std::vector<uint64_t> fences;
+    fences.reserve(2u * trailer.getFenceCount());
+    const auto writeOrder = [&](uint64_t RecordSeekEntry::* key, uint64_t offset)
+    {
+        std::sort(seekEntries.begin(), seekEntries.end(), [key](const RecordSeekEntry& a, const RecordSeekEntry& b)
+            { return a.*key < b.*key || (a.*key == b.*key && a.offset < b.offset); });
+        for (size_t i = 0; i < seekEntries.size(); i += RecordSeekTrailer::EntriesPerPage)
+        {
+            fences.emplace_back(seekEntries[i].*key);
+        }
+        return WriteAll(file, reinterpret_cast<const uint8_t*>(seekEntries.data()), entryBytes, offset);
+    };
+
+    return writeOrder(&RecordSeekEntry::seed, trailer.seedOffset) &&
+        writeOrder(&RecordSeekEntry::systemIndex, trailer.indexOffset) &&
+        WriteAll(file, reinterpret_cast<const uint8_t*>(fences.data()), fences.size() * sizeof(uint64_t), trailer.fenceOffset) &&
+        WriteAll(file, reinterpret_cast<const uint8_t*>(&trailer), sizeof(trailer), trailer.fenceOffset + fences.size() * sizeof(uint64_t));
+#endif
+}
+
+}
+}
@@ -0,0 +1,471 @@
+/*****************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Questionable Coding
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************/
+#include <qcSysGen/ResultRing.h>
+
+#include <qcSysGen/System.h>
+
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <thread>
+
+#if !defined(_WIN32)
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace qc
+{
+
+namespace SystemGenerator
+{
+
+/// @brief A reader's cursor.  One cache line each, so readers don't contend.
+struct alignas(64) ResultRingCursor
+{
+    std::atomic<uint64_t> position; //!< Everything before this position has been released.
+    std::atomic<uint32_t> pid; //!< Process ID of the reader, or 0 if the cursor is free.
+};
+
+/// @brief The start of the shared-memory object.
+struct alignas(64) ResultRingHeader
+{
+    std::atomic<uint32_t> magic; //!< ResultRingMagic once the header is initialized.
+    uint32_t version; //!< ResultRingVersion.
+    uint64_t capacity; //!< Size of the data area, a power of two.
+    std::atomic<uint32_t> writerPid; //!< Process ID of the writer.
+    std::atomic<uint32_t> closed; //!< Non-zero once the writer has closed the ring.
+
+    alignas(64) std::atomic<uint64_t> writePosition; //!< Everything before this position has been published.
+
+    ResultRingCursor cursor[ResultRingWriter::MaxReaders]; //!< Reader cursors.
+};
+
+}
+}
+
+namespace
+{
+
+using qc::SystemGenerator::ResultRingHeader;
+
+/// @brief Marks a valid ring header ("QCRR").
+static constexpr uint32_t ResultRingMagic = 0x52524351u;
+
+/// @brief Version of the ring layout.
+static constexpr uint32_t ResultRingVersion = 1u;
+
+/// @brief Frame value meaning "the rest of the data area is unused; continue at the start".
+static constexpr uint64_t WrapFrame = ~0ull;
+
+/// @brief Each record is preceded by a 64-bit frame holding its size.
+static constexpr uint64_t FrameSize = sizeof(uint64_t);
+
+//----------------------------------------------------------------------------
+// Round a size up to a multiple of 8, so frames stay aligned.
+__inline uint64_t AlignRecord(uint64_t size)
+{
+    return (size + 7u) & ~7ull;
+}
+
+//----------------------------------------------------------------------------
+// Returns the size of the header rounded up to the data area alignment.
+__inline size_t HeaderSize()
+{
+    return (sizeof(ResultRingHeader) + 63u) & ~static_cast<size_t>(63u);
+}
+
+//----------------------------------------------------------------------------
+// Back off while waiting on another process.
+void Backoff(uint32_t& attempt)
+{
+    if (++attempt < 64u)
+    {
+        std::this_thread::yield();
+    }
+    else
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+#if !defined(_WIN32)
+//----------------------------------------------------------------------------
+// Returns true if the process is running.
+bool IsProcessAlive(uint32_t pid)
+{
+    return pid != 0u && (kill(static_cast<pid_t>(pid), 0) == 0 || errno != ESRCH);
+}
+#endif
+
+}
+
+namespace qc
+{
+
+namespace SystemGenerator
+{
+
+//----------------------------------------------------------------------------
+bool ResultRingWriter::create(const char* name_, uint64_t capacity)
+{
+    close();
+
+#if defined(_WIN32)
+    (void)name_;
+    (void)capacity;
+    return false;
+#else
+    uint64_t dataSize = 4096u;
+    while (dataSize < capacity)
+    {
+        dataSize <<= 1u;
+    }
+    const size_t size = HeaderSize() + static_cast<size_t>(dataSize);
+
+    int fd = shm_open(name_, O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0 && errno == EEXIST)
+    {
+        // Only replace a ring whose writer is gone.
+        const int existing = shm_open(name_, O_RDONLY, 0);
+        if (existing >= 0)
+        {
+            struct stat st;
+            bool inUse = false;
+            if (fstat(existing, &st) == 0 && static_cast<size_t>(st.st_size) >= sizeof(ResultRingHeader))
+            {
+                void* p = mmap(nullptr, sizeof(ResultRingHeader), PROT_READ, MAP_SHARED, existing, 0);
+                if (p != MAP_FAILED)
+                {
+                    const ResultRingHeader* h = static_cast<const ResultRingHeader*>(p);
+                    inUse = h->magic.load(std::memory_order_acquire) == ResultRingMagic &&
+                        h->closed.load(std::memory_order_acquire) == 0u &&
+                        IsProcessAlive(h->writerPid.load(std::memory_order_relaxed));
+                    munmap(p, sizeof(ResultRingHeader));
+                }
+            }
+            ::close(existing);
+
+            if (inUse)
+            {
+                return false;
+            }
+        }
+
+        shm_unlink(name_);
+        fd = shm_open(name_, O_CREAT | O_EXCL | O_RDWR, 0644);
+    }
+
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0)
+    {
+        ::close(fd);
+        shm_unlink(name_);
+        return false;
+    }
+
+    void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED)
+    {
+        shm_unlink(name_);
+        return false;
+    }
+
+    name = name_;
+    mappedSize = size;
+    data = static_cast<uint8_t*>(p) + HeaderSize();
+
+    // The new object is zero-filled, so the magic is 0 until the header is complete.
+    header = new (p) ResultRingHeader;
+    header->version = ResultRingVersion;
+    header->capacity = dataSize;
+    header->writerPid.store(static_cast<uint32_t>(getpid()), std::memory_order_relaxed);
+    header->closed.store(0u, std::memory_order_relaxed);
+    header->writePosition.store(0u, std::memory_order_relaxed);
+    for (auto& c : header->cursor)
+    {
+        c.position.store(0u, std::memory_order_relaxed);
+        c.pid.store(0u, std::memory_order_relaxed);
+    }
+    header->magic.store(ResultRingMagic, std::memory_order_release);
+
+    return true;
+#endif
+}
+
+//----------------------------------------------------------------------------
+void ResultRingWriter::close()
+{
+#if !defined(_WIN32)
+    if (header)
+    {
+        header->closed.store(1u, std::memory_order_release);
+        munmap(header, mappedSize);
+        shm_unlink(name.c_str());
+    }
+#endif
+
+    header = nullptr;
+    data = nullptr;
+    mappedSize = 0u;
+    name.clear();
+}
+
+//----------------------------------------------------------------------------
+uint64_t ResultRingWriter::getReadLimit(uint64_t writePosition)
+{
+    uint64_t limit = writePosition;
+
+    for (auto& c : header->cursor)
+    {
+        const uint32_t pid = c.pid.load(std::memory_order_acquire);
+        if (pid == 0u)
+        {
+            continue;
+        }
+
+        const uint64_t position = c.position.load(std::memory_order_acquire);
+        if (position < limit)
+        {
+#if !defined(_WIN32)
+            if (!IsProcessAlive(pid))
+            {
+                // The reader died holding its cursor.  Detach it so it doesn't stall the ring forever.
+                uint32_t expected = pid;
+                c.pid.compare_exchange_strong(expected, 0u, std::memory_order_acq_rel);
+                continue;
+            }
+#endif
+            limit = position;
+        }
+    }
+
+    return limit;
+}
+
+//----------------------------------------------------------------------------
+bool ResultRingWriter::publish(uint64_t seed, uint64_t systemIndex, const SolarSystem& system, bool wait)
+{
+    if (header == nullptr)
+    {
+        return false;
+    }
+
+    const uint64_t capacity = header->capacity;
+    const uint64_t recordSize = AlignRecord(SystemRecord::GetSize(system));
+    const uint64_t need = FrameSize + recordSize;
+    if (need > capacity / 2u)
+    {
+        return false;
+    }
+
+    uint64_t position = header->writePosition.load(std::memory_order_relaxed);
+    const uint64_t offset = position & (capacity - 1u);
+    const uint64_t tail = capacity - offset;
+
+    // A record that doesn't fit before the end of the data area starts over at the beginning.
+    const uint64_t total = (tail < need) ? tail + need : need;
+
+    uint32_t attempt = 0u;
+    while (position + total - getReadLimit(position) > capacity)
+    {
+        if (!wait)
+        {
+            return false;
+        }
+        Backoff(attempt);
+    }
+
+    if (tail < need)
+    {
+        *reinterpret_cast<uint64_t*>(data + offset) = WrapFrame;
+        position += tail;
+    }
+
+    uint8_t* frame = data + (position & (capacity - 1u));
+    SystemRecord::Write(frame + FrameSize, static_cast<size_t>(recordSize), seed, systemIndex, system);
+    *reinterpret_cast<uint64_t*>(frame) = recordSize;
+
+    header->writePosition.store(position + need, std::memory_order_release);
+
+    return true;
+}
+
+//----------------------------------------------------------------------------
+bool ResultRingReader::attach(const char* name_)
+{
+    detach();
+
+#if defined(_WIN32)
+    (void)name_;
+    return false;
+#else
+    const int fd = shm_open(name_, O_RDWR, 0);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < HeaderSize())
+    {
+        ::close(fd);
+        return false;
+    }
+
+    void* p = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED)
+    {
+        return false;
+    }
+
+    ResultRingHeader* h = static_cast<ResultRingHeader*>(p);
+    // Don't attach to a ring left behind by a writer that's gone.
+    if (h->magic.load(std::memory_order_acquire) != ResultRingMagic || h->version != ResultRingVersion ||
+        HeaderSize() + h->capacity != static_cast<uint64_t>(st.st_size) ||
+        h->closed.load(std::memory_order_acquire) != 0u || !IsProcessAlive(h->writerPid.load(std::memory_order_relaxed)))
+    {
+        munmap(p, static_cast<size_t>(st.st_size));
+        return false;
+    }
+
+    // Claim a free cursor, then publish the write position into it.  Only the reader that won the pid
+    // writes the position.  Until it does, the writer sees the cursor's previous position, which is never
+    // ahead of the write position, so it only holds the writer back.
+    const uint32_t pid = static_cast<uint32_t>(getpid());
+    for (uint32_t i = 0; i < ResultRingWriter::MaxReaders; ++i)
+    {
+        ResultRingCursor& c = h->cursor[i];
+        uint32_t expected = 0u;
+        if (c.pid.load(std::memory_order_relaxed) == 0u && c.pid.compare_exchange_strong(expected, pid, std::memory_order_acq_rel))
+        {
+            header = h;
+            data = static_cast<const uint8_t*>(p) + HeaderSize();
+            mappedSize = static_cast<size_t>(st.st_size);
+            slot = i;
+            position = h->writePosition.load(std::memory_order_acquire);
+            c.position.store(position, std::memory_order_release);
+            holding = false;
+            return true;
+        }
+    }
+
+    munmap(p, static_cast<size_t>(st.st_size));
+    return false;
+#endif
+}
+
+//----------------------------------------------------------------------------
+void ResultRingReader::detach()
+{
+#if !defined(_WIN32)
+    if (header)
+    {
+        header->cursor[slot].pid.store(0u, std::memory_order_release);
+        munmap(header, mappedSize);
+    }
+#endif
+
+    header = nullptr;
+    data = nullptr;
+    mappedSize = 0u;
+    holding = false;
+}
+
+//----------------------------------------------------------------------------
+bool ResultRingReader::isFinished() const
+{
+    if (header == nullptr || header->closed.load(std::memory_order_acquire) != 0u)
+    {
+        return true;
+    }
+
+#if !defined(_WIN32)
+    return !IsProcessAlive(header->writerPid.load(std::memory_order_relaxed));
+#else
+    return true;
+#endif
+}
+
+//----------------------------------------------------------------------------
+const SystemRecord* ResultRingReader::next(uint32_t timeoutMilliseconds)
+{
+    if (header == nullptr)
+    {
+        return nullptr;
+    }
+
+    release();
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMilliseconds);
+    uint32_t attempt = 0u;
+    while (header->writePosition.load(std::memory_order_acquire) == position)
+    {
+        if (std::chrono::steady_clock::now() >= deadline || isFinished())
+        {
+            return nullptr;
+        }
+        Backoff(attempt);
+    }
+
+    const uint64_t capacity = header->capacity;
+    uint64_t offset = position & (capacity - 1u);
+    uint64_t frame = *reinterpret_cast<const uint64_t*>(data + offset);
+    if (frame == WrapFrame)
+    {
+        position += capacity - offset;
+        offset = 0u;
+        frame = *reinterpret_cast<const uint64_t*>(data);
+    }
+
+    pending = position + FrameSize + frame;
+    holding = true;
+
+    return reinterpret_cast<const SystemRecord*>(data + offset + FrameSize);
+}
+
+//----------------------------------------------------------------------------
+void ResultRingReader::release()
+{
+    if (header && holding)
+    {
+        position = pending;
+        header->cursor[slot].position.store(position, std::memory_order_release);
+        holding = false;
+    }
+}
+
+}
+}
@@ -0,0 +1,507 @@
+/*****************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Questionable Coding
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************/
+#include <qcSysGen/SeedOptimizer.h>
+
+#include <qcSysGen/Consts.h>
+#include <qcSysGen/Generator.h>
+#include <qcSysGen/System.h>
+
+#include <algorithm>
+#include <atomic>
+#include <math.h>
+#include <random>
+#include <thread>
+
+namespace
+{
+
+using qc::SystemGenerator::DesignCandidate;
+using qc::SystemGenerator::TargetRange;
+
+/// @brief Highest eccentricity the optimizer gives a seed.
+static constexpr float MaxSeedEccentricity = 0.5f;
+
+/// @brief Size of each edge of the initial simplex, in normalized coordinates.
+static constexpr double InitialSimplexSize = 0.1;
+
+/// @brief The simplex has converged when its scores and extent are this close.
+static constexpr double SimplexTolerance = 1.0e-4;
+
+/// @brief One vertex of a Nelder-Mead simplex.
+struct Vertex
+{
+    std::vector<double> x; //!< Normalized coordinates, [0, 1].
+    float f; //!< Score.
+};
+
+//----------------------------------------------------------------------------
+// Ranks two designs: lowest score first.  Ties are broken by seed and placement so the ranking is a total order.
+bool IsBetterDesign(const DesignCandidate& lhs, const DesignCandidate& rhs)
+{
+    if (lhs.score != rhs.score)
+    {
+        return lhs.score < rhs.score;
+    }
+    if (lhs.seed != rhs.seed)
+    {
+        return lhs.seed < rhs.seed;
+    }
+
+    for (size_t i = 0; i < std::min(lhs.seeds.size(), rhs.seeds.size()); ++i)
+    {
+        if (lhs.seeds[i].semiMajorAxis != rhs.seeds[i].semiMajorAxis)
+        {
+            return lhs.seeds[i].semiMajorAxis < rhs.seeds[i].semiMajorAxis;
+        }
+        if (lhs.seeds[i].eccentricity != rhs.seeds[i].eccentricity)
+        {
+            return lhs.seeds[i].eccentricity < rhs.seeds[i].eccentricity;
+        }
+    }
+
+    return lhs.seeds.size() < rhs.seeds.size();
+}
+
+//----------------------------------------------------------------------------
+// Returns true if two designs generate the same system.
+bool IsSameDesign(const DesignCandidate& lhs, const DesignCandidate& rhs)
+{
+    return !IsBetterDesign(lhs, rhs) && !IsBetterDesign(rhs, lhs);
+}
+
+//----------------------------------------------------------------------------
+// Keep `candidate` if it is one of the `count` best designs in `best`.
+void KeepDesign(std::vector<DesignCandidate>& best, const DesignCandidate& candidate, uint32_t count)
+{
+    for (const auto& b : best)
+    {
+        if (IsSameDesign(b, candidate))
+        {
+            return;
+        }
+    }
+
+    if (best.size() < count)
+    {
+        best.emplace_back(candidate);
+    }
+    else if (!best.empty() && IsBetterDesign(candidate, best.back()))
+    {
+        best.back() = candidate;
+    }
+    else
+    {
+        return;
+    }
+
+    std::sort(best.begin(), best.end(), IsBetterDesign);
+}
+
+//----------------------------------------------------------------------------
+// Returns how far `value` is outside `range`, relative to the size of the range.
+float RangePenalty(const TargetRange& range, float value)
+{
+    if (!range.isSet() || (value >= range.lower && value <= range.upper))
+    {
+        return 0.0f;
+    }
+
+    const float bound = (value < range.lower) ? range.lower : range.upper;
+    const float scale = std::max(range.upper - range.lower, std::max(0.1f * fabsf(bound), 1.0e-3f));
+
+    return fabsf(value - bound) / scale;
+}
+
+}
+
+namespace qc
+{
+
+namespace SystemGenerator
+{
+
+//----------------------------------------------------------------------------
+float PlanetTarget::getPenalty(const Planet& planet) const
+{
+    float penalty = 0.0f;
+
+    if (typeMask != 0u && (typeMask & (1u << static_cast<uint32_t>(planet.getPlanetType()))) == 0u)
+    {
+        penalty += 1.0f;
+    }
+
+    penalty += RangePenalty(semimajorAxis, static_cast<float>(planet.getSemimajorAxis()));
+    penalty += RangePenalty(mass, static_cast<float>(planet.getMass() * SolarMassToEarthMass));
+    penalty += RangePenalty(radius, planet.getRadius());
+    penalty += RangePenalty(earthSimilarityIndex, planet.getEarthSimilarityIndex());
+    penalty += RangePenalty(surfaceTemperature, planet.getSurfaceTemperature());
+    penalty += RangePenalty(hydrosphere, planet.getHydroPercentage());
+    penalty += RangePenalty(surfacePressure, planet.getSurfacePressure());
+
+    return penalty;
+}
+
+//----------------------------------------------------------------------------
+SeedOptimizer::SeedOptimizer(uint32_t workerCount_)
+    : workerCount(workerCount_)
+{
+    if (workerCount == 0u)
+    {
+        workerCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+}
+
+//----------------------------------------------------------------------------
+void SeedOptimizer::regenerate(const DesignCandidate& candidate, const Config& config, const Star& star, bool useGenerate2, Generator& generator, SolarSystem& system)
+{
+    Config designConfig(config);
+    designConfig.generateStar = false;
+    designConfig.protoplanetSeeds = candidate.seeds;
+
+    system.add(star);
+    generator.seed(candidate.seed);
+    if (useGenerate2)
+    {
+        generator.generate2(system, designConfig);
+    }
+    else
+    {
+        generator.generate(system, designConfig);
+    }
+}
+
+//----------------------------------------------------------------------------
+void SeedOptimizer::run(const Config& config, const std::vector<PlanetTarget>& targets, const SeedOptimizerSettings& settings)
+{
+    results.clear();
+    generatedCount = 0u;
+
+    const uint32_t seedCount = (settings.seedCount > 0u) ? settings.seedCount : static_cast<uint32_t>(targets.size());
+    if (targets.empty() || seedCount == 0u || settings.restartCount == 0u || settings.rngSeedsPerPoint == 0u || settings.resultCount == 0u)
+    {
+        return;
+    }
+
+    Star star = settings.star;
+    star.evaluate();
+
+    const BandLimit_t& zone = star.getProtoplanetZone();
+    const double logInner = log(zone.first);
+    const double logOuter = log(zone.second);
+
+    // Each seed is two coordinates: the position of its semi-major axis on a log scale across the
+    // protoplanet zone, and its eccentricity relative to MaxSeedEccentricity.
+    const uint32_t dimensions = 2u * seedCount;
+
+    auto toSmaCoordinate = [&](double sma)
+    {
+        return std::min(1.0, std::max(0.0, (log(std::max(sma, 1.0e-6)) - logInner) / (logOuter - logInner)));
+    };
+
+    std::vector<std::vector<DesignCandidate>> restartBest(settings.restartCount);
+    std::vector<uint64_t> generated(workerCount, 0u);
+    std::atomic<uint32_t> nextRestart(0u);
+
+    auto worker = [&](uint32_t workerIndex)
+    {
+        Generator generator;
+        SolarSystem system;
+        DesignCandidate candidate;
+        DesignCandidate best;
+
+        for (;;)
+        {
+            const uint32_t restart = nextRestart.fetch_add(1u, std::memory_order_relaxed);
+            if (restart >= settings.restartCount)
+            {
+                break;
+            }
+
+            std::seed_seq sequence{ static_cast<uint32_t>(settings.searchSeed), static_cast<uint32_t>(settings.searchSeed >> 32), restart };
+            std::mt19937_64 rng(sequence);
+            std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+            std::vector<uint64_t> rngSeeds(settings.rngSeedsPerPoint);
+            for (auto& s : rngSeeds)
+            {
+                s = rng();
+            }
+
+            std::vector<DesignCandidate>& keep = restartBest[restart];
+            uint32_t evaluations = 0u;
+
+            // Generate the placement at `x` with each of the restart's Generator seeds, and return the best score.
+            auto evaluate = [&](std::vector<double>& x)
+            {
+                candidate.seeds.resize(seedCount);
+                for (uint32_t s = 0; s < seedCount; ++s)
+                {
+                    x[2u * s] = std::min(1.0, std::max(0.0, x[2u * s]));
+                    x[2u * s + 1u] = std::min(1.0, std::max(0.0, x[2u * s + 1u]));
+
+                    const double sma = exp(logInner + x[2u * s] * (logOuter - logInner));
+                    candidate.seeds[s].semiMajorAxis = std::min(zone.second, std::max(zone.first, sma));
+                    candidate.seeds[s].eccentricity = static_cast<float>(x[2u * s + 1u]) * MaxSeedEccentricity;
+                }
+
+                best.score = -1.0f;
+                for (uint64_t seed : rngSeeds)
+                {
+                    candidate.seed = seed;
+                    regenerate(candidate, config, star, settings.useGenerate2, generator, system);
+                    candidate.score = score(targets, system, &candidate.planetOrdinal);
+
+                    if (best.score < 0.0f || IsBetterDesign(candidate, best))
+                    {
+                        best = candidate;
+                    }
+                }
+
+                generated[workerIndex] += rngSeeds.size();
+                ++evaluations;
+                KeepDesign(keep, best, settings.resultCount);
+
+                return best.score;
+            };
+
+            // The starting point.
+            std::vector<Vertex> simplex(dimensions + 1u);
+            std::vector<double>& x0 = simplex[0].x;
+            x0.resize(dimensions);
+            for (auto& x : x0)
+            {
+                x = unit(rng);
+            }
+
+            if (restart == 0u)
+            {
+                if (!config.protoplanetSeeds.empty())
+                {
+                    for (uint32_t s = 0; s < seedCount && s < config.protoplanetSeeds.size(); ++s)
+                    {
+                        const ProtoplanetSeed& seed = config.protoplanetSeeds[s];
+                        x0[2u * s] = toSmaCoordinate(seed.semiMajorAxis);
+                        if (seed.eccentricity >= 0.0f && seed.eccentricity <= 0.9f)
+                        {
+                            x0[2u * s + 1u] = std::min(1.0, static_cast<double>(seed.eccentricity / MaxSeedEccentricity));
+                        }
+                    }
+                }
+                else
+                {
+                    for (uint32_t s = 0; s < seedCount && s < targets.size(); ++s)
+                    {
+                        const TargetRange& sma = targets[s].semimajorAxis;
+                        if (sma.isSet())
+                        {
+                            x0[2u * s] = toSmaCoordinate(sqrt(std::max(sma.lower, 1.0e-6f) * static_cast<double>(sma.upper)));
+                        }
+                    }
+                }
+            }
+
+            for (uint32_t i = 1; i <= dimensions; ++i)
+            {
+                simplex[i].x = x0;
+                double& x = simplex[i].x[i - 1u];
+                x = (x + InitialSimplexSize <= 1.0) ? x + InitialSimplexSize : x - InitialSimplexSize;
+            }
+
+            for (auto& v : simplex)
+            {
+                v.f = evaluate(v.x);
+            }
+
+            // Nelder-Mead.
+            std::vector<double> centroid(dimensions);
+            std::vector<double> reflected(dimensions);
+            std::vector<double> trial(dimensions);
+            auto byScore = [](const Vertex& lhs, const Vertex& rhs) { return lhs.f < rhs.f; };
+
+            while (evaluations < settings.evaluationsPerRestart)
+            {
+                std::stable_sort(simplex.begin(), simplex.end(), byScore);
+
+                Vertex& worst = simplex[dimensions];
+                if (simplex[0].f == 0.0f)
+                {
+                    break;
+                }
+
+                double extent = 0.0;
+                for (uint32_t i = 1; i <= dimensions; ++i)
+                {
+                    for (uint32_t d = 0; d < dimensions; ++d)
+                    {
+                        extent = std::max(extent, fabs(simplex[i].x[d] - simplex[0].x[d]));
+                    }
+                }
+                if (extent < SimplexTolerance && worst.f - simplex[0].f < SimplexTolerance)
+                {
+                    break;
+                }
+
+                std::fill(centroid.begin(), centroid.end(), 0.0);
+                for (uint32_t i = 0; i < dimensions; ++i)
+                {
+                    for (uint32_t d = 0; d < dimensions; ++d)
+                    {
+                        centroid[d] += simplex[i].x[d] / dimensions;
+                    }
+                }
+
+                for (uint32_t d = 0; d < dimensions; ++d)
+                {
+                    reflected[d] = 2.0 * centroid[d] - worst.x[d];
+                }
+                const float fr = evaluate(reflected);
+
+                if (fr < simplex[0].f)
+                {
+                    // Expand.
+                    for (uint32_t d = 0; d < dimensions; ++d)
+                    {
+                        trial[d] = 3.0 * centroid[d] - 2.0 * worst.x[d];
+                    }
+                    const float fe = evaluate(trial);
+                    worst.x = (fe < fr) ? trial : reflected;
+                    worst.f = std::min(fe, fr);
+                }
+                else if (fr < simplex[dimensions - 1u].f)
+                {
+                    worst.x = reflected;
+                    worst.f = fr;
+                }
+                else
+                {
+                    // Contract, outside the simplex if the reflection improved on the worst vertex.
+                    const std::vector<double>& towards = (fr < worst.f) ? reflected : worst.x;
+                    for (uint32_t d = 0; d < dimensions; ++d)
+                    {
+                        trial[d] = 0.5 * (centroid[d] + towards[d]);
+                    }
+                    const float fc = evaluate(trial);
+
+                    if (fc < std::min(fr, worst.f))
+                    {
+                        worst.x = trial;
+                        worst.f = fc;
+                    }
+                    else
+                    {
+                        // Shrink towards the best vertex.
+                        for (uint32_t i = 1; i <= dimensions && evaluations < settings.evaluationsPerRestart; ++i)
+                        {
+                            for (uint32_t d = 0; d < dimensions; ++d)
+                            {
+                                simplex[i].x[d] = 0.5 * (simplex[0].x[d] + simplex[i].x[d]);
+                            }
+                            simplex[i].f = evaluate(simplex[i].x);
+                        }
+                    }
+                }
+            }
+        }
+    };
+
+    if (workerCount == 1u || settings.restartCount == 1u)
+    {
+        worker(0u);
+    }
+    else
+    {
+        std::vector<std::thread> threads;
+        const uint32_t threadCount = std::min(workerCount, settings.restartCount);
+        threads.reserve(threadCount);
+        for (uint32_t i = 0; i < threadCount; ++i)
+        {
+            threads.emplace_back(worker, i);
+        }
+
+        for (auto& t : threads)
+        {
+            t.join();
+        }
+    }
+
+    for (const auto& keep : restartBest)
+    {
+        for (const auto& c : keep)
+        {
+            KeepDesign(results, c, settings.resultCount);
+        }
+    }
+
+    for (uint64_t g : generated)
+    {
+        generatedCount += g;
+    }
+}
+
+//----------------------------------------------------------------------------
+float SeedOptimizer::score(const std::vector<PlanetTarget>& targets, const SolarSystem& system, std::vector<uint32_t>* planetOrdinal)
+{
+    const PlanetVector& planets = system.getPlanets();
+
+    std::vector<bool> used(planets.size(), false);
+    if (planetOrdinal)
+    {
+        planetOrdinal->assign(targets.size(), 0u);
+    }
+
+    float total = 0.0f;
+    for (size_t t = 0; t < targets.size(); ++t)
+    {
+        float bestPenalty = MissingPlanetPenalty;
+        size_t bestPlanet = planets.size();
+        for (size_t p = 0; p < planets.size(); ++p)
+        {
+            if (!used[p])
+            {
+                const float penalty = targets[t].getPenalty(planets[p]);
+                if (penalty < bestPenalty)
+                {
+                    bestPenalty = penalty;
+                    bestPlanet = p;
+                }
+            }
+        }
+
+        if (bestPlanet < planets.size())
+        {
+            used[bestPlanet] = true;
+            if (planetOrdinal)
+            {
+                (*planetOrdinal)[t] = static_cast<uint32_t>(bestPlanet + 1u);
+            }
+        }
+        total += bestPenalty;
+    }
+
+    return total;
+}
+
+}
+}
@@ -0,0 +1,355 @@
+/*****************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Questionable Coding
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************/
+#include <qcSysGen/SeedStrategy.h>
+
+#include <qcSysGen/Generator.h>
+#include <qcSysGen/Star.h>
+
+#include <math.h>
+
+namespace
+{
+
+/// @brief The 1.7275^n progression of the Bode layout is cached for n in [-BodeTableTerms, BodeTableTerms].
+/// Systems reach about n = +/-12, terms outside the table are computed.
+static constexpr int32_t BodeTableTerms = 32;
+
+/// @brief Index of 1.7275^0 in the Bode layout.  Index 0 holds the ecosphere-scaled A coefficient.
+static constexpr int32_t BodeTableOffset = 1 + BodeTableTerms;
+
+//----------------------------------------------------------------------------
+// Apply the Blagg's formumation of the Bode Law using the specified parameters.
+double BodeSequence(int n, double A, double B, float alpha, float beta, const qc::SystemGenerator::SeedLayout& layout)
+{
+    const float theta = alpha + n * beta;
+    // f(theta) = 0.249 + 0.86 * ( cos(theta)/(3 - cos(2 * theta)) + 1/(6 - 4*cos(2 * (theta - pi/6))) )
+    const double f = 0.249 + 0.86 * (cosf(theta) / (3.0 - cosf(2.0f * theta)) + 1.0 / (6.0 - 4.0 * cosf(theta - 0.52359877559829887307710723054658f)));
+
+    const float progression = (n >= -BodeTableTerms && n <= BodeTableTerms) ? static_cast<float>(layout[BodeTableOffset + n]) : powf(1.7275f, float(n));
+
+    return A * (B + f) * progression;
+}
+
+}
+
+namespace qc
+{
+
+namespace SystemGenerator
+{
+
+//----------------------------------------------------------------------------
+void BodeSeedStrategy::generate(Generator& generator, const Star& star, const SeedLayout& layout, std::vector<ProtoplanetSeed>& protoplanetSeeds) const
+{
+#ifdef ALLOW_DEBUG_PRINTF
+    if (generator.getVerbose())
+    {
+        printf("Generating Bode seeds:\n");
+    }
+#endif
+
+    // The Blagg formulation of Bode's Law is:
+    // SMA (AU) = A * (B + f(a + nb)) * 1.7275 ^ n
+    // where:
+    // f(theta) = 0.249 + 0.86 * ( cos(theta)/(3 - cos(2 * theta)) + 1/(6 - 4*cos(2 * (theta - pi/6))) )
+    // A = 0.4162
+    // B = 2.025
+    // a =  84.9*
+    // b =  56.6*
+    // n = integer (-2, -1, 0, 1, 2, ...)
+    //
+    // This formulation is pretty accurate for the solar system - within 5% on all of the major planets except
+    // Neptune (which is 5.6%).  It also is reasonable for the moons of the gas giants with tweaking of the constants.
+    //
+    // For this simulation's sake, we'll vary A and B within a small range (+/- 5%), with additional scaling
+    // of A based on the ideal ecosphere of the central star.  This way, we can more-or-less guarantee that the first
+    // protoplanet (n = 0) is within or close to the ecosphere.
+
+    // A in the Blagg formulation, initially 0.4162.
+    // We scale that value by the ecosphere radius (cached in the layout), and then apply a random
+    // Gaussian distribution within a few percent of that result.
+    const double A = layout[0] * generator.randomNear(1.0f, 0.04f);
+
+    // B in the Blagg formulation, initially 2.025.
+    const double B = 2.025 * generator.randomNear(1.0f, 0.04f);
+
+    // alpha in the Blagg formulation.  For our solar system, it's 84.9 degrees (~1.4818).
+    // We'll use a completely random value here.
+    const float a = generator.randomTwoPi();
+
+    // beta in the Blagg formulation.  For our solar system, it's 56.6 degrees (~0.9879).
+    const float b = 0.9879f;
+
+    const BandLimit_t& protoplanetZone = star.getProtoplanetZone();
+
+    // Generate the seeds:
+    ProtoplanetSeed s;
+
+    s.semiMajorAxis = BodeSequence(0, A, B, a, b, layout);
+    s.eccentricity = generator.randomEccentricity();
+
+    const size_t firstSeed = protoplanetSeeds.size();
+    protoplanetSeeds.emplace_back(s);
+#ifdef ALLOW_DEBUG_PRINTF
+    if (generator.getVerbose())
+    {
+        printf(" ... n =  0 - SMA = %.3lf, ecc = %.3f\n", s.semiMajorAxis, s.eccentricity);
+    }
+#endif
+
+    int32_t n = 1;
+    bool added = false;
+    do
+    {
+        added = false;
+        s.semiMajorAxis = BodeSequence(-n, A, B, a, b, layout);
+        s.eccentricity = generator.randomEccentricity();
+        if (s.semiMajorAxis >= protoplanetZone.first)
+        {
+            protoplanetSeeds.emplace_back(s);
+            added = true;
+#ifdef ALLOW_DEBUG_PRINTF
+            if (generator.getVerbose())
+            {
+                printf(" ... n = %2d - SMA = %.3lf, ecc = %.3f\n", -n, s.semiMajorAxis, s.eccentricity);
+            }
+#endif
+        }
+
+        s.semiMajorAxis = BodeSequence(n, A, B, a, b, layout);
+        s.eccentricity = generator.randomEccentricity();
+        if (s.semiMajorAxis <= protoplanetZone.second)
+        {
+            protoplanetSeeds.emplace_back(s);
+            added = true;
+#ifdef ALLOW_DEBUG_PRINTF
+            if (generator.getVerbose())
+            {
+                printf(" ... n = %2d - SMA = %.3lf, ecc = %.3f\n", n, s.semiMajorAxis, s.eccentricity);
+            }
+#endif
+        }
+
+        ++n;
+    } while (added);
+
+    // Reorder them.  This is not a uniform shuffle, but it is the order existing Bode systems were generated with.
+    const size_t count = protoplanetSeeds.size() - firstSeed;
+    size_t i = 1u;
+    while (i < count - 1u)
+    {
+        const size_t otherIdx = generator.randomUniformInt<size_t>(1u, count - 1u);
+        if (i != otherIdx)
+        {
+#ifdef ALLOW_DEBUG_PRINTF
+            if (generator.getVerbose())
+            {
+                printf(" ... Swapping [%Iu] and [%Iu]\n", i, otherIdx);
+            }
+#endif
+            std::swap(protoplanetSeeds[firstSeed + i], protoplanetSeeds[firstSeed + otherIdx]);
+        }
+        ++i;
+    }
+}
+
+//----------------------------------------------------------------------------
+void BodeSeedStrategy::prepare(const Star& star, SeedLayout& layout) const
+{
+    layout.resize(BodeTableOffset + BodeTableTerms + 1);
+
+    layout[0] = 0.4162 * star.getEcosphere();
+    for (int32_t n = -BodeTableTerms; n <= BodeTableTerms; ++n)
+    {
+        layout[BodeTableOffset + n] = powf(1.7275f, float(n));
+    }
+}
+
+//----------------------------------------------------------------------------
+void LogUniformSeedStrategy::addFingerprint(Fingerprint& fingerprint) const
+{
+    fingerprint.addString(getName());
+    fingerprint.add(count);
+}
+
+//----------------------------------------------------------------------------
+void LogUniformSeedStrategy::generate(Generator& generator, const Star&, const SeedLayout& layout, std::vector<ProtoplanetSeed>& seeds) const
+{
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        ProtoplanetSeed s;
+        s.semiMajorAxis = exp(generator.randomUniform(layout[0], layout[1]));
+        s.eccentricity = generator.randomEccentricity();
+        seeds.emplace_back(s);
+    }
+}
+
+//----------------------------------------------------------------------------
+void LogUniformSeedStrategy::prepare(const Star& star, SeedLayout& layout) const
+{
+    const BandLimit_t& protoplanetZone = star.getProtoplanetZone();
+
+    layout.resize(2u);
+    layout[0] = log(protoplanetZone.first);
+    layout[1] = log(protoplanetZone.second);
+}
+
+//----------------------------------------------------------------------------
+void ResonantChainSeedStrategy::addFingerprint(Fingerprint& fingerprint) const
+{
+    fingerprint.addString(getName());
+    fingerprint.add(periodRatio);
+    fingerprint.add(jitter);
+}
+
+//----------------------------------------------------------------------------
+void ResonantChainSeedStrategy::generate(Generator& generator, const Star&, const SeedLayout& layout, std::vector<ProtoplanetSeed>& seeds) const
+{
+    // The layout is the chain, innermost first, except for layout[0], which is the index of the seed at the ecosphere.
+    const double shift = generator.randomAbout(1.0, static_cast<double>(jitter));
+    const int32_t center = static_cast<int32_t>(layout[0]);
+    const int32_t last = static_cast<int32_t>(layout.size()) - 1;
+
+    // Start at the ecosphere and alternate outwards and inwards, so the seeds closest to the ecosphere are
+    // placed first.
+    for (int32_t step = 0; ; ++step)
+    {
+        const int32_t outward = center + step;
+        const int32_t inward = center - step;
+        if (outward > last && inward < 1)
+        {
+            break;
+        }
+
+        if (outward >= 1 && outward <= last)
+        {
+            ProtoplanetSeed s;
+            s.semiMajorAxis = layout[outward] * shift;
+            s.eccentricity = generator.randomEccentricity();
+            seeds.emplace_back(s);
+        }
+
+        if (step > 0 && inward >= 1 && inward <= last)
+        {
+            ProtoplanetSeed s;
+            s.semiMajorAxis = layout[inward] * shift;
+            s.eccentricity = generator.randomEccentricity();
+            seeds.emplace_back(s);
+        }
+    }
+}
+
+//----------------------------------------------------------------------------
+void ResonantChainSeedStrategy::prepare(const Star& star, SeedLayout& layout) const
+{
+    const BandLimit_t& protoplanetZone = star.getProtoplanetZone();
+
+    // Kepler's third law: the ratio of the semi-major axes is the period ratio to the 2/3.
+    const double step = pow(periodRatio, 2.0 / 3.0);
+
+    // The chain is extended past the zone by the jitter, since the whole chain may shift.
+    const double inner = protoplanetZone.first / (1.0 + jitter);
+    const double outer = protoplanetZone.second * (1.0 + jitter);
+
+    const double ecosphere = star.getEcosphere();
+    int32_t innerStep = 0;
+    while (ecosphere * pow(step, innerStep - 1) >= inner)
+    {
+        --innerStep;
+    }
+
+    layout.resize(1u);
+    layout[0] = static_cast<double>(1 - innerStep);
+    for (int32_t k = innerStep; ecosphere * pow(step, k) <= outer; ++k)
+    {
+        layout.emplace_back(ecosphere * pow(step, k));
+    }
+}
+
+//----------------------------------------------------------------------------
+void TableSeedStrategy::addFingerprint(Fingerprint& fingerprint) const
+{
+    fingerprint.addString(getName());
+    for (const auto& seed : table)
+    {
+        fingerprint.add(seed.semiMajorAxis);
+        fingerprint.add(seed.eccentricity);
+    }
+    fingerprint.add(jitter);
+}
+
+//----------------------------------------------------------------------------
+void TableSeedStrategy::generate(Generator& generator, const Star&, const SeedLayout& layout, std::vector<ProtoplanetSeed>& seeds) const
+{
+    for (size_t i = 0; i < table.size(); ++i)
+    {
+        ProtoplanetSeed s;
+        s.semiMajorAxis = (jitter > 0.0f) ? generator.randomAbout(layout[i], static_cast<double>(jitter)) : layout[i];
+        s.eccentricity = (table[i].eccentricity < 0.0f || table[i].eccentricity > 0.9f) ? generator.randomEccentricity() : table[i].eccentricity;
+        seeds.emplace_back(s);
+    }
+}
+
+//----------------------------------------------------------------------------
+void TableSeedStrategy::prepare(const Star& star, SeedLayout& layout) const
+{
+    layout.resize(table.size());
+    for (size_t i = 0; i < table.size(); ++i)
+    {
+        layout[i] = table[i].semiMajorAxis * star.getEcosphere();
+    }
+}
+
+//----------------------------------------------------------------------------
+void UniformSeedStrategy::addFingerprint(Fingerprint& fingerprint) const
+{
+    fingerprint.addString(getName());
+    fingerprint.add(count);
+}
+
+//----------------------------------------------------------------------------
+void UniformSeedStrategy::generate(Generator& generator, const Star&, const SeedLayout& layout, std::vector<ProtoplanetSeed>& seeds) const
+{
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        ProtoplanetSeed s;
+        s.semiMajorAxis = generator.randomUniform(layout[0], layout[1]);
+        s.eccentricity = generator.randomEccentricity();
+        seeds.emplace_back(s);
+    }
+}
+
+//----------------------------------------------------------------------------
+void UniformSeedStrategy::prepare(const Star& star, SeedLayout& layout) const
+{
+    const BandLimit_t& protoplanetZone = star.getProtoplanetZone();
+
+    layout.resize(2u);
+    layout[0] = protoplanetZone.first;
+    layout[1] = protoplanetZone.second;
+}
+
+}
+}
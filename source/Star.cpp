@@ -133,7 +133,7 @@ void Star::evaluate(Generator* generator)
     radiusSolar = si.radius;
     massSolar = si.mass;
 
-    const double maximumStellarAge = std::min(MaximumStellarAge, 1.0e10 * (massSolar / luminositySolar));
+    const double maximumStellarAge = getMaximumAge();
 
     if (ageYears == 0.0)
     {
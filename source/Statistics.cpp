@@ -0,0 +1,524 @@
+/*****************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Questionable Coding
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************/
+#include <qcSysGen/Statistics.h>
+
+#include <qcSysGen/Generator.h>
+#include <qcSysGen/System.h>
+
+#include <algorithm>
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Names used for the star classification columns of the report.
+const char* StarClassificationName(uint32_t idx)
+{
+    static const char* starClass[] = { "O", "B", "A", "F", "G", "K", "M" };
+
+    return (idx < _countof(starClass)) ? starClass[idx] : "?";
+}
+
+/// @brief Identifies serialized PopulationStatistics ("QCPS").
+static constexpr uint32_t StatisticsMagic = 0x53504351u;
+
+/// @brief Version of the serialized PopulationStatistics layout.
+static constexpr uint32_t StatisticsVersion = 1u;
+
+//----------------------------------------------------------------------------
+// Write `count` values to the stream.
+template <typename T_>
+bool WriteValues(FILE* fp, const T_* values, size_t count)
+{
+    return fwrite(values, sizeof(T_), count, fp) == count;
+}
+
+//----------------------------------------------------------------------------
+// Read `count` values from the stream.
+template <typename T_>
+bool ReadValues(FILE* fp, T_* values, size_t count)
+{
+    return fread(values, sizeof(T_), count, fp) == count;
+}
+
+//----------------------------------------------------------------------------
+// Read a count of values and verify that it matches the size of `values`, then read the values.
+bool ReadCounts(FILE* fp, std::vector<uint64_t>& values)
+{
+    uint32_t count;
+    return ReadValues(fp, &count, 1u) && count == values.size() && ReadValues(fp, values.data(), values.size());
+}
+
+//----------------------------------------------------------------------------
+// Write a count of values, then the values.
+bool WriteCounts(FILE* fp, const std::vector<uint64_t>& values)
+{
+    const uint32_t count = static_cast<uint32_t>(values.size());
+    return WriteValues(fp, &count, 1u) && WriteValues(fp, values.data(), values.size());
+}
+
+}
+
+namespace qc
+{
+
+namespace SystemGenerator
+{
+
+//----------------------------------------------------------------------------
+Histogram::Histogram(double lower_, double upper_, uint32_t binCount, bool logarithmic_)
+    : bin(std::max(1u, binCount), 0u)
+    , logarithmic(logarithmic_)
+{
+    assert(upper_ > lower_);
+    assert(!logarithmic_ || lower_ > 0.0);
+
+    lower = (logarithmic) ? log(lower_) : lower_;
+    upper = (logarithmic) ? log(upper_) : upper_;
+    scale = double(bin.size()) / (upper - lower);
+}
+
+//----------------------------------------------------------------------------
+void Histogram::add(double value)
+{
+    if (logarithmic)
+    {
+        if (value <= 0.0)
+        {
+            ++underflow;
+            return;
+        }
+        value = log(value);
+    }
+
+    if (value < lower)
+    {
+        ++underflow;
+    }
+    else if (value >= upper)
+    {
+        ++overflow;
+    }
+    else
+    {
+        // Guard against rounding at the upper edge.
+        const size_t idx = std::min(static_cast<size_t>((value - lower) * scale), bin.size() - 1u);
+        ++bin[idx];
+    }
+}
+
+//----------------------------------------------------------------------------
+double Histogram::getBinLower(uint32_t index) const
+{
+    const double edge = lower + double(index) / scale;
+
+    return (logarithmic) ? exp(edge) : edge;
+}
+
+//----------------------------------------------------------------------------
+uint64_t Histogram::getTotal() const
+{
+    uint64_t total = underflow + overflow;
+    for (auto b : bin)
+    {
+        total += b;
+    }
+
+    return total;
+}
+
+//----------------------------------------------------------------------------
+void Histogram::merge(const Histogram& rhs)
+{
+    assert(bin.size() == rhs.bin.size() && lower == rhs.lower && upper == rhs.upper && logarithmic == rhs.logarithmic);
+
+    for (size_t i = 0; i < bin.size(); ++i)
+    {
+        bin[i] += rhs.bin[i];
+    }
+    underflow += rhs.underflow;
+    overflow += rhs.overflow;
+}
+
+//----------------------------------------------------------------------------
+bool Histogram::read(FILE* fp)
+{
+    return ReadCounts(fp, bin) && ReadValues(fp, &underflow, 1u) && ReadValues(fp, &overflow, 1u);
+}
+
+//----------------------------------------------------------------------------
+void Histogram::report(FILE* fp, const char* title) const
+{
+    const uint64_t total = getTotal();
+
+    fprintf(fp, "%s (%llu samples)\n", title, static_cast<unsigned long long>(total));
+    if (total == 0u)
+    {
+        return;
+    }
+
+    const double invTotal = 100.0 / double(total);
+    if (underflow > 0u)
+    {
+        fprintf(fp, "  %12s < %-12.4g %12llu %6.2f%%\n", "", getBinLower(0u), static_cast<unsigned long long>(underflow), double(underflow) * invTotal);
+    }
+    for (uint32_t i = 0; i < getBinCount(); ++i)
+    {
+        if (bin[i] > 0u)
+        {
+            fprintf(fp, "  %12.4g - %-12.4g %12llu %6.2f%%\n", getBinLower(i), getBinLower(i + 1u), static_cast<unsigned long long>(bin[i]), double(bin[i]) * invTotal);
+        }
+    }
+    if (overflow > 0u)
+    {
+        fprintf(fp, "  %12s >= %-11.4g %12llu %6.2f%%\n", "", getBinLower(getBinCount()), static_cast<unsigned long long>(overflow), double(overflow) * invTotal);
+    }
+}
+
+//----------------------------------------------------------------------------
+bool Histogram::write(FILE* fp) const
+{
+    return WriteCounts(fp, bin) && WriteValues(fp, &underflow, 1u) && WriteValues(fp, &overflow, 1u);
+}
+
+//----------------------------------------------------------------------------
+void RunningMoments::add(double value)
+{
+    ++count;
+    if (count == 1u)
+    {
+        minValue = maxValue = value;
+    }
+    else
+    {
+        minValue = std::min(minValue, value);
+        maxValue = std::max(maxValue, value);
+    }
+
+    const double delta = value - mean;
+    mean += delta / double(count);
+    m2 += delta * (value - mean);
+}
+
+//----------------------------------------------------------------------------
+double RunningMoments::getStdDev() const
+{
+    return sqrt(getVariance());
+}
+
+//----------------------------------------------------------------------------
+void RunningMoments::merge(const RunningMoments& rhs)
+{
+    if (rhs.count == 0u)
+    {
+        return;
+    }
+    else if (count == 0u)
+    {
+        *this = rhs;
+        return;
+    }
+
+    const double n1 = double(count);
+    const double n2 = double(rhs.count);
+    const double n = n1 + n2;
+    const double delta = rhs.mean - mean;
+
+    mean += delta * (n2 / n);
+    m2 += rhs.m2 + delta * delta * (n1 * n2 / n);
+    count += rhs.count;
+    minValue = std::min(minValue, rhs.minValue);
+    maxValue = std::max(maxValue, rhs.maxValue);
+}
+
+//----------------------------------------------------------------------------
+bool RunningMoments::read(FILE* fp)
+{
+    return ReadValues(fp, &count, 1u) && ReadValues(fp, &mean, 1u) && ReadValues(fp, &m2, 1u) &&
+        ReadValues(fp, &minValue, 1u) && ReadValues(fp, &maxValue, 1u);
+}
+
+//----------------------------------------------------------------------------
+bool RunningMoments::write(FILE* fp) const
+{
+    return WriteValues(fp, &count, 1u) && WriteValues(fp, &mean, 1u) && WriteValues(fp, &m2, 1u) &&
+        WriteValues(fp, &minValue, 1u) && WriteValues(fp, &maxValue, 1u);
+}
+
+//----------------------------------------------------------------------------
+QuantileSketch::QuantileSketch(double minValue, double maxValue, double relativeAccuracy)
+{
+    assert(minValue > 0.0 && maxValue > minValue);
+    assert(relativeAccuracy > 0.0 && relativeAccuracy < 1.0);
+
+    gamma = (1.0 + relativeAccuracy) / (1.0 - relativeAccuracy);
+    logGamma = log(gamma);
+
+    minIndex = static_cast<int32_t>(ceil(log(minValue) / logGamma));
+    const int32_t maxIndex = static_cast<int32_t>(ceil(log(maxValue) / logGamma));
+
+    bucket.assign(static_cast<size_t>(maxIndex - minIndex + 1), 0u);
+}
+
+//----------------------------------------------------------------------------
+void QuantileSketch::add(double value)
+{
+    ++count;
+    if (value <= 0.0)
+    {
+        ++zeroCount;
+        return;
+    }
+
+    const int32_t key = static_cast<int32_t>(ceil(log(value) / logGamma));
+    const int32_t idx = Clamp(key - minIndex, 0, static_cast<int32_t>(bucket.size()) - 1);
+    ++bucket[idx];
+}
+
+//----------------------------------------------------------------------------
+double QuantileSketch::getQuantile(double q) const
+{
+    if (count == 0u)
+    {
+        return 0.0;
+    }
+
+    const uint64_t rank = static_cast<uint64_t>(Clamp(q, 0.0, 1.0) * double(count - 1u));
+
+    uint64_t seen = zeroCount;
+    if (rank < seen)
+    {
+        return 0.0;
+    }
+
+    for (size_t i = 0; i < bucket.size(); ++i)
+    {
+        seen += bucket[i];
+        if (rank < seen)
+        {
+            // Midpoint (in relative terms) of the bucket (gamma^(k-1), gamma^k].
+            return 2.0 * pow(gamma, double(minIndex + int32_t(i))) / (gamma + 1.0);
+        }
+    }
+
+    return 2.0 * pow(gamma, double(minIndex + int32_t(bucket.size()) - 1)) / (gamma + 1.0);
+}
+
+//----------------------------------------------------------------------------
+void QuantileSketch::merge(const QuantileSketch& rhs)
+{
+    assert(bucket.size() == rhs.bucket.size() && minIndex == rhs.minIndex && gamma == rhs.gamma);
+
+    for (size_t i = 0; i < bucket.size(); ++i)
+    {
+        bucket[i] += rhs.bucket[i];
+    }
+    zeroCount += rhs.zeroCount;
+    count += rhs.count;
+}
+
+//----------------------------------------------------------------------------
+bool QuantileSketch::read(FILE* fp)
+{
+    return ReadCounts(fp, bucket) && ReadValues(fp, &zeroCount, 1u) && ReadValues(fp, &count, 1u);
+}
+
+//----------------------------------------------------------------------------
+bool QuantileSketch::write(FILE* fp) const
+{
+    return WriteCounts(fp, bucket) && WriteValues(fp, &zeroCount, 1u) && WriteValues(fp, &count, 1u);
+}
+
+//----------------------------------------------------------------------------
+PopulationStatistics::PopulationStatistics()
+    : planetsPerSystem(0.0, 64.0, 64u)
+    , protoplanetHistogram(1.0, 100000.0, 50u, true)
+    , esiHistogram(0.0, 1.0 + 1.0e-6, 20u)
+    , esiQuantiles(1.0e-4, 1.0, 0.01)
+    , temperatureHistogram(10.0, 10000.0, 60u, true)
+    , temperatureQuantiles(1.0, 100000.0, 0.01)
+{
+    memset(planetType, 0, sizeof(planetType));
+    memset(orbitalZone, 0, sizeof(orbitalZone));
+}
+
+//----------------------------------------------------------------------------
+void PopulationStatistics::add(const SolarSystem& system, const Generator& generator)
+{
+    ++systemCount;
+
+    const uint32_t starClass = std::min(static_cast<uint32_t>(system.getStar().getStarType().first), StarClassificationCount - 1u);
+
+    const PlanetVector& planets = system.getPlanets();
+    planetsPerSystem.add(double(planets.size()));
+
+    const double protoplanets = double(generator.getProtoplanetCount());
+    protoplanetHistogram.add(protoplanets);
+    protoplanetMoments.add(protoplanets);
+
+    for (const auto& p : planets)
+    {
+        const uint32_t type = std::min(static_cast<uint32_t>(p.getPlanetType()), PlanetTypeCount - 1u);
+        ++planetType[starClass][type];
+
+        const uint32_t zone = std::min(static_cast<uint32_t>(p.getOrbitalZone()), OrbitalZoneCount - 1u);
+        ++orbitalZone[zone];
+
+        if (!p.isGaseous())
+        {
+            const double esi = p.getEarthSimilarityIndex();
+            esiHistogram.add(esi);
+            esiMoments.add(esi);
+            esiQuantiles.add(esi);
+
+            const double temperature = p.getSurfaceTemperature();
+            temperatureHistogram.add(temperature);
+            temperatureMoments.add(temperature);
+            temperatureQuantiles.add(temperature);
+        }
+    }
+}
+
+//----------------------------------------------------------------------------
+void PopulationStatistics::merge(const PopulationStatistics& rhs)
+{
+    systemCount += rhs.systemCount;
+
+    for (uint32_t s = 0; s < StarClassificationCount; ++s)
+    {
+        for (uint32_t t = 0; t < PlanetTypeCount; ++t)
+        {
+            planetType[s][t] += rhs.planetType[s][t];
+        }
+    }
+    for (uint32_t z = 0; z < OrbitalZoneCount; ++z)
+    {
+        orbitalZone[z] += rhs.orbitalZone[z];
+    }
+
+    planetsPerSystem.merge(rhs.planetsPerSystem);
+    protoplanetHistogram.merge(rhs.protoplanetHistogram);
+    protoplanetMoments.merge(rhs.protoplanetMoments);
+    esiHistogram.merge(rhs.esiHistogram);
+    esiMoments.merge(rhs.esiMoments);
+    esiQuantiles.merge(rhs.esiQuantiles);
+    temperatureHistogram.merge(rhs.temperatureHistogram);
+    temperatureMoments.merge(rhs.temperatureMoments);
+    temperatureQuantiles.merge(rhs.temperatureQuantiles);
+}
+
+//----------------------------------------------------------------------------
+bool PopulationStatistics::read(FILE* fp)
+{
+    uint32_t header[2];
+    return ReadValues(fp, header, _countof(header)) &&
+        header[0] == StatisticsMagic && header[1] == StatisticsVersion &&
+        ReadValues(fp, &systemCount, 1u) &&
+        ReadValues(fp, &planetType[0][0], StarClassificationCount * PlanetTypeCount) &&
+        ReadValues(fp, orbitalZone, OrbitalZoneCount) &&
+        planetsPerSystem.read(fp) &&
+        protoplanetHistogram.read(fp) &&
+        protoplanetMoments.read(fp) &&
+        esiHistogram.read(fp) &&
+        esiMoments.read(fp) &&
+        esiQuantiles.read(fp) &&
+        temperatureHistogram.read(fp) &&
+        temperatureMoments.read(fp) &&
+        temperatureQuantiles.read(fp);
+}
+
+//----------------------------------------------------------------------------
+void PopulationStatistics::report(FILE* fp) const
+{
+    fprintf(fp, "=== Population statistics: %llu systems ===\n\n", static_cast<unsigned long long>(systemCount));
+
+    fprintf(fp, "Planet type mix per star class:\n%-20s", "");
+    for (uint32_t s = 0; s < StarClassificationCount; ++s)
+    {
+        fprintf(fp, " %12s", StarClassificationName(s));
+    }
+    fputc('\n', fp);
+    for (uint32_t t = 0; t < PlanetTypeCount; ++t)
+    {
+        fprintf(fp, "%-20s", PlanetTypeName(PlanetType(t)));
+        for (uint32_t s = 0; s < StarClassificationCount; ++s)
+        {
+            fprintf(fp, " %12llu", static_cast<unsigned long long>(planetType[s][t]));
+        }
+        fputc('\n', fp);
+    }
+
+    fprintf(fp, "\nOrbital zone occupancy:\n");
+    for (uint32_t z = 0; z < OrbitalZoneCount; ++z)
+    {
+        fprintf(fp, "  %-10s %12llu\n", OrbitalZoneName(OrbitalZone(z)), static_cast<unsigned long long>(orbitalZone[z]));
+    }
+    fputc('\n', fp);
+
+    planetsPerSystem.report(fp, "Planets per system");
+    fputc('\n', fp);
+
+    fprintf(fp, "Protoplanets consumed: mean %.2f, stddev %.2f, min %.0f, max %.0f\n",
+            protoplanetMoments.getMean(), protoplanetMoments.getStdDev(), protoplanetMoments.getMin(), protoplanetMoments.getMax());
+    protoplanetHistogram.report(fp, "Protoplanets consumed");
+    fputc('\n', fp);
+
+    fprintf(fp, "ESI (non-gaseous): mean %.3f, stddev %.3f, p50 %.3f, p90 %.3f, p99 %.3f, max %.3f\n",
+            esiMoments.getMean(), esiMoments.getStdDev(),
+            esiQuantiles.getQuantile(0.5), esiQuantiles.getQuantile(0.9), esiQuantiles.getQuantile(0.99),
+            esiMoments.getMax());
+    esiHistogram.report(fp, "ESI (non-gaseous)");
+    fputc('\n', fp);
+
+    fprintf(fp, "Surface temperature (non-gaseous, K): mean %.1f, stddev %.1f, p01 %.1f, p50 %.1f, p99 %.1f\n",
+            temperatureMoments.getMean(), temperatureMoments.getStdDev(),
+            temperatureQuantiles.getQuantile(0.01), temperatureQuantiles.getQuantile(0.5), temperatureQuantiles.getQuantile(0.99));
+    temperatureHistogram.report(fp, "Surface temperature (non-gaseous, K)");
+}
+
+//----------------------------------------------------------------------------
+bool PopulationStatistics::write(FILE* fp) const
+{
+    const uint32_t header[2] = { StatisticsMagic, StatisticsVersion };
+    return WriteValues(fp, header, _countof(header)) &&
+        WriteValues(fp, &systemCount, 1u) &&
+        WriteValues(fp, &planetType[0][0], StarClassificationCount * PlanetTypeCount) &&
+        WriteValues(fp, orbitalZone, OrbitalZoneCount) &&
+        planetsPerSystem.write(fp) &&
+        protoplanetHistogram.write(fp) &&
+        protoplanetMoments.write(fp) &&
+        esiHistogram.write(fp) &&
+        esiMoments.write(fp) &&
+        esiQuantiles.write(fp) &&
+        temperatureHistogram.write(fp) &&
+        temperatureMoments.write(fp) &&
+        temperatureQuantiles.write(fp);
+}
+
+}
+}
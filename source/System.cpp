@@ -24,6 +24,9 @@
 ****************************************************************************/
 #include <qcSysGen/System.h>
 
+#include <qcSysGen/Generator.h>
+#include <qcSysGen/PhaseCounters.h>
+
 #include <assert.h>
 
 namespace
@@ -142,7 +145,10 @@ void SolarSystem::evaluate(Generator& generator)
 {
     // The star should have been evaluated when it was added.  If this is the
     // default star, I need to evaluate it now.
-    star.evaluate(&generator);
+    {
+        PhaseScope phase(generator.getPhaseCounters(), GenerationPhase::Star);
+        star.evaluate(&generator);
+    }
 
     // If the star isn't named, name it after the system.
     if (star.getName().empty())
@@ -185,6 +191,7 @@ void SolarSystem::evaluate(Generator& generator)
         }
 #endif
 
+        generator.preemptionPoint();
         p.evaluate(generator, star);
 
         ++ordinal;
@@ -0,0 +1,111 @@
+/*****************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Questionable Coding
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************/
+#include <qcSysGen/SystemRecord.h>
+
+#include <qcSysGen/System.h>
+
+#include <algorithm>
+#include <string.h>
+
+namespace qc
+{
+
+namespace SystemGenerator
+{
+
+//----------------------------------------------------------------------------
+size_t SystemRecord::GetSize(const SolarSystem& system)
+{
+    return sizeof(SystemRecord) + system.getPlanets().size() * sizeof(PlanetRecord);
+}
+
+//----------------------------------------------------------------------------
+size_t SystemRecord::Write(void* buffer, size_t bufferSize, uint64_t seed, uint64_t systemIndex, const SolarSystem& system)
+{
+    const size_t size = GetSize(system);
+    if (size > bufferSize)
+    {
+        return 0u;
+    }
+
+    memset(buffer, 0, size);
+
+    SystemRecord* record = static_cast<SystemRecord*>(buffer);
+    record->size = static_cast<uint32_t>(size);
+    record->planetCount = static_cast<uint32_t>(system.getPlanets().size());
+    record->seed = seed;
+    record->systemIndex = systemIndex;
+
+    const Star& star = system.getStar();
+    const StarType_t starType = star.getStarType();
+    record->star.starClass = static_cast<uint8_t>(starType.first);
+    record->star.subtype = static_cast<int8_t>(starType.second);
+    record->star.temperature = static_cast<float>(star.getTemperature());
+    record->star.age = star.getAge();
+    record->star.mass = star.getMass();
+    record->star.luminosity = star.getLuminosity();
+    record->star.radius = star.getSolarRadius();
+    record->star.ecosphere = star.getEcosphere();
+    record->star.snowLine = star.getSnowLine();
+    record->star.habitableZone[0] = star.getHabitableZone().first;
+    record->star.habitableZone[1] = star.getHabitableZone().second;
+
+    PlanetRecord* planetRecord = reinterpret_cast<PlanetRecord*>(record + 1);
+    for (const auto& p : system.getPlanets())
+    {
+        planetRecord->semimajorAxis = p.getSemimajorAxis();
+        planetRecord->periapsis = p.getPeriapsis();
+        planetRecord->apoapsis = p.getApoapsis();
+        planetRecord->mass = p.getMass();
+        planetRecord->dustMass = p.getDustMassComponent();
+        planetRecord->gasMass = p.getGasMassComponent();
+        planetRecord->sphereOfInfluence = p.getSphereOfInfluence();
+        planetRecord->surfaceGravity = p.getSurfaceGravity();
+        planetRecord->eccentricity = p.getEccentricity();
+        planetRecord->inclination = p.getInclination();
+        planetRecord->radius = p.getRadius();
+        planetRecord->density = p.getDensity();
+        planetRecord->surfacePressure = p.getSurfacePressure();
+        planetRecord->surfaceTemperature = p.getSurfaceTemperature();
+        planetRecord->hydrosphere = p.getHydroPercentage();
+        planetRecord->iceCoverage = p.getIcePercentage();
+        planetRecord->cloudCoverage = p.getCloudPercentage();
+        planetRecord->earthSimilarityIndex = p.getEarthSimilarityIndex();
+        planetRecord->planetType = static_cast<uint8_t>(p.getPlanetType());
+        planetRecord->orbitalZone = static_cast<uint8_t>(p.getOrbitalZone());
+
+        const auto& atmo = p.getAtmo();
+        const size_t atmoCount = std::min(atmo.size(), static_cast<size_t>(PlanetRecord::MaxAtmosphere));
+        planetRecord->atmosphereCount = static_cast<uint8_t>(atmoCount);
+        std::copy(atmo.begin(), atmo.begin() + atmoCount, planetRecord->atmosphere);
+
+        ++planetRecord;
+    }
+
+    return size;
+}
+
+}
+}
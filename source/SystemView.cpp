@@ -0,0 +1,80 @@
+/*****************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Questionable Coding
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************/
+#include <qcSysGen/SystemView.h>
+
+#include <qcSysGen/Planet.h>
+#include <qcSysGen/Star.h>
+
+#include <algorithm>
+
+namespace qc
+{
+
+namespace SystemGenerator
+{
+
+//----------------------------------------------------------------------------
+void PlanetView::materialize(Planet& planet) const
+{
+    planet.reset();
+
+    planet.semimajorAxis = record->semimajorAxis;
+    planet.periapsis = record->periapsis;
+    planet.apoapsis = record->apoapsis;
+    planet.totalMass = record->mass;
+    planet.dustMass = record->dustMass;
+    planet.gasMass = record->gasMass;
+    planet.sphereOfInfluence = record->sphereOfInfluence;
+    planet.surfaceAcceleration = static_cast<float>(record->surfaceGravity / AccelerationInGees);
+    planet.eccentricity = record->eccentricity;
+    planet.inclination = record->inclination;
+    planet.radius = record->radius;
+    planet.density = record->density;
+    planet.surfacePressure = record->surfacePressure;
+    planet.meanSurfaceTemperature = record->surfaceTemperature;
+    planet.hydrosphere = record->hydrosphere;
+    planet.iceCoverage = record->iceCoverage;
+    planet.cloudCoverage = record->cloudCoverage;
+    planet.earthSimilarityIndex = record->earthSimilarityIndex;
+    planet.type = getPlanetType();
+    planet.orbitalZone = getOrbitalZone();
+
+    const uint32_t atmosphereCount = std::min<uint32_t>(record->atmosphereCount, PlanetRecord::MaxAtmosphere);
+    planet.atmosphere.assign(record->atmosphere, record->atmosphere + atmosphereCount);
+
+    planet.evaluated = true;
+}
+
+//----------------------------------------------------------------------------
+void StarView::materialize(Star& star) const
+{
+    const StarType_t type = getStarType();
+    star.setType(type.first, type.second);
+    star.setAge(record->age);
+    star.evaluate();
+}
+
+}
+}
@@ -0,0 +1,253 @@
+/*****************************************************************************
+* The MIT License (MIT)
+*
+* Copyright (c) 2024 Questionable Coding
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*
+****************************************************************************/
+#include <qcSysGen/Generator.h>
+#include <qcSysGen/System.h>
+#include <qcSysGen/SystemRecord.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+using namespace qc::SystemGenerator;
+
+// Bakes systems generated from fixed seeds into a header, so shipped content doesn't have to generate
+// them at startup.
+//
+//   systemBaker <output.h> [--namespace NAME] [--star G2] [--protoplanets N] [--generate-star] [--bode]
+//               [--generate2] NAME=SEED [NAME=SEED ...]
+//
+// Every NAME=SEED pair is generated exactly as Generator::generate() (or generate2()) does at runtime,
+// and written to the header as a SystemRecord image:
+//
+//   namespace NAME
+//   {
+//   static constexpr uint64_t HomeImage[] = { ... };
+//   inline const qc::SystemGenerator::SystemRecord& Home() { ... }
+//   }
+//
+// The image is a constant initializer, so it lives in the executable's read-only data and reading it
+// costs nothing.  The header asserts the sizes of the record structures, so a header baked against an
+// older record layout fails to compile instead of being misread.  Images are in the byte order of the
+// machine that ran the baker.  Rerun the baker whenever the generator changes.
+//
+// A SystemRecord holds the star and the planets but no moons or derived values such as day length, so
+// --moons is rejected rather than baked into an image that would silently drop the moons.
+
+namespace
+{
+
+/// @brief A system to bake.
+struct BakeEntry
+{
+    std::string name;
+    uint64_t seed;
+};
+
+//----------------------------------------------------------------------------
+// Returns true if `name` is a valid C++ identifier.
+bool IsIdentifier(const char* name)
+{
+    if (!*name || (*name >= '0' && *name <= '9'))
+    {
+        return false;
+    }
+
+    for (const char* c = name; *c; ++c)
+    {
+        if (!((*c >= 'a' && *c <= 'z') || (*c >= 'A' && *c <= 'Z') || (*c >= '0' && *c <= '9') || *c == '_'))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//----------------------------------------------------------------------------
+// Parse a star type such as "G2" or "K5V".
+bool ParseStar(const char* text, Star& star)
+{
+    static const char Classes[] = "OBAFGKM";
+
+    const char* c = (*text) ? strchr(Classes, *text) : nullptr;
+    if (!c || text[1] < '0' || text[1] > '9' || (text[2] && strcmp(text + 2, "V")))
+    {
+        return false;
+    }
+
+    star.setType(static_cast<StarClassification>(c - Classes), text[1] - '0');
+    return true;
+}
+
+//----------------------------------------------------------------------------
+// Write one system to the header.
+void WriteSystem(FILE* fp, const BakeEntry& entry, const SolarSystem& system)
+{
+    const size_t size = SystemRecord::GetSize(system);
+    std::vector<uint64_t> image((size + sizeof(uint64_t) - 1u) / sizeof(uint64_t), 0u);
+    SystemRecord::Write(image.data(), image.size() * sizeof(uint64_t), entry.seed, 0u, system);
+
+    char stellarClass[8];
+    system.getStar().getStellarClass(stellarClass, sizeof(stellarClass));
+
+    fprintf(fp, "// %s: seed %llu, %s, %u planets.\n", entry.name.c_str(), static_cast<unsigned long long>(entry.seed),
+            stellarClass, static_cast<uint32_t>(system.getPlanets().size()));
+    fprintf(fp, "static constexpr uint64_t %sImage[] =\n{", entry.name.c_str());
+    for (size_t i = 0; i < image.size(); ++i)
+    {
+        fprintf(fp, "%s0x%016llXull,", (i % 4u) ? " " : "\n    ", static_cast<unsigned long long>(image[i]));
+    }
+    fprintf(fp, "\n};\n\n");
+
+    fprintf(fp, "inline const qc::SystemGenerator::SystemRecord& %s() { return *reinterpret_cast<const qc::SystemGenerator::SystemRecord*>(%sImage); }\n\n",
+            entry.name.c_str(), entry.name.c_str());
+}
+
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        printf("Usage:\n"
+               "  systemBaker <output.h> [--namespace NAME] [--star G2] [--protoplanets N] [--generate-star] [--bode]\n"
+               "              [--generate2] NAME=SEED [NAME=SEED ...]\n");
+        return 1;
+    }
+
+    const char* outputPath = argv[1];
+    std::string namespaceName = "BakedSystems";
+    Config config;
+    Star star;
+    bool useGenerate2 = false;
+    std::vector<BakeEntry> entries;
+
+    for (int i = 2; i < argc; ++i)
+    {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : "";
+
+        if (!strcmp(arg, "--namespace")) { namespaceName = value; ++i; }
+        else if (!strcmp(arg, "--star"))
+        {
+            if (!ParseStar(value, star))
+            {
+                fprintf(stderr, "Invalid star type '%s'\n", value);
+                return 1;
+            }
+            ++i;
+        }
+        else if (!strcmp(arg, "--protoplanets")) { config.protoplanetCount = static_cast<uint32_t>(strtoul(value, nullptr, 10)); ++i; }
+        else if (!strcmp(arg, "--generate-star")) { config.generateStar = true; }
+        else if (!strcmp(arg, "--bode")) { config.generateBodeSeeds = true; }
+        else if (!strcmp(arg, "--moons"))
+        {
+            fprintf(stderr, "--moons is not supported: baked SystemRecords do not store moons\n");
+            return 1;
+        }
+        else if (!strcmp(arg, "--generate2")) { useGenerate2 = true; }
+        else
+        {
+            const char* equals = strchr(arg, '=');
+            char* end = nullptr;
+            BakeEntry entry;
+            if (equals)
+            {
+                entry.name.assign(arg, equals);
+                entry.seed = strtoull(equals + 1, &end, 10);
+            }
+
+            if (!equals || !IsIdentifier(entry.name.c_str()) || end == equals + 1 || *end)
+            {
+                fprintf(stderr, "Invalid argument '%s' (expected NAME=SEED)\n", arg);
+                return 1;
+            }
+            entries.emplace_back(entry);
+        }
+    }
+
+    if (entries.empty() || !IsIdentifier(namespaceName.c_str()))
+    {
+        fprintf(stderr, "Nothing to bake\n");
+        return 1;
+    }
+
+    FILE* fp = nullptr;
+    if (fopen_s(&fp, outputPath, "wt"))
+    {
+        fprintf(stderr, "Failed to open %s\n", outputPath);
+        return 1;
+    }
+
+    char stellarClass[8];
+    star.getStellarClass(stellarClass, sizeof(stellarClass));
+
+    fprintf(fp, "// Generated by systemBaker - do not edit.\n");
+    fprintf(fp, "// Config: %s%s%sprotoplanets %u, star %s.\n",
+            useGenerate2 ? "generate2, " : "generate, ",
+            config.generateStar ? "generated star, " : "",
+            config.generateBodeSeeds ? "Bode seeds, " : "",
+            config.protoplanetCount, config.generateStar ? "generated" : stellarClass);
+    fprintf(fp, "#pragma once\n\n#include <qcSysGen/SystemRecord.h>\n\n#include <cstdint>\n\n");
+    fprintf(fp, "static_assert(sizeof(qc::SystemGenerator::SystemRecord) == %u && sizeof(qc::SystemGenerator::PlanetRecord) == %u,\n",
+            static_cast<uint32_t>(sizeof(SystemRecord)), static_cast<uint32_t>(sizeof(PlanetRecord)));
+    fprintf(fp, "              \"SystemRecord layout changed - rerun systemBaker\");\n\n");
+    fprintf(fp, "namespace %s\n{\n\n", namespaceName.c_str());
+
+    Generator generator;
+    SolarSystem system;
+    for (const auto& entry : entries)
+    {
+        system.add(star);
+        generator.seed(entry.seed);
+        if (useGenerate2)
+        {
+            generator.generate2(system, config);
+        }
+        else
+        {
+            generator.generate(system, config);
+        }
+
+        WriteSystem(fp, entry, system);
+    }
+
+    fprintf(fp, "}\n");
+
+    const bool success = (ferror(fp) == 0);
+    fclose(fp);
+
+    if (!success)
+    {
+        fprintf(stderr, "Failed to write %s\n", outputPath);
+        return 1;
+    }
+
+    printf("Baked %u systems into %s\n", static_cast<uint32_t>(entries.size()), outputPath);
+    return 0;
+}